@@ -0,0 +1,132 @@
+/**
+* @file alias.c
+* @brief Walker/Vose alias tables for O(1) popularity-weighted sampling.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "alias.h"
+
+// Todennäköisyys 32-bittisenä kiintolukuna (1.0 -> lokero osoittaa itseensä)
+static uint32_t to_fixed(double p) {
+    double scaled = p * 4294967296.0;
+    if (scaled >= 4294967295.0) {
+        return UINT32_MAX;
+    }
+    return (scaled > 0.0) ? (uint32_t)scaled : 0;
+}
+
+int alias_build(AliasEntry *table, const double *weights, uint32_t count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    double total = 0.0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (weights[i] > 0.0) {
+            total += weights[i];
+        }
+    }
+
+    // Ilman painoja arvotaan tasaisesti
+    if (!(total > 0.0)) {
+        for (uint32_t i = 0; i < count; i++) {
+            table[i].prob = UINT32_MAX;
+            table[i].alias = i;
+        }
+        return 0;
+    }
+
+    // Skaalatut todennäköisyydet (keskiarvo 1) ja pienten/suurten pinot
+    double *scaled = (double *)malloc((size_t)count * sizeof(double));
+    uint32_t *small = (uint32_t *)malloc((size_t)count * sizeof(uint32_t));
+    uint32_t *large = (uint32_t *)malloc((size_t)count * sizeof(uint32_t));
+    if (scaled == NULL || small == NULL || large == NULL) {
+        free(scaled);
+        free(small);
+        free(large);
+        return -1;
+    }
+
+    uint32_t num_small = 0, num_large = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        double w = (weights[i] > 0.0) ? weights[i] : 0.0;
+        scaled[i] = w * (double)count / total;
+        if (scaled[i] < 1.0) {
+            small[num_small++] = i;
+        } else {
+            large[num_large++] = i;
+        }
+    }
+
+    // Pieni lokero täydennetään suuren lokeron ylijäämällä
+    while (num_small > 0 && num_large > 0) {
+        uint32_t s = small[--num_small];
+        uint32_t l = large[--num_large];
+
+        table[s].prob = to_fixed(scaled[s]);
+        table[s].alias = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        if (scaled[l] < 1.0) {
+            small[num_small++] = l;
+        } else {
+            large[num_large++] = l;
+        }
+    }
+
+    // Pyöristysvirheiden jäljiltä jäljelle jääneet ovat täysiä lokeroita
+    while (num_large > 0) {
+        uint32_t l = large[--num_large];
+        table[l].prob = UINT32_MAX;
+        table[l].alias = l;
+    }
+    while (num_small > 0) {
+        uint32_t s = small[--num_small];
+        table[s].prob = UINT32_MAX;
+        table[s].alias = s;
+    }
+
+    free(scaled);
+    free(small);
+    free(large);
+    return 0;
+}
+
+void alias_probabilities(const AliasEntry *table, uint32_t count, double *probabilities) {
+    for (uint32_t i = 0; i < count; i++) {
+        probabilities[i] = 0.0;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        // Täysi lokero (prob = UINT32_MAX ja alias = i) kuuluu kokonaan itselleen
+        double own = (table[i].alias == i) ? 1.0 : (double)table[i].prob / 4294967296.0;
+        probabilities[i] += own / (double)count;
+        probabilities[table[i].alias] += (1.0 - own) / (double)count;
+    }
+}
+
+void zipf_weights(double *weights, uint32_t count, double exponent) {
+    for (uint32_t r = 0; r < count; r++) {
+        weights[r] = pow((double)r + 1.0, -exponent);
+    }
+}
@@ -0,0 +1,61 @@
+/**
+* @file alias.h
+* @brief Walker/Vose alias tables for O(1) popularity-weighted sampling.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef ALIAS_H
+#define ALIAS_H
+
+#include <stdint.h>
+
+#include "rng.h"
+
+// Yksi alias-taulun lokero: indeksi i valitaan, jos satunnainen 32-bittinen
+// luku on pienempi kuin prob, muuten valitaan alias. Lokero, jonka
+// todennäköisyys on 1, osoittaa itseensä (alias == i).
+typedef struct {
+    uint32_t prob;
+    uint32_t alias;
+} AliasEntry;
+
+// Rakentaa alias-taulun painoista (Vosen menetelmä, O(n)). Taulussa on count
+// lokeroa. Negatiiviset painot käsitellään nollina; jos kaikki painot ovat
+// nollia, taulu arpoo tasaisesti. Palauttaa 0 onnistuessa, -1 muistivirheessä.
+int alias_build(AliasEntry *table, const double *weights, uint32_t count);
+
+// Laskee taulun todennäköisyydet takaisin (summa 1). Lokeron i osuus on
+// prob_i / 2^32 omasta lokerosta ja loput lokeroista, joiden alias on i.
+void alias_probabilities(const AliasEntry *table, uint32_t count, double *probabilities);
+
+// Täyttää painot Zipfin lain mukaan: sijalla r (0 = suosituin) paino 1 / (r + 1)^s
+void zipf_weights(double *weights, uint32_t count, double exponent);
+
+// Arpoo indeksin yhdellä satunnaisluvulla ja yhdellä taulun haulla. Ylin puolisko
+// valitsee lokeron (kerto-siirto), alin puolisko ratkaisee lokeron sisällä.
+static inline uint32_t alias_sample(const AliasEntry *table, uint32_t count, Rng *rng) {
+    uint64_t x = rng_next(rng);
+    uint32_t slot = (uint32_t)(((x >> 32) * (uint64_t)count) >> 32);
+    AliasEntry entry = table[slot];
+    return ((uint32_t)x < entry.prob) ? slot : entry.alias;
+}
+
+#endif // ALIAS_H
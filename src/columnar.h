@@ -0,0 +1,81 @@
+/**
+* @file columnar.h
+* @brief Binary columnar output: dictionary once, then batches of 32-bit name ID columns.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "outbuf.h"
+
+#define COLUMNAR_MAGIC "NGCOLUMN"
+#define COLUMNAR_VERSION 1
+#define COLUMNAR_BYTE_ORDER 0x01020304u
+#define COLUMNAR_NO_MIDDLE UINT32_MAX
+
+// Tiedoston rakenne (luvut kirjoittajan tavujärjestyksessä, osat 8 tavun rajoissa):
+//
+//   ColumnarHeader
+//   char label[label_length]          vuosikymmen tai vuosi (UTF-8), täyte 8 tavuun
+//   uint32_t names[2 * num_names]     sanakirja: (offset, length) pooliin
+//   char pool[pool_size]              nimet, täyte 8 tavuun
+//   palat:  ColumnarBatch, uint32_t first[count], middle[count], last[count], täyte 8 tavuun
+//   loppu:  ColumnarBatch, jossa count = 0
+//
+// Sarakkeet ovat sanakirjan tunnisteita, joten ne voi kuvata muistiin ja
+// lukea suoraan taulukkoina (esim. numpy.frombuffer). Keskinimen
+// COLUMNAR_NO_MIDDLE tarkoittaa, ettei keskinimeä ole.
+typedef struct {
+    char magic[8];           // COLUMNAR_MAGIC
+    uint32_t version;        // COLUMNAR_VERSION
+    uint32_t byte_order;     // COLUMNAR_BYTE_ORDER kirjoittajan tavujärjestyksessä
+    uint64_t seed;           // Ajon siemen
+    uint32_t num_names;      // Sanakirjan koko
+    uint32_t label_length;   // Otsikon pituus ilman täytettä
+    uint64_t pool_size;      // Poolin pituus ilman täytettä
+} ColumnarHeader;
+
+typedef struct {
+    uint32_t count;          // Nimiä palassa (0 = tiedoston loppu)
+    uint32_t reserved;
+} ColumnarBatch;
+
+// Kirjoittaa otsakkeen, otsikon ja sanakirjan. Sanakirja ja pooli kirjoitetaan
+// kutsujan muistista (korpuksen kuvauksesta) yhdellä kokoavalla kirjoituksella.
+void columnar_write_header(OutBuf *out, const char *label, uint64_t seed, const uint32_t *names,
+                           uint32_t num_names, const char *pool, uint64_t pool_size);
+
+// Palan koko tavuina count nimelle
+size_t columnar_batch_size(uint32_t count);
+
+// Kääntää count tietuetta (etu, keski, suku; 12 tavua per nimi) palaksi
+// kohtaan out (columnar_batch_size(count) tavua, ei saa osua tietueisiin).
+// Palauttaa palan koon.
+size_t columnar_batch(char *out, const uint32_t *records, uint32_t count);
+
+// Kirjoittaa loppupalan
+void columnar_write_end(OutBuf *out);
+
+#endif // COLUMNAR_H
@@ -0,0 +1,329 @@
+/**
+* @file condtable.c
+* @brief Middle-name tables conditioned on the first name (CSR rows with per-row alias tables).
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condtable.h"
+#include "namedict.h"
+
+// Kolikon raja keskinimen todennäköisyydelle p: keskinimi tulee, jos kolikko >= (1 - p) * 2^64.
+// p = 0.5 antaa 2^63 eli saman kuin riippumattoman otannan ylin bitti.
+static uint64_t skip_for(double p) {
+    if (!(p > 0.0)) {
+        return UINT64_MAX;
+    }
+    if (p >= 1.0) {
+        return 0;
+    }
+    double scaled = (1.0 - p) * 18446744073709551616.0;
+    return (scaled >= 18446744073709551615.0) ? UINT64_MAX : (uint64_t)scaled;
+}
+
+// Funktio lisää nimen sanakirjaan (kopio poolin loppuun) ja palauttaa tunnisteen.
+// Tavutusvihjeet (U+00AD, "Johan­nes") on poistettu jo latauksessa, joten
+// vertailu on tavuvertailu.
+static uint32_t intern(NameDict *dict, char *pool, size_t *used, const char *name, uint32_t length) {
+    memcpy(pool + *used, name, length);
+    uint32_t id = name_dict_find(dict, pool + *used, length);
+    if (id == NAME_DICT_NONE) {
+        id = name_dict_add(dict, (uint32_t)*used, length);
+        *used += length;
+    }
+    return id;
+}
+
+// Funktio etsii yhdistelmätiedoston sarakkeen otsikon perusteella (-1 = ei ole)
+static int find_column(const DecadeData *data, const char *label) {
+    for (int i = 0; i < data->num_decades; i++) {
+        if (strcmp(data->decades[i], label) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Funktio laskee listan nimien yhteispituuden
+static size_t list_bytes(const NameList *list) {
+    size_t bytes = 0;
+    for (int i = 0; i < list->count; i++) {
+        bytes += name_length(list, i);
+    }
+    return bytes;
+}
+
+// Yhden sarakkeen rakentamisen väliaikaiset taulukot (yksi per pari)
+typedef struct {
+    NameDict firsts;     // Parien etunimet (kopiot scratch-pooliin)
+    char *scratch;
+    size_t scratch_used;
+    int *group;          // Parin etunimen tunniste (-1 = virheellinen pari)
+    uint32_t *middle;    // Parin keskinimen tunniste taulun sanakirjassa
+    double *weight;
+    int *order;          // Parit ryhmittäin (laskentalajittelu)
+    int *group_start;    // Ryhmän ensimmäinen pari order-taulukossa (num_groups + 1)
+    int *cursor;         // Lajittelun kirjoituspaikat
+    double *row_weight;  // Rivin keskinimien painot alias_buildille
+} PairScratch;
+
+static void free_scratch(PairScratch *scratch) {
+    name_dict_free(&scratch->firsts);
+    free(scratch->scratch);
+    free(scratch->group);
+    free(scratch->middle);
+    free(scratch->weight);
+    free(scratch->order);
+    free(scratch->group_start);
+    free(scratch->cursor);
+    free(scratch->row_weight);
+}
+
+int cond_table_build(CondTable *table, const DecadeData *first, const DecadeData *middle,
+                     const DecadeData *pairs, int weighted, double zipf_exponent) {
+    memset(table, 0, sizeof(*table));
+    int num_columns = first->num_decades;
+
+    // 1. Koot: rivi per etunimi, merkintä per pari ja varalistan nimi
+    size_t num_rows = 0, num_entries = 0, pool_bytes = 0, longest_first = 0;
+    for (int d = 0; d < num_columns; d++) {
+        const NameList *firsts = &first->lists[d];
+        num_rows += (size_t)firsts->count;
+        for (int i = 0; i < firsts->count; i++) {
+            if (name_length(firsts, i) > longest_first) {
+                longest_first = name_length(firsts, i);
+            }
+        }
+        int pc = find_column(pairs, first->decades[d]);
+        if (pc >= 0) {
+            num_entries += (size_t)pairs->lists[pc].count;
+            pool_bytes += list_bytes(&pairs->lists[pc]);
+        }
+        if (d < middle->num_decades) {
+            num_entries += (size_t)middle->lists[d].count;
+            pool_bytes += list_bytes(&middle->lists[d]);
+        }
+    }
+
+    size_t columns_size = (size_t)num_columns * sizeof(CondColumn);
+    size_t rows_size = num_rows * sizeof(CondRow);
+    size_t alias_size = num_entries * sizeof(AliasEntry);
+    size_t ids_size = num_entries * sizeof(uint32_t);
+    size_t slices_size = num_entries * sizeof(NameSlice);
+    // Poolin perässä 16 nollatavua: sampler kopioi nimet 16 tavun paloina
+    char *block = (char *)calloc(1, columns_size + rows_size + alias_size + ids_size + slices_size + pool_bytes + 16);
+    if (block == NULL) {
+        return NAMELIST_ERR_NOMEM;
+    }
+    CondColumn *columns = (CondColumn *)block;
+    CondRow *rows = (CondRow *)(block + columns_size);
+    AliasEntry *alias = (AliasEntry *)(block + columns_size + rows_size);
+    uint32_t *ids = (uint32_t *)(block + columns_size + rows_size + alias_size);
+    NameSlice *slices = (NameSlice *)(block + columns_size + rows_size + alias_size + ids_size);
+    char *pool = block + columns_size + rows_size + alias_size + ids_size + slices_size;
+
+    NameDict names;
+    name_dict_init(&names, pool);
+    size_t pool_used = 0;
+    uint32_t next = 0;
+    int result = NAMELIST_OK;
+
+    for (int d = 0; d < num_columns && result == NAMELIST_OK; d++) {
+        const NameList *firsts = &first->lists[d];
+        CondColumn *column = &columns[d];
+        column->rows = rows;
+        column->num_rows = firsts->count;
+        column->num_pairs = 0;
+
+        // 2. Varajakauma: vuosikymmenen keskinimilista sellaisenaan (alias-taulun
+        // indeksit ovat jo suhteessa listaan)
+        uint32_t fallback_start = next, fallback_count = 0;
+        if (d < middle->num_decades) {
+            const NameList *list = &middle->lists[d];
+            for (int i = 0; i < list->count; i++) {
+                ids[next + (uint32_t)i] = intern(&names, pool, &pool_used, name_at(list, i),
+                                                 (uint32_t)name_length(list, i));
+                if (list->alias != NULL) {
+                    alias[next + (uint32_t)i] = list->alias[i];
+                } else {
+                    alias[next + (uint32_t)i].prob = UINT32_MAX;
+                    alias[next + (uint32_t)i].alias = (uint32_t)i;
+                }
+            }
+            fallback_count = (uint32_t)list->count;
+            next += fallback_count;
+        }
+
+        // 3. Parit ryhmitellään etunimen mukaan
+        int pc = find_column(pairs, first->decades[d]);
+        const NameList *pair_list = (pc >= 0) ? &pairs->lists[pc] : NULL;
+        int num_pairs = (pair_list != NULL) ? pair_list->count : 0;
+        PairScratch s;
+        memset(&s, 0, sizeof(s));
+        s.scratch = (char *)malloc(((pair_list != NULL) ? list_bytes(pair_list) : 0) + longest_first + 1);
+        s.group = (int *)malloc(((size_t)num_pairs + 1) * sizeof(int));
+        s.middle = (uint32_t *)malloc(((size_t)num_pairs + 1) * sizeof(uint32_t));
+        s.weight = (double *)malloc(((size_t)num_pairs + 1) * sizeof(double));
+        s.order = (int *)malloc(((size_t)num_pairs + 1) * sizeof(int));
+        s.row_weight = (double *)malloc(((size_t)num_pairs + 1) * sizeof(double));
+        name_dict_init(&s.firsts, s.scratch);
+        if (s.scratch == NULL || s.group == NULL || s.middle == NULL || s.weight == NULL ||
+            s.order == NULL || s.row_weight == NULL) {
+            free_scratch(&s);
+            result = NAMELIST_ERR_NOMEM;
+            break;
+        }
+
+        for (int k = 0; k < num_pairs; k++) {
+            const char *pair = name_at(pair_list, k);
+            uint32_t length = (uint32_t)name_length(pair_list, k);
+            const char *space = (const char *)memchr(pair, ' ', length);
+            s.group[k] = -1;
+            if (space == NULL || space == pair || space + 1 == pair + length) {
+                continue; // Ei kahta nimeä
+            }
+            uint32_t first_length = (uint32_t)(space - pair);
+            memcpy(s.scratch + s.scratch_used, pair, first_length);
+            uint32_t g = name_dict_find(&s.firsts, s.scratch + s.scratch_used, first_length);
+            if (g == NAME_DICT_NONE) {
+                g = name_dict_add(&s.firsts, (uint32_t)s.scratch_used, first_length);
+                s.scratch_used += first_length;
+            }
+            s.group[k] = (int)g;
+            s.middle[k] = intern(&names, pool, &pool_used, space + 1, (uint32_t)(pair + length - space - 1));
+            s.weight[k] = (pair_list->counts != NULL) ? (double)pair_list->counts[k] :
+                          weighted ? pow((double)k + 1.0, -zipf_exponent) : 1.0;
+            column->num_pairs++;
+        }
+        if (s.firsts.error != 0 || names.error != 0) {
+            free_scratch(&s);
+            result = NAMELIST_ERR_NOMEM;
+            break;
+        }
+
+        uint32_t num_groups = s.firsts.count;
+        s.group_start = (int *)calloc((size_t)num_groups + 1, sizeof(int));
+        s.cursor = (int *)malloc(((size_t)num_groups + 1) * sizeof(int));
+        uint32_t *group_entry = (uint32_t *)malloc(((size_t)num_groups + 1) * 2 * sizeof(uint32_t));
+        double *group_mass = (double *)calloc((size_t)num_groups + 1, sizeof(double));
+        if (s.group_start == NULL || s.cursor == NULL || group_entry == NULL || group_mass == NULL) {
+            free(group_entry);
+            free(group_mass);
+            free_scratch(&s);
+            result = NAMELIST_ERR_NOMEM;
+            break;
+        }
+        for (int k = 0; k < num_pairs; k++) {
+            if (s.group[k] >= 0) {
+                s.group_start[s.group[k] + 1]++;
+            }
+        }
+        for (uint32_t g = 0; g < num_groups; g++) {
+            s.group_start[g + 1] += s.group_start[g];
+        }
+        memcpy(s.cursor, s.group_start, ((size_t)num_groups + 1) * sizeof(int));
+        for (int k = 0; k < num_pairs; k++) {
+            if (s.group[k] >= 0) {
+                s.order[s.cursor[s.group[k]]++] = k;
+            }
+        }
+
+        // 4. Ryhmän rivi: eri keskinimet painoineen ja oma alias-taulu
+        for (uint32_t g = 0; g < num_groups && result == NAMELIST_OK; g++) {
+            uint32_t start = next, count = 0;
+            for (int j = s.group_start[g]; j < s.group_start[g + 1]; j++) {
+                int k = s.order[j];
+                uint32_t slot = 0;
+                while (slot < count && ids[start + slot] != s.middle[k]) {
+                    slot++;
+                }
+                if (slot == count) {
+                    ids[start + count] = s.middle[k];
+                    s.row_weight[count++] = 0.0;
+                }
+                s.row_weight[slot] += s.weight[k];
+                group_mass[g] += s.weight[k];
+            }
+            if (alias_build(alias + start, s.row_weight, count) != 0) {
+                result = NAMELIST_ERR_NOMEM;
+            }
+            group_entry[2 * g] = start;
+            group_entry[2 * g + 1] = count;
+            next += count;
+        }
+
+        // 5. Rivi jokaiselle etunimelle: oma ryhmä tai varajakauma
+        int counted = (firsts->counts != NULL && pair_list != NULL && pair_list->counts != NULL);
+        for (int i = 0; i < firsts->count && result == NAMELIST_OK; i++) {
+            uint32_t length = (uint32_t)name_length(firsts, i);
+            memcpy(s.scratch + s.scratch_used, name_at(firsts, i), length);
+            uint32_t g = name_dict_find(&s.firsts, s.scratch + s.scratch_used, length);
+            if (g == NAME_DICT_NONE) {
+                rows[i].start = fallback_start;
+                rows[i].count = fallback_count;
+                rows[i].skip = skip_for(COND_DEFAULT_MIDDLE);
+                continue;
+            }
+            rows[i].start = group_entry[2 * g];
+            rows[i].count = group_entry[2 * g + 1];
+            double p = COND_DEFAULT_MIDDLE;
+            if (counted && firsts->counts[i] > 0) {
+                p = group_mass[g] / (double)firsts->counts[i];
+            }
+            rows[i].skip = skip_for(p);
+        }
+        rows += firsts->count;
+
+        free(group_entry);
+        free(group_mass);
+        free_scratch(&s);
+    }
+
+    if (result == NAMELIST_OK && names.error != 0) {
+        result = NAMELIST_ERR_NOMEM;
+    }
+    if (result != NAMELIST_OK) {
+        name_dict_free(&names);
+        free(block);
+        return result;
+    }
+
+    // Sanakirja kopioidaan lohkoon, jolloin väliaikainen taulukko voidaan vapauttaa
+    memcpy(slices, names.names, (size_t)names.count * sizeof(NameSlice));
+    table->columns = columns;
+    table->num_columns = num_columns;
+    table->alias = alias;
+    table->ids = ids;
+    table->names.pool = pool;
+    table->names.slices = slices;
+    table->names.count = (int)names.count;
+    table->block = block;
+    name_dict_free(&names);
+    return NAMELIST_OK;
+}
+
+void cond_table_free(CondTable *table) {
+    free(table->block);
+    memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,96 @@
+/**
+* @file condtable.h
+* @brief Middle-name tables conditioned on the first name (CSR rows with per-row alias tables).
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CONDTABLE_H
+#define CONDTABLE_H
+
+#include <stdint.h>
+
+#include "alias.h"
+#include "namelist.h"
+
+// Keskinimen valinta etunimen mukaan. Nimiyhdistelmätiedoston ("Juho Kustaa")
+// parit kootaan vuosikymmenittäin riveiksi: jokaisella etunimilistan paikalla
+// on oma rivi, jonka keskinimet ovat peräkkäin yhteisissä taulukoissa (CSR)
+// omine alias-tauluineen. Etunimet, joita yhdistelmissä ei ole, osoittavat
+// vuosikymmenen tavalliseen keskinimilistaan (varajakauma), joten otannassa
+// on aina täsmälleen yksi rivin haku eikä erillistä tarkistusta.
+
+// Yksi rivi: keskinimet [start, start + count) ja keskinimen todennäköisyys
+typedef struct {
+    uint32_t start;      // Ensimmäinen keskinimi alias- ja ids-taulukoissa
+    uint32_t count;      // Keskinimiä rivillä (0 = ei koskaan keskinimeä)
+    uint64_t skip;       // Keskinimi tulee, jos kolikko >= skip, eli skip = (1 - p) * 2^64
+} CondRow;
+
+// Yhden vuosikymmenen rivit (yksi per etunimilistan paikka)
+typedef struct {
+    const CondRow *rows;
+    int num_rows;
+    int num_pairs;       // Yhdistelmätiedoston pareja tällä vuosikymmenellä
+} CondColumn;
+
+// Kaikkien vuosikymmenten taulut. Keskinimet kopioidaan taulun omaan pooliin
+// sanakirjaksi, joten yhdistelmien ja varalistan nimet ovat samassa paikassa.
+// names on sanakirjan näkymä (tunniste = indeksi), jota otanta käyttää
+// keskinimilistana.
+typedef struct {
+    CondColumn *columns;     // Yksi per etunimien vuosikymmen
+    int num_columns;
+    const AliasEntry *alias; // Rivin sisäiset alias-taulut (indeksit suhteessa riviin)
+    const uint32_t *ids;     // Keskinimien tunnisteet sanakirjaan
+    NameList names;          // Sanakirja (pool ja slices osoittavat lohkoon)
+    void *block;             // Ainoa varattu muistilohko
+} CondTable;
+
+// Keskinimen todennäköisyys riveillä, joille sitä ei voi laskea lukumääristä
+// (sama kuin riippumattomassa otannassa)
+#define COND_DEFAULT_MIDDLE 0.5
+
+// Rakentaa taulut. first ja middle ovat etu- ja keskinimien vuosikymmenet,
+// pairs yhdistelmätiedosto; sarakkeet yhdistetään otsikon perusteella. Jos
+// weighted on nollasta poikkeava, parit painotetaan lukumääräsarakkeella tai
+// sijan mukaan (Zipf) ja varajakauma keskinimilistan alias-taululla; muuten
+// rivin keskinimet ovat yhtä todennäköisiä. Keskinimen todennäköisyys lasketaan
+// lukumääristä (parien määrä / etunimen määrä), jos molemmissa tiedostoissa
+// on lukumääräsarake. Palauttaa NAMELIST_OK tai NAMELIST_ERR_NOMEM.
+int cond_table_build(CondTable *table, const DecadeData *first, const DecadeData *middle,
+                     const DecadeData *pairs, int weighted, double zipf_exponent);
+
+void cond_table_free(CondTable *table);
+
+// Arpoo rivin keskinimen kolikolla ja yhdellä luvulla. Palauttaa tunnisteen
+// tai UINT32_MAX, jos keskinimeä ei tule.
+static inline uint32_t cond_sample(const CondTable *table, const CondRow *row,
+                                   uint64_t coin_word, uint64_t middle_word) {
+    if (row->count == 0 || coin_word < row->skip) {
+        return UINT32_MAX;
+    }
+    uint32_t slot = (uint32_t)(((middle_word >> 32) * (uint64_t)row->count) >> 32);
+    AliasEntry entry = table->alias[row->start + slot];
+    uint32_t k = ((uint32_t)middle_word < entry.prob) ? slot : entry.alias;
+    return table->ids[row->start + k];
+}
+
+#endif // CONDTABLE_H
@@ -0,0 +1,446 @@
+/**
+* @file corpus.c
+* @brief Precompiled binary name corpus that is used straight from mmap.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "corpus.h"
+#include "namedict.h"
+#include "stats.h"
+
+// Osiot alkavat 8 tavun rajalta
+#define CORPUS_ALIGN(x) (((x) + 7) & ~(uint64_t)7)
+
+// --- 1. LUKEMINEN ---
+
+// Funktio tarkistaa, että osio [offset, offset + count * size) on tiedoston sisällä
+static int section_fits(const CorpusHeader *header, uint64_t offset, uint64_t count, uint64_t size) {
+    if (offset % 8 != 0 || offset > header->file_size) {
+        return 0;
+    }
+    return count <= (header->file_size - offset) / size;
+}
+
+int corpus_verify(const Corpus *corpus) {
+    const CorpusHeader *header = corpus->header;
+    for (uint32_t n = 0; n < header->num_names; n++) {
+        if ((uint64_t)corpus->names[n].offset + corpus->names[n].length >= header->pool_size) {
+            return NAMELIST_ERR_FORMAT;
+        }
+    }
+    for (uint32_t l = 0; l < header->num_lists; l++) {
+        const CorpusList *list = &corpus->lists[l];
+        const AliasEntry *alias = corpus->alias + list->first_entry;
+        for (uint32_t i = 0; i < list->count; i++) {
+            uint64_t entry = list->first_entry + i;
+            uint32_t id = (header->id_width == 2) ? ((const uint16_t *)corpus->ids)[entry]
+                                                  : ((const uint32_t *)corpus->ids)[entry];
+            if (id >= header->num_names || alias[i].alias >= list->count) {
+                return NAMELIST_ERR_FORMAT;
+            }
+        }
+    }
+    return NAMELIST_OK;
+}
+
+int corpus_open(const char *filename, Corpus *corpus) {
+    memset(corpus, 0, sizeof(*corpus));
+
+    uint64_t start = stats_begin();
+    if (map_file(filename, &corpus->file) != 0) {
+        return NAMELIST_ERR_IO;
+    }
+    stats_end(STATS_MAP, start);
+    stats_count(STATS_FILES, 1);
+    stats_count(STATS_FILE_BYTES, corpus->file.size);
+
+    const CorpusHeader *header = (const CorpusHeader *)corpus->file.data;
+    if (corpus->file.size < sizeof(CorpusHeader) ||
+        memcmp(header->magic, CORPUS_MAGIC, sizeof(header->magic)) != 0) {
+        corpus_close(corpus);
+        return NAMELIST_ERR_FORMAT;
+    }
+
+    if (header->version != CORPUS_VERSION || header->byte_order != CORPUS_BYTE_ORDER) {
+        corpus_close(corpus);
+        return NAMELIST_ERR_VERSION;
+    }
+
+    // Rakenne tarkistetaan osioiden tasolla. Nimiä ei käydä läpi, jotta
+    // avaaminen ei riipu korpuksen koosta.
+    if (header->file_size != corpus->file.size ||
+        !section_fits(header, header->tables_offset, header->num_tables, sizeof(CorpusTable)) ||
+        !section_fits(header, header->lists_offset, header->num_lists, sizeof(CorpusList)) ||
+        (header->id_width != 2 && header->id_width != 4) ||
+        !section_fits(header, header->names_offset, header->num_names, sizeof(NameSlice)) ||
+        !section_fits(header, header->alias_offset, header->num_entries, sizeof(AliasEntry)) ||
+        !section_fits(header, header->ids_offset, header->num_entries, header->id_width) ||
+        !section_fits(header, header->pool_offset, header->pool_size, 1) ||
+        !section_fits(header, header->models_offset, header->models_size, 1) ||
+        header->pool_size > UINT32_MAX) {
+        corpus_close(corpus);
+        return NAMELIST_ERR_FORMAT;
+    }
+
+    const char *base = corpus->file.data;
+    corpus->header = header;
+    corpus->tables = (const CorpusTable *)(base + header->tables_offset);
+    corpus->lists = (const CorpusList *)(base + header->lists_offset);
+    corpus->names = (const NameSlice *)(base + header->names_offset);
+    corpus->alias = (const AliasEntry *)(base + header->alias_offset);
+    corpus->ids = base + header->ids_offset;
+    corpus->pool = base + header->pool_offset;
+
+    for (uint32_t t = 0; t < header->num_tables; t++) {
+        const CorpusTable *table = &corpus->tables[t];
+        if ((uint64_t)table->first_list + table->num_lists > header->num_lists ||
+            (uint64_t)table->name_offset + table->name_length >= header->pool_size) {
+            corpus_close(corpus);
+            return NAMELIST_ERR_FORMAT;
+        }
+    }
+    for (uint32_t l = 0; l < header->num_lists; l++) {
+        const CorpusList *list = &corpus->lists[l];
+        if (list->first_entry > header->num_entries ||
+            list->count > header->num_entries - list->first_entry ||
+            (uint64_t)list->header_offset + list->header_length >= header->pool_size ||
+            (list->model_size > 0 && (list->model_offset < header->models_offset ||
+                                      !section_fits(header, list->model_offset, list->model_size, 1) ||
+                                      list->model_offset + list->model_size >
+                                      header->models_offset + header->models_size))) {
+            corpus_close(corpus);
+            return NAMELIST_ERR_FORMAT;
+        }
+    }
+
+    return NAMELIST_OK;
+}
+
+void corpus_close(Corpus *corpus) {
+    unmap_file(&corpus->file);
+    memset(corpus, 0, sizeof(*corpus));
+}
+
+int corpus_find_table(const Corpus *corpus, const char *name) {
+    size_t name_len = strlen(name);
+    for (uint32_t t = 0; t < corpus->header->num_tables; t++) {
+        const CorpusTable *table = &corpus->tables[t];
+        if (table->name_length == name_len &&
+            memcmp(corpus->pool + table->name_offset, name, name_len) == 0) {
+            return (int)t;
+        }
+    }
+    return -1;
+}
+
+int corpus_table_view(const Corpus *corpus, int table_index, DecadeData *data) {
+    memset(data, 0, sizeof(*data));
+    if (table_index < 0 || (uint32_t)table_index >= corpus->header->num_tables) {
+        return NAMELIST_ERR_FORMAT;
+    }
+
+    const CorpusTable *table = &corpus->tables[table_index];
+    int num_decades = (int)table->num_lists;
+    size_t lists_size = (size_t)num_decades * sizeof(NameList);
+
+    // Lohkon rakenne: [NameList * n][otsikko-osoittimet * n]
+    char *block = (char *)malloc(lists_size + (size_t)num_decades * sizeof(char *) + 1);
+    if (block == NULL) {
+        return NAMELIST_ERR_NOMEM;
+    }
+
+    NameList *lists = (NameList *)block;
+    const char **decades = (const char **)(block + lists_size);
+    for (int col = 0; col < num_decades; col++) {
+        const CorpusList *source = &corpus->lists[table->first_list + (uint32_t)col];
+        memset(&lists[col], 0, sizeof(NameList));
+        lists[col].pool = corpus->pool;
+        lists[col].slices = corpus->names;
+        lists[col].ids = (const char *)corpus->ids + source->first_entry * corpus->header->id_width;
+        lists[col].id_width = (int)corpus->header->id_width;
+        lists[col].count = (int)source->count;
+        lists[col].alias = corpus->alias + source->first_entry;
+        decades[col] = corpus->pool + source->header_offset;
+    }
+
+    data->decades = decades;
+    data->lists = lists;
+    data->num_decades = num_decades;
+    data->num_names = corpus->header->num_names;
+    data->block = block;
+    return NAMELIST_OK;
+}
+
+int corpus_list_model(const Corpus *corpus, int table_index, int column, MarkovModel *model) {
+    memset(model, 0, sizeof(*model));
+    if (table_index < 0 || (uint32_t)table_index >= corpus->header->num_tables ||
+        column < 0 || (uint32_t)column >= corpus->tables[table_index].num_lists) {
+        return NAMELIST_ERR_FORMAT;
+    }
+    const CorpusList *list = &corpus->lists[corpus->tables[table_index].first_list + (uint32_t)column];
+    if (list->model_size == 0) {
+        return NAMELIST_OK;
+    }
+    // Sijainti on tarkistettu avattaessa, rakenne tarkistetaan vasta käytettäessä
+    return markov_view(model, corpus->file.data + list->model_offset, (size_t)list->model_size);
+}
+
+// --- 2. KIRJOITTAMINEN ---
+
+// Funktio lisää merkkijonon pooliin NUL-päätteisenä ja palauttaa sen paikan
+static uint32_t pool_append(char *pool, uint64_t *pool_len, const char *str, size_t len) {
+    uint32_t offset = (uint32_t)*pool_len;
+    memcpy(pool + offset, str, len);
+    pool[offset + len] = '\0';
+    *pool_len += len + 1;
+    return offset;
+}
+
+// Funktio lisää kaikkien taulujen nimet sanakirjaan. Sanakirjan pooli on
+// korpuksen oma pooli, johon uusi nimi kopioidaan ensimmäisellä kerralla.
+// Lopuksi *pool_len on käytetyn poolin pituus.
+static int intern_names(NameDict *dict, char *pool, uint64_t *pool_len,
+                        const DecadeData *tables, int num_tables) {
+    for (int t = 0; t < num_tables; t++) {
+        for (int col = 0; col < tables[t].num_decades; col++) {
+            const NameList *list = &tables[t].lists[col];
+            for (int i = 0; i < list->count; i++) {
+                uint32_t length = (uint32_t)name_length(list, i);
+                if (name_dict_find(dict, name_at(list, i), length) == NAME_DICT_NONE) {
+                    uint32_t offset = pool_append(pool, pool_len, name_at(list, i), length);
+                    if (name_dict_add(dict, offset, length) == NAME_DICT_NONE) {
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int corpus_write(const char *filename, const char *const *names,
+                 const DecadeData *tables, int num_tables, double zipf_exponent, int markov_order) {
+    // 1. Lasketaan osioiden koot. Poolin yläraja olettaa, ettei yksikään nimi toistu;
+    // nimet kootaan ensin väliaikaiseen pooliin, ja tiedostoon tulee vain käytetty osa.
+    uint64_t num_lists = 0;
+    uint64_t num_entries = 0;
+    uint64_t names_size = 0;
+    uint64_t strings_size = 0;
+    for (int t = 0; t < num_tables; t++) {
+        strings_size += strlen(names[t]) + 1;
+        for (int col = 0; col < tables[t].num_decades; col++) {
+            const NameList *list = &tables[t].lists[col];
+            strings_size += strlen(tables[t].decades[col]) + 1;
+            for (int i = 0; i < list->count; i++) {
+                names_size += name_length(list, i) + 1;
+            }
+            num_entries += (uint64_t)list->count;
+            num_lists++;
+        }
+    }
+
+    if (names_size + strings_size > UINT32_MAX || num_lists > UINT32_MAX) {
+        fprintf(stderr, "ERROR: Corpus would exceed 4 GiB of strings.\n");
+        return -1;
+    }
+
+    char *pool = (char *)calloc(1, (size_t)(names_size + strings_size) + 1);
+    if (pool == NULL) {
+        perror("Memory allocation failed (corpus pool)");
+        return -1;
+    }
+    uint64_t pool_len = 0;
+    NameDict dict;
+    name_dict_init(&dict, pool);
+    if (intern_names(&dict, pool, &pool_len, tables, num_tables) != 0) {
+        perror("Memory allocation failed (corpus dictionary)");
+        name_dict_free(&dict);
+        free(pool);
+        return -1;
+    }
+    uint64_t pool_size = pool_len + strings_size;
+
+    // Mallit opetetaan ennen kuin tiedoston koko tiedetään
+    MarkovModel *models = (MarkovModel *)calloc((size_t)num_lists + 1, sizeof(MarkovModel));
+    uint64_t models_size = 0;
+    if (models == NULL) {
+        perror("Memory allocation failed (corpus models)");
+        name_dict_free(&dict);
+        free(pool);
+        return -1;
+    }
+    uint64_t model_index = 0;
+    for (int t = 0; t < num_tables && markov_order > 0; t++) {
+        for (int col = 0; col < tables[t].num_decades; col++) {
+            int status = markov_train(&models[model_index], &tables[t].lists[col], markov_order);
+            if (status != NAMELIST_OK) {
+                fprintf(stderr, "ERROR: Could not train the name model of %s: %s\n", names[t],
+                        namelist_strerror(status));
+                for (uint64_t m = 0; m < model_index; m++) {
+                    markov_free(&models[m]);
+                }
+                free(models);
+                name_dict_free(&dict);
+                free(pool);
+                return -1;
+            }
+            models_size += CORPUS_ALIGN((uint64_t)models[model_index++].size);
+        }
+    }
+
+    CorpusHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CORPUS_MAGIC, sizeof(header.magic));
+    header.version = CORPUS_VERSION;
+    header.byte_order = CORPUS_BYTE_ORDER;
+    header.num_tables = (uint32_t)num_tables;
+    header.num_lists = (uint32_t)num_lists;
+    header.num_names = dict.count;
+    header.id_width = (uint32_t)name_dict_id_width(dict.count);
+    header.num_entries = num_entries;
+    header.tables_offset = CORPUS_ALIGN(sizeof(CorpusHeader));
+    header.lists_offset = CORPUS_ALIGN(header.tables_offset + (uint64_t)num_tables * sizeof(CorpusTable));
+    header.names_offset = CORPUS_ALIGN(header.lists_offset + num_lists * sizeof(CorpusList));
+    header.alias_offset = CORPUS_ALIGN(header.names_offset + (uint64_t)dict.count * sizeof(NameSlice));
+    header.ids_offset = CORPUS_ALIGN(header.alias_offset + num_entries * sizeof(AliasEntry));
+    header.pool_offset = CORPUS_ALIGN(header.ids_offset + num_entries * header.id_width);
+    header.pool_size = pool_size;
+    header.zipf_exponent = zipf_exponent;
+    header.markov_order = (markov_order > 0) ? (uint32_t)markov_order : 0;
+    header.models_offset = CORPUS_ALIGN(header.pool_offset + pool_size);
+    header.models_size = models_size;
+    header.file_size = header.models_offset + models_size;
+
+    // 2. Kootaan koko tiedosto muistiin (nollat täyttävät tasausvälit)
+    char *image = (char *)calloc(1, (size_t)header.file_size);
+    if (image == NULL) {
+        perror("Memory allocation failed (corpus image)");
+        for (uint64_t m = 0; m < model_index; m++) {
+            markov_free(&models[m]);
+        }
+        free(models);
+        name_dict_free(&dict);
+        free(pool);
+        return -1;
+    }
+
+    CorpusTable *out_tables = (CorpusTable *)(image + header.tables_offset);
+    CorpusList *out_lists = (CorpusList *)(image + header.lists_offset);
+    AliasEntry *out_alias = (AliasEntry *)(image + header.alias_offset);
+    char *out_ids = image + header.ids_offset;
+    char *out_pool = image + header.pool_offset;
+    memcpy(image + header.names_offset, dict.names, (size_t)dict.count * sizeof(NameSlice));
+    memcpy(out_pool, pool, (size_t)pool_len);
+    uint64_t list_index = 0;
+    uint64_t entry_index = 0;
+    uint64_t model_at = header.models_offset;
+
+    for (int t = 0; t < num_tables; t++) {
+        CorpusTable *table = &out_tables[t];
+        table->name_length = (uint32_t)strlen(names[t]);
+        table->name_offset = pool_append(out_pool, &pool_len, names[t], table->name_length);
+        table->first_list = (uint32_t)list_index;
+        table->num_lists = (uint32_t)tables[t].num_decades;
+
+        for (int col = 0; col < tables[t].num_decades; col++) {
+            const NameList *list = &tables[t].lists[col];
+            CorpusList *out_list = &out_lists[list_index++];
+            out_list->header_length = (uint32_t)strlen(tables[t].decades[col]);
+            out_list->header_offset = pool_append(out_pool, &pool_len, tables[t].decades[col],
+                                                  out_list->header_length);
+            out_list->first_entry = entry_index;
+            out_list->count = (uint32_t)list->count;
+            out_list->flags = (list->counts != NULL) ? CORPUS_LIST_COUNTS : 0;
+            if (markov_order > 0) {
+                const MarkovModel *model = &models[list_index - 1];
+                memcpy(image + model_at, model->image, model->size);
+                out_list->model_offset = model_at;
+                out_list->model_size = model->size;
+                model_at += CORPUS_ALIGN((uint64_t)model->size);
+            }
+
+            for (int i = 0; i < list->count; i++) {
+                if (list->alias != NULL) {
+                    out_alias[entry_index] = list->alias[i];
+                } else {
+                    out_alias[entry_index].prob = UINT32_MAX;
+                    out_alias[entry_index].alias = (uint32_t)i;
+                }
+                uint32_t id = name_dict_find(&dict, name_at(list, i), (uint32_t)name_length(list, i));
+                name_dict_store_id(out_ids, (int)header.id_width, (size_t)entry_index++, id);
+            }
+        }
+    }
+    for (uint64_t m = 0; m < model_index; m++) {
+        markov_free(&models[m]);
+    }
+    free(models);
+    name_dict_free(&dict);
+    free(pool);
+
+    memcpy(image, &header, sizeof(header));
+
+    // 3. Kirjoitetaan väliaikaiseen tiedostoon ja nimetään valmiina
+    size_t tmp_len = strlen(filename) + 5;
+    char *tmp_name = (char *)malloc(tmp_len);
+    if (tmp_name == NULL) {
+        free(image);
+        return -1;
+    }
+    snprintf(tmp_name, tmp_len, "%s.tmp", filename);
+
+    int result = 0;
+    FILE *file = fopen(tmp_name, "wb");
+    if (file == NULL) {
+        perror("Error opening corpus file");
+        result = -1;
+    } else {
+        if (fwrite(image, 1, (size_t)header.file_size, file) != header.file_size) {
+            result = -1;
+        }
+        if (fclose(file) != 0) {
+            result = -1;
+        }
+        if (result != 0) {
+            perror("Error writing corpus file");
+            remove(tmp_name);
+        }
+    }
+
+#ifdef _WIN32
+    if (result == 0) {
+        remove(filename); // Windowsin rename ei korvaa olemassa olevaa tiedostoa
+    }
+#endif
+    if (result == 0 && rename(tmp_name, filename) != 0) {
+        perror("Error renaming corpus file");
+        remove(tmp_name);
+        result = -1;
+    }
+
+    free(tmp_name);
+    free(image);
+    return result;
+}
@@ -0,0 +1,153 @@
+/**
+* @file corpus.h
+* @brief Precompiled binary name corpus that is used straight from mmap.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdint.h>
+
+#include "csvscan.h"
+#include "markov.h"
+#include "namelist.h"
+
+// Tiedostomuodon tunniste ja versio. Versio kasvaa aina, kun rakenne tai
+// sisällön sopimus muuttuu (versiosta 5 alkaen nimet ovat normalisoitua UTF-8:aa).
+#define CORPUS_MAGIC "NGCORPUS"
+#define CORPUS_VERSION 5
+#define CORPUS_BYTE_ORDER 0x01020304u
+
+// --- TIEDOSTOMUOTO ---
+// Kaikki osiot alkavat 8 tavun rajalta, joten rakenteita voi lukea suoraan
+// kuvauksesta. Merkkijonot (nimet ja otsikot) ovat NUL-päätteisiä poolissa.
+// Korpuksella on yksi sanakirja: jokainen eri nimi on poolissa kerran, vaikka
+// se esiintyisi kaikissa tauluissa ja sarakkeissa, ja listoissa on vain
+// tunnisteet. Tunniste tarkoittaa samaa nimeä kaikissa tauluissa.
+//
+//   CorpusHeader
+//   CorpusTable[num_tables]   yksi taulu per lähdetiedosto
+//   CorpusList[num_lists]     yksi lista per vuosikymmensarake
+//   NameSlice[num_names]      sanakirja: eri nimien paikat poolissa
+//   AliasEntry[num_entries]   painotetut otantataulut, listoittain peräkkäin
+//   uint16/32[num_entries]    listojen nimien tunnisteet (leveys id_width)
+//   char pool[pool_size]      merkkijonot
+//   Markov-mallit             yksi per lista (markov.h), 8 tavun rajoilla
+
+typedef struct {
+    char magic[8];           // CORPUS_MAGIC
+    uint32_t version;        // CORPUS_VERSION
+    uint32_t byte_order;     // CORPUS_BYTE_ORDER kirjoittajan tavujärjestyksessä
+    uint64_t file_size;      // Koko tiedoston pituus
+    uint32_t num_tables;
+    uint32_t num_lists;
+    uint32_t num_names;      // Sanakirjan koko
+    uint32_t id_width;       // Tunnisteen koko tavuina (2 tai 4)
+    uint64_t num_entries;    // Nimiä kaikissa listoissa yhteensä
+    uint64_t tables_offset;
+    uint64_t lists_offset;
+    uint64_t names_offset;
+    uint64_t alias_offset;
+    uint64_t ids_offset;
+    uint64_t pool_offset;
+    uint64_t pool_size;
+    double zipf_exponent;    // Eksponentti, jolla lukumäärättömät listat painotettiin
+    uint32_t markov_order;   // Mallien järjestys (0 = ei malleja)
+    uint32_t reserved;
+    uint64_t models_offset;
+    uint64_t models_size;
+} CorpusHeader;
+
+// Yksi lähdetiedosto (esim. "Finnish-men-firts-names.csv")
+typedef struct {
+    uint32_t name_offset;    // Taulun nimi poolissa
+    uint32_t name_length;
+    uint32_t first_list;     // Ensimmäinen sarake CorpusList-taulukossa
+    uint32_t num_lists;      // Sarakkeiden (vuosikymmenten) määrä
+} CorpusTable;
+
+// CorpusList.flags: painot tulivat lähdetiedoston lukumääräsarakkeesta
+#define CORPUS_LIST_COUNTS 0x1u
+
+// Yksi vuosikymmensarake. Sen tunnisteet ovat alueella [first_entry,
+// first_entry + count) ja alias-taulu samalla alueella AliasEntry-taulukossa.
+typedef struct {
+    uint32_t header_offset;  // Vuosikymmenen otsikko poolissa ("1870–79")
+    uint32_t header_length;
+    uint64_t first_entry;    // Ensimmäinen nimi tunniste- ja alias-taulukoissa
+    uint32_t count;          // Nimien määrä
+    uint32_t flags;          // CORPUS_LIST_*
+    uint64_t model_offset;   // Listan Markov-malli tiedoston alusta (koko 0 = ei mallia)
+    uint64_t model_size;
+} CorpusList;
+
+// Avattu korpus: kaikki osoittimet osoittavat suoraan kuvattuun tiedostoon
+typedef struct {
+    MappedFile file;
+    const CorpusHeader *header;
+    const CorpusTable *tables;
+    const CorpusList *lists;
+    const NameSlice *names;  // Sanakirja
+    const AliasEntry *alias;
+    const void *ids;
+    const char *pool;
+} Corpus;
+
+// Kuvaa korpustiedoston muistiin ja tarkistaa sen rakenteen. Palauttaa
+// NAMELIST_OK tai virhekoodin (NAMELIST_ERR_IO, _FORMAT tai _VERSION).
+int corpus_open(const char *filename, Corpus *corpus);
+
+// Käy avatun korpuksen nimet ja listat läpi: nimet ovat poolissa, tunnisteet
+// sanakirjassa ja alias-viittaukset oman listansa sisällä. Generointi ei
+// tarkista näitä. Lukee koko korpuksen (ngcompile --verify). Palauttaa
+// NAMELIST_OK tai NAMELIST_ERR_FORMAT.
+int corpus_verify(const Corpus *corpus);
+
+// Vapauttaa korpuksen kuvauksen. Näkymät (corpus_table_view) on vapautettava ensin.
+void corpus_close(Corpus *corpus);
+
+// Etsii taulun lähdetiedoston nimellä. Palauttaa indeksin tai -1.
+int corpus_find_table(const Corpus *corpus, const char *name);
+
+// Täyttää DecadeDatan, jonka listat osoittavat suoraan korpukseen. Ainoa
+// varaus on sarakkeiden NameList-taulukko; nimiä ei kopioida eikä jäsennetä.
+// Listojen alias-taulut osoittavat korpuksen valmiisiin tauluihin; tasaista
+// otantaa varten kutsuja asettaa ne NULLiksi.
+// Vapautetaan tavalliseen tapaan free_decade_data-funktiolla. Palauttaa
+// NAMELIST_OK, NAMELIST_ERR_FORMAT (ei taulua) tai NAMELIST_ERR_NOMEM.
+int corpus_table_view(const Corpus *corpus, int table, DecadeData *data);
+
+// Avaa taulun sarakkeen Markov-mallin suoraan kuvauksesta. Jos korpuksessa ei
+// ole malleja, model jää tyhjäksi (header NULL) ja paluuarvo on NAMELIST_OK.
+// NAMELIST_ERR_FORMAT virheelliselle taululle, sarakkeelle tai mallille.
+int corpus_list_model(const Corpus *corpus, int table, int column, MarkovModel *model);
+
+// Kirjoittaa taulut korpustiedostoksi. names[i] on taulun i nimi ja tables[i]
+// sen sisältö. Listoilta, joilla ei ole alias-taulua, kirjoitetaan tasainen taulu.
+// zipf_exponent tallennetaan otsakkeeseen tiedoksi. Jos markov_order > 0,
+// jokaiselle listalle opetetaan sen järjestyksen Markov-malli. Tiedosto
+// kirjoitetaan ensin väliaikaisena ja nimetään lopuksi, joten samanaikaiset
+// lukijat näkevät vain valmiin tiedoston.
+int corpus_write(const char *filename, const char *const *names,
+                 const DecadeData *tables, int num_tables, double zipf_exponent, int markov_order);
+
+#endif // CORPUS_H
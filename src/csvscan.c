@@ -0,0 +1,289 @@
+/**
+* @file csvscan.c
+* @brief Zero-copy CSV scanner over memory-mapped files.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CSVSCAN_SSE2 1
+#endif
+
+#include "csvscan.h"
+
+// --- 1. TIEDOSTON KUVAUS MUISTIIN ---
+
+int map_file_copies = 0;
+
+#ifdef _WIN32
+
+// Windowsissa tiedosto luetaan kokonaan muistiin
+int map_file(const char *filename, MappedFile *file) {
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(fp);
+        return size == 0 ? 0 : -1;
+    }
+
+    char *buffer = (char *)malloc((size_t)size);
+    if (buffer == NULL || fread(buffer, 1, (size_t)size, fp) != (size_t)size) {
+        free(buffer);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    file->data = buffer;
+    file->size = (size_t)size;
+    return 0;
+}
+
+void unmap_file(MappedFile *file) {
+    free((void *)file->data);
+    file->data = NULL;
+    file->size = 0;
+}
+
+#else
+
+// Funktio lukee avatun tiedoston puskuriin. Tiedosto voi lyhentyä luvun
+// aikana, joten koko on luettujen tavujen määrä.
+static int read_copy(int fd, size_t size, MappedFile *file) {
+    char *buffer = (char *)malloc(size + MAP_FILE_PADDING);
+    if (buffer == NULL) {
+        return -1;
+    }
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, buffer + done, size - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            free(buffer);
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+    if (done == 0) {
+        free(buffer);
+        return 0;
+    }
+    memset(buffer + done, 0, MAP_FILE_PADDING);
+    file->data = buffer;
+    file->size = done;
+    return 0;
+}
+
+int map_file(const char *filename, MappedFile *file) {
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Tyhjää tiedostoa ei voi kuvata, mutta se on silti kelvollinen
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    if (map_file_copies) {
+        int status = read_copy(fd, (size_t)st.st_size, file);
+        close(fd);
+        return status;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // Kuvaus pysyy voimassa ilman tiedostokahvaa
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    // Tiedosto luetaan alusta loppuun kerran
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    file->data = (const char *)data;
+    file->size = (size_t)st.st_size;
+    file->mapped = 1;
+    return 0;
+}
+
+void unmap_file(MappedFile *file) {
+    if (file->mapped) {
+        munmap((void *)file->data, file->size);
+    } else {
+        free((void *)file->data); // Normalisoitu kopio (utf8_normalize)
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+}
+
+#endif
+
+// --- 2. EROTINMERKKIEN HAKU ---
+
+// Palauttaa alimman asetetun bitin paikan (x != 0)
+static inline unsigned count_trailing_zeros(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctzll(x);
+#endif
+}
+
+// Funktio palauttaa bittimaskin, jossa bitti i on asetettu, jos p[i] on
+// ',', '\r' tai '\n'. Täysi 64 tavun lohko käsitellään SSE2:lla.
+static uint64_t delimiter_mask(const char *p, size_t n) {
+    uint64_t mask = 0;
+
+#ifdef CSVSCAN_SSE2
+    if (n == 64) {
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i lf = _mm_set1_epi8('\n');
+        const __m128i cr = _mm_set1_epi8('\r');
+        for (int k = 0; k < 4; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, comma),
+                                        _mm_or_si128(_mm_cmpeq_epi8(v, lf),
+                                                     _mm_cmpeq_epi8(v, cr)));
+            mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(hits) << (16 * k);
+        }
+        return mask;
+    }
+#endif
+
+    for (size_t i = 0; i < n; i++) {
+        char c = p[i];
+        if (c == ',' || c == '\n' || c == '\r') {
+            mask |= (uint64_t)1 << i;
+        }
+    }
+    return mask;
+}
+
+// Funktio etsii seuraavan erottimen kohdasta from alkaen (size, jos ei löydy)
+static size_t find_delimiter(CsvScanner *scanner, size_t from) {
+    while (from < scanner->size) {
+        size_t block = from & ~(size_t)63;
+        if (!scanner->has_block || block != scanner->block_start) {
+            size_t n = scanner->size - block;
+            if (n > 64) {
+                n = 64;
+            }
+            scanner->mask = delimiter_mask(scanner->data + block, n);
+            scanner->block_start = block;
+            scanner->has_block = 1;
+        }
+
+        uint64_t remaining = scanner->mask & (~(uint64_t)0 << (from - block));
+        if (remaining != 0) {
+            return block + count_trailing_zeros(remaining);
+        }
+        from = block + 64;
+    }
+    return scanner->size;
+}
+
+// --- 3. KENTTIEN LUKU ---
+
+void csv_scanner_init(CsvScanner *scanner, const char *data, size_t size) {
+    scanner->data = data;
+    scanner->size = size;
+    scanner->pos = 0;
+    scanner->block_start = 0;
+    scanner->mask = 0;
+    scanner->has_block = 0;
+    scanner->column = 0;
+    scanner->row = 0;
+}
+
+int csv_next_field(CsvScanner *scanner, CsvField *field) {
+    if (scanner->pos >= scanner->size) {
+        return 0;
+    }
+
+    size_t start = scanner->pos;
+    size_t end = find_delimiter(scanner, start);
+
+    field->offset = start;
+    field->length = (uint32_t)(end - start);
+    field->column = scanner->column;
+    field->row = scanner->row;
+
+    if (end < scanner->size && scanner->data[end] == ',') {
+        field->end_of_row = 0;
+        scanner->column++;
+        scanner->pos = end + 1;
+        return 1;
+    }
+
+    // Rivin loppu: "\n", "\r\n", pelkkä "\r" tai tiedoston loppu
+    field->end_of_row = 1;
+    scanner->pos = end + 1;
+    if (end < scanner->size && scanner->data[end] == '\r' &&
+        end + 1 < scanner->size && scanner->data[end + 1] == '\n') {
+        scanner->pos++;
+    }
+    scanner->column = 0;
+    scanner->row++;
+    return 1;
+}
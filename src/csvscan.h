@@ -0,0 +1,82 @@
+/**
+* @file csvscan.h
+* @brief Zero-copy CSV scanner over memory-mapped files.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CSVSCAN_H
+#define CSVSCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// map_file_copies-kopion perässä olevat nollatavut (kuten utf8_normalize-kopiossa),
+// jotta nimiä voi kopioida 16 tavun paloina puskurin lopusta
+#define MAP_FILE_PADDING 16
+
+// Muistiin kuvattu (tai kokonaan luettu) tiedosto
+typedef struct {
+    const char *data;    // Tiedoston sisältö (ei NUL-päätteinen)
+    size_t size;         // Koko tavuina
+    int mapped;          // 1 = mmap, 0 = malloc-puskuri (Windows / kopio / normalisoitu / tyhjä)
+} MappedFile;
+
+// Yksi CSV-kenttä: osoittaa suoraan tiedoston sisältöön
+typedef struct {
+    size_t offset;       // Kentän alku tiedostossa
+    uint32_t length;     // Kentän pituus tavuina (0 = tyhjä kenttä)
+    uint32_t column;     // Sarakkeen numero rivillä (0 = ensimmäinen)
+    uint32_t row;        // Rivin numero (0 = otsikkorivi)
+    int end_of_row;      // 1, jos kenttä on rivin viimeinen
+} CsvField;
+
+// Lukijan tila. Erottimet (',', '\r', '\n') etsitään 64 tavun lohkoissa
+// bittimaskiin, josta seuraava erotin saadaan yhdellä bittihaulla.
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t pos;          // Seuraavan kentän alku
+    size_t block_start;  // Maskin kattaman lohkon alku
+    uint64_t mask;       // Erotinmerkkien paikat lohkossa
+    int has_block;
+    uint32_t column;
+    uint32_t row;
+} CsvScanner;
+
+// Kuvaa tiedoston muistiin vain luettavaksi. Palauttaa 0 onnistuessa, -1 virheessä.
+int map_file(const char *filename, MappedFile *file);
+
+// Jos asetettu, map_file lukee tiedostot kopioksi kuvaamisen sijaan. Kuvattu
+// tiedosto, jota joku typistää paikallaan, kaataa lukijan (SIGBUS); pitkään
+// ajettava ohjelma, joka lataa muuttuvia tiedostoja uudelleen, tarvitsee kopiot.
+extern int map_file_copies;
+
+// Vapauttaa map_file-funktion varaaman kuvauksen
+void unmap_file(MappedFile *file);
+
+// Alustaa lukijan annetulle datalle
+void csv_scanner_init(CsvScanner *scanner, const char *data, size_t size);
+
+// Lukee seuraavan kentän. Tyhjät kentät palautetaan, jotta sarakkeet pysyvät
+// kohdallaan. Palauttaa 1, jos kenttä luettiin, ja 0 tiedoston lopussa.
+int csv_next_field(CsvScanner *scanner, CsvField *field);
+
+#endif // CSVSCAN_H
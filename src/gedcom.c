@@ -0,0 +1,344 @@
+/**
+* @file gedcom.c
+* @brief Streaming GEDCOM 5.5.1 export of a simulated population.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gedcom.h"
+
+// Tietueen kiinteät rivit ja yksi viittausrivi enintään (tavuja)
+#define GEDCOM_MAX_FIXED 160
+#define GEDCOM_MAX_LINK 24
+
+static const char GEDCOM_HEADER[] =
+    "0 HEAD\n"
+    "1 SOUR GENESIM\n"
+    "2 NAME GeneSim\n"
+    "1 SUBM @U1@\n"
+    "1 GEDC\n"
+    "2 VERS 5.5.1\n"
+    "2 FORM LINEAGE-LINKED\n"
+    "1 CHAR UTF-8\n"
+    "0 @U1@ SUBM\n"
+    "1 NAME genesim\n";
+
+static const char GEDCOM_TRAILER[] = "0 TRLR\n";
+
+// Lapset äideittäin ja perheiden esikoiset isittäin (CSR-taulukot)
+typedef struct {
+    uint32_t *child_start;    // Naisen w lapset: children[child_start[w] ... child_start[w + 1] - 1]
+    uint32_t *children;       // Syntymäjärjestyksessä
+    uint32_t *family_start;   // Miehen m perheet: firstborns[family_start[m] ... family_start[m + 1] - 1]
+    uint32_t *firstborns;     // Perheen esikoinen on perheen tunniste, syntymäjärjestyksessä
+} FamilyIndex;
+
+// --- 1. PERHEET ---
+
+static void free_index(FamilyIndex *index) {
+    free(index->child_start);
+    free(index->children);
+    free(index->family_start);
+    free(index->firstborns);
+}
+
+// Funktio kertoo, aloittaako lapsi children[k] uuden perheen äitinsä lapsista.
+// Naisen saman miehen lapset ovat peräkkäin, koska edellinen puoliso on
+// kuollut ennen seuraavaa avioliittoa.
+static int starts_family(const FamilyIndex *index, const Population *pop, uint32_t begin, uint32_t k) {
+    return k == begin || pop->father[index->children[k]] != pop->father[index->children[k - 1]];
+}
+
+// Funktio rakentaa lapsi- ja perhelistat laskentalajittelulla: laskuri on
+// paikassa p + 2, summien jälkeen täyttö siirtää paikan p + 1 alkuun p + 1.
+// Palauttaa perheiden määrän tai -1 (muisti loppui).
+static long long build_index(FamilyIndex *index, const Population *pop) {
+    uint32_t n = pop->count;
+    memset(index, 0, sizeof(*index));
+    index->child_start = (uint32_t *)calloc((size_t)n + 2, sizeof(uint32_t));
+    index->family_start = (uint32_t *)calloc((size_t)n + 2, sizeof(uint32_t));
+    if (index->child_start == NULL || index->family_start == NULL) {
+        free_index(index);
+        return -1;
+    }
+
+    // 1. Lapset äideittäin
+    for (uint32_t c = 0; c < n; c++) {
+        if (pop->mother[c] != POP_NONE) {
+            index->child_start[pop->mother[c] + 2]++;
+        }
+    }
+    for (uint32_t p = 0; p < n; p++) {
+        index->child_start[p + 2] += index->child_start[p + 1];
+    }
+    index->children = (uint32_t *)malloc(((size_t)index->child_start[n + 1] + 1) * sizeof(uint32_t));
+    if (index->children == NULL) {
+        free_index(index);
+        return -1;
+    }
+    for (uint32_t c = 0; c < n; c++) {
+        if (pop->mother[c] != POP_NONE) {
+            index->children[index->child_start[pop->mother[c] + 1]++] = c;
+        }
+    }
+
+    // 2. Perheiden esikoiset isittäin
+    long long families = 0;
+    for (uint32_t w = 0; w < n; w++) {
+        for (uint32_t k = index->child_start[w]; k < index->child_start[w + 1]; k++) {
+            if (starts_family(index, pop, index->child_start[w], k)) {
+                index->family_start[pop->father[index->children[k]] + 2]++;
+                families++;
+            }
+        }
+    }
+    for (uint32_t p = 0; p < n; p++) {
+        index->family_start[p + 2] += index->family_start[p + 1];
+    }
+    index->firstborns = (uint32_t *)malloc(((size_t)families + 1) * sizeof(uint32_t));
+    if (index->firstborns == NULL) {
+        free_index(index);
+        return -1;
+    }
+    for (uint32_t w = 0; w < n; w++) {
+        for (uint32_t k = index->child_start[w]; k < index->child_start[w + 1]; k++) {
+            if (starts_family(index, pop, index->child_start[w], k)) {
+                uint32_t child = index->children[k];
+                index->firstborns[index->family_start[pop->father[child] + 1]++] = child;
+            }
+        }
+    }
+
+    // Miehen perheet ovat vaimojen järjestyksessä; järjestetään esikoisen
+    // mukaan (lisäyslajittelu, perheitä on yleensä yksi)
+    for (uint32_t m = 0; m < n; m++) {
+        uint32_t *first = index->firstborns + index->family_start[m];
+        uint32_t count = index->family_start[m + 1] - index->family_start[m];
+        for (uint32_t i = 1; i < count; i++) {
+            uint32_t key = first[i];
+            uint32_t j = i;
+            while (j > 0 && first[j - 1] > key) {
+                first[j] = first[j - 1];
+                j--;
+            }
+            first[j] = key;
+        }
+    }
+    return families;
+}
+
+// Funktio palauttaa lapsen perheen tunnisteen (perheen esikoisen)
+static uint32_t family_of(const FamilyIndex *index, const Population *pop, uint32_t child) {
+    uint32_t begin = index->child_start[pop->mother[child]];
+    uint32_t low = begin;
+    uint32_t high = index->child_start[pop->mother[child] + 1];
+    while (high - low > 1) {
+        uint32_t mid = low + (high - low) / 2;
+        if (index->children[mid] <= child) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    while (!starts_family(index, pop, begin, low)) {
+        low--;
+    }
+    return index->children[low];
+}
+
+// Funktio kertoo, onko naisen nykyinen avioliitto lapseton. Vain avioliitto,
+// jossa kumpikin on toisen viimeisin puoliso, on tallessa.
+static int childless_marriage(const FamilyIndex *index, const Population *pop, uint32_t woman) {
+    uint32_t husband = pop->spouse[woman];
+    if (husband == POP_NONE || pop->spouse[husband] != woman) {
+        return 0;
+    }
+    uint32_t end = index->child_start[woman + 1];
+    return end == index->child_start[woman] || pop->father[index->children[end - 1]] != husband;
+}
+
+// --- 2. TIETUEET ---
+
+// Funktio kirjoittaa luvun kymmenjärjestelmässä ja palauttaa sen pituuden
+static size_t write_decimal(char *out, uint32_t value) {
+    char digits[10];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+static char *put_text(char *p, const char *text, size_t length) {
+    memcpy(p, text, length);
+    return p + length;
+}
+
+#define PUT_LITERAL(p, literal) put_text((p), (literal), sizeof(literal) - 1)
+
+// Funktio kirjoittaa viittauksen "@<laji><tunniste>@"
+static char *put_xref(char *p, char kind, uint32_t id) {
+    *p++ = '@';
+    *p++ = kind;
+    p += write_decimal(p, id);
+    *p++ = '@';
+    return p;
+}
+
+// Funktio kirjoittaa rivin "<taso> <tagi> @<laji><tunniste>@\n"
+static char *put_link(char *p, const char *line, size_t length, char kind, uint32_t id) {
+    p = put_xref(put_text(p, line, length), kind, id);
+    *p++ = '\n';
+    return p;
+}
+
+#define PUT_LINK(p, line, kind, id) put_link((p), (line), sizeof(line) - 1, (kind), (id))
+
+// Funktio kirjoittaa henkilön INDI-tietueen
+static void write_person(OutBuf *out, const FamilyIndex *index, const Population *pop, const PopNames *names,
+                         uint32_t person) {
+    size_t first_len, middle_len, last_len;
+    const char *first = pop_first_name(names, pop, person, &first_len);
+    const char *middle = pop_middle_name(names, pop, person, &middle_len);
+    const char *last = pop_last_name(names, pop, person, &last_len);
+
+    // Omat perheet: naisella lapsiryhmät, miehellä perhelista
+    int female = (pop->sex[person] == POP_FEMALE);
+    uint32_t begin = female ? index->child_start[person] : index->family_start[person];
+    uint32_t end = female ? index->child_start[person + 1] : index->family_start[person + 1];
+    uint32_t wife = female ? person : pop->spouse[person];
+    int childless = (wife != POP_NONE && (female || pop->spouse[wife] == person) &&
+                     childless_marriage(index, pop, wife));
+
+    size_t need = GEDCOM_MAX_FIXED + 2 * (first_len + middle_len + last_len) +
+                  GEDCOM_MAX_LINK * ((size_t)(end - begin) + 1);
+    char *start = outbuf_reserve(out, need);
+    if (start == NULL) {
+        return; // Muisti loppui, virhe jää puskuriin
+    }
+    char *p = put_xref(PUT_LITERAL(start, "0 "), 'I', person);
+    p = PUT_LITERAL(p, " INDI\n1 NAME ");
+    char *given = p;
+    p = put_text(p, first, first_len);
+    if (middle_len > 0) {
+        *p++ = ' ';
+        p = put_text(p, middle, middle_len);
+    }
+    size_t given_len = (size_t)(p - given);
+    p = PUT_LITERAL(p, " /");
+    p = put_text(p, last, last_len);
+    p = PUT_LITERAL(p, "/\n2 GIVN ");
+    p = put_text(p, given, given_len);
+    if (last_len > 0) {
+        p = PUT_LITERAL(p, "\n2 SURN ");
+        p = put_text(p, last, last_len);
+    }
+    p = female ? PUT_LITERAL(p, "\n1 SEX F\n1 BIRT\n2 DATE ") : PUT_LITERAL(p, "\n1 SEX M\n1 BIRT\n2 DATE ");
+    p += write_decimal(p, pop->birth_year[person]);
+    *p++ = '\n';
+    if (pop->death_year[person] != POP_ALIVE) {
+        p = PUT_LITERAL(p, "1 DEAT\n2 DATE ");
+        p += write_decimal(p, pop->death_year[person]);
+        *p++ = '\n';
+    }
+    if (pop->mother[person] != POP_NONE) {
+        p = PUT_LINK(p, "1 FAMC ", 'F', family_of(index, pop, person));
+    }
+    for (uint32_t k = begin; k < end; k++) {
+        if (!female) {
+            p = PUT_LINK(p, "1 FAMS ", 'F', index->firstborns[k]);
+        } else if (starts_family(index, pop, begin, k)) {
+            p = PUT_LINK(p, "1 FAMS ", 'F', index->children[k]);
+        }
+    }
+    if (childless) {
+        p = PUT_LINK(p, "1 FAMS ", 'M', wife);
+    }
+    out->len += (size_t)(p - start);
+}
+
+// Funktio kirjoittaa naisen perheiden FAM-tietueet ja palauttaa niiden määrän
+static uint32_t write_families(OutBuf *out, const FamilyIndex *index, const Population *pop, uint32_t woman) {
+    uint32_t begin = index->child_start[woman];
+    uint32_t end = index->child_start[woman + 1];
+    uint32_t families = 0;
+    uint32_t k = begin;
+    while (k < end) {
+        uint32_t family_end = k + 1;
+        while (family_end < end && !starts_family(index, pop, begin, family_end)) {
+            family_end++;
+        }
+        char *start = outbuf_reserve(out, GEDCOM_MAX_FIXED + GEDCOM_MAX_LINK * (size_t)(family_end - k));
+        if (start == NULL) {
+            return families; // Muisti loppui, virhe jää puskuriin
+        }
+        char *p = put_xref(PUT_LITERAL(start, "0 "), 'F', index->children[k]);
+        p = PUT_LITERAL(p, " FAM\n");
+        p = PUT_LINK(p, "1 HUSB ", 'I', pop->father[index->children[k]]);
+        p = PUT_LINK(p, "1 WIFE ", 'I', woman);
+        for (; k < family_end; k++) {
+            p = PUT_LINK(p, "1 CHIL ", 'I', index->children[k]);
+        }
+        out->len += (size_t)(p - start);
+        families++;
+    }
+    if (childless_marriage(index, pop, woman)) {
+        char *start = outbuf_reserve(out, GEDCOM_MAX_FIXED);
+        if (start == NULL) {
+            return families;
+        }
+        char *p = put_xref(PUT_LITERAL(start, "0 "), 'M', woman);
+        p = PUT_LITERAL(p, " FAM\n");
+        p = PUT_LINK(p, "1 HUSB ", 'I', pop->spouse[woman]);
+        p = PUT_LINK(p, "1 WIFE ", 'I', woman);
+        out->len += (size_t)(p - start);
+        families++;
+    }
+    return families;
+}
+
+// --- 3. VIENTI ---
+
+int gedcom_write(OutBuf *out, const Population *pop, const PopNames *names, uint64_t *families) {
+    FamilyIndex index;
+    if (build_index(&index, pop) < 0) {
+        return -1;
+    }
+
+    *families = 0;
+    outbuf_write(out, GEDCOM_HEADER, sizeof(GEDCOM_HEADER) - 1);
+    for (uint32_t person = 0; person < pop->count && !out->error; person++) {
+        write_person(out, &index, pop, names, person);
+        if (pop->sex[person] == POP_FEMALE) {
+            *families += write_families(out, &index, pop, person);
+        }
+    }
+    outbuf_write(out, GEDCOM_TRAILER, sizeof(GEDCOM_TRAILER) - 1);
+
+    free_index(&index);
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**
+* @file gedcom.h
+* @brief Streaming GEDCOM 5.5.1 export of a simulated population.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef GEDCOM_H
+#define GEDCOM_H
+
+#include <stdint.h>
+
+#include "outbuf.h"
+#include "population.h"
+
+// Puskurin koko GEDCOM-tiedostolle: tietueet kootaan puskuriin ja
+// kirjoitetaan harvoina isoina paloina
+#define GEDCOM_BUFFER_SIZE (8 << 20)
+
+// Tiedosto kirjoitetaan yhdellä kierroksella syntymäjärjestyksessä: jokaisen
+// henkilön INDI-tietue ja naisen perään hänen perheidensä FAM-tietueet.
+// Perhe on pari ja heidän yhteiset lapsensa (@F<esikoinen>@) tai lapseton
+// nykyinen avioliitto (@M<vaimo>@); henkilöt ovat @I<tunniste>@. Aiemmat
+// lapsettomat avioliitot eivät ole väestössä tallessa. Muistia tarvitaan
+// väestön lisäksi lapsi- ja perhelistoihin (noin 12 tavua henkilöä kohti),
+// ei tulosteen koon mukaan.
+
+// Kirjoittaa väestön GEDCOM 5.5.1 -muodossa (UTF-8) ja palauttaa perheiden
+// määrän muuttujaan families. Palauttaa 0 tai -1 (muisti loppui);
+// kirjoitusvirhe jää puskurin error-kenttään.
+int gedcom_write(OutBuf *out, const Population *pop, const PopNames *names, uint64_t *families);
+
+#endif // GEDCOM_H
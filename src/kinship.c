@@ -0,0 +1,415 @@
+/**
+* @file kinship.c
+* @brief Indexed kinship queries (common ancestor, relationship) over a simulated population.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kinship.h"
+#include "stats.h"
+
+// Henkilöitä per indeksin rakennustehtävä ja pareja per erätehtävä
+#define KIN_CHUNK 65536
+#define KIN_BATCH_TASK 4096
+
+// Esivanhempalistan avain: tunniste, sukupolvia ylöspäin ja lehtibitti (vanhempi,
+// jonka esivanhemmat on jo lisätty isovanhempina). Järjestämällä avaimet saman
+// henkilön lähin esiintymä tulee ensin.
+#define KEY(id, up, leaf) (((uint64_t)(id) << 8) | ((uint64_t)(up) << 1) | (uint64_t)(leaf))
+#define KEY_ID(key) ((uint32_t)((key) >> 8))
+#define KEY_UP(key) ((int)((key) >> 1) & 0x7F)
+#define KEY_LEAF(key) ((int)(key) & 1)
+
+// --- 1. INDEKSI ---
+
+// Vaihe 1: vanhemmat ja isovanhemmat yhteen tietueeseen
+static void ancestors_task(void *context, long long chunk) {
+    KinshipIndex *index = (KinshipIndex *)context;
+    const Population *pop = index->pop;
+    uint32_t begin = (uint32_t)(chunk * KIN_CHUNK);
+    uint32_t end = (index->count - begin > KIN_CHUNK) ? begin + KIN_CHUNK : index->count;
+    for (uint32_t p = begin; p < end; p++) {
+        KinAncestors *record = &index->ancestors[p];
+        record->parents[0] = pop->mother[p];
+        record->parents[1] = pop->father[p];
+        for (int k = 0; k < 2; k++) {
+            uint32_t parent = record->parents[k];
+            record->grandparents[2 * k] = (parent != POP_NONE) ? pop->mother[parent] : POP_NONE;
+            record->grandparents[2 * k + 1] = (parent != POP_NONE) ? pop->father[parent] : POP_NONE;
+        }
+    }
+}
+
+// Funktio laskee sukupolvinumerot ja lasten taulukon. Vanhemman tunniste on
+// aina pienempi kuin lapsen, joten yksi kierros tunnistejärjestyksessä riittää.
+static int build_descendants(KinshipIndex *index) {
+    const Population *pop = index->pop;
+    uint32_t count = index->count;
+    index->child_start = (uint32_t *)calloc((size_t)count + 1, sizeof(uint32_t));
+    if (index->child_start == NULL) {
+        return -1;
+    }
+
+    for (uint32_t p = 0; p < count; p++) {
+        uint8_t generation = 0;
+        for (int k = 0; k < 2; k++) {
+            uint32_t parent = index->ancestors[p].parents[k];
+            if (parent != POP_NONE) {
+                if (index->generation[parent] + 1 > generation) {
+                    generation = (uint8_t)(index->generation[parent] + 1);
+                }
+                index->child_start[parent + 1]++;
+            }
+        }
+        index->generation[p] = (generation < UINT8_MAX) ? generation : UINT8_MAX;
+    }
+    for (uint32_t p = 0; p < count; p++) {
+        index->child_start[p + 1] += index->child_start[p];
+    }
+
+    index->children = (uint32_t *)malloc(((size_t)index->child_start[count] + 1) * sizeof(uint32_t));
+    uint32_t *next = (uint32_t *)malloc((size_t)count * sizeof(uint32_t) + 1);
+    if (index->children == NULL || next == NULL) {
+        free(next);
+        return -1;
+    }
+    memcpy(next, index->child_start, (size_t)count * sizeof(uint32_t));
+    for (uint32_t p = 0; p < count; p++) {
+        if (pop->mother[p] != POP_NONE) {
+            index->children[next[pop->mother[p]]++] = p;
+        }
+        if (pop->father[p] != POP_NONE) {
+            index->children[next[pop->father[p]]++] = p;
+        }
+    }
+    free(next);
+    return 0;
+}
+
+int kinship_build(KinshipIndex *index, const Population *pop, int threads) {
+    memset(index, 0, sizeof(KinshipIndex));
+    uint64_t start = stats_now_ns();
+    index->pop = pop;
+    index->count = pop->count;
+    index->ancestors = (KinAncestors *)malloc((size_t)pop->count * sizeof(KinAncestors) + 1);
+    index->generation = (uint8_t *)malloc((size_t)pop->count + 1);
+    index->pool = parallel_pool_new(threads);
+    if (index->ancestors == NULL || index->generation == NULL || index->pool == NULL) {
+        kinship_free(index);
+        return -1;
+    }
+
+    parallel_pool_run(index->pool, ((long long)pop->count + KIN_CHUNK - 1) / KIN_CHUNK, ancestors_task, index);
+    if (build_descendants(index) != 0) {
+        kinship_free(index);
+        return -1;
+    }
+    index->build_seconds = (double)(stats_now_ns() - start) / 1e9;
+    return 0;
+}
+
+void kinship_free(KinshipIndex *index) {
+    free(index->ancestors);
+    free(index->generation);
+    free(index->child_start);
+    free(index->children);
+    parallel_pool_free(index->pool);
+    memset(index, 0, sizeof(KinshipIndex));
+}
+
+size_t kinship_memory(const KinshipIndex *index) {
+    size_t children = (index->child_start != NULL) ? index->child_start[index->count] : 0;
+    return (size_t)index->count * (sizeof(KinAncestors) + sizeof(uint8_t) + sizeof(uint32_t)) +
+           sizeof(uint32_t) + children * sizeof(uint32_t);
+}
+
+// --- 2. HAUT ---
+
+static int compare_keys(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Funktio kerää henkilön esivanhemmat KIN_MAX_UP sukupolveen asti (henkilö
+// itse etäisyydellä 0) ja jättää jokaisesta lähimmän esiintymän tunnisteen
+// mukaan järjestettynä. Jokainen käsitelty tietue lisää kaksi sukupolvea.
+static uint32_t collect_ancestors(const KinshipIndex *index, uint32_t person, uint64_t keys[KIN_MAX_PATHS]) {
+    uint32_t n = 0;
+    keys[n++] = KEY(person, 0, 0);
+    for (uint32_t i = 0; i < n; i++) {
+        int up = KEY_UP(keys[i]);
+        if (KEY_LEAF(keys[i]) || up >= KIN_MAX_UP) {
+            continue;
+        }
+        const KinAncestors *record = &index->ancestors[KEY_ID(keys[i])];
+        for (int k = 0; k < 2; k++) {
+            if (record->parents[k] != POP_NONE) {
+                keys[n++] = KEY(record->parents[k], up + 1, 1);
+            }
+        }
+        if (up + 2 <= KIN_MAX_UP) {
+            for (int k = 0; k < 4; k++) {
+                if (record->grandparents[k] != POP_NONE) {
+                    keys[n++] = KEY(record->grandparents[k], up + 2, 0);
+                }
+            }
+        }
+    }
+
+    // Lyhyet listat lisäyslajittelulla, pitkät qsortilla
+    if (n <= 32) {
+        for (uint32_t i = 1; i < n; i++) {
+            uint64_t key = keys[i];
+            uint32_t j = i;
+            for (; j > 0 && keys[j - 1] > key; j--) {
+                keys[j] = keys[j - 1];
+            }
+            keys[j] = key;
+        }
+    } else {
+        qsort(keys, n, sizeof(uint64_t), compare_keys);
+    }
+    uint32_t unique = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (unique == 0 || KEY_ID(keys[unique - 1]) != KEY_ID(keys[i])) {
+            keys[unique++] = keys[i];
+        }
+    }
+    return unique;
+}
+
+void kinship_relate(const KinshipIndex *index, uint32_t a, uint32_t b, KinRelation *relation) {
+    relation->ancestor = POP_NONE;
+    relation->other_ancestor = POP_NONE;
+    relation->up_a = 0;
+    relation->up_b = 0;
+    if (a == b) {
+        relation->ancestor = a;
+        return;
+    }
+    // Kahdella alkuväestön jäsenellä ei ole tunnettuja esivanhempia
+    if (index->generation[a] == 0 && index->generation[b] == 0) {
+        return;
+    }
+
+    uint64_t keys_a[KIN_MAX_PATHS], keys_b[KIN_MAX_PATHS];
+    uint32_t na = collect_ancestors(index, a, keys_a);
+    uint32_t nb = collect_ancestors(index, b, keys_b);
+
+    // Yhteisistä esivanhemmista lähin: pienin etäisyyksien summa, sitten
+    // pienin ero (tasapeli syntyy vain sukulaisavioliitoista)
+    int best_total = 2 * KIN_MAX_UP + 1, best_diff = 0;
+    uint32_t i = 0, j = 0;
+    while (i < na && j < nb) {
+        uint32_t id_a = KEY_ID(keys_a[i]), id_b = KEY_ID(keys_b[j]);
+        if (id_a < id_b) {
+            i++;
+        } else if (id_a > id_b) {
+            j++;
+        } else {
+            int up_a = KEY_UP(keys_a[i]), up_b = KEY_UP(keys_b[j]);
+            int total = up_a + up_b;
+            int diff = (up_a > up_b) ? up_a - up_b : up_b - up_a;
+            if (total < best_total || (total == best_total && diff < best_diff)) {
+                best_total = total;
+                best_diff = diff;
+                relation->ancestor = id_a;
+                relation->other_ancestor = POP_NONE;
+                relation->up_a = (uint8_t)up_a;
+                relation->up_b = (uint8_t)up_b;
+            } else if (up_a == relation->up_a && up_b == relation->up_b && relation->other_ancestor == POP_NONE) {
+                relation->other_ancestor = id_a;
+            }
+            i++;
+            j++;
+        }
+    }
+}
+
+typedef struct {
+    const KinshipIndex *index;
+    const uint32_t *pairs;
+    size_t count;
+    KinRelation *relations;
+} BatchJob;
+
+static void batch_task(void *context, long long task) {
+    const BatchJob *job = (const BatchJob *)context;
+    size_t begin = (size_t)task * KIN_BATCH_TASK;
+    size_t end = (job->count - begin > KIN_BATCH_TASK) ? begin + KIN_BATCH_TASK : job->count;
+    for (size_t i = begin; i < end; i++) {
+        kinship_relate(job->index, job->pairs[2 * i], job->pairs[2 * i + 1], &job->relations[i]);
+    }
+}
+
+void kinship_relate_batch(KinshipIndex *index, const uint32_t *pairs, size_t count, KinRelation *relations) {
+    BatchJob job = {index, pairs, count, relations};
+    parallel_pool_run(index->pool, (long long)((count + KIN_BATCH_TASK - 1) / KIN_BATCH_TASK), batch_task, &job);
+}
+
+// Funktio lisää tunnisteen kasvavaan taulukkoon. Palauttaa 0 tai -1.
+static int push_id(uint32_t **array, size_t *count, size_t *cap, uint32_t id) {
+    if (*count == *cap) {
+        size_t grown = (*cap > 0) ? *cap * 2 : 256;
+        uint32_t *larger = (uint32_t *)realloc(*array, grown * sizeof(uint32_t));
+        if (larger == NULL) {
+            return -1;
+        }
+        *array = larger;
+        *cap = grown;
+    }
+    (*array)[(*count)++] = id;
+    return 0;
+}
+
+static int compare_ids(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+long long kinship_relatives(const KinshipIndex *index, uint32_t person, int up_person, int up_other,
+                            uint32_t *out, size_t cap) {
+    if (up_person < 0 || up_other < 0 || up_person > KIN_MAX_UP || up_other > KIN_MAX_UP) {
+        return 0;
+    }
+    uint64_t keys[KIN_MAX_PATHS];
+    uint32_t num_keys = collect_ancestors(index, person, keys);
+
+    // Jokaisen esivanhemman jälkeläiset up_other sukupolvea alempana ovat ehdokkaita
+    uint32_t *level = NULL, *next = NULL, *found = NULL;
+    size_t level_count = 0, level_cap = 0, next_count = 0, next_cap = 0, found_count = 0, found_cap = 0;
+    int error = 0;
+    for (uint32_t k = 0; k < num_keys && !error; k++) {
+        if (KEY_UP(keys[k]) != up_person) {
+            continue;
+        }
+        level_count = 0;
+        error = push_id(&level, &level_count, &level_cap, KEY_ID(keys[k]));
+        for (int down = 0; down < up_other && !error; down++) {
+            next_count = 0;
+            for (size_t i = 0; i < level_count && !error; i++) {
+                for (uint32_t c = index->child_start[level[i]]; c < index->child_start[level[i] + 1] && !error; c++) {
+                    error = push_id(&next, &next_count, &next_cap, index->children[c]);
+                }
+            }
+            uint32_t *swap = level;
+            level = next;
+            next = swap;
+            size_t swap_cap = level_cap;
+            level_cap = next_cap;
+            next_cap = swap_cap;
+            level_count = next_count;
+        }
+        for (size_t i = 0; i < level_count && !error; i++) {
+            error = push_id(&found, &found_count, &found_cap, level[i]);
+        }
+    }
+    free(level);
+    free(next);
+    if (error) {
+        free(found);
+        return -1;
+    }
+
+    // Ehdokkaista jätetään ne, joiden lähin sukulaisuus on juuri tämä
+    // (esim. pikkuserkkujen joukosta pois serkut ja sisarukset)
+    if (found_count > 0) {
+        qsort(found, found_count, sizeof(uint32_t), compare_ids);
+    }
+    long long total = 0;
+    for (size_t i = 0; i < found_count; i++) {
+        if ((i > 0 && found[i] == found[i - 1]) || found[i] == person) {
+            continue;
+        }
+        KinRelation relation;
+        kinship_relate(index, person, found[i], &relation);
+        if (relation.ancestor != POP_NONE && relation.up_a == up_person && relation.up_b == up_other) {
+            if ((size_t)total < cap) {
+                out[total] = found[i];
+            }
+            total++;
+        }
+    }
+    free(found);
+    return total;
+}
+
+// --- 3. NIMET ---
+
+static const char *const ORDINALS[KIN_MAX_UP] = {
+    "first", "second", "third", "fourth", "fifth", "sixth", "seventh", "eighth"
+};
+static const char *const REMOVALS[KIN_MAX_UP] = {
+    "", " once removed", " twice removed", " three times removed", " four times removed",
+    " five times removed", " six times removed", " seven times removed"
+};
+
+// Sukupuolen mukaan (POP_MALE, POP_FEMALE)
+static const char *const PARENT[2] = {"father", "mother"};
+static const char *const CHILD[2] = {"son", "daughter"};
+static const char *const SIBLING[2] = {"brother", "sister"};
+static const char *const PARENT_SIBLING[2] = {"uncle", "aunt"};
+static const char *const SIBLING_CHILD[2] = {"nephew", "niece"};
+
+// Funktio kirjoittaa "great-" count kertaa
+static const char *greats(char *buffer, int count) {
+    buffer[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        strcat(buffer, "great-");
+    }
+    return buffer;
+}
+
+int kinship_describe(const KinshipIndex *index, uint32_t a, const KinRelation *relation, char *buffer, size_t cap) {
+    char prefix[6 * KIN_MAX_UP + 1];
+    int sex = index->pop->sex[a];
+    int up_a = relation->up_a, up_b = relation->up_b;
+    const char *half = (relation->other_ancestor == POP_NONE) ? "half-" : "";
+    if (relation->ancestor == POP_NONE) {
+        return snprintf(buffer, cap, "not related");
+    }
+    if (up_a == 0 && up_b == 0) {
+        return snprintf(buffer, cap, "self");
+    }
+    if (up_a == 0) {
+        return snprintf(buffer, cap, "%s%s%s", greats(prefix, up_b - 2), (up_b > 1) ? "grand" : "", PARENT[sex]);
+    }
+    if (up_b == 0) {
+        return snprintf(buffer, cap, "%s%s%s", greats(prefix, up_a - 2), (up_a > 1) ? "grand" : "", CHILD[sex]);
+    }
+    if (up_a == 1 && up_b == 1) {
+        return snprintf(buffer, cap, "%s%s", half, SIBLING[sex]);
+    }
+    if (up_a == 1) {
+        return snprintf(buffer, cap, "%s%s%s", half, greats(prefix, up_b - 2), PARENT_SIBLING[sex]);
+    }
+    if (up_b == 1) {
+        return snprintf(buffer, cap, "%s%s%s", half, greats(prefix, up_a - 2), SIBLING_CHILD[sex]);
+    }
+    int degree = ((up_a < up_b) ? up_a : up_b) - 1;
+    int removed = (up_a > up_b) ? up_a - up_b : up_b - up_a;
+    return snprintf(buffer, cap, "%s%s cousin%s", half, ORDINALS[degree - 1], REMOVALS[removed]);
+}
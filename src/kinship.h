@@ -0,0 +1,106 @@
+/**
+* @file kinship.h
+* @brief Indexed kinship queries (common ancestor, relationship) over a simulated population.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KINSHIP_H
+#define KINSHIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "parallel.h"
+#include "population.h"
+
+// Sukulaisuushaut tehdään valmiiksi rakennetun indeksin avulla:
+// - jokaisella henkilöllä on yhdessä tietueessa vanhemmat ja isovanhemmat
+//   (nousutaulun kaksi ensimmäistä tasoa), joten esivanhempien läpikäynti
+//   hyppää kaksi sukupolvea yhdellä muistihaulla
+// - sukupolvinumero: alkuväestö 0, lapsi 1 + vanhempien suurempi numero
+// - lapset vanhemmittain (CSR-taulukko) jälkeläisten hakuun
+// Indeksi viittaa väestöön, jota ei saa muuttaa indeksin elinaikana.
+
+#define KIN_MAX_UP 8              // Kauimmainen haettava yhteinen esivanhempi (sukupolvia)
+#define KIN_MAX_PATHS (2 << KIN_MAX_UP) // Esivanhempapolkuja enintään (henkilö mukaan lukien)
+
+// Vanhemmat (äiti, isä) ja isovanhemmat (äidin äiti, äidin isä, isän äiti,
+// isän isä). Puuttuva on POP_NONE.
+typedef struct {
+    uint32_t parents[2];
+    uint32_t grandparents[4];
+} KinAncestors;
+
+typedef struct {
+    const Population *pop;
+    uint32_t count;
+    KinAncestors *ancestors;
+    uint8_t *generation;
+    uint32_t *child_start;    // Henkilön p lapset: children[child_start[p] ... child_start[p + 1] - 1]
+    uint32_t *children;       // Syntymäjärjestyksessä
+    ParallelPool *pool;       // kinship_relate_batch
+    double build_seconds;
+} KinshipIndex;
+
+// Kahden henkilön sukulaisuus lähimmän yhteisen esivanhemman kautta: a on
+// up_a sukupolvea ja b up_b sukupolvea esivanhemman alapuolella (0 = henkilö
+// itse, esim. 2 ja 2 = serkut). Jos samalla etäisyydellä on toinenkin yhteinen
+// esivanhempi (yleensä puoliso), se on other_ancestor ja sukulaisuus on täysi
+// (sisarukset), muuten puolisukulaisuus. Jos yhteistä esivanhempaa ei ole
+// KIN_MAX_UP sukupolven sisällä, ancestor on POP_NONE.
+typedef struct {
+    uint32_t ancestor;
+    uint32_t other_ancestor;
+    uint8_t up_a;
+    uint8_t up_b;
+} KinRelation;
+
+// Rakentaa indeksin threads säikeellä (0 = laitteiston säiemäärä). Säikeet jäävät
+// kinship_relate_batch-kutsuja varten. Palauttaa 0 tai -1 (muisti loppui).
+int kinship_build(KinshipIndex *index, const Population *pop, int threads);
+
+void kinship_free(KinshipIndex *index);
+
+// Indeksin koko tavuina
+size_t kinship_memory(const KinshipIndex *index);
+
+// Ratkaisee henkilöiden a ja b sukulaisuuden. Voidaan kutsua samanaikaisesti
+// useasta säikeestä.
+void kinship_relate(const KinshipIndex *index, uint32_t a, uint32_t b, KinRelation *relation);
+
+// Ratkaisee count paria (pairs[2 * i], pairs[2 * i + 1]) rinnakkain indeksin
+// säikeillä. Vain yksi eräkutsu kerrallaan samalle indeksille.
+void kinship_relate_batch(KinshipIndex *index, const uint32_t *pairs, size_t count, KinRelation *relations);
+
+// Hakee henkilön sukulaiset, joiden lähin yhteinen esivanhempi on up_person
+// sukupolvea henkilön ja up_other sukupolvea sukulaisen yläpuolella (esim. 3 ja 3
+// = pikkuserkut, 1 ja 0 = vanhemmat). Kirjoittaa enintään cap tunnistetta
+// kasvavassa järjestyksessä ja palauttaa löydettyjen määrän (voi olla suurempi
+// kuin cap) tai -1, jos muisti loppui.
+long long kinship_relatives(const KinshipIndex *index, uint32_t person, int up_person, int up_other,
+                            uint32_t *out, size_t cap);
+
+// Kirjoittaa sukulaisuuden nimen a:n näkökulmasta ("a on b:n ..."), esim.
+// "grandmother", "half-brother" tai "second cousin once removed". Palauttaa
+// merkkijonon pituuden kuten snprintf.
+int kinship_describe(const KinshipIndex *index, uint32_t a, const KinRelation *relation, char *buffer, size_t cap);
+
+#endif // KINSHIP_H
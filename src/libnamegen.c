@@ -0,0 +1,950 @@
+/**
+* @file libnamegen.c
+* @brief Embeddable name generation library (libnamegen).
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "condtable.h"
+#include "corpus.h"
+#include "libnamegen.h"
+#include "lineformat.h"
+#include "markov.h"
+#include "namedict.h"
+#include "namelist.h"
+#include "sampler.h"
+#include "yearcache.h"
+
+// Kirjaston koodit ovat samat kuin lataajien, joten ne välitetään sellaisenaan
+_Static_assert(NAMEGEN_FORMAT_IDS == LINE_FORMAT_IDS && NAMEGEN_FORMAT_CSV == LINE_FORMAT_CSV &&
+               NAMEGEN_FORMAT_JSONL == LINE_FORMAT_JSONL && NAMEGEN_FORMAT_RECORDS == LINE_FORMAT_RECORDS &&
+               NAMEGEN_NO_MIDDLE == LINE_NO_MIDDLE && NAMEGEN_RECORD_SIZE == LINE_RECORD_SIZE,
+               "line formats differ");
+_Static_assert(NAMEGEN_ERR_IO == NAMELIST_ERR_IO && NAMEGEN_ERR_NOMEM == NAMELIST_ERR_NOMEM &&
+               NAMEGEN_ERR_FORMAT == NAMELIST_ERR_FORMAT && NAMEGEN_ERR_VERSION == NAMELIST_ERR_VERSION &&
+               NAMEGEN_ERR_TOO_LARGE == NAMELIST_ERR_TOO_LARGE, "status codes differ");
+
+struct NameGen {
+    DecadeData first_names;
+    DecadeData middle_names;
+    NameList last_names;       // CSV-tilassa sukunimet
+    DecadeData last_table;     // Korpustilassa sukunimitaulu (yksi sarake)
+    NameList *last;            // Käytettävä sukunimilista (&last_names tai last_table.lists)
+    Corpus corpus;
+    int has_corpus;
+    int format;                // Rivimuoto (NAMEGEN_FORMAT_*)
+    int escape[LINE_FORMAT_COUNT]; // Onko jossain nimessä muodon lainattava merkki
+    uint64_t format_seed;      // JSONL-rivien siemen
+    int weighted;              // Viimeisin namegen_set_weighting (ehdollisia rivejä varten)
+    double zipf_exponent;
+    DecadeData pairs;          // Etu- ja keskinimien yhdistelmät (vapaaehtoinen)
+    CondTable cond;            // Keskinimi etunimen mukaan
+    int conditional;           // Onko cond käytössä
+    MarkovModel *models;       // Etu- ja keskinimien mallit vuosikymmenittäin ja sukunimien malli
+                               // (NULL = Markov-tila ei ole käytössä)
+    MarkovExclusion *exclusions; // Mallin hylättävät nimet (nodes NULL = ei hylkäystä), yksi per malli
+    YearCache years;           // Vuosittain sekoitetut etu- ja keskinimet
+    pthread_mutex_t unique_lock;
+    NameList *unique_lists;    // Listat ilman toistuvia nimiä: etunimet ja keskinimet
+                               // vuosikymmenittäin, lopuksi sukunimet (NULL = ei rakennettu)
+};
+
+// --- 1. AVAAMINEN JA SULKEMINEN ---
+
+const char *namegen_strerror(int status) {
+    switch (status) {
+    case NAMEGEN_ERR_MISSING:  return "required name list is missing or empty";
+    case NAMEGEN_ERR_ARGUMENT: return "invalid argument";
+    case NAMEGEN_ERR_EXHAUSTED: return "not enough distinct name combinations";
+    default:                   return namelist_strerror(status);
+    }
+}
+
+// Funktio varaa tyhjän kontekstin
+static NameGen *context_new(void) {
+    NameGen *ctx = (NameGen *)calloc(1, sizeof(NameGen));
+    if (ctx != NULL) {
+        ctx->last = &ctx->last_names;
+        pthread_mutex_init(&ctx->unique_lock, NULL);
+    }
+    return ctx;
+}
+
+// Funktio tarkistaa, että pakolliset listat (etu- ja sukunimet) ovat olemassa
+static int check_required(const NameGen *ctx) {
+    if (ctx->first_names.num_decades == 0 || ctx->last->count == 0) {
+        return NAMEGEN_ERR_MISSING;
+    }
+    return NAMEGEN_OK;
+}
+
+// Funktio tarkistaa, onko jossain taulun nimessä muodon lainattava merkki
+static int table_needs_escape(int kind, const DecadeData *data) {
+    for (int col = 0; col < data->num_decades; col++) {
+        const NameList *list = &data->lists[col];
+        for (int i = 0; i < list->count; i++) {
+            if (line_format_needs_escape(kind, name_at(list, i), name_length(list, i))) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Funktio tarkistaa kerran avattaessa, tarvitsevatko CSV- ja JSONL-kentät
+// lainausta. Ehdollisen taulun, vuosien ja mallien nimet koostuvat samoista
+// nimistä tai niiden merkeistä, joten lähdetaulut riittävät.
+static void find_escapes(NameGen *ctx) {
+    static const int kinds[] = {LINE_FORMAT_CSV, LINE_FORMAT_JSONL};
+    DecadeData last = {0};
+    last.lists = ctx->last;
+    last.num_decades = 1;
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        int kind = kinds[k];
+        ctx->escape[kind] = table_needs_escape(kind, &ctx->first_names) ||
+                            table_needs_escape(kind, &ctx->middle_names) ||
+                            table_needs_escape(kind, &last) || table_needs_escape(kind, &ctx->pairs);
+    }
+}
+
+// Funktio liittää hakemiston ja tiedostonimen (kutsuja vapauttaa)
+static char *join_path(const char *dir, const char *name) {
+    size_t len = strlen(dir) + strlen(name) + 2;
+    char *path = (char *)malloc(len);
+    if (path != NULL) {
+        snprintf(path, len, "%s/%s", dir, name);
+    }
+    return path;
+}
+
+int namegen_open_directory(const char *locale_dir, NameGen **out_ctx) {
+    *out_ctx = NULL;
+    NameGen *ctx = context_new();
+    char *first_file = join_path(locale_dir, NAMEGEN_FIRST_NAMES);
+    char *middle_file = join_path(locale_dir, NAMEGEN_MIDDLE_NAMES);
+    char *last_file = join_path(locale_dir, NAMEGEN_LAST_NAMES);
+    char *pairs_file = join_path(locale_dir, NAMEGEN_COMBINATIONS);
+
+    int result = NAMEGEN_ERR_NOMEM;
+    if (ctx != NULL && first_file != NULL && middle_file != NULL && last_file != NULL && pairs_file != NULL) {
+        result = load_names_multi_column(first_file, &ctx->first_names);
+        if (result == NAMEGEN_OK) {
+            // Keskinimet ovat vapaaehtoisia: puuttuva tiedosto ei ole virhe
+            result = load_names_multi_column(middle_file, &ctx->middle_names);
+            if (result == NAMEGEN_ERR_IO) {
+                result = NAMEGEN_OK;
+            }
+        }
+        if (result == NAMEGEN_OK) {
+            // Sukunimitiedostolla on otsikkorivi ("1870-29"), joten se luetaan CSV:nä
+            result = load_names_from_csv(last_file, &ctx->last_names);
+        }
+        if (result == NAMEGEN_OK) {
+            // Yhdistelmät ovat vapaaehtoisia kuten keskinimet
+            result = load_names_multi_column(pairs_file, &ctx->pairs);
+            if (result == NAMEGEN_ERR_IO) {
+                result = NAMEGEN_OK;
+            }
+        }
+        if (result == NAMEGEN_OK) {
+            result = check_required(ctx);
+        }
+        if (result == NAMEGEN_OK) {
+            find_escapes(ctx);
+            result = year_cache_init(&ctx->years, &ctx->first_names, &ctx->middle_names, YEAR_CACHE_DEFAULT);
+        }
+    }
+
+    free(first_file);
+    free(middle_file);
+    free(last_file);
+    free(pairs_file);
+    if (result != NAMEGEN_OK) {
+        namegen_close(ctx);
+        return result;
+    }
+    *out_ctx = ctx;
+    return NAMEGEN_OK;
+}
+
+// Funktio hakee korpuksesta taulun. Puuttuva taulu jättää datan tyhjäksi.
+static int load_corpus_table(const Corpus *corpus, const char *name, DecadeData *data) {
+    int index = corpus_find_table(corpus, name);
+    if (index < 0) {
+        memset(data, 0, sizeof(*data));
+        return NAMEGEN_OK;
+    }
+    int result = corpus_table_view(corpus, index, data);
+    if (result == NAMEGEN_OK && namelist_verbose) {
+        fprintf(stderr, "Loaded %d decades from corpus table: %s\n", data->num_decades, name);
+    }
+    return result;
+}
+
+int namegen_open_corpus(const char *corpus_file, NameGen **out_ctx) {
+    *out_ctx = NULL;
+    NameGen *ctx = context_new();
+    if (ctx == NULL) {
+        return NAMEGEN_ERR_NOMEM;
+    }
+
+    // Käännetty korpus: ei jäsennystä, listat osoittavat suoraan kuvaukseen
+    int result = corpus_open(corpus_file, &ctx->corpus);
+    if (result == NAMEGEN_OK) {
+        ctx->has_corpus = 1;
+        result = load_corpus_table(&ctx->corpus, NAMEGEN_FIRST_NAMES, &ctx->first_names);
+    }
+    if (result == NAMEGEN_OK) {
+        result = load_corpus_table(&ctx->corpus, NAMEGEN_MIDDLE_NAMES, &ctx->middle_names);
+    }
+    if (result == NAMEGEN_OK) {
+        result = load_corpus_table(&ctx->corpus, NAMEGEN_LAST_NAMES, &ctx->last_table);
+    }
+    if (result == NAMEGEN_OK) {
+        result = load_corpus_table(&ctx->corpus, NAMEGEN_COMBINATIONS, &ctx->pairs);
+    }
+    if (result == NAMEGEN_OK && ctx->last_table.num_decades > 0) {
+        ctx->last = &ctx->last_table.lists[0];
+    }
+    if (result == NAMEGEN_OK) {
+        result = check_required(ctx);
+    }
+    if (result == NAMEGEN_OK) {
+        find_escapes(ctx);
+        result = year_cache_init(&ctx->years, &ctx->first_names, &ctx->middle_names, YEAR_CACHE_DEFAULT);
+    }
+    if (result != NAMEGEN_OK) {
+        namegen_close(ctx);
+        return result;
+    }
+
+    // Korpuksen alias-taulut ovat valmiina, mutta oletus on tasainen otanta
+    namegen_set_weighting(ctx, 0, 1.0);
+    *out_ctx = ctx;
+    return NAMEGEN_OK;
+}
+
+void namegen_close(NameGen *ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+    year_cache_free(&ctx->years);
+    cond_table_free(&ctx->cond);
+    namegen_set_markov(ctx, 0, 0);
+    if (ctx->unique_lists != NULL) {
+        int num_lists = ctx->first_names.num_decades + ctx->middle_names.num_decades + 1;
+        for (int i = 0; i < num_lists; i++) {
+            free_names(&ctx->unique_lists[i]);
+        }
+        free(ctx->unique_lists);
+    }
+    pthread_mutex_destroy(&ctx->unique_lock);
+    free_decade_data(&ctx->first_names);
+    free_decade_data(&ctx->middle_names);
+    free_names(&ctx->last_names);
+    free_decade_data(&ctx->last_table);
+    free_decade_data(&ctx->pairs);
+    corpus_close(&ctx->corpus);
+    free(ctx);
+}
+
+int namegen_set_weighting(NameGen *ctx, int weighted, double zipf_exponent) {
+    if (zipf_exponent < 0.0) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+    // Sekoitetut taulut on rakennettu vanhoista painoista
+    year_cache_clear(&ctx->years);
+    ctx->weighted = weighted;
+    ctx->zipf_exponent = zipf_exponent;
+
+    int result = NAMEGEN_OK;
+    if (ctx->has_corpus) {
+        // Korpuksen näkymät osoitetaan uudelleen käännettyihin tauluihin
+        static const char *const names[] = {NAMEGEN_FIRST_NAMES, NAMEGEN_MIDDLE_NAMES, NAMEGEN_LAST_NAMES};
+        DecadeData *tables[] = {&ctx->first_names, &ctx->middle_names, &ctx->last_table};
+        for (size_t t = 0; t < sizeof(tables) / sizeof(tables[0]); t++) {
+            int index = corpus_find_table(&ctx->corpus, names[t]);
+            for (int col = 0; col < tables[t]->num_decades; col++) {
+                const CorpusList *list = &ctx->corpus.lists[ctx->corpus.tables[index].first_list + (uint32_t)col];
+                tables[t]->lists[col].alias = weighted ? ctx->corpus.alias + list->first_entry : NULL;
+            }
+        }
+    } else if (!weighted) {
+        unweight_decade_data(&ctx->first_names);
+        unweight_decade_data(&ctx->middle_names);
+        free(ctx->last_names.alias_block);
+        ctx->last_names.alias = NULL;
+        ctx->last_names.alias_block = NULL;
+    } else {
+        result = weight_decade_data(&ctx->first_names, zipf_exponent);
+        if (result == NAMEGEN_OK) {
+            result = weight_decade_data(&ctx->middle_names, zipf_exponent);
+        }
+        if (result == NAMEGEN_OK) {
+            result = weight_names(&ctx->last_names, zipf_exponent);
+        }
+        if (result != NAMEGEN_OK) {
+            namegen_set_weighting(ctx, 0, zipf_exponent); // Ei puolittaisia tauluja
+            return result;
+        }
+    }
+
+    // Ehdollisten rivien varajakaumat ovat kopioita keskinimien alias-tauluista
+    if (ctx->conditional) {
+        result = namegen_set_conditional(ctx, 1);
+    }
+    return result;
+}
+
+// Funktio kertoo, kirjoitetaanko sanakirjan tunnisteita (ei sovi omiin sanakirjoihin)
+static int dictionary_format(const NameGen *ctx) {
+    return ctx->format == NAMEGEN_FORMAT_IDS || ctx->format == NAMEGEN_FORMAT_RECORDS;
+}
+
+int namegen_set_conditional(NameGen *ctx, int conditional) {
+    cond_table_free(&ctx->cond);
+    ctx->conditional = 0;
+    if (!conditional) {
+        return NAMEGEN_OK;
+    }
+    if (ctx->models != NULL) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+    if (ctx->pairs.num_decades == 0) {
+        return NAMEGEN_ERR_MISSING;
+    }
+    if (dictionary_format(ctx)) {
+        return NAMEGEN_ERR_ARGUMENT; // Taulun sanakirja ei ole korpuksen sanakirja
+    }
+    int result = cond_table_build(&ctx->cond, &ctx->first_names, &ctx->middle_names, &ctx->pairs,
+                                  ctx->weighted, ctx->zipf_exponent);
+    if (result == NAMEGEN_OK) {
+        ctx->conditional = 1;
+    }
+    return result;
+}
+
+// --- 2. TIEDOT ---
+
+int namegen_num_decades(const NameGen *ctx) {
+    return ctx->first_names.num_decades;
+}
+
+const char *namegen_decade_label(const NameGen *ctx, int decade) {
+    if (decade < 0 || decade >= ctx->first_names.num_decades) {
+        return NULL;
+    }
+    return ctx->first_names.decades[decade];
+}
+
+int namegen_decade_size(const NameGen *ctx, int decade) {
+    if (decade < 0 || decade >= ctx->first_names.num_decades) {
+        return 0;
+    }
+    return ctx->first_names.lists[decade].count;
+}
+
+int namegen_has_middle_names(const NameGen *ctx) {
+    return ctx->middle_names.num_decades > 0;
+}
+
+int namegen_find_decade(const NameGen *ctx, const char *spec) {
+    const DecadeData *data = &ctx->first_names;
+    char *end = NULL;
+    long number = strtol(spec, &end, 10);
+    if (*end == '\0' && number >= 1 && number <= data->num_decades) {
+        return (int)number - 1;
+    }
+
+    size_t spec_len = strlen(spec);
+    for (int i = 0; i < data->num_decades; i++) {
+        if (strncmp(data->decades[i], spec, spec_len) == 0) {
+            return i;
+        }
+    }
+    return NAMEGEN_ERR_ARGUMENT;
+}
+
+// Funktio alustaa kutsun rivimuodon: JSONL-rivien loppuun tulee otsikko
+static void init_format(const NameGen *ctx, int kind, uint64_t seed, const char *key, const char *label,
+                        LineFormat *format) {
+    if (line_format_init(format, kind, key, label, seed) != 0) {
+        line_format_init(format, kind, key, "", seed); // Tarkistettu namegen_set_format:ssa
+    }
+    format->escape = ctx->escape[kind];
+}
+
+// Funktio palauttaa pisimmän rivin nimien enimmäispituuksista
+static size_t format_line_length(const NameGen *ctx, int kind, const char *key, const char *label,
+                                 size_t first, size_t middle, size_t last) {
+    if (kind == NAMEGEN_FORMAT_IDS) {
+        return SAMPLER_MAX_ID_LINE;
+    }
+    LineFormat format;
+    init_format(ctx, kind, UINT64_MAX, key, label, &format); // Pisin siemen
+    return line_format_max_line(&format, first, middle, last);
+}
+
+// Funktio palauttaa vuosikymmenen keskinimilistan (NULL, jos nimiä ei ole)
+static const NameList *middle_list(const NameGen *ctx, int decade) {
+    if (decade < ctx->middle_names.num_decades && ctx->middle_names.lists[decade].count > 0) {
+        return &ctx->middle_names.lists[decade];
+    }
+    return NULL;
+}
+
+// Funktio palauttaa listan pisimmän nimen pituuden
+static size_t longest_name(const NameList *list) {
+    size_t longest = 0;
+    for (int i = 0; list != NULL && i < list->count; i++) {
+        if (name_length(list, i) > longest) {
+            longest = name_length(list, i);
+        }
+    }
+    return longest;
+}
+
+// Funktio palauttaa vuosikymmenen mallien indeksit: etu-, keski- (-1, jos
+// keskinimiä ei ole) ja sukunimi
+static void markov_models(const NameGen *ctx, int decade, int models[3]) {
+    int num_first = ctx->first_names.num_decades;
+    models[0] = decade;
+    models[1] = (middle_list(ctx, decade) != NULL) ? num_first + decade : -1;
+    models[2] = num_first + ctx->middle_names.num_decades;
+}
+
+// Funktio palauttaa mallien pisimmän rivin. Merkit kopioidaan neljän tavun
+// paloina, joten viimeinen kopio voi ylittää rivin kolmella tavulla.
+static size_t markov_line_length(const NameGen *ctx, int kind, int decade) {
+    int models[3];
+    markov_models(ctx, decade, models);
+    size_t lengths[3];
+    for (int part = 0; part < 3; part++) {
+        lengths[part] = (models[part] >= 0) ? ctx->models[models[part]].header->max_length : 0;
+    }
+    return format_line_length(ctx, kind, "decade", ctx->first_names.decades[decade], lengths[0], lengths[1],
+                              lengths[2]) + 3;
+}
+
+size_t namegen_max_formatted_line(const NameGen *ctx, int format, int decade) {
+    if (decade < 0 || decade >= ctx->first_names.num_decades || format < 0 || format >= LINE_FORMAT_COUNT) {
+        return 0;
+    }
+    if (ctx->models != NULL) {
+        return markov_line_length(ctx, format, decade);
+    }
+    // Tekstinä etunimi, välilyönti, keskinimi, välilyönti, sukunimi ja rivinvaihto
+    const NameList *middle = ctx->conditional ? &ctx->cond.names : middle_list(ctx, decade);
+    return format_line_length(ctx, format, "decade", ctx->first_names.decades[decade],
+                              longest_name(&ctx->first_names.lists[decade]), longest_name(middle),
+                              longest_name(ctx->last));
+}
+
+size_t namegen_max_line_length(const NameGen *ctx, int decade) {
+    return namegen_max_formatted_line(ctx, ctx->format, decade);
+}
+
+int namegen_supports_years(const NameGen *ctx) {
+    return year_cache_supported(&ctx->years);
+}
+
+size_t namegen_year_max_line_length(NameGen *ctx, int year) {
+    YearTable *table;
+    if (year_cache_acquire(&ctx->years, year, &table) != NAMELIST_OK) {
+        return 0;
+    }
+    char label[16];
+    snprintf(label, sizeof(label), "%d", year);
+    size_t length = format_line_length(ctx, ctx->format, "year", label, longest_name(&table->first),
+                                       longest_name(&table->middle), longest_name(ctx->last));
+    year_cache_release(&ctx->years, table);
+    return length;
+}
+
+int namegen_set_year_cache(NameGen *ctx, int capacity) {
+    return (year_cache_resize(&ctx->years, capacity) == NAMELIST_OK) ? NAMEGEN_OK :
+           (capacity <= 0) ? NAMEGEN_ERR_ARGUMENT : NAMEGEN_ERR_NOMEM;
+}
+
+int namegen_set_emit_ids(NameGen *ctx, int emit_ids) {
+    return namegen_set_format(ctx, emit_ids ? NAMEGEN_FORMAT_IDS : NAMEGEN_FORMAT_TEXT, 0);
+}
+
+int namegen_supports_format(const NameGen *ctx, int format) {
+    if (format < NAMEGEN_FORMAT_TEXT || format > NAMEGEN_FORMAT_RECORDS) {
+        return 0;
+    }
+    int dictionary = (format == NAMEGEN_FORMAT_IDS || format == NAMEGEN_FORMAT_RECORDS);
+    return !dictionary || (ctx->has_corpus && !ctx->conditional && ctx->models == NULL);
+}
+
+int namegen_set_format(NameGen *ctx, int format, uint64_t seed) {
+    if (!namegen_supports_format(ctx, format)) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+    // Otsikoiden on mahduttava JSONL-rivin kiinteään loppuun
+    LineFormat probe;
+    for (int i = 0; i < ctx->first_names.num_decades; i++) {
+        if (line_format_init(&probe, format, "decade", ctx->first_names.decades[i], seed) != 0) {
+            return NAMEGEN_ERR_ARGUMENT;
+        }
+    }
+
+    ctx->format = format;
+    ctx->format_seed = seed;
+    return NAMEGEN_OK;
+}
+
+uint32_t namegen_dictionary_size(const NameGen *ctx) {
+    return ctx->has_corpus ? ctx->corpus.header->num_names : 0;
+}
+
+const char *namegen_dictionary_name(const NameGen *ctx, uint32_t id, size_t *length) {
+    if (id >= namegen_dictionary_size(ctx)) {
+        *length = 0;
+        return NULL;
+    }
+    *length = ctx->corpus.names[id].length;
+    return ctx->corpus.pool + ctx->corpus.names[id].offset;
+}
+
+int namegen_dictionary_data(const NameGen *ctx, const uint32_t **slices, const char **pool,
+                            uint64_t *pool_size) {
+    if (!ctx->has_corpus) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+    _Static_assert(sizeof(NameSlice) == 2 * sizeof(uint32_t), "NameSlice is not two words");
+    *slices = (const uint32_t *)ctx->corpus.names;
+    *pool = ctx->corpus.pool;
+    *pool_size = ctx->corpus.header->pool_size;
+    return NAMEGEN_OK;
+}
+
+void namegen_year_cache_stats(const NameGen *ctx, unsigned long long *hits, unsigned long long *misses) {
+    *hits = ctx->years.hits;
+    *misses = ctx->years.misses;
+}
+
+// --- 3. UUDET NIMET ---
+
+// Funktio lisää taulun kaikkien sarakkeiden nimet hylkäysjoukkoon
+static int add_existing(NameDict *set, const NameList *lists, int num_lists) {
+    for (int col = 0; col < num_lists; col++) {
+        const NameList *list = &lists[col];
+        for (int i = 0; i < list->count; i++) {
+            uint32_t length = (uint32_t)name_length(list, i);
+            if (name_dict_find(set, name_at(list, i), length) == NAME_DICT_NONE) {
+                name_dict_add(set, (uint32_t)(name_at(list, i) - set->pool), length);
+            }
+        }
+    }
+    return (set->error != 0) ? NAMEGEN_ERR_NOMEM : NAMEGEN_OK;
+}
+
+// Funktio hakee listan mallin korpuksesta tai opettaa sen
+static int load_model(const NameGen *ctx, const char *table, int column, const NameList *list,
+                      MarkovModel *model) {
+    if (ctx->has_corpus) {
+        int result = corpus_list_model(&ctx->corpus, corpus_find_table(&ctx->corpus, table), column, model);
+        if (result != NAMEGEN_OK || model->header != NULL) {
+            return result;
+        }
+    }
+    return markov_train(model, list, MARKOV_DEFAULT_ORDER);
+}
+
+int namegen_set_markov(NameGen *ctx, int markov, int reject_existing) {
+    int num_first = ctx->first_names.num_decades;
+    int num_middle = ctx->middle_names.num_decades;
+    if (ctx->models != NULL) {
+        for (int i = 0; i < num_first + num_middle + 1; i++) {
+            markov_free(&ctx->models[i]);
+            markov_exclusion_free(&ctx->exclusions[i]);
+        }
+        free(ctx->models);
+        free(ctx->exclusions);
+        ctx->models = NULL;
+        ctx->exclusions = NULL;
+    }
+    if (!markov) {
+        return NAMEGEN_OK;
+    }
+    if (ctx->conditional || dictionary_format(ctx)) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+
+    MarkovModel *models = (MarkovModel *)calloc((size_t)(num_first + num_middle + 1), sizeof(MarkovModel));
+    MarkovExclusion *exclusions =
+        (MarkovExclusion *)calloc((size_t)(num_first + num_middle + 1), sizeof(MarkovExclusion));
+    if (models == NULL || exclusions == NULL) {
+        free(models);
+        free(exclusions);
+        return NAMEGEN_ERR_NOMEM;
+    }
+    int result = NAMEGEN_OK;
+    for (int i = 0; i < num_first + num_middle + 1 && result == NAMEGEN_OK; i++) {
+        if (i < num_first) {
+            result = load_model(ctx, NAMEGEN_FIRST_NAMES, i, &ctx->first_names.lists[i], &models[i]);
+        } else if (i < num_first + num_middle) {
+            result = load_model(ctx, NAMEGEN_MIDDLE_NAMES, i - num_first,
+                                &ctx->middle_names.lists[i - num_first], &models[i]);
+        } else {
+            result = load_model(ctx, NAMEGEN_LAST_NAMES, 0, ctx->last, &models[i]);
+        }
+    }
+    if (result != NAMEGEN_OK) {
+        for (int i = 0; i < num_first + num_middle + 1; i++) {
+            markov_free(&models[i]);
+        }
+        free(models);
+        free(exclusions);
+        return result;
+    }
+    ctx->models = models;
+    ctx->exclusions = exclusions;
+
+    // Hylkäysjoukot: jokainen tiedoston nimi kerran (sarakkeissa samat nimet toistuvat)
+    if (!reject_existing) {
+        return NAMEGEN_OK;
+    }
+    NameDict existing[3];
+    name_dict_init(&existing[0], ctx->first_names.lists[0].pool);
+    name_dict_init(&existing[1], (num_middle > 0) ? ctx->middle_names.lists[0].pool : NULL);
+    name_dict_init(&existing[2], ctx->last->pool);
+    result = add_existing(&existing[0], ctx->first_names.lists, num_first);
+    if (result == NAMEGEN_OK) {
+        result = add_existing(&existing[1], ctx->middle_names.lists, num_middle);
+    }
+    if (result == NAMEGEN_OK) {
+        result = add_existing(&existing[2], ctx->last, 1);
+    }
+
+    // Pienestä listasta (esim. kaksi keskinimeä) malli ei keksi mitään uutta.
+    // Koearvonta kiinteällä siemenellä kertoo, voiko malli tuottaa uuden
+    // nimen; jos ei, listan nimiä ei hylätä, jotta generointi ei jumitu.
+    char probe[1024];
+    for (int i = 0; i < num_first + num_middle + 1 && result == NAMEGEN_OK; i++) {
+        const NameDict *set = &existing[(i < num_first) ? 0 : (i < num_first + num_middle) ? 1 : 2];
+        int reject = (models[i].header->max_length + 4 > sizeof(probe)); // Pitkiä nimiä ei koeta
+        Rng rng;
+        rng_seed(&rng, (uint64_t)i);
+        for (int attempt = 0; attempt < NAMEGEN_MARKOV_ATTEMPTS && !reject; attempt++) {
+            size_t length = markov_sample(&models[i], &rng, probe);
+            reject = (length > 0 && name_dict_find(set, probe, (uint32_t)length) == NAME_DICT_NONE);
+        }
+        if (reject) {
+            result = markov_exclusion_build(&exclusions[i], &models[i], set);
+        }
+    }
+    for (int part = 0; part < 3; part++) {
+        name_dict_free(&existing[part]);
+    }
+    if (result != NAMEGEN_OK) {
+        namegen_set_markov(ctx, 0, 0);
+    }
+    return result;
+}
+
+// Funktio arpoo nimen osan kohtaan out. Tyhjät ja liian pitkät nimet arvotaan
+// uudelleen; hylkäyksen kanssa lähdetiedostojen nimiä ei arvota lainkaan
+// (markov_sample_novel). Palauttaa pituuden tai 0, jos uutta nimeä ei löytynyt.
+static size_t markov_part(const MarkovModel *model, const MarkovExclusion *exclusion, Rng *rng, char *out) {
+    for (int attempt = 0; attempt < NAMEGEN_MARKOV_ATTEMPTS; attempt++) {
+        size_t length = (exclusion->nodes != NULL) ? markov_sample_novel(model, exclusion, rng, out)
+                                                   : markov_sample(model, rng, out);
+        if (length > 0) {
+            return length;
+        }
+    }
+    return 0;
+}
+
+// Funktio generoi rivit malleista. Satunnaislukujen määrä vaihtelee nimen
+// pituuden mukaan, mutta sama siemen antaa aina saman sarjan: etunimen merkit,
+// kolikko (jos keskinimiä on), keskinimen merkit ja sukunimen merkit.
+static long long generate_markov(const NameGen *ctx, int kind, uint64_t seed, Rng *rng, int decade, char *out,
+                                 size_t capacity, long long n, size_t *bytes_written) {
+    int models[3];
+    markov_models(ctx, decade, models);
+    size_t max_line = markov_line_length(ctx, kind, decade);
+    LineFormat format;
+    init_format(ctx, kind, seed, "decade", ctx->first_names.decades[decade], &format);
+    const LineFormat *f = &format;
+    size_t pos = 0;
+    long long i = 0;
+    for (; i < n && capacity - pos >= max_line; i++) {
+        char *p = out + pos;
+        memcpy(p, f->begin, f->begin_length);
+        p += f->begin_length;
+        size_t length = markov_part(&ctx->models[models[0]], &ctx->exclusions[models[0]], rng, p);
+        if (length == 0) {
+            *bytes_written = pos;
+            return NAMEGEN_ERR_EXHAUSTED;
+        }
+        p += line_format_escape_in_place(f, p, length);
+        if (models[1] >= 0 && rng_coin(rng)) {
+            memcpy(p, f->middle, f->middle_length);
+            p += f->middle_length;
+            length = markov_part(&ctx->models[models[1]], &ctx->exclusions[models[1]], rng, p);
+            if (length == 0) {
+                *bytes_written = pos;
+                return NAMEGEN_ERR_EXHAUSTED;
+            }
+            p += line_format_escape_in_place(f, p, length);
+            memcpy(p, f->last, f->last_length);
+            p += f->last_length;
+        } else {
+            memcpy(p, f->no_middle, f->no_middle_length);
+            p += f->no_middle_length;
+        }
+        length = markov_part(&ctx->models[models[2]], &ctx->exclusions[models[2]], rng, p);
+        if (length == 0) {
+            *bytes_written = pos;
+            return NAMEGEN_ERR_EXHAUSTED;
+        }
+        p += line_format_escape_in_place(f, p, length);
+        memcpy(p, f->end, f->end_length);
+        p += f->end_length;
+        pos = (size_t)(p - out);
+    }
+    *bytes_written = pos;
+    return i;
+}
+
+// --- 4. GENEROINTI ---
+
+// Satunnaislukujen käyttö on kuvattu sampler.h:ssa. Painotetuilla listoilla
+// ydin käyttää alias-taulua.
+long long namegen_generate_formatted(const NameGen *ctx, int format, uint64_t seed, Rng *rng, int decade,
+                                     char *out_buffer, size_t capacity, long long n, size_t *bytes_written) {
+    *bytes_written = 0;
+    if (decade < 0 || decade >= ctx->first_names.num_decades ||
+        ctx->first_names.lists[decade].count == 0 || n < 0 || !namegen_supports_format(ctx, format)) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+
+    if (ctx->models != NULL) {
+        return generate_markov(ctx, format, seed, rng, decade, out_buffer, capacity, n, bytes_written);
+    }
+
+    Sampler sampler;
+    LineFormat line_format;
+    sampler_init(&sampler, &ctx->first_names.lists[decade], middle_list(ctx, decade), ctx->last);
+    if (format != NAMEGEN_FORMAT_TEXT) {
+        init_format(ctx, format, seed, "decade", ctx->first_names.decades[decade], &line_format);
+        sampler.format = &line_format;
+    }
+    if (ctx->conditional) {
+        sampler_set_conditional(&sampler, &ctx->cond, decade);
+    }
+    return sampler_generate(&sampler, rng, out_buffer, capacity, n, bytes_written);
+}
+
+long long namegen_generate_batch(const NameGen *ctx, Rng *rng, int decade,
+                                 char *out_buffer, size_t capacity, long long n,
+                                 size_t *bytes_written) {
+    return namegen_generate_formatted(ctx, ctx->format, ctx->format_seed, rng, decade, out_buffer, capacity, n,
+                                      bytes_written);
+}
+
+long long namegen_generate_year(NameGen *ctx, Rng *rng, int year,
+                                char *out_buffer, size_t capacity, long long n,
+                                size_t *bytes_written) {
+    *bytes_written = 0;
+    if (n < 0 || ctx->conditional || ctx->models != NULL) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+
+    YearTable *table;
+    int result = year_cache_acquire(&ctx->years, year, &table);
+    if (result != NAMELIST_OK) {
+        return (result == NAMELIST_ERR_FORMAT) ? NAMEGEN_ERR_ARGUMENT : result;
+    }
+
+    // Lämpimällä välimuistilla kustannus on sama kuin vuosikymmenellä:
+    // yksi haku ja valmiit alias-taulut
+    long long written = NAMEGEN_ERR_ARGUMENT;
+    if (table->first.count > 0) {
+        Sampler sampler;
+        LineFormat format;
+        sampler_init(&sampler, &table->first, (table->middle.count > 0) ? &table->middle : NULL, ctx->last);
+        if (ctx->format != NAMEGEN_FORMAT_TEXT) {
+            char label[16];
+            snprintf(label, sizeof(label), "%d", year);
+            init_format(ctx, ctx->format, ctx->format_seed, "year", label, &format);
+            sampler.format = &format;
+        }
+        written = sampler_generate(&sampler, rng, out_buffer, capacity, n, bytes_written);
+    }
+    year_cache_release(&ctx->years, table);
+    return written;
+}
+
+// --- 5. YKSIKÄSITTEISET NIMET ---
+
+// Funktio rakentaa listat ilman toistuvia nimiä ensimmäisellä kutsulla. Sarakkeissa
+// voi olla sama nimi kahdesti, ja yhdistelmien on oltava eri nimiä.
+// Korpuksen avaaminen ei siis maksa näistä mitään, jos --unique ei ole käytössä.
+static int unique_lists(NameGen *ctx, const NameList **lists) {
+    int num_first = ctx->first_names.num_decades;
+    int num_middle = ctx->middle_names.num_decades;
+    int result = NAMEGEN_OK;
+
+    pthread_mutex_lock(&ctx->unique_lock);
+    if (ctx->unique_lists == NULL) {
+        NameList *built = (NameList *)calloc((size_t)(num_first + num_middle + 1), sizeof(NameList));
+        if (built == NULL) {
+            result = NAMEGEN_ERR_NOMEM;
+        }
+        for (int i = 0; i < num_first + num_middle + 1 && result == NAMEGEN_OK; i++) {
+            const NameList *source = (i < num_first) ? &ctx->first_names.lists[i] :
+                                     (i < num_first + num_middle) ? &ctx->middle_names.lists[i - num_first] :
+                                     ctx->last;
+            result = distinct_names(source, &built[i]);
+        }
+        if (result == NAMEGEN_OK) {
+            ctx->unique_lists = built;
+        } else if (built != NULL) {
+            for (int i = 0; i < num_first + num_middle + 1; i++) {
+                free_names(&built[i]);
+            }
+            free(built);
+        }
+    }
+    pthread_mutex_unlock(&ctx->unique_lock);
+
+    *lists = ctx->unique_lists;
+    return result;
+}
+
+// Funktio valmistelee vuosikymmenen otannan listoista ilman toistuvia nimiä
+static int decade_sampler(NameGen *ctx, int decade, Sampler *sampler, LineFormat *format) {
+    if (ctx->conditional || ctx->models != NULL || decade < 0 || decade >= ctx->first_names.num_decades || ctx->first_names.lists[decade].count == 0) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+    const NameList *lists;
+    int result = unique_lists(ctx, &lists);
+    if (result != NAMEGEN_OK) {
+        return result;
+    }
+    int num_first = ctx->first_names.num_decades;
+    const NameList *middle = (middle_list(ctx, decade) != NULL) ? &lists[num_first + decade] : NULL;
+    sampler_init(sampler, &lists[decade], middle,
+                 &lists[num_first + ctx->middle_names.num_decades]);
+    if (ctx->format != NAMEGEN_FORMAT_TEXT) {
+        init_format(ctx, ctx->format, ctx->format_seed, "decade", ctx->first_names.decades[decade], format);
+        sampler->format = format;
+    }
+    return NAMEGEN_OK;
+}
+
+// Funktio valmistelee vuoden otannan. Sekoitetuissa listoissa jokainen nimi on
+// valmiiksi kerran; sukunimet otetaan listasta ilman toistuvia nimiä.
+static int year_sampler(NameGen *ctx, int year, const YearTable *table, Sampler *sampler, LineFormat *format) {
+    if (ctx->conditional || ctx->models != NULL || table->first.count == 0) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+    const NameList *lists;
+    int result = unique_lists(ctx, &lists);
+    if (result != NAMEGEN_OK) {
+        return result;
+    }
+    sampler_init(sampler, &table->first, (table->middle.count > 0) ? &table->middle : NULL,
+                 &lists[ctx->first_names.num_decades + ctx->middle_names.num_decades]);
+    if (ctx->format != NAMEGEN_FORMAT_TEXT) {
+        char label[16];
+        snprintf(label, sizeof(label), "%d", year);
+        init_format(ctx, ctx->format, ctx->format_seed, "year", label, format);
+        sampler->format = format;
+    }
+    return NAMEGEN_OK;
+}
+
+// Funktio kirjoittaa permutaation nimet first_index ... first_index + n - 1
+static long long generate_unique(const Sampler *sampler, uint64_t seed, uint64_t first_index,
+                                 char *out_buffer, size_t capacity, long long n, size_t *bytes_written) {
+    uint64_t space = sampler_space(sampler);
+    if (n < 0) {
+        return NAMEGEN_ERR_ARGUMENT;
+    }
+    if (space == 0 || first_index > space || (uint64_t)n > space - first_index) {
+        return NAMEGEN_ERR_EXHAUSTED;
+    }
+    Permutation perm;
+    permutation_init(&perm, space, seed);
+    return sampler_generate_unique(sampler, &perm, first_index, out_buffer, capacity, n, bytes_written);
+}
+
+uint64_t namegen_unique_space(NameGen *ctx, int decade) {
+    Sampler sampler;
+    LineFormat format;
+    return (decade_sampler(ctx, decade, &sampler, &format) == NAMEGEN_OK) ? sampler_space(&sampler) : 0;
+}
+
+long long namegen_generate_unique(NameGen *ctx, uint64_t seed, int decade, uint64_t first_index,
+                                  char *out_buffer, size_t capacity, long long n, size_t *bytes_written) {
+    *bytes_written = 0;
+    Sampler sampler;
+    LineFormat format;
+    int result = decade_sampler(ctx, decade, &sampler, &format);
+    if (result != NAMEGEN_OK) {
+        return result;
+    }
+    return generate_unique(&sampler, seed, first_index, out_buffer, capacity, n, bytes_written);
+}
+
+uint64_t namegen_unique_space_year(NameGen *ctx, int year) {
+    YearTable *table;
+    if (year_cache_acquire(&ctx->years, year, &table) != NAMELIST_OK) {
+        return 0;
+    }
+    uint64_t space = 0;
+    Sampler sampler;
+    LineFormat format;
+    if (year_sampler(ctx, year, table, &sampler, &format) == NAMEGEN_OK) {
+        space = sampler_space(&sampler);
+    }
+    year_cache_release(&ctx->years, table);
+    return space;
+}
+
+long long namegen_generate_unique_year(NameGen *ctx, uint64_t seed, int year, uint64_t first_index,
+                                       char *out_buffer, size_t capacity, long long n, size_t *bytes_written) {
+    *bytes_written = 0;
+    YearTable *table;
+    int result = year_cache_acquire(&ctx->years, year, &table);
+    if (result != NAMELIST_OK) {
+        return (result == NAMELIST_ERR_FORMAT) ? NAMEGEN_ERR_ARGUMENT : result;
+    }
+
+    Sampler sampler;
+    LineFormat format;
+    long long written = year_sampler(ctx, year, table, &sampler, &format);
+    if (written == NAMEGEN_OK) {
+        written = generate_unique(&sampler, seed, first_index, out_buffer, capacity, n, bytes_written);
+    }
+    year_cache_release(&ctx->years, table);
+    return written;
+}
@@ -0,0 +1,253 @@
+/**
+* @file libnamegen.h
+* @brief Embeddable name generation library (libnamegen).
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef LIBNAMEGEN_H
+#define LIBNAMEGEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rng.h"
+
+// Kirjaston käyttö lyhyesti:
+//
+//   NameGen *ctx;
+//   if (namegen_open_corpus("data/FI-fi.ngc", &ctx) != NAMEGEN_OK) { ... }
+//   Rng rng;
+//   rng_seed(&rng, 42);
+//   size_t bytes;
+//   long long n = namegen_generate_batch(ctx, &rng, decade, buffer, sizeof(buffer), 1000, &bytes);
+//   namegen_close(ctx);
+//
+// Kirjasto ei tulosta mitään eikä lopeta ohjelmaa: kaikki virheet palautetaan
+// koodeina. Avattu konteksti on vain luettava, joten samaa kontekstia voi käyttää
+// useasta säikeestä, kunhan jokaisella säikeellä on oma Rng.
+
+// Paluuarvot (samat kuin NAMELIST_*-koodit)
+#define NAMEGEN_OK 0
+#define NAMEGEN_ERR_IO (-1)          // Tiedostoa ei voitu avata
+#define NAMEGEN_ERR_NOMEM (-2)       // Muisti loppui
+#define NAMEGEN_ERR_FORMAT (-3)      // Tiedosto tai korpus on virheellinen
+#define NAMEGEN_ERR_VERSION (-4)     // Korpus on käännetty eri versiolla
+#define NAMEGEN_ERR_TOO_LARGE (-5)   // Tiedosto on yli 4 GiB
+#define NAMEGEN_ERR_MISSING (-6)     // Pakollinen nimilista puuttuu tai on tyhjä
+#define NAMEGEN_ERR_ARGUMENT (-7)    // Virheellinen argumentti (esim. vuosikymmen)
+#define NAMEGEN_ERR_EXHAUSTED (-8)   // Eri nimiä pyydettiin enemmän kuin yhdistelmiä on
+
+// Oletushakemisto ja sen tiedostot. Korpuksesta taulut haetaan samoilla nimillä.
+#define NAMEGEN_DEFAULT_LOCALE "data/FI-fi"
+#define NAMEGEN_FIRST_NAMES "Finnish-men-firts-names.csv"
+#define NAMEGEN_MIDDLE_NAMES "Finnish-men-seconds-names.csv"
+#define NAMEGEN_LAST_NAMES "Finnish-men-last-names.csv"
+#define NAMEGEN_COMBINATIONS "Finnish-Most-common-name-combinations-for-men.csv"
+
+// Läpinäkymätön konteksti: ladatut nimilistat ja otantataulut
+typedef struct NameGen NameGen;
+
+// Palauttaa virhekoodin kuvauksen englanniksi
+const char *namegen_strerror(int status);
+
+// Lataa nimet hakemiston CSV-tiedostoista. Keskinimet ovat vapaaehtoisia.
+int namegen_open_directory(const char *locale_dir, NameGen **ctx);
+
+// Avaa ngcompile-ohjelmalla käännetyn korpuksen (ei jäsennystä)
+int namegen_open_corpus(const char *corpus_file, NameGen **ctx);
+
+// Vapauttaa kontekstin (NULL sallitaan)
+void namegen_close(NameGen *ctx);
+
+// Valitsee otannan: weighted = 0 tasainen, muuten painotettu (lukumääräsarake
+// tai Zipfin laki eksponentilla zipf_exponent). Korpus käyttää käännettyjä
+// taulujaan, joten eksponentti ei vaikuta siihen. Ei säieturvallinen: kutsu
+// ennen generointia.
+int namegen_set_weighting(NameGen *ctx, int weighted, double zipf_exponent);
+
+// --- TIEDOT ---
+
+int namegen_num_decades(const NameGen *ctx);
+
+// Vuosikymmenen otsikko ("1890–99", UTF-8). NULL virheelliselle indeksille.
+const char *namegen_decade_label(const NameGen *ctx, int decade);
+
+// Vuosikymmenen etunimien määrä
+int namegen_decade_size(const NameGen *ctx, int decade);
+
+// Onko keskinimiä ladattu
+int namegen_has_middle_names(const NameGen *ctx);
+
+// Etsii vuosikymmenen numerolla (1-N) tai otsikon alulla ("1890").
+// Palauttaa indeksin tai NAMEGEN_ERR_ARGUMENT.
+int namegen_find_decade(const NameGen *ctx, const char *spec);
+
+// Pisimmän mahdollisen rivin pituus vuosikymmenellä (rivinvaihto mukaan lukien).
+// n nimeä mahtuu aina n * namegen_max_line_length tavuun.
+size_t namegen_max_line_length(const NameGen *ctx, int decade);
+
+// --- SANAKIRJA ---
+// Korpuksessa jokainen eri nimi on kerran sanakirjassa, ja listat ovat 16- tai
+// 32-bittisiä tunnisteita siihen. Tunniste tarkoittaa samaa nimeä kaikissa
+// tauluissa, joten generoinnin voi tulostaa tunnisteina ja muuntaa nimiksi myöhemmin.
+
+// Kirjoitetaanko rivit tunnisteina ("17 4 230") nimien sijaan. Vain korpukselle
+// (muuten NAMEGEN_ERR_ARGUMENT). Ei säieturvallinen: kutsu ennen generointia.
+// Sama kuin namegen_set_format(ctx, NAMEGEN_FORMAT_IDS, 0).
+int namegen_set_emit_ids(NameGen *ctx, int emit_ids);
+
+// --- RIVIMUODOT ---
+// Generointi kirjoittaa nimet suoraan listojen poolista valittuun muotoon
+// ilman välimerkkijonoja. Muodon kiinteät osat (erottimet, JSON-avaimet,
+// vuosikymmen ja siemen) kootaan kerran kutsua kohden.
+#define NAMEGEN_FORMAT_TEXT 0      // "Etu Keski Suku\n" (oletus)
+#define NAMEGEN_FORMAT_IDS 1       // "17 4 230\n" (vain korpus)
+#define NAMEGEN_FORMAT_CSV 2       // RFC 4180 ilman otsikkoriviä: "Etu,Keski,Suku\r\n", "Etu,,Suku\r\n"
+#define NAMEGEN_FORMAT_JSONL 3     // {"first":"Etu","middle":null,"last":"Suku","decade":"1890–99","seed":42}
+#define NAMEGEN_FORMAT_RECORDS 4   // 12 tavua per nimi: etu-, keski- ja sukunimen tunnisteet
+                                   // (uint32, koneen tavujärjestys; NAMEGEN_NO_MIDDLE = ei keskinimeä)
+#define NAMEGEN_NO_MIDDLE UINT32_MAX
+#define NAMEGEN_RECORD_SIZE 12
+
+// Valitsee rivimuodon. seed kirjoitetaan JSONL-riveille; vuosigeneroinnissa
+// vuosikymmenen tilalla on "year". CSV- ja JSONL-kentät lainataan vain, jos
+// jossain ladatussa nimessä on lainattava merkki (tarkistetaan kerran avattaessa).
+// Tunnisteet ja tietueet vaativat korpuksen eivätkä sovi ehdolliseen
+// keskinimeen tai malleihin (NAMEGEN_ERR_ARGUMENT). Ei säieturvallinen: kutsu
+// ennen generointia.
+int namegen_set_format(NameGen *ctx, int format, uint64_t seed);
+
+// Palauttaa 1, jos kontekstilla voi generoida muodossa format (tunnisteet ja
+// tietueet vain korpukselle ilman ehdollista keskinimeä ja malleja), muuten 0
+int namegen_supports_format(const NameGen *ctx, int format);
+
+// Sanakirjan nimien määrä (0 ilman korpusta)
+uint32_t namegen_dictionary_size(const NameGen *ctx);
+
+// Tunnisteen nimi (ei NUL-päätteinen) ja pituus, NULL virheelliselle tunnisteelle
+const char *namegen_dictionary_name(const NameGen *ctx, uint32_t id, size_t *length);
+
+// Koko sanakirja suoraan korpuksen kuvauksesta: *slices on num_names paria
+// (offset, length) uint32-lukuina ja *pool merkkijonot. NAMEGEN_ERR_ARGUMENT
+// ilman korpusta. Muisti on voimassa kontekstin sulkemiseen asti.
+int namegen_dictionary_data(const NameGen *ctx, const uint32_t **slices, const char **pool,
+                            uint64_t *pool_size);
+
+// --- EHDOLLINEN KESKINIMI ---
+// Yhdistelmätiedoston parit ("Juho Kustaa") antavat jokaiselle etunimelle oman
+// keskinimijakauman. Etunimet, joita yhdistelmissä ei ole, saavat vuosikymmenen
+// tavallisen keskinimilistan. Otanta maksaa saman kuin riippumaton: yksi rivin
+// haku ja yksi alias-haku. Rivit rakennetaan uudelleen, jos painotus vaihtuu.
+
+// Kytkee ehdollisen otannan päälle tai pois. NAMEGEN_ERR_MISSING, jos
+// yhdistelmätiedostoa ei ole. Ei säieturvallinen: kutsu ennen generointia.
+// Ei yhdistettävissä vuosiin, tunnisteisiin eikä yksikäsitteisiin nimiin
+// (ne palauttavat NAMEGEN_ERR_ARGUMENT).
+int namegen_set_conditional(NameGen *ctx, int conditional);
+
+// --- UUDET NIMET (MARKOV) ---
+// Jokaiselle listalle opetetaan merkkitason n-grammimalli (ä ja ö ovat yksi
+// merkki), ja etu-, keski- ja sukunimi arvotaan merkki kerrallaan malleista.
+// Korpukseen käännetyt mallit käytetään suoraan kuvauksesta; hakemistosta
+// avattaessa mallit opetetaan, kun tila kytketään päälle.
+
+// Kytkee mallit päälle tai pois. Jos reject_existing on nollasta poikkeava,
+// nimet, jotka löytyvät jo lähdetiedostosta, arvotaan uudelleen (paitsi
+// listoista, joista malli ei keksi yhtään uutta nimeä). Ei
+// säieturvallinen: kutsu ennen generointia. Ei yhdistettävissä vuosiin,
+// tunnisteisiin, ehdolliseen keskinimeen eikä yksikäsitteisiin nimiin.
+int namegen_set_markov(NameGen *ctx, int markov, int reject_existing);
+
+// Uudelleenarvontojen yläraja nimeä kohden. Jos malli ei tuota uutta nimeä
+// näin monella yrityksellä, generointi palauttaa NAMEGEN_ERR_EXHAUSTED.
+#define NAMEGEN_MARKOV_ATTEMPTS 1000
+
+// --- VUODET ---
+// Vuosi y saa kahden lähimmän vuosikymmenen jakaumat lineaarisesti painottaen:
+// 1890–99:n keskikohta on 1894.5, joten 1899 saa siitä 55 % ja 1900–09:stä 45 %.
+// Ensimmäistä keskikohtaa aiemmat ja viimeistä myöhemmät vuodet saavat reunan
+// vuosikymmenen. Sekoitetut taulut rakennetaan ensimmäisellä käytöllä ja pidetään
+// rajatussa LRU-välimuistissa, joten toistuva vuosi maksaa yhden haun.
+
+// Onko vuosikymmenten otsikoissa vuosiluvut (muuten vuosia ei voi käyttää)
+int namegen_supports_years(const NameGen *ctx);
+
+// Kuten namegen_max_line_length, mutta vuoden sekoitetuille listoille (0 virheessä)
+size_t namegen_year_max_line_length(NameGen *ctx, int year);
+
+// Vaihtaa välimuistin koon (oletus 128 vuotta). Säieturvallinen.
+int namegen_set_year_cache(NameGen *ctx, int capacity);
+
+// Välimuistin osumat ja rakennetut taulut
+void namegen_year_cache_stats(const NameGen *ctx, unsigned long long *hits, unsigned long long *misses);
+
+// --- GENEROINTI ---
+
+// Generoi enintään n nimeä vuosikymmeneltä kutsujan puskuriin, yksi nimi
+// riviä kohden ('\n' tai valitun rivimuodon mukaan, ei NUL-päätettä). Ei varaa muistia ja on säieturvallinen.
+// Jos puskuri täyttyy, generointi pysähtyy ja rng jää ensimmäisen kirjoittamatta
+// jääneen nimen kohdalle, joten seuraava kutsu jatkaa samaa sarjaa.
+// Palauttaa kirjoitettujen nimien määrän ja tavut muuttujaan *bytes_written,
+// tai negatiivisen virhekoodin.
+long long namegen_generate_batch(const NameGen *ctx, Rng *rng, int decade,
+                                 char *out_buffer, size_t capacity, long long n,
+                                 size_t *bytes_written);
+
+// Kuten namegen_generate_batch, mutta muoto ja JSONL-rivien siemen annetaan
+// kutsussa eikä kontekstin muotoa käytetä, joten yksi konteksti voi palvella
+// eri muotoja yhtä aikaa. Tunnisteet ja tietueet kuten namegen_set_format.
+long long namegen_generate_formatted(const NameGen *ctx, int format, uint64_t seed, Rng *rng, int decade,
+                                     char *out_buffer, size_t capacity, long long n, size_t *bytes_written);
+
+// Kuten namegen_max_line_length muodolle format
+size_t namegen_max_formatted_line(const NameGen *ctx, int format, int decade);
+
+// Kuten namegen_generate_batch, mutta vuoden sekoitetuista listoista.
+// Säieturvallinen (välimuisti on lukittu). NAMEGEN_ERR_ARGUMENT, jos
+// otsikoissa ei ole vuosia.
+long long namegen_generate_year(NameGen *ctx, Rng *rng, int year,
+                                char *out_buffer, size_t capacity, long long n,
+                                size_t *bytes_written);
+
+// --- YKSIKÄSITTEISET NIMET ---
+// Vuosikymmenen kaikki yhdistelmät (etunimi, keskinimi tai ei keskinimeä,
+// sukunimi) numeroidaan, ja siemen valitsee niille satunnaisen järjestyksen
+// (Feistel-permutaatio). Järjestyksen nimet 0 ... N - 1 ovat kaikki eri nimiä;
+// muistia ei tarvita eikä aiempia nimiä tarkisteta. Otanta on tasainen
+// yhdistelmien yli, joten painotus ei vaikuta siihen. Sarakkeen toistuvat nimet
+// lasketaan kerran. Säieturvallinen.
+
+// Yhdistelmien määrä (0 virheelliselle vuosikymmenelle)
+uint64_t namegen_unique_space(NameGen *ctx, int decade);
+
+// Kirjoittaa järjestyksen nimet first_index ... first_index + n - 1 kuten
+// namegen_generate_batch. Sama siemen antaa saman järjestyksen, joten peräkkäiset
+// kutsut (tai säikeet eri alueilla) jatkavat samaa sarjaa ilman toistoja.
+// NAMEGEN_ERR_EXHAUSTED, jos first_index + n ylittää yhdistelmien määrän.
+long long namegen_generate_unique(NameGen *ctx, uint64_t seed, int decade, uint64_t first_index,
+                                  char *out_buffer, size_t capacity, long long n, size_t *bytes_written);
+
+// Samat vuoden sekoitetuille listoille
+uint64_t namegen_unique_space_year(NameGen *ctx, int year);
+long long namegen_generate_unique_year(NameGen *ctx, uint64_t seed, int year, uint64_t first_index,
+                                       char *out_buffer, size_t capacity, long long n, size_t *bytes_written);
+
+#endif // LIBNAMEGEN_H
@@ -0,0 +1,201 @@
+/**
+* @file lineformat.c
+* @brief Line formats for generated names: text, IDs, RFC 4180 CSV, JSON Lines and binary records.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lineformat.h"
+
+// Funktio kopioi kiinteän osan muotoon ja tallentaa sen pituuden
+static void set_part(char *part, size_t size, uint32_t *length, const char *text) {
+    size_t n = strlen(text);
+    if (n >= size) {
+        n = size - 1;
+    }
+    memcpy(part, text, n);
+    part[n] = '\0';
+    *length = (uint32_t)n;
+}
+
+int line_format_init(LineFormat *format, int kind, const char *key, const char *label, uint64_t seed) {
+    memset(format, 0, sizeof(*format));
+    format->kind = kind;
+    switch (kind) {
+    case LINE_FORMAT_TEXT:
+        set_part(format->middle, sizeof(format->middle), &format->middle_length, " ");
+        set_part(format->last, sizeof(format->last), &format->last_length, " ");
+        set_part(format->no_middle, sizeof(format->no_middle), &format->no_middle_length, " ");
+        set_part(format->end, sizeof(format->end), &format->end_length, "\n");
+        return 0;
+    case LINE_FORMAT_CSV:
+        set_part(format->middle, sizeof(format->middle), &format->middle_length, ",");
+        set_part(format->last, sizeof(format->last), &format->last_length, ",");
+        set_part(format->no_middle, sizeof(format->no_middle), &format->no_middle_length, ",,");
+        set_part(format->end, sizeof(format->end), &format->end_length, "\r\n");
+        return 0;
+    case LINE_FORMAT_JSONL: {
+        set_part(format->begin, sizeof(format->begin), &format->begin_length, "{\"first\":\"");
+        set_part(format->middle, sizeof(format->middle), &format->middle_length, "\",\"middle\":\"");
+        set_part(format->last, sizeof(format->last), &format->last_length, "\",\"last\":\"");
+        set_part(format->no_middle, sizeof(format->no_middle), &format->no_middle_length,
+                 "\",\"middle\":null,\"last\":\"");
+
+        // Otsikko lainataan kuten nimet (otsikot ovat lyhyitä, ks. koko)
+        char quoted[96];
+        size_t label_length = strlen(label);
+        if (line_format_needs_escape(kind, label, label_length)) {
+            LineFormat escaping = *format;
+            escaping.escape = 1;
+            if (line_format_field_bound(&escaping, label_length) >= sizeof(quoted)) {
+                return -1;
+            }
+            label_length = line_format_write_field(&escaping, quoted, label, label_length);
+        } else if (label_length < sizeof(quoted)) {
+            memcpy(quoted, label, label_length);
+        } else {
+            return -1;
+        }
+        int n = snprintf(format->end, sizeof(format->end), "\",\"%s\":\"%.*s\",\"seed\":%llu}\n",
+                         key, (int)label_length, quoted, (unsigned long long)seed);
+        if (n <= 0 || (size_t)n >= sizeof(format->end)) {
+            return -1;
+        }
+        format->end_length = (uint32_t)n;
+        return 0;
+    }
+    case LINE_FORMAT_IDS:
+    case LINE_FORMAT_RECORDS:
+        return 0; // Ei tekstiosia
+    default:
+        return -1;
+    }
+}
+
+int line_format_needs_escape(int kind, const char *name, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)name[i];
+        if (kind == LINE_FORMAT_CSV && (c == ',' || c == '"' || c == '\r' || c == '\n')) {
+            return 1;
+        }
+        if (kind == LINE_FORMAT_JSONL && (c == '"' || c == '\\' || c < 0x20)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+size_t line_format_field_bound(const LineFormat *format, size_t length) {
+    if (!format->escape) {
+        return length;
+    }
+    // CSV: lainausmerkit ympärille ja jokainen " kahdennetaan; JSON: \u00XX
+    return (format->kind == LINE_FORMAT_CSV) ? 2 * length + 2 : 6 * length;
+}
+
+size_t line_format_max_line(const LineFormat *format, size_t first, size_t middle, size_t last) {
+    if (format->kind == LINE_FORMAT_RECORDS) {
+        return LINE_RECORD_SIZE;
+    }
+    size_t with_middle = line_format_field_bound(format, middle) + format->middle_length + format->last_length;
+    size_t separators = (middle > 0 && with_middle > format->no_middle_length) ? with_middle : format->no_middle_length;
+    return format->begin_length + line_format_field_bound(format, first) + separators +
+           line_format_field_bound(format, last) + format->end_length;
+}
+
+// Funktio kirjoittaa merkin JSON-koodattuna ja palauttaa pituuden
+static size_t json_escape(char *out, unsigned char c) {
+    static const char hex[] = "0123456789abcdef";
+    if (c == '"' || c == '\\') {
+        out[0] = '\\';
+        out[1] = (char)c;
+        return 2;
+    }
+    if (c < 0x20) {
+        memcpy(out, "\\u00", 4);
+        out[4] = hex[c >> 4];
+        out[5] = hex[c & 15];
+        return 6;
+    }
+    out[0] = (char)c;
+    return 1;
+}
+
+size_t line_format_write_field(const LineFormat *format, char *out, const char *name, size_t length) {
+    if (!format->escape) {
+        memcpy(out, name, length);
+        return length;
+    }
+    char *p = out;
+    if (format->kind == LINE_FORMAT_CSV) {
+        *p++ = '"';
+        for (size_t i = 0; i < length; i++) {
+            if (name[i] == '"') {
+                *p++ = '"';
+            }
+            *p++ = name[i];
+        }
+        *p++ = '"';
+    } else {
+        for (size_t i = 0; i < length; i++) {
+            p += json_escape(p, (unsigned char)name[i]);
+        }
+    }
+    return (size_t)(p - out);
+}
+
+size_t line_format_escape_in_place(const LineFormat *format, char *field, size_t length) {
+    if (!format->escape) {
+        return length;
+    }
+    // Lainattu kenttä kirjoitetaan lopusta alkuun, jolloin lähde ei ylikirjoitu
+    size_t escaped = 0;
+    char encoded[6];
+    for (size_t i = 0; i < length; i++) {
+        escaped += (format->kind == LINE_FORMAT_CSV) ? (field[i] == '"' ? 2 : 1)
+                                                     : json_escape(encoded, (unsigned char)field[i]);
+    }
+    if (format->kind == LINE_FORMAT_CSV) {
+        escaped += 2;
+    }
+    char *p = field + escaped;
+    if (format->kind == LINE_FORMAT_CSV) {
+        *--p = '"';
+    }
+    for (size_t i = length; i-- > 0;) {
+        if (format->kind == LINE_FORMAT_CSV) {
+            *--p = field[i];
+            if (field[i] == '"') {
+                *--p = '"';
+            }
+        } else {
+            size_t n = json_escape(encoded, (unsigned char)field[i]);
+            p -= n;
+            memcpy(p, encoded, n);
+        }
+    }
+    if (format->kind == LINE_FORMAT_CSV) {
+        *--p = '"';
+    }
+    return escaped;
+}
@@ -0,0 +1,86 @@
+/**
+* @file lineformat.h
+* @brief Line formats for generated names: text, IDs, RFC 4180 CSV, JSON Lines and binary records.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef LINEFORMAT_H
+#define LINEFORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Rivimuodot. Arvot ovat samat kuin libnamegen.h:n NAMEGEN_FORMAT_*.
+#define LINE_FORMAT_TEXT 0      // "Etu Keski Suku\n"
+#define LINE_FORMAT_IDS 1       // "17 4 230\n" (sanakirjan tunnisteet)
+#define LINE_FORMAT_CSV 2       // RFC 4180: "Etu,Keski,Suku\r\n", puuttuva keskinimi tyhjänä kenttänä
+#define LINE_FORMAT_JSONL 3     // {"first":"Etu","middle":"Keski"|null,"last":"Suku","decade":"...","seed":N}
+#define LINE_FORMAT_RECORDS 4   // Binääri: etu, keski (LINE_NO_MIDDLE = ei) ja suku uint32-lukuina
+#define LINE_FORMAT_COUNT 5
+
+#define LINE_NO_MIDDLE UINT32_MAX
+#define LINE_RECORD_SIZE 12
+
+// Tekstimuotoinen rivi kootaan kiinteistä osista ja nimistä:
+//   begin + etu + middle + keski + last + suku + end     (keskinimen kanssa)
+//   begin + etu + no_middle + suku + end                 (ilman keskinimeä)
+// Nimet kopioidaan suoraan listojen poolista. Jos jossain lähteen nimessä on
+// merkki, joka pitää lainata (CSV: , " CR LF; JSON: " \ ja ohjausmerkit),
+// escape on asetettu ja nimet kirjoitetaan line_format_write_field-funktiolla.
+typedef struct {
+    int kind;                 // LINE_FORMAT_*
+    int escape;               // Kirjoitetaanko kentät lainattuina (hidas polku)
+    uint32_t begin_length;
+    uint32_t middle_length;
+    uint32_t last_length;
+    uint32_t no_middle_length;
+    uint32_t end_length;
+    char begin[16];           // Koot ovat 16:n monikertoja: osat voi kopioida
+    char middle[32];          // 16 tavun paloina lukematta taulukon ohi
+    char last[32];
+    char no_middle[48];
+    char end[160];
+} LineFormat;
+
+// Alustaa muodon. JSONL-rivien loppuun kirjoitetaan kenttä key ("decade" tai
+// "year") arvolla label sekä seed. escape on aluksi 0. Palauttaa 0 tai -1
+// (tuntematon muoto tai liian pitkä otsikko).
+int line_format_init(LineFormat *format, int kind, const char *key, const char *label, uint64_t seed);
+
+// Tarvitseeko nimi lainausta muodossa kind (1) vai voiko sen kopioida sellaisenaan (0)
+int line_format_needs_escape(int kind, const char *name, size_t length);
+
+// Pisin mahdollinen kenttä length-tavuisesta nimestä
+size_t line_format_field_bound(const LineFormat *format, size_t length);
+
+// Pisin mahdollinen rivi, kun nimien enimmäispituudet ovat first, middle (0 = ei
+// keskinimiä) ja last
+size_t line_format_max_line(const LineFormat *format, size_t first, size_t middle, size_t last);
+
+// Kirjoittaa nimen kenttänä (lainattuna, jos escape on asetettu) ja palauttaa
+// pituuden. Tilaa on oltava line_format_field_bound(length) tavua.
+size_t line_format_write_field(const LineFormat *format, char *out, const char *name, size_t length);
+
+// Kuten edellä, mutta nimi on jo kohdassa field: lainataan paikallaan
+// (tilaa on oltava line_format_field_bound(length) tavua)
+size_t line_format_escape_in_place(const LineFormat *format, char *field, size_t length);
+
+#endif // LINEFORMAT_H
@@ -27,179 +27,554 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 #include <string.h>
 #include <time.h>
 
-// Maksimipituus yhdelle nimelle ja riville
-#define MAX_LINE_LENGTH 256
-#define MAX_NAME_LENGTH 100
-
-// Rakenne nimilistan tietojen tallentamiseen
+#include "gedcom.h"
+#include "kinship.h"
+#include "libnamegen.h"
+#include "namelist.h"
+#include "outbuf.h"
+#include "population.h"
+#include "rng.h"
+#include "snapshot.h"
+#include "stats.h"
+
+// Nimiä generoidaan kerralla näin monta ja numeroidaan sitten rivi kerrallaan
+#define NAMES_PER_BATCH 4096
+
+// Ryhmiteltävät sukulaisuudet --relatives-tulosteessa (sukupolvia henkilöstä
+// ja sukulaisesta yhteiseen esivanhempaan)
+static const int RELATIVE_GROUPS[][2] = {
+    {3, 0}, {2, 0}, {1, 0}, {1, 1}, {1, 2}, {1, 3}, {2, 2}, {2, 3}, {3, 2}, {3, 3}, {2, 1}, {3, 1},
+    {0, 1}, {0, 2}, {0, 3}
+};
+
+// Sukulaisuushaut simuloidusta väestöstä
 typedef struct {
-    char **names;
-    int count;
-} NameList;
-
-// --- 1. TIEDOSTON LATAUSFUNKTIOT ---
+    const char *relate;       // "A,B" tai NULL
+    long long relatives;      // Henkilö tai -1
+    long long queries;        // Satunnaisia pareja nopeusmittaukseen
+} KinshipOptions;
 
-// Funktio lataa nimet tavallisesta tiedostosta (yksi nimi per rivi)
-void load_names_simple(const char *filename, NameList *list) {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        fprintf(stderr, "WARNING: Could not open file: %s\n", filename);
-        list->count = 0;
-        list->names = NULL;
-        return;
+// Väestön tallennus ja vienti
+typedef struct {
+    const char *load;         // Tilannevedos, joka avataan simuloinnin sijaan, tai NULL
+    const char *save;         // Tilannevedos simuloinnin jälkeen tai NULL
+    const char *gedcom;       // GEDCOM-tiedosto tai NULL
+    int verify;               // Tilannevedoksen henkilöt tarkistetaan avattaessa
+} FileOptions;
+
+// --- 1. SUKULAISUUS ---
+
+// Funktio tulostaa henkilön tunnisteen, nimen ja elinvuodet
+static void print_person(const PopNames *names, const Population *pop, uint32_t person) {
+    size_t first_len, middle_len, last_len;
+    const char *first = pop_first_name(names, pop, person, &first_len);
+    const char *middle = pop_middle_name(names, pop, person, &middle_len);
+    const char *last = pop_last_name(names, pop, person, &last_len);
+    printf("%u %.*s%s%.*s %.*s (%u-", person, (int)first_len, first, (middle_len > 0) ? " " : "",
+           (int)middle_len, middle, (int)last_len, last, pop->birth_year[person]);
+    if (pop->death_year[person] != POP_ALIVE) {
+        printf("%u", pop->death_year[person]);
     }
+    printf(")");
+}
 
-    list->count = 0;
-    list->names = NULL;
-    char buffer[MAX_LINE_LENGTH];
-
-    while (fgets(buffer, MAX_LINE_LENGTH, file) != NULL) {
-        buffer[strcspn(buffer, "\n")] = 0; // Poista rivinvaihto
+// Funktio tulostaa kahden henkilön sukulaisuuden ("A,B")
+static int print_relation(const KinshipIndex *index, const PopNames *names, const char *pair) {
+    char *end = NULL;
+    unsigned long long a = strtoull(pair, &end, 10);
+    unsigned long long b = (*end == ',') ? strtoull(end + 1, &end, 10) : index->count;
+    if (*end != '\0' || a >= index->count || b >= index->count) {
+        fprintf(stderr, "ERROR: Invalid pair for --relate (two IDs below %u, e.g. 12,345): %s\n", index->count, pair);
+        return 1;
+    }
 
-        list->names = (char **)realloc(list->names, (list->count + 1) * sizeof(char *));
-        if (list->names == NULL) {
-            perror("Memory allocation failed (simple realloc)");
-            exit(EXIT_FAILURE);
+    KinRelation relation;
+    char description[96];
+    uint64_t start = stats_now_ns();
+    kinship_relate(index, (uint32_t)a, (uint32_t)b, &relation);
+    double micros = (double)(stats_now_ns() - start) / 1e3;
+    kinship_describe(index, (uint32_t)a, &relation, description, sizeof(description));
+
+    print_person(names, index->pop, (uint32_t)a);
+    if (relation.ancestor == POP_NONE) {
+        printf(" is not related to ");
+    } else if (a == b) {
+        printf(" is the same person as ");
+    } else {
+        printf(" is the %s of ", description);
+    }
+    print_person(names, index->pop, (uint32_t)b);
+    printf((relation.ancestor == POP_NONE) ? " within %d generations\n" : "\n", KIN_MAX_UP);
+    if (relation.ancestor != POP_NONE && relation.ancestor != a && relation.ancestor != b) {
+        printf("Common ancestor%s: ", (relation.other_ancestor != POP_NONE) ? "s" : "");
+        print_person(names, index->pop, relation.ancestor);
+        if (relation.other_ancestor != POP_NONE) {
+            printf(" and ");
+            print_person(names, index->pop, relation.other_ancestor);
         }
+        printf(", %u and %u generations up\n", relation.up_a, relation.up_b);
+    }
+    printf("Answered in %.1f us\n", micros);
+    return 0;
+}
 
-        list->names[list->count] = strdup(buffer);
-        if (list->names[list->count] == NULL) {
-            perror("Memory allocation failed (simple strdup)");
-            exit(EXIT_FAILURE);
+// Funktio tulostaa henkilön sukulaiset pikkuserkkuihin asti ryhmittäin
+static int print_relatives(const KinshipIndex *index, const PopNames *names, long long person) {
+    if (person < 0 || person >= index->count) {
+        fprintf(stderr, "ERROR: Invalid person for --relatives (0-%u): %lld\n", index->count - 1, person);
+        return 1;
+    }
+    printf("Relatives of ");
+    print_person(names, index->pop, (uint32_t)person);
+    printf(":\n");
+
+    uint32_t *ids = NULL;
+    size_t cap = 0;
+    long long total = 0;
+    uint64_t start = stats_now_ns();
+    for (size_t g = 0; g < sizeof(RELATIVE_GROUPS) / sizeof(RELATIVE_GROUPS[0]); g++) {
+        long long found;
+        // Ensimmäinen kutsu kertoo tarvittavan tilan
+        while ((found = kinship_relatives(index, (uint32_t)person, RELATIVE_GROUPS[g][0], RELATIVE_GROUPS[g][1],
+                                          ids, cap)) > (long long)cap) {
+            free(ids);
+            cap = (size_t)found;
+            ids = (uint32_t *)malloc(cap * sizeof(uint32_t));
+            if (ids == NULL) {
+                found = -1;
+                break;
+            }
+        }
+        if (found < 0) {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            free(ids);
+            return 1;
+        }
+        for (long long i = 0; i < found; i++) {
+            KinRelation relation;
+            char description[96];
+            kinship_relate(index, ids[i], (uint32_t)person, &relation);
+            kinship_describe(index, ids[i], &relation, description, sizeof(description));
+            printf("  %s: ", description);
+            print_person(names, index->pop, ids[i]);
+            printf("\n");
         }
+        total += found;
+    }
+    printf("%lld relatives found in %.2f ms\n", total, (double)(stats_now_ns() - start) / 1e6);
+    free(ids);
+    return 0;
+}
 
-        list->count++;
+// Funktio mittaa sukulaisuushakujen nopeuden: puolet pareista arvotaan koko
+// väestöstä (yleensä ei sukua), puolet kulkemalla satunnaisesti 1-4 sukupolvea
+// ylös ja 1-4 alas (yleensä sukulaisia)
+static int run_queries(KinshipIndex *index, uint64_t seed, long long count) {
+    uint32_t *pairs = (uint32_t *)malloc((size_t)count * 2 * sizeof(uint32_t));
+    KinRelation *relations = (KinRelation *)malloc((size_t)count * sizeof(KinRelation));
+    if (pairs == NULL || relations == NULL) {
+        fprintf(stderr, "ERROR: Out of memory (%lld queries)\n", count);
+        free(pairs);
+        free(relations);
+        return 1;
+    }
+    Rng rng;
+    rng_seed_stream(&rng, seed, UINT64_MAX);
+    for (long long i = 0; i < count; i++) {
+        uint32_t a = rng_bounded(&rng, index->count);
+        uint32_t b = rng_bounded(&rng, index->count);
+        if (i % 2 == 1) {
+            b = a;
+            int up = 1 + (int)rng_bounded(&rng, 4), down = 1 + (int)rng_bounded(&rng, 4);
+            for (int k = 0; k < up && index->ancestors[b].parents[0] != POP_NONE; k++) {
+                b = index->ancestors[b].parents[rng_coin(&rng)];
+            }
+            for (int k = 0; k < down && index->child_start[b + 1] > index->child_start[b]; k++) {
+                uint32_t children = index->child_start[b + 1] - index->child_start[b];
+                b = index->children[index->child_start[b] + rng_bounded(&rng, children)];
+            }
+        }
+        pairs[2 * i] = a;
+        pairs[2 * i + 1] = b;
     }
 
-    fclose(file);
-    printf("Loaded %d name of the file: %s\n", list->count, filename);
+    uint64_t start = stats_now_ns();
+    for (long long i = 0; i < count; i++) {
+        kinship_relate(index, pairs[2 * i], pairs[2 * i + 1], &relations[i]);
+    }
+    double single = (double)(stats_now_ns() - start) / 1e9;
+    start = stats_now_ns();
+    kinship_relate_batch(index, pairs, (size_t)count, relations);
+    double batch = (double)(stats_now_ns() - start) / 1e9;
+
+    long long related = 0;
+    for (long long i = 0; i < count; i++) {
+        related += (relations[i].ancestor != POP_NONE);
+    }
+    printf("Queries: %lld pairs (%lld related), %.2f us per pair on 1 thread, %.0f pairs/s in a batch on %d threads\n",
+           count, related, single * 1e6 / (double)count, (double)count / batch, parallel_pool_threads(index->pool));
+    free(pairs);
+    free(relations);
+    return 0;
 }
 
+// --- 2. TALLENNUS JA VIENTI ---
 
-// Funktio lataa nimet CSV-tiedostosta (ottaa vain ensimmäisen sarakkeen)
-void load_names_from_csv(const char *filename, NameList *list) {
-    FILE *file = fopen(filename, "r");
+// Funktio kirjoittaa väestön tilannevedokseen (save) tai GEDCOM-tiedostoon ja
+// tulostaa tiedoston koon ja kirjoitusnopeuden
+static int write_population(const char *path, int gedcom, const Population *pop, const PopNames *names,
+                            const PopConfig *config) {
+    FILE *file = fopen(path, "wb");
     if (file == NULL) {
-        fprintf(stderr, "WARNING: Unable to open CSV-file: %s\n", filename);
-        list->count = 0;
-        list->names = NULL;
-        return;
+        perror(path);
+        return 1;
     }
-
-    list->count = 0;
-    list->names = NULL;
-    char buffer[MAX_LINE_LENGTH];
-
-    // OHITA ENSIMMÄINEN OTSIKKORIVI
-    if (fgets(buffer, MAX_LINE_LENGTH, file) == NULL) {
+    OutBuf out;
+    if (outbuf_init(&out, file, gedcom ? GEDCOM_BUFFER_SIZE : OUTBUF_DEFAULT_SIZE) != 0) {
         fclose(file);
-        return;
+        return 1;
     }
 
-    // Luetaan rivi kerrallaan
-    while (fgets(buffer, MAX_LINE_LENGTH, file) != NULL) {
-        char temp_buffer[MAX_LINE_LENGTH];
-        strcpy(temp_buffer, buffer); // Kopioidaan rivi, koska strtok muuttaa alkuperäistä
-
-        // Poista rivinvaihto kopioidusta
-        temp_buffer[strcspn(temp_buffer, "\n")] = 0;
-
-        // Käytetään strtok-funktiota erottamaan merkkijono pilkun (',') kohdalta
-        char *name_token = strtok(temp_buffer, ",");
-
-        if (name_token != NULL) {
-            // Varmistus: Tyhjien nimien ohitus (tapahtuu usein virheellisissä CSV-riveissä)
-            if (strlen(name_token) > 0) {
-
-                // Kasvatetaan muistia
-                list->names = (char **)realloc(list->names, (list->count + 1) * sizeof(char *));
-                if (list->names == NULL) {
-                    perror("Memory allocation failed (csv realloc)");
-                    exit(EXIT_FAILURE);
-                }
-
-                // Tallennetaan nimi
-                list->names[list->count] = strdup(name_token);
-                if (list->names[list->count] == NULL) {
-                    perror("Memory allocation failed (csv strdup)");
-                    exit(EXIT_FAILURE);
-                }
-
-                list->count++;
-            }
-        }
+    uint64_t start = stats_now_ns();
+    uint64_t families = 0;
+    int result = 0;
+    if (gedcom) {
+        result = gedcom_write(&out, pop, names, &families);
+    } else {
+        snapshot_write(&out, pop, names, config);
+    }
+    if (outbuf_close(&out) != 0 || fclose(file) != 0) {
+        result = -1;
+    }
+    double seconds = (double)(stats_now_ns() - start) / 1e9;
+    if (result != 0) {
+        fprintf(stderr, "ERROR: Could not write %s\n", path);
+        return 1;
     }
 
-    fclose(file);
-    printf("Loaded %d name from CSV-file: %s\n", list->count, filename);
+    double megabytes = (double)out.bytes_written / 1e6;
+    if (gedcom) {
+        printf("GEDCOM: %s, %.1f MB (%u people, %llu families) in %.2f s, %.0f MB/s\n", path, megabytes,
+               pop->count, (unsigned long long)families, seconds, megabytes / seconds);
+    } else {
+        printf("Snapshot: %s, %.1f MB in %.2f s, %.0f MB/s\n", path, megabytes, seconds, megabytes / seconds);
+    }
+    return 0;
 }
 
-// --- 2. APUFUNKTIOT ---
+// Funktio tallentaa ja vie väestön sekä tekee sukulaisuushaut
+static int use_population(const Population *pop, const PopNames *names, const PopConfig *config,
+                          const KinshipOptions *kin, const FileOptions *files) {
+    if (files->save != NULL && write_population(files->save, 0, pop, names, config) != 0) {
+        return 1;
+    }
+    if (files->gedcom != NULL && write_population(files->gedcom, 1, pop, names, config) != 0) {
+        return 1;
+    }
 
-// Funktio vapauttaa NameList-rakenteen varaaman muistin
-void free_names(NameList *list) {
-    if (list->names != NULL) {
-        for (int i = 0; i < list->count; i++) {
-            free(list->names[i]);
+    // Sukulaisuushaut tarvitsevat indeksin
+    int result = 0;
+    if (kin->relate != NULL || kin->relatives >= 0 || kin->queries > 0) {
+        KinshipIndex index;
+        if (kinship_build(&index, pop, config->threads) != 0) {
+            fprintf(stderr, "ERROR: Could not build the kinship index (out of memory)\n");
+            return 1;
+        }
+        printf("Kinship index: %.2f s, %.1f bytes per person, %.1f MB\n", index.build_seconds,
+               (double)kinship_memory(&index) / (double)pop->count, (double)kinship_memory(&index) / 1e6);
+        if (kin->relate != NULL) {
+            result = print_relation(&index, names, kin->relate);
         }
-        free(list->names);
+        if (result == 0 && kin->relatives >= 0) {
+            result = print_relatives(&index, names, kin->relatives);
+        }
+        if (result == 0 && kin->queries > 0) {
+            result = run_queries(&index, config->seed, kin->queries);
+        }
+        kinship_free(&index);
     }
+    return result;
 }
 
-// Funktio valitsee ja palauttaa satunnaisen nimen NameList-rakenteesta
-const char* select_random_name(const NameList *list) {
-    if (list->count == 0) {
-        return "";
+// Funktio avaa tilannevedoksen simuloinnin sijaan
+static int run_snapshot(const char *path, int threads, const KinshipOptions *kin, const FileOptions *files) {
+    Snapshot snapshot;
+    uint64_t start = stats_now_ns();
+    int status = snapshot_open(path, &snapshot);
+    if (status != NAMELIST_OK) {
+        fprintf(stderr, "ERROR: Could not open snapshot %s: %s.\n", path, namelist_strerror(status));
+        return 1;
+    }
+    if (files->verify && (status = snapshot_verify(&snapshot)) != NAMELIST_OK) {
+        fprintf(stderr, "ERROR: Snapshot %s is damaged: %s.\n", path, namelist_strerror(status));
+        snapshot_close(&snapshot);
+        return 1;
     }
-    int index = rand() % list->count;
-    return list->names[index];
+    double seconds = (double)(stats_now_ns() - start) / 1e9;
+    snapshot.config.threads = threads;
+    printf("Opened %s in %.3f ms%s: %u people simulated %d-%d (%u founders, seed %llu)\n", path, seconds * 1e3,
+           files->verify ? " (verified)" : "", snapshot.pop.count, snapshot.config.start_year,
+           snapshot.config.end_year, snapshot.config.founders, (unsigned long long)snapshot.config.seed);
+
+    int result = use_population(&snapshot.pop, &snapshot.names, &snapshot.config, kin, files);
+    snapshot_close(&snapshot);
+    return result;
 }
 
-// --- 3. PÄÄOHJELMA ---
+// --- 3. VÄESTÖSIMULAATIO ---
+
+// Funktio simuloi väestön ja tulostaa yhteenvedon
+static int run_simulation(const char *locale_dir, PopConfig *config, double people, const KinshipOptions *kin,
+                          const FileOptions *files) {
+    PopNames names;
+    uint64_t start = stats_now_ns();
+    int status = pop_names_load(&names, locale_dir);
+    if (status != NAMELIST_OK) {
+        fprintf(stderr, "ERROR: Could not load names from %s: %s.\n", locale_dir, namelist_strerror(status));
+        return 1;
+    }
+    double load_seconds = (double)(stats_now_ns() - start) / 1e9;
+
+    // Kokonaismäärästä arvioidaan alkuväestö pienellä koeajolla
+    if (people > 0.0) {
+        config->founders = population_founders_for((uint64_t)people, &names, config);
+        if (config->founders == 0) {
+            fprintf(stderr, "ERROR: Could not size the founding population for %.0f people\n", people);
+            pop_names_free(&names);
+            return 1;
+        }
+    }
 
-int main() {
-    // Asetetaan satunnaislukugeneraattorin siemen
-    srand(time(NULL));
+    Population pop;
+    PopSummary summary;
+    population_init(&pop);
+    if (population_simulate(&pop, &names, config, &summary) != 0) {
+        fprintf(stderr, "ERROR: Simulation failed (out of memory)\n");
+        population_free(&pop);
+        pop_names_free(&names);
+        return 1;
+    }
 
-    NameList first_names, middle_names, last_names;
+    printf("Simulated %d-%d: %u people (%u founders, %llu births), %llu deaths, %llu marriages, %u living\n",
+           config->start_year, config->end_year, pop.count, config->founders, (unsigned long long)summary.births,
+           (unsigned long long)summary.deaths, (unsigned long long)summary.marriages, summary.living);
+    printf("Memory: %u bytes per person, %.1f MB for %u people\n", (unsigned)POP_BYTES_PER_PERSON,
+           (double)pop.count * POP_BYTES_PER_PERSON / 1e6, pop.count);
+    printf("Kinship: %llu marriages of relatives rejected, mean inbreeding %.5f, max %.4f\n",
+           (unsigned long long)summary.rejected, summary.mean_inbreeding, summary.max_inbreeding);
+    printf("Time: %.2f s (deaths %.2f s, births %.2f s, kinship %.2f s, marriages %.2f s), names loaded in %.2f s\n",
+           summary.seconds, summary.pass_seconds[0], summary.pass_seconds[1], summary.pass_seconds[3],
+           summary.pass_seconds[2], load_seconds);
+
+    int result = use_population(&pop, &names, config, kin, files);
+    population_free(&pop);
+    pop_names_free(&names);
+    return result;
+}
 
-    // 1. Ladataan nimet listoihin (Muista muuttaa tiedostonimet vastaamaan omia tiedostojasi!)
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--count N] [--seed S]\n"
+            "       %s (--people N | --founders N) [--from YEAR] [--to YEAR] [--kinship-limit K] [--threads N]\n"
+            "          [--locale DIR] [--seed S] [--save FILE] [--gedcom FILE] [--relate A,B] [--relatives ID]\n"
+            "          [--queries N]\n"
+            "       %s --load FILE [--verify] [--gedcom FILE] [--relate A,B] [--relatives ID] [--queries N]\n"
+            "\n"
+            "Without --people or --founders, prints N random names.\n"
+            "\n"
+            "  -p, --people N     Simulate about N people in total (e.g. 1e7); the size of\n"
+            "                     the founding population is estimated with a small trial run\n"
+            "  -f, --founders N   Simulate from N founders alive at the start\n"
+            "      --from YEAR    First simulated year (default 1860)\n"
+            "      --to YEAR      Last simulated year (default 1929)\n"
+            "      --kinship-limit K  Relatives whose kinship coefficient is at least K do\n"
+            "                     not marry (default 0.0625: first cousins and closer);\n"
+            "                     0 only stops siblings\n"
+            "  -j, --threads N    Worker threads (default: all cores); the population for\n"
+            "                     a seed is the same with any number of threads\n"
+            "  -l, --locale DIR   Name files (default %s)\n"
+            "  -s, --seed S       Seed for the random number generator\n"
+            "\n"
+            "Saving and exporting the population:\n"
+            "      --save FILE    Write a binary snapshot after the simulation\n"
+            "      --load FILE    Open a snapshot instead of simulating\n"
+            "      --verify       Check every person of the loaded snapshot (parents, spouse,\n"
+            "                     name IDs) before using it\n"
+            "      --gedcom FILE  Write the population as a GEDCOM 5.5.1 family tree\n"
+            "\n"
+            "Kinship queries on the simulated population (people are numbered by birth):\n"
+            "      --relate A,B   How A is related to B and their nearest common ancestor\n"
+            "      --relatives ID Parents, siblings, cousins, second cousins etc. of ID\n"
+            "      --queries N    Time N random pairs, one at a time and as a batch\n",
+            program, program, program, NAMEGEN_DEFAULT_LOCALE);
+}
 
-    // Esimerkki CSV-latauksesta (ensimmäiset nimet):
-    load_names_from_csv("data/FI-fi/Finnish-men-firts-names.csv", &first_names);
-    load_names_from_csv("data/FI-fi/Finnish-men-seconds-names.csv", &middle_names);
-    load_names_from_csv("data/FI-fi/Finnish-men-last-names.csv", &last_names);
+// --- 4. PÄÄOHJELMA ---
+
+int main(int argc, char *argv[]) {
+    // Komentorivi: --count N (oletus 1) ja --seed S (oletus kellonaika), tai
+    // väestösimulaatio --people N / --founders N
+    long long count = 1;
+    double people = 0.0;
+    const char *locale_dir = NAMEGEN_DEFAULT_LOCALE;
+    PopConfig config = {(uint64_t)time(NULL), 1860, 1929, 0, 0, POP_KINSHIP_LIMIT};
+    KinshipOptions kin = {NULL, -1, 0};
+    FileOptions files = {NULL, NULL, NULL, 0};
+    for (int i = 1; i < argc; i += 2) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        char *end = NULL;
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(arg, "--verify") == 0) {
+            files.verify = 1;
+            i--; // Ei arvoa
+        } else if (value == NULL) {
+            print_usage(argv[0]);
+            return 1; // Asetukselta puuttuu arvo
+        } else if (strcmp(arg, "--count") == 0 || strcmp(arg, "-n") == 0) {
+            count = strtoll(value, NULL, 10);
+        } else if (strcmp(arg, "--seed") == 0 || strcmp(arg, "-s") == 0) {
+            config.seed = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--people") == 0 || strcmp(arg, "-p") == 0) {
+            people = strtod(value, &end);
+            if (*end != '\0' || people < 1.0 || people > 4e9) {
+                fprintf(stderr, "ERROR: Invalid number of people: %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--founders") == 0 || strcmp(arg, "-f") == 0) {
+            double founders = strtod(value, &end);
+            if (*end != '\0' || founders < 1.0 || founders > 4e9) {
+                fprintf(stderr, "ERROR: Invalid number of founders: %s\n", value);
+                return 1;
+            }
+            config.founders = (uint32_t)founders;
+        } else if (strcmp(arg, "--from") == 0 || strcmp(arg, "--to") == 0) {
+            long year = strtol(value, &end, 10);
+            if (*end != '\0' || year < 1800 || year > 2100) {
+                fprintf(stderr, "ERROR: Invalid year (1800-2100): %s\n", value);
+                return 1;
+            }
+            *(strcmp(arg, "--from") == 0 ? &config.start_year : &config.end_year) = (int)year;
+        } else if (strcmp(arg, "--threads") == 0 || strcmp(arg, "-j") == 0) {
+            long threads = strtol(value, &end, 10);
+            if (*end != '\0' || threads <= 0 || threads > 1024) {
+                fprintf(stderr, "ERROR: Invalid thread count: %s\n", value);
+                return 1;
+            }
+            config.threads = (int)threads;
+        } else if (strcmp(arg, "--kinship-limit") == 0) {
+            config.kinship_limit = strtod(value, &end);
+            if (*end != '\0' || config.kinship_limit < 0.0 || config.kinship_limit > 1.0) {
+                fprintf(stderr, "ERROR: Invalid kinship limit (0-1): %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--locale") == 0 || strcmp(arg, "-l") == 0) {
+            locale_dir = value;
+        } else if (strcmp(arg, "--load") == 0) {
+            files.load = value;
+        } else if (strcmp(arg, "--save") == 0) {
+            files.save = value;
+        } else if (strcmp(arg, "--gedcom") == 0) {
+            files.gedcom = value;
+        } else if (strcmp(arg, "--relate") == 0) {
+            kin.relate = value;
+        } else if (strcmp(arg, "--relatives") == 0 || strcmp(arg, "--queries") == 0) {
+            long long number = strtoll(value, &end, 10);
+            if (*end != '\0' || number < 0) {
+                fprintf(stderr, "ERROR: Invalid number for %s: %s\n", arg, value);
+                return 1;
+            }
+            *(strcmp(arg, "--relatives") == 0 ? &kin.relatives : &kin.queries) = number;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    int simulate = (people > 0.0 || config.founders > 0);
+    if (files.load != NULL) {
+        if (simulate || files.save != NULL) {
+            fprintf(stderr, "ERROR: --load replaces the simulation (--people, --founders and --save)\n");
+            return 1;
+        }
+        return run_snapshot(files.load, config.threads, &kin, &files);
+    }
+    if (files.verify) {
+        fprintf(stderr, "ERROR: --verify checks a snapshot opened with --load\n");
+        return 1;
+    }
+    if ((kin.relate != NULL || kin.relatives >= 0 || kin.queries > 0 || files.save != NULL ||
+         files.gedcom != NULL) && !simulate) {
+        fprintf(stderr, "ERROR: Kinship queries, --save and --gedcom need a population (--people, --founders "
+                        "or --load)\n");
+        return 1;
+    }
+    if (simulate) {
+        if (config.end_year < config.start_year) {
+            fprintf(stderr, "ERROR: --to is before --from\n");
+            return 1;
+        }
+        return run_simulation(locale_dir, &config, people, &kin, &files);
+    }
+    uint64_t seed = config.seed;
 
-    // Esimerkki simple-latauksesta (keskinimet ja sukunimet, olettaen että ne ovat omissa tiedostoissaan)
-    // load_names_simple("data/FI-fi/firstnames.txt", &first_names);
-    // load_names_simple("data/FI-fi/middlenames.txt", &middle_names);
-    // load_names_simple("data/FI-fi/surnames.txt", &last_names);
+    // Asetetaan satunnaislukugeneraattorin siemen
+    Rng rng;
+    rng_seed(&rng, seed);
+
+    // 1. Ladataan nimet kirjastolla. Käytetään ensimmäistä vuosikymmentä (1860-69).
+    NameGen *ctx = NULL;
+    int status = namegen_open_directory(NAMEGEN_DEFAULT_LOCALE, &ctx);
+    if (status != NAMEGEN_OK) {
+        fprintf(stderr, "ERROR: Could not load names from %s: %s.\n",
+                NAMEGEN_DEFAULT_LOCALE, namegen_strerror(status));
+        return 1;
+    }
+    const int decade = 0;
 
-    printf("\n--- Randomly generated names (Middle name with 50%% probability) ---\n");
+    fprintf(stderr, "\n--- Randomly generated names (Middle name with 50%% probability) ---\n");
 
-    // 2. Generoidaan ja tulostetaan 1 satunnaista nimeä
-    for (int i = 0; i < 1; i++) {
-        const char *first = select_random_name(&first_names);
-        const char *last = select_random_name(&last_names);
-        const char *middle = "";
+    OutBuf out;
+    size_t batch_cap = namegen_max_line_length(ctx, decade) * NAMES_PER_BATCH;
+    char *batch = (char *)malloc(batch_cap);
+    if (batch == NULL || outbuf_init(&out, stdout, OUTBUF_DEFAULT_SIZE) != 0) {
+        free(batch);
+        namegen_close(ctx);
+        return 1;
+    }
 
-        // Ehto keskinimen valinnalle (50 % todennäköisyys ja lista ei saa olla tyhjä)
-        if (rand() % 2 == 1 && middle_names.count > 0) {
-            middle = select_random_name(&middle_names);
+    // 2. Generoidaan count satunnaista nimeä ja tulostetaan ne numeroituina puskurin kautta
+    char number[24];
+    long long done = 0;
+    while (done < count) {
+        long long n = count - done;
+        if (n > NAMES_PER_BATCH) {
+            n = NAMES_PER_BATCH;
+        }
+        size_t bytes = 0;
+        n = namegen_generate_batch(ctx, &rng, decade, batch, batch_cap, n, &bytes);
+        if (n <= 0) {
+            break;
         }
 
-        // Tulostus: Jos middle on tyhjä, tulostetaan vain kaksi nimeä.
-        if (strlen(middle) > 0) {
-            printf("%d: %s %s %s\n", i + 1, first, middle, last);
-        } else {
-            printf("%d: %s %s\n", i + 1, first, last);
+        const char *line = batch;
+        for (long long i = 0; i < n; i++) {
+            const char *newline = (const char *)memchr(line, '\n', bytes - (size_t)(line - batch));
+            int number_len = snprintf(number, sizeof(number), "%lld: ", ++done);
+            outbuf_write(&out, number, (size_t)number_len);
+            outbuf_write(&out, line, (size_t)(newline - line) + 1);
+            line = newline + 1;
         }
     }
 
+    if (outbuf_close(&out) != 0) {
+        perror("Error writing names");
+    }
+
     // 3. Vapautetaan kaikki dynaamisesti varattu muisti
-    free_names(&first_names);
-    free_names(&middle_names);
-    free_names(&last_names);
+    free(batch);
+    namegen_close(ctx);
 
     return 0;
 }
@@ -0,0 +1,490 @@
+/**
+* @file markov.c
+* @brief Character n-gram (Markov chain) models for synthesizing new names.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "markov.h"
+#include "namedict.h"
+
+// --- 1. APUTAULUT ---
+
+// 64-bittisten avainten hajautustaulu (avoin osoitus). Arvo on lisäysjärjestys.
+typedef struct {
+    uint64_t *keys;
+    uint32_t *values;        // Arvo + 1 (0 = tyhjä paikka)
+    size_t size;             // Kahden potenssi
+    uint32_t count;
+} KeyMap;
+
+static uint64_t mix_key(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static int key_map_init(KeyMap *map, size_t size) {
+    map->keys = (uint64_t *)malloc(size * sizeof(uint64_t));
+    map->values = (uint32_t *)calloc(size, sizeof(uint32_t));
+    map->size = size;
+    map->count = 0;
+    return (map->keys != NULL && map->values != NULL) ? 0 : -1;
+}
+
+static void key_map_free(KeyMap *map) {
+    free(map->keys);
+    free(map->values);
+    memset(map, 0, sizeof(*map));
+}
+
+// Funktio etsii avaimen tai lisää sen seuraavalla arvolla. *added kertoo,
+// oliko avain uusi. Palauttaa arvon tai UINT32_MAX, jos muisti loppui.
+static uint32_t key_map_insert(KeyMap *map, uint64_t key, int *added) {
+    *added = 0;
+    if ((size_t)(map->count + 1) * 2 > map->size) {
+        KeyMap grown;
+        if (key_map_init(&grown, map->size * 2) != 0) {
+            key_map_free(&grown);
+            return UINT32_MAX;
+        }
+        for (size_t i = 0; i < map->size; i++) {
+            if (map->values[i] != 0) {
+                size_t slot = mix_key(map->keys[i]) & (grown.size - 1);
+                while (grown.values[slot] != 0) {
+                    slot = (slot + 1) & (grown.size - 1);
+                }
+                grown.keys[slot] = map->keys[i];
+                grown.values[slot] = map->values[i];
+            }
+        }
+        grown.count = map->count;
+        key_map_free(map);
+        *map = grown;
+    }
+
+    size_t slot = mix_key(key) & (map->size - 1);
+    while (map->values[slot] != 0) {
+        if (map->keys[slot] == key) {
+            return map->values[slot] - 1;
+        }
+        slot = (slot + 1) & (map->size - 1);
+    }
+    map->keys[slot] = key;
+    map->values[slot] = ++map->count;
+    *added = 1;
+    return map->count - 1;
+}
+
+// Funktio palauttaa UTF-8-merkin pituuden kohdassa p (enintään left tavua).
+// Virheellinen jono (esim. Latin-1-tavu) on yksi tavu, joten tavut säilyvät.
+static uint32_t utf8_length(const unsigned char *p, size_t left) {
+    uint32_t length = (p[0] < 0xc0) ? 1 : (p[0] < 0xe0) ? 2 : (p[0] < 0xf0) ? 3 : (p[0] < 0xf8) ? 4 : 1;
+    if (length > left) {
+        return 1;
+    }
+    for (uint32_t i = 1; i < length; i++) {
+        if ((p[i] & 0xc0) != 0x80) {
+            return 1;
+        }
+    }
+    return length;
+}
+
+// Opetuksen aikainen siirtymä (tila, merkki) -> seuraava tila
+typedef struct {
+    uint32_t state;
+    uint32_t symbol;
+    uint32_t next;
+    uint32_t count;
+} Transition;
+
+// --- 2. OPETUS ---
+
+int markov_train(MarkovModel *model, const NameList *list, int order) {
+    memset(model, 0, sizeof(*model));
+    if (order < 1 || order > MARKOV_MAX_ORDER) {
+        return NAMELIST_ERR_FORMAT;
+    }
+
+    // Tila on order viimeisintä merkkiä 16 bitin kentissä (alku = nollat)
+    uint64_t key_mask = (order == 4) ? UINT64_MAX : (((uint64_t)1 << (16 * order)) - 1);
+    NameDict symbols;
+    name_dict_init(&symbols, list->pool);
+    KeyMap states, edges;
+    Transition *transitions = NULL;
+    size_t transitions_cap = 0;
+    uint32_t max_length = 0;
+    int result = NAMELIST_OK;
+
+    if (key_map_init(&states, 64) != 0 || key_map_init(&edges, 256) != 0) {
+        result = NAMELIST_ERR_NOMEM;
+    }
+    int added;
+    if (result == NAMELIST_OK) {
+        key_map_insert(&states, 0, &added); // Tila 0 on nimen alku
+    }
+
+    for (int i = 0; i < list->count && result == NAMELIST_OK; i++) {
+        const char *name = name_at(list, i);
+        size_t length = name_length(list, i);
+        if (length > max_length) {
+            max_length = (uint32_t)length;
+        }
+
+        uint64_t key = 0;
+        uint32_t state = 0;
+        size_t pos = 0;
+        for (;;) {
+            // Merkki 0 päättää nimen; muut ovat sanakirjan tunnisteita + 1
+            uint32_t symbol = 0;
+            uint32_t symbol_length = 0;
+            if (pos < length) {
+                symbol_length = utf8_length((const unsigned char *)name + pos, length - pos);
+                uint32_t id = name_dict_find(&symbols, name + pos, symbol_length);
+                if (id == NAME_DICT_NONE) {
+                    id = name_dict_add(&symbols, (uint32_t)(name + pos - list->pool), symbol_length);
+                }
+                if (id == NAME_DICT_NONE || id >= 0xffff) {
+                    result = (id == NAME_DICT_NONE) ? NAMELIST_ERR_NOMEM : NAMELIST_ERR_FORMAT;
+                    break;
+                }
+                symbol = id + 1;
+            }
+
+            uint32_t edge = key_map_insert(&edges, ((uint64_t)state << 32) | symbol, &added);
+            if (edge == UINT32_MAX) {
+                result = NAMELIST_ERR_NOMEM;
+                break;
+            }
+            if (added) {
+                if (edge == transitions_cap) {
+                    transitions_cap = (transitions_cap > 0) ? transitions_cap * 2 : 256;
+                    Transition *grown = (Transition *)realloc(transitions, transitions_cap * sizeof(Transition));
+                    if (grown == NULL) {
+                        result = NAMELIST_ERR_NOMEM;
+                        break;
+                    }
+                    transitions = grown;
+                }
+                transitions[edge].state = state;
+                transitions[edge].symbol = symbol;
+                transitions[edge].next = 0;
+                transitions[edge].count = 0;
+                if (symbol != 0) {
+                    key = ((key << 16) | symbol) & key_mask;
+                    uint32_t next = key_map_insert(&states, key, &added);
+                    if (next == UINT32_MAX) {
+                        result = NAMELIST_ERR_NOMEM;
+                        break;
+                    }
+                    transitions[edge].next = next;
+                }
+            } else if (symbol != 0) {
+                key = ((key << 16) | symbol) & key_mask;
+            }
+            transitions[edge].count++;
+            if (symbol == 0) {
+                break;
+            }
+            state = transitions[edge].next;
+            pos += symbol_length;
+        }
+    }
+    if (result == NAMELIST_OK && symbols.error != 0) {
+        result = NAMELIST_ERR_NOMEM;
+    }
+
+    // Muistikuva: siirtymät tiloittain (laskentalajittelu) ja rivien alias-taulut
+    uint32_t num_symbols = symbols.count + 1;
+    uint32_t num_states = states.count;
+    uint32_t num_edges = edges.count;
+    size_t size = sizeof(MarkovHeader) + (size_t)num_symbols * sizeof(MarkovSymbol) +
+                  (size_t)num_states * sizeof(MarkovState) +
+                  (size_t)num_edges * (sizeof(AliasEntry) + sizeof(MarkovEdge));
+    char *image = NULL;
+    double *weights = NULL;
+    if (result == NAMELIST_OK) {
+        image = (char *)calloc(1, size);
+        weights = (double *)malloc(((size_t)num_edges + 1) * sizeof(double));
+        if (image == NULL || weights == NULL) {
+            result = NAMELIST_ERR_NOMEM;
+        }
+    }
+
+    if (result == NAMELIST_OK) {
+        MarkovHeader *header = (MarkovHeader *)image;
+        MarkovSymbol *out_symbols = (MarkovSymbol *)(image + sizeof(MarkovHeader));
+        MarkovState *out_states = (MarkovState *)(out_symbols + num_symbols);
+        AliasEntry *out_alias = (AliasEntry *)(out_states + num_states);
+        MarkovEdge *out_edges = (MarkovEdge *)(out_alias + num_edges);
+        header->order = (uint32_t)order;
+        header->num_symbols = num_symbols;
+        header->num_states = num_states;
+        header->num_edges = num_edges;
+        header->max_length = max_length;
+        header->num_names = (uint32_t)list->count;
+
+        for (uint32_t s = 1; s < num_symbols; s++) {
+            const NameSlice *slice = &symbols.names[s - 1];
+            memcpy(out_symbols[s].bytes, list->pool + slice->offset, slice->length);
+            out_symbols[s].length = slice->length;
+        }
+
+        for (uint32_t e = 0; e < num_edges; e++) {
+            out_states[transitions[e].state].num_edges++;
+        }
+        uint32_t first = 0;
+        for (uint32_t st = 0; st < num_states; st++) {
+            out_states[st].first_edge = first;
+            first += out_states[st].num_edges;
+            out_states[st].num_edges = 0;
+        }
+        for (uint32_t e = 0; e < num_edges; e++) {
+            MarkovState *row = &out_states[transitions[e].state];
+            uint32_t at = row->first_edge + row->num_edges++;
+            out_edges[at].symbol = transitions[e].symbol;
+            out_edges[at].next = transitions[e].next;
+            weights[at] = (double)transitions[e].count;
+        }
+        for (uint32_t st = 0; st < num_states && result == NAMELIST_OK; st++) {
+            const MarkovState *row = &out_states[st];
+            if (alias_build(out_alias + row->first_edge, weights + row->first_edge, row->num_edges) != 0) {
+                result = NAMELIST_ERR_NOMEM;
+            }
+        }
+    }
+
+    free(weights);
+    free(transitions);
+    key_map_free(&states);
+    key_map_free(&edges);
+    name_dict_free(&symbols);
+    if (result != NAMELIST_OK) {
+        free(image);
+        return result;
+    }
+    result = markov_view(model, image, size);
+    model->block = image;
+    return result;
+}
+
+// --- 3. KUVAN AVAAMINEN ---
+
+int markov_view(MarkovModel *model, const void *image, size_t size) {
+    memset(model, 0, sizeof(*model));
+    const MarkovHeader *header = (const MarkovHeader *)image;
+    if (size < sizeof(MarkovHeader) || ((uintptr_t)image % MARKOV_ALIGN) != 0 || header->num_symbols == 0 ||
+        header->num_states == 0 || header->order < 1 || header->order > MARKOV_MAX_ORDER) {
+        return NAMELIST_ERR_FORMAT;
+    }
+    uint64_t expected = sizeof(MarkovHeader) + (uint64_t)header->num_symbols * sizeof(MarkovSymbol) +
+                        (uint64_t)header->num_states * sizeof(MarkovState) +
+                        (uint64_t)header->num_edges * (sizeof(AliasEntry) + sizeof(MarkovEdge));
+    if (expected != size) {
+        return NAMELIST_ERR_FORMAT;
+    }
+
+    const char *base = (const char *)image;
+    const MarkovSymbol *symbols = (const MarkovSymbol *)(base + sizeof(MarkovHeader));
+    const MarkovState *states = (const MarkovState *)(symbols + header->num_symbols);
+    const AliasEntry *alias = (const AliasEntry *)(states + header->num_states);
+    const MarkovEdge *edges = (const MarkovEdge *)(alias + header->num_edges);
+
+    // Rivit, merkit, seuraavat tilat ja alias-viitteet pysyvät taulukoiden sisällä
+    for (uint32_t s = 0; s < header->num_symbols; s++) {
+        if (symbols[s].length > sizeof(symbols[s].bytes)) {
+            return NAMELIST_ERR_FORMAT;
+        }
+    }
+    for (uint32_t st = 0; st < header->num_states; st++) {
+        const MarkovState *row = &states[st];
+        if (row->first_edge > header->num_edges || row->num_edges > header->num_edges - row->first_edge) {
+            return NAMELIST_ERR_FORMAT;
+        }
+        for (uint32_t k = 0; k < row->num_edges; k++) {
+            const MarkovEdge *edge = &edges[row->first_edge + k];
+            if (edge->symbol >= header->num_symbols || edge->next >= header->num_states ||
+                alias[row->first_edge + k].alias >= row->num_edges) {
+                return NAMELIST_ERR_FORMAT;
+            }
+        }
+    }
+
+    model->header = header;
+    model->symbols = symbols;
+    model->states = states;
+    model->alias = alias;
+    model->edges = edges;
+    model->image = image;
+    model->size = size;
+    return NAMELIST_OK;
+}
+
+void markov_free(MarkovModel *model) {
+    free(model->block);
+    memset(model, 0, sizeof(*model));
+}
+
+// --- 4. HYLÄTTÄVÄT NIMET ---
+
+// Funktio etsii merkin tavujen perusteella. Palauttaa merkin tai 0.
+static uint32_t find_symbol(const MarkovModel *model, const char *bytes, uint32_t length) {
+    for (uint32_t s = 1; s < model->header->num_symbols; s++) {
+        if (model->symbols[s].length == length && memcmp(model->symbols[s].bytes, bytes, length) == 0) {
+            return s;
+        }
+    }
+    return 0;
+}
+
+// Funktio etsii tilan rivistä merkin siirtymän. Palauttaa indeksin riviin tai UINT32_MAX.
+static uint32_t find_edge(const MarkovModel *model, uint32_t state, uint32_t symbol) {
+    const MarkovState *row = &model->states[state];
+    for (uint32_t k = 0; k < row->num_edges; k++) {
+        if (model->edges[row->first_edge + k].symbol == symbol) {
+            return k;
+        }
+    }
+    return UINT32_MAX;
+}
+
+// Funktio lisää solmun tilaan state ja varaa sille rivin. Palauttaa solmun tai
+// UINT32_MAX, jos muisti loppui. Kapasiteetit kasvavat kahdella kertoimella.
+static uint32_t add_node(MarkovExclusion *exclusion, const MarkovModel *model, uint32_t state, uint32_t *nodes_cap,
+                         uint32_t *edges_cap) {
+    uint32_t row = model->states[state].num_edges;
+    if (exclusion->num_nodes == *nodes_cap) {
+        uint32_t grown = (*nodes_cap > 0) ? *nodes_cap * 2 : 256;
+        MarkovTrieNode *larger = (MarkovTrieNode *)realloc(exclusion->nodes, (size_t)grown * sizeof(MarkovTrieNode));
+        if (larger == NULL) {
+            return UINT32_MAX;
+        }
+        exclusion->nodes = larger;
+        *nodes_cap = grown;
+    }
+    while (exclusion->num_edges + row > *edges_cap) {
+        uint32_t grown = (*edges_cap > 0) ? *edges_cap * 2 : 1024;
+        uint32_t *larger = (uint32_t *)realloc(exclusion->children, (size_t)grown * sizeof(uint32_t));
+        if (larger == NULL) {
+            return UINT32_MAX;
+        }
+        exclusion->children = larger;
+        *edges_cap = grown;
+    }
+    uint32_t node = exclusion->num_nodes++;
+    exclusion->nodes[node].state = state;
+    exclusion->nodes[node].first = exclusion->num_edges;
+    exclusion->nodes[node].is_name = 0;
+    memset(exclusion->children + exclusion->num_edges, 0, (size_t)row * sizeof(uint32_t));
+    exclusion->num_edges += row;
+    return node;
+}
+
+int markov_exclusion_build(MarkovExclusion *exclusion, const MarkovModel *model, const NameDict *names) {
+    memset(exclusion, 0, sizeof(*exclusion));
+    uint32_t nodes_cap = 0;
+    uint32_t edges_cap = 0;
+    int result = (add_node(exclusion, model, 0, &nodes_cap, &edges_cap) == UINT32_MAX) ? NAMELIST_ERR_NOMEM
+                                                                                        : NAMELIST_OK;
+
+    // 1. Nimet puuhun mallin siirtymiä pitkin
+    for (uint32_t n = 0; n < names->count && result == NAMELIST_OK; n++) {
+        const char *name = names->pool + names->names[n].offset;
+        size_t length = names->names[n].length;
+        uint32_t node = 0;
+        size_t pos = 0;
+        while (pos < length && node != UINT32_MAX) {
+            uint32_t symbol_length = utf8_length((const unsigned char *)name + pos, length - pos);
+            uint32_t symbol = find_symbol(model, name + pos, symbol_length);
+            uint32_t state = exclusion->nodes[node].state;
+            uint32_t k = (symbol != 0) ? find_edge(model, state, symbol) : UINT32_MAX;
+            if (k == UINT32_MAX) {
+                node = UINT32_MAX; // Malli ei tuota tätä nimeä
+                break;
+            }
+            uint32_t at = exclusion->nodes[node].first + k;
+            if (exclusion->children[at] == 0) {
+                uint32_t next = model->edges[model->states[state].first_edge + k].next;
+                uint32_t child = add_node(exclusion, model, next, &nodes_cap, &edges_cap);
+                if (child == UINT32_MAX) {
+                    result = NAMELIST_ERR_NOMEM;
+                    break;
+                }
+                exclusion->children[at] = child;
+            }
+            node = exclusion->children[at];
+            pos += symbol_length;
+        }
+        if (node != UINT32_MAX && result == NAMELIST_OK) {
+            exclusion->nodes[node].is_name = 1;
+        }
+    }
+
+    // 2. Lapsista juureen (lapsi lisätään aina vanhempansa jälkeen): siirtymän
+    // paino kerrotaan todennäköisyydellä, että jatko on uusi nimi
+    double *novel = NULL;
+    double *weights = NULL;
+    if (result == NAMELIST_OK) {
+        novel = (double *)malloc((size_t)exclusion->num_nodes * sizeof(double));
+        weights = (double *)malloc(((size_t)exclusion->num_edges + 1) * sizeof(double));
+        exclusion->alias = (AliasEntry *)malloc(((size_t)exclusion->num_edges + 1) * sizeof(AliasEntry));
+        if (novel == NULL || weights == NULL || exclusion->alias == NULL) {
+            result = NAMELIST_ERR_NOMEM;
+        }
+    }
+    for (uint32_t v = exclusion->num_nodes; v-- > 0 && result == NAMELIST_OK;) {
+        const MarkovTrieNode *node = &exclusion->nodes[v];
+        const MarkovState *row = &model->states[node->state];
+        double *w = weights + node->first;
+        alias_probabilities(model->alias + row->first_edge, row->num_edges, w);
+        double total = 0.0;
+        for (uint32_t k = 0; k < row->num_edges; k++) {
+            uint32_t child = exclusion->children[node->first + k];
+            if (model->edges[row->first_edge + k].symbol == 0) {
+                w[k] = node->is_name ? 0.0 : w[k];
+            } else if (child != 0) {
+                w[k] *= novel[child];
+            }
+            total += w[k];
+        }
+        novel[v] = total;
+        if (alias_build(exclusion->alias + node->first, w, row->num_edges) != 0) {
+            result = NAMELIST_ERR_NOMEM;
+        }
+    }
+    free(novel);
+    free(weights);
+    if (result != NAMELIST_OK) {
+        markov_exclusion_free(exclusion);
+    }
+    return result;
+}
+
+void markov_exclusion_free(MarkovExclusion *exclusion) {
+    free(exclusion->nodes);
+    free(exclusion->alias);
+    free(exclusion->children);
+    memset(exclusion, 0, sizeof(*exclusion));
+}
@@ -0,0 +1,202 @@
+/**
+* @file markov.h
+* @brief Character n-gram (Markov chain) models for synthesizing new names.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef MARKOV_H
+#define MARKOV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alias.h"
+#include "namedict.h"
+#include "namelist.h"
+#include "rng.h"
+
+// Merkkitason n-grammimalli. Nimi pilkotaan UTF-8-merkeiksi (ä ja ö ovat yksi
+// merkki, eivät kaksi tavua), ja tila on order edellistä merkkiä. Jokaisella
+// tilalla on rivi seuraavia merkkejä omine alias-tauluineen ja valmiiksi
+// laskettuine seuraavine tiloineen, joten yksi merkki maksaa yhden
+// satunnaisluvun ja kaksi peräkkäistä taulukkohakua.
+//
+// Malli on yksi yhtenäinen muistikuva ilman osoittimia, joten sen voi
+// kirjoittaa korpukseen sellaisenaan ja käyttää suoraan kuvauksesta:
+//
+//   MarkovHeader
+//   MarkovSymbol[num_symbols]   merkki 0 = nimen loppu
+//   MarkovState[num_states]     tila 0 = nimen alku
+//   AliasEntry[num_edges]       rivien alias-taulut (indeksit suhteessa riviin)
+//   MarkovEdge[num_edges]       merkki ja seuraava tila
+
+// Oletusjärjestys (edellisten merkkien määrä) ja suurin sallittu
+#define MARKOV_DEFAULT_ORDER 3
+#define MARKOV_MAX_ORDER 4
+
+typedef struct {
+    uint32_t order;
+    uint32_t num_symbols;
+    uint32_t num_states;
+    uint32_t num_edges;
+    uint32_t max_length;     // Pisin opetusnimi tavuina: pidemmät arvonnat hylätään
+    uint32_t num_names;      // Opetusnimien määrä
+} MarkovHeader;
+
+typedef struct {
+    char bytes[4];           // UTF-8-tavut (loput nollia)
+    uint32_t length;         // Merkin pituus tavuina (1-4)
+} MarkovSymbol;
+
+typedef struct {
+    uint32_t first_edge;
+    uint32_t num_edges;
+} MarkovState;
+
+typedef struct {
+    uint32_t symbol;
+    uint32_t next;           // Seuraava tila (merkille 0 käyttämätön)
+} MarkovEdge;
+
+// Malli: osoittimet muistikuvaan
+typedef struct {
+    const MarkovHeader *header;
+    const MarkovSymbol *symbols;
+    const MarkovState *states;
+    const AliasEntry *alias;
+    const MarkovEdge *edges;
+    const void *image;       // Muistikuva (kirjoitetaan korpukseen sellaisenaan)
+    size_t size;
+    void *block;             // Oma kuva (NULL, jos kuva on korpuksessa)
+} MarkovModel;
+
+// Opettaa mallin listan nimistä. Jokainen esiintymä lasketaan, joten sarakkeessa
+// toistuva nimi painaa enemmän. Tyhjä lista antaa mallin, joka ei tuota nimiä.
+// Palauttaa NAMELIST_OK, NAMELIST_ERR_NOMEM tai NAMELIST_ERR_FORMAT (order ei ole 1-4).
+int markov_train(MarkovModel *model, const NameList *list, int order);
+
+// Avaa muistikuvan (esim. korpuksesta) kopioimatta. Tarkistaa rakenteen, joten
+// arvonta ei voi lukea kuvan ulkopuolelta. Palauttaa NAMELIST_OK tai NAMELIST_ERR_FORMAT.
+int markov_view(MarkovModel *model, const void *image, size_t size);
+
+void markov_free(MarkovModel *model);
+
+// Kuvan tasaus: korpuksessa kuvat alkavat 8 tavun rajalta
+#define MARKOV_ALIGN 8
+
+// Arpoo nimen puskuriin (vähintään header->max_length + 4 tavua, koska merkit
+// kopioidaan aina neljän tavun paloina). Palauttaa pituuden
+// tai 0, jos nimi jäi tyhjäksi tai kasvoi pidemmäksi kuin yksikään opetusnimi
+// (kutsuja arpoo uudelleen).
+static inline size_t markov_sample(const MarkovModel *model, Rng *rng, char *out) {
+    const MarkovState *states = model->states;
+    uint32_t max_length = model->header->max_length;
+    uint32_t state = 0;
+    size_t length = 0;
+    for (;;) {
+        MarkovState row = states[state];
+        if (row.num_edges == 0) {
+            return 0;
+        }
+        uint64_t x = rng_next(rng);
+        uint32_t slot = (uint32_t)(((x >> 32) * (uint64_t)row.num_edges) >> 32);
+        AliasEntry entry = model->alias[row.first_edge + slot];
+        uint32_t k = ((uint32_t)x < entry.prob) ? slot : entry.alias;
+        MarkovEdge edge = model->edges[row.first_edge + k];
+        if (edge.symbol == 0) {
+            return length;
+        }
+        const MarkovSymbol *symbol = &model->symbols[edge.symbol];
+        if (length + symbol->length > max_length) {
+            return 0;
+        }
+        memcpy(out + length, symbol->bytes, 4);  // Merkki on enintään 4 tavua
+        length += symbol->length;
+        state = edge.next;
+    }
+}
+
+// Hylättävien nimien (--novel) etuliitepuu mallin merkeistä. Solmu on
+// hylättävän nimen alku ja mallin tila sen kohdalla. Solmun alias-taulussa
+// rivin siirtymien painot on kerrottu todennäköisyydellä, että jatko on uusi
+// nimi, joten arvonta ei koskaan päädy hylättävään nimeen eikä mitään arvota
+// uudelleen. Uudet nimet saadaan samalla jakaumalla kuin koko nimen
+// hylkäyksellä. Puusta poistuttua käytetään mallin omia tauluja.
+typedef struct {
+    uint32_t state;          // Mallin tila solmussa
+    uint32_t first;          // Solmun rivi alias- ja children-taulukoissa (rivin pituus = tilan siirtymät)
+    uint32_t is_name;        // Solmu päättää hylättävän nimen
+} MarkovTrieNode;
+
+typedef struct {
+    MarkovTrieNode *nodes;   // Solmu 0 on juuri
+    AliasEntry *alias;       // Solmujen alias-taulut
+    uint32_t *children;      // Siirtymän lapsisolmu tai 0 (juuri ei ole kenenkään lapsi)
+    uint32_t num_nodes;
+    uint32_t num_edges;
+} MarkovExclusion;
+
+// Rakentaa mallin etuliitepuun sanakirjan nimistä. Nimet, joita malli ei voi
+// tuottaa, jätetään pois. Palauttaa NAMELIST_OK tai NAMELIST_ERR_NOMEM.
+int markov_exclusion_build(MarkovExclusion *exclusion, const MarkovModel *model, const NameDict *names);
+
+void markov_exclusion_free(MarkovExclusion *exclusion);
+
+// Arpoo nimen kuten markov_sample, mutta ei koskaan etuliitepuun nimeä.
+// Satunnaislukuja kuluu yksi merkkiä kohden kuten markov_samplessa.
+static inline size_t markov_sample_novel(const MarkovModel *model, const MarkovExclusion *exclusion, Rng *rng,
+                                         char *out) {
+    const MarkovState *states = model->states;
+    uint32_t max_length = model->header->max_length;
+    uint32_t state = 0;
+    uint32_t node = 0;       // UINT32_MAX = nimi on jo poistunut puusta
+    size_t length = 0;
+    for (;;) {
+        MarkovState row = states[state];
+        if (row.num_edges == 0) {
+            return 0;
+        }
+        const AliasEntry *alias = (node != UINT32_MAX) ? exclusion->alias + exclusion->nodes[node].first
+                                                       : model->alias + row.first_edge;
+        uint64_t x = rng_next(rng);
+        uint32_t slot = (uint32_t)(((x >> 32) * (uint64_t)row.num_edges) >> 32);
+        AliasEntry entry = alias[slot];
+        uint32_t k = ((uint32_t)x < entry.prob) ? slot : entry.alias;
+        MarkovEdge edge = model->edges[row.first_edge + k];
+        if (node != UINT32_MAX) {
+            uint32_t child = exclusion->children[exclusion->nodes[node].first + k];
+            node = (child != 0) ? child : UINT32_MAX;
+        }
+        if (edge.symbol == 0) {
+            return length;
+        }
+        const MarkovSymbol *symbol = &model->symbols[edge.symbol];
+        if (length + symbol->length > max_length) {
+            return 0;
+        }
+        memcpy(out + length, symbol->bytes, 4);  // Merkki on enintään 4 tavua
+        length += symbol->length;
+        state = edge.next;
+    }
+}
+
+#endif // MARKOV_H
@@ -0,0 +1,113 @@
+/**
+* @file namedict.c
+* @brief Name dictionary: interns each distinct name once and hands out compact IDs.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "namedict.h"
+
+// FNV-1a nimen tavuille
+static uint32_t hash_name(const char *name, uint32_t length) {
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void name_dict_init(NameDict *dict, const char *pool) {
+    memset(dict, 0, sizeof(*dict));
+    dict->pool = pool;
+}
+
+void name_dict_free(NameDict *dict) {
+    free(dict->names);
+    free(dict->hash);
+    name_dict_init(dict, NULL);
+}
+
+uint32_t name_dict_find(const NameDict *dict, const char *name, uint32_t length) {
+    if (dict->hash_size == 0) {
+        return NAME_DICT_NONE;
+    }
+    size_t mask = dict->hash_size - 1;
+    for (size_t slot = hash_name(name, length) & mask; dict->hash[slot] != 0; slot = (slot + 1) & mask) {
+        const NameSlice *seen = &dict->names[dict->hash[slot] - 1];
+        if (seen->length == length && memcmp(dict->pool + seen->offset, name, length) == 0) {
+            return dict->hash[slot] - 1;
+        }
+    }
+    return NAME_DICT_NONE;
+}
+
+// Funktio sijoittaa tunnisteen hajautustauluun (taulussa on aina tyhjää)
+static void hash_insert(uint32_t *hash, size_t hash_size, const char *name, uint32_t length, uint32_t id) {
+    size_t mask = hash_size - 1;
+    size_t slot = hash_name(name, length) & mask;
+    while (hash[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    hash[slot] = id + 1;
+}
+
+uint32_t name_dict_add(NameDict *dict, uint32_t offset, uint32_t length) {
+    if (dict->error != 0 || dict->count == NAME_DICT_NONE - 1) {
+        dict->error = NAMELIST_ERR_NOMEM;
+        return NAME_DICT_NONE;
+    }
+
+    if (dict->count == dict->cap) {
+        size_t cap = (dict->cap > 0) ? dict->cap * 2 : 256;
+        NameSlice *names = (NameSlice *)realloc(dict->names, cap * sizeof(NameSlice));
+        if (names == NULL) {
+            dict->error = NAMELIST_ERR_NOMEM;
+            return NAME_DICT_NONE;
+        }
+        dict->names = names;
+        dict->cap = cap;
+    }
+
+    // Hajautustaulu pidetään enintään puoliksi täytenä
+    if (((size_t)dict->count + 1) * 2 > dict->hash_size) {
+        size_t hash_size = (dict->hash_size > 0) ? dict->hash_size * 2 : 512;
+        uint32_t *hash = (uint32_t *)calloc(hash_size, sizeof(uint32_t));
+        if (hash == NULL) {
+            dict->error = NAMELIST_ERR_NOMEM;
+            return NAME_DICT_NONE;
+        }
+        for (uint32_t id = 0; id < dict->count; id++) {
+            const NameSlice *name = &dict->names[id];
+            hash_insert(hash, hash_size, dict->pool + name->offset, name->length, id);
+        }
+        free(dict->hash);
+        dict->hash = hash;
+        dict->hash_size = hash_size;
+    }
+
+    uint32_t id = dict->count++;
+    dict->names[id].offset = offset;
+    dict->names[id].length = length;
+    hash_insert(dict->hash, dict->hash_size, dict->pool + offset, length, id);
+    return id;
+}
@@ -0,0 +1,74 @@
+/**
+* @file namedict.h
+* @brief Name dictionary: interns each distinct name once and hands out compact IDs.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef NAMEDICT_H
+#define NAMEDICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "namelist.h"
+
+// Tunniste, jota ei ole (haku ei löytänyt nimeä tai muisti loppui)
+#define NAME_DICT_NONE UINT32_MAX
+
+// Sanakirja rakennetaan latauksen tai korpuksen kirjoittamisen aikana. Jokainen
+// eri nimi on siinä kerran, ja sen tunniste on lisäysjärjestyksen indeksi.
+// Kaikki nimet ovat samassa kotipoolissa (kuvattu tiedosto tai korpuksen pooli).
+typedef struct {
+    const char *pool;    // Kotipooli, johon names osoittaa
+    NameSlice *names;    // Eri nimet, tunniste = indeksi
+    uint32_t count;
+    size_t cap;
+    uint32_t *hash;      // Avoin osoitus: tunniste + 1 (0 = tyhjä paikka)
+    size_t hash_size;
+    int error;           // NAMELIST_ERR_NOMEM, jos jokin kasvatus epäonnistui
+} NameDict;
+
+void name_dict_init(NameDict *dict, const char *pool);
+
+void name_dict_free(NameDict *dict);
+
+// Etsii nimen (mistä tahansa muistista). Palauttaa tunnisteen tai NAME_DICT_NONE.
+uint32_t name_dict_find(const NameDict *dict, const char *name, uint32_t length);
+
+// Lisää kotipoolissa olevan nimen, jota sanakirjassa ei vielä ole. Palauttaa
+// tunnisteen tai NAME_DICT_NONE, jos muisti loppui.
+uint32_t name_dict_add(NameDict *dict, uint32_t offset, uint32_t length);
+
+// Tunnisteiden leveys tavuina: 2, jos tunnisteet mahtuvat 16 bittiin, muuten 4
+static inline int name_dict_id_width(uint32_t count) {
+    return (count <= 65536u) ? 2 : 4;
+}
+
+// Kirjoittaa tunnisteen i paikkaan width tavun taulukossa
+static inline void name_dict_store_id(void *ids, int width, size_t i, uint32_t id) {
+    if (width == 2) {
+        ((uint16_t *)ids)[i] = (uint16_t)id;
+    } else {
+        ((uint32_t *)ids)[i] = id;
+    }
+}
+
+#endif // NAMEDICT_H
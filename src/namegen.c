@@ -26,333 +26,543 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <locale.h>
-#include <ctype.h> // Kytetn isspace:n kanssa trimmaamiseen
-#include <windows.h> // LIS TM
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "columnar.h"
+#include "libnamegen.h"
+#include "namelist.h"
+#include "outbuf.h"
+#include "parallel.h"
+#include "rng.h"
+#include "stats.h"
 
-// Maksimipituus yhdelle nimelle ja riville
-#define MAX_LINE_LENGTH 4096
 #define DEBUG_MODE 0
 
-// Rakenne nimilistan tietojen tallentamiseen
-typedef struct {
-    char **names;
-    int count;
-} NameList;
+// Latausviestit ja yhteenveto tulostetaan vain, jos verbose on pll (--quiet sammuttaa)
+static int verbose = 1;
 
-// --- B. KOKO TIEDOSTON TIETORAKENNE (DecadeData) ---
-// Koko sil CSV-tiedoston vuosikymmentiedoille
-typedef struct {
-    char **decades;      // Taulukko vuosikymmenten otsikoille ("187079")
-    NameList *lists;     // Dynaaminen taulukko NameList-rakenteille
-    int num_decades;     // Vuosikymmenten lukumr (sarakkeiden lkm)
-} DecadeData;
+// --- 1. APUFUNKTIOT ---
 
-// Funktio poistaa alussa olevat vlilynnit (trimmaa)
-char* trim_leading_spaces(char *str) {
-    while (isspace((unsigned char)*str)) {
-        str++;
+// Funktio tulostaa kytettviss olevat vuosikymmenet ja niiden koot
+void print_available_decades(const NameGen *ctx) {
+    printf("\n--- Available time periods (CSV structure) ---\n");
+    for (int i = 0; i < namegen_num_decades(ctx); i++) {
+        printf("%d: %s (Names on the list: %d)\n",
+               i + 1, namegen_decade_label(ctx, i), namegen_decade_size(ctx, i));
     }
-    return str;
+    printf("------------------------------------------------------\n");
 }
 
-// Funktio vapauttaa DecadeData-rakenteen varaaman muistin
-void free_decade_data(DecadeData *data) {
-    if (data->decades != NULL) {
-        // 1. Vapauta vuosikymmenten otsikot
-        for (int i = 0; i < data->num_decades; i++) {
-            free(data->decades[i]);
-        }
-        free(data->decades);
-    }
-
-    if (data->lists != NULL) {
-        // 2. Vapauta jokainen NameList
-        for (int i = 0; i < data->num_decades; i++) {
-            free_names(&data->lists[i]);
-        }
-        free(data->lists);
-    }
+// --- 2. ERAJO (--count) ---
 
-// Nollaa laskurit ja osoittimet
-    data->num_decades = 0;
-    data->decades = NULL;
-    data->lists = NULL;
+// Komentorivin asetukset
+typedef struct {
+    long long count;     // Generoitavien nimien mr (0 = interaktiivinen tila)
+    const char *decade;  // Vuosikymmen numerona (1-N) tai otsikon alkuna ("1890")
+    int year;            // Vuosi, jolle vuosikymmenet sekoitetaan (0 = ei vuotta)
+    uint64_t seed;       // Satunnaislukugeneraattorin siemen
+    int has_seed;        // Onko siemen annettu komentorivill
+    const char *output;  // Tulostiedosto (NULL = stdout)
+    const char *corpus;  // Knnetty korpus (NULL = luetaan CSV-tiedostot)
+    int weighted;        // Painotettu otanta (lukumrsarake tai Zipfin laki)
+    double zipf;         // Zipfin eksponentti listoille, joilla ei ole lukumri
+    int has_zipf;        // Onko eksponentti annettu komentorivill
+    int threads;         // Erajon sikeet (0 = laitteiston siemr)
+    int format;          // Rivimuoto (NAMEGEN_FORMAT_*; tietueet kirjoitetaan sarakemuotoon)
+    int dictionary;      // Tulostetaan sanakirja ("tunniste<TAB>nimi") ja lopetetaan
+    int unique;          // Kaikki nimet eri yhdistelmi (permutaatio yhdistelmien yli)
+    int conditional;     // Keskinimi etunimen mukaan (nimiyhdistelmtiedosto)
+    int markov;          // Uudet nimet merkkitason malleista
+    int novel;           // Markov-nimist hyltn lhdetiedostossa olevat
+    int stats;           // Mittausraportti: 0 = ei, 1 = taulukko, 2 = JSON
+} Options;
+
+// Funktio tulostaa ohjeen
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--count N (--decade X | --year Y)] [--seed S] [--output FILE] [--corpus FILE]\n"
+            "          [--weighted] [--zipf S] [--threads N] [--unique] [--format F] [--ids] [--dictionary]\n"
+            "          [--conditional] [--markov] [--novel] [--stats[=json]] [--quiet]\n"
+            "\n"
+            "Without --count the program asks for the period interactively.\n"
+            "\n"
+            "  -n, --count N      Generate N names, one per line, and exit\n"
+            "  -d, --decade X     Period number (1-N) or start of its title, e.g. 1890\n"
+            "  -y, --year Y       Blend the two nearest periods for year Y, e.g. 1894\n"
+            "  -s, --seed S       Seed for the random number generator\n"
+            "  -o, --output FILE  Write names to FILE instead of stdout\n"
+            "  -c, --corpus FILE  Use a corpus compiled with ngcompile instead of the CSV files\n"
+            "  -w, --weighted     Draw common names more often: by the count column of the\n"
+            "                     list if it has one, otherwise by rank (Zipf's law)\n"
+            "  -z, --zipf S       Zipf exponent for lists without counts (default 1.0,\n"
+            "                     implies --weighted; a corpus uses its compiled exponent)\n"
+            "  -j, --threads N    Worker threads for --count (default: all cores). The output\n"
+            "                     for a seed is the same with any number of threads\n"
+            "  -u, --unique       Every name is a different combination of first, middle (or\n"
+            "                     none) and last name; fails if N exceeds the combinations\n"
+            "  -f, --format F     With --count: text (default), csv (RFC 4180 with a header\n"
+            "                     row), jsonl (one object per name with the period and\n"
+            "                     seed), ids or columnar (both need --corpus; columnar is a\n"
+            "                     binary file of the dictionary and 32-bit ID columns)\n"
+            "  -i, --ids          Same as --format ids: dictionary IDs instead of names,\n"
+            "                     e.g. \"17 4 230\"\n"
+            "      --dictionary   With --corpus: print the dictionary as ID<TAB>name and exit\n"
+            "  -m, --conditional  Draw the middle name given the first name from the name\n"
+            "                     combination list (first names not in it use the middle\n"
+            "                     name list)\n"
+            "  -k, --markov       Invent new names letter by letter with a model trained on\n"
+            "                     the lists (compiled into the corpus by ngcompile)\n"
+            "      --novel        With --markov: reject names that are already in the lists\n"
+            "      --stats[=json] Print phase times, counters and the batch latency\n"
+            "                     histogram to stderr at exit, as a table or as JSON\n"
+            "  -q, --quiet        Do not print loading messages or the summary\n"
+            "  -h, --help         Show this help\n",
+            program);
 }
 
-// Ladataan nimet CSV-tiedostosta, jossa on useita sarakkeita (yksi sarake = yksi vuosikymmenlista)
-void load_names_multi_column(const char *filename, DecadeData *data) {
-    // Alustus
-    data->num_decades = 0;
-    data->decades = NULL;
-    data->lists = NULL;
-
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        perror("Error opening file");
-        return;
-    }
-
-    char buffer[MAX_LINE_LENGTH];
-
-    // 1. Lue otsikkorivi (vuosikymmenet)
-    if (fgets(buffer, MAX_LINE_LENGTH, file) == NULL) {
-        fclose(file);
-        return;
-    }
-
-    char header_copy[MAX_LINE_LENGTH];
-    strcpy(header_copy, buffer);
-    header_copy[strcspn(header_copy, "\n\r")] = 0; // Poista rivinvaihto
-
-    // Lasketaan sarakkeiden/vuosikymmenten mr ja varataan muisti otsikoille ja listoille
-    char *token = strtok(header_copy, ",");
-    while (token != NULL) {
-        // Otsikon varaus ja tallennus
-        data->decades = (char **)realloc(data->decades, (data->num_decades + 1) * sizeof(char *));
-        data->decades[data->num_decades] = strdup(trim_leading_spaces(token));
-
-        // NameList-rakenteen varaus ja alustus
-        data->lists = (NameList *)realloc(data->lists, (data->num_decades + 1) * sizeof(NameList));
-        data->lists[data->num_decades].names = NULL;
-        data->lists[data->num_decades].count = 0;
-
-        data->num_decades++;
-        token = strtok(NULL, ",");
+// Funktio muuntaa muodon nimen kirjaston muodoksi (-1 tuntemattomalle).
+// Sarakemuoto generoidaan tietueina, jotka generate_chunk knt sarakkeiksi.
+static int parse_format(const char *name) {
+    static const struct {
+        const char *name;
+        int format;
+    } formats[] = {
+        {"text", NAMEGEN_FORMAT_TEXT}, {"csv", NAMEGEN_FORMAT_CSV}, {"jsonl", NAMEGEN_FORMAT_JSONL},
+        {"ids", NAMEGEN_FORMAT_IDS}, {"columnar", NAMEGEN_FORMAT_RECORDS},
+    };
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcmp(name, formats[i].name) == 0) {
+            return formats[i].format;
+        }
     }
-    printf("Loaded %d headlines of the decade.\n", data->num_decades);
-
-    // 2. Lue varsinaiset tiedot rivi kerrallaan
-    while (fgets(buffer, MAX_LINE_LENGTH, file) != NULL) {
-        buffer[strcspn(buffer, "\n\r")] = 0;
-        char data_copy[MAX_LINE_LENGTH];
-        strcpy(data_copy, buffer);
-
-        token = strtok(data_copy, ",");
-        int col = 0;
-        while (token != NULL && col < data->num_decades) {
-
-            char *clean_name = trim_leading_spaces(token); // Puhdista vlilynnit
+    return -1;
+}
 
-            // Jos sarake ei ole tyhj, tallenna nimi
-            if (strlen(clean_name) > 0) {
-                NameList *current_list = &data->lists[col];
+// Funktio lukee komentorivin asetukset. Palauttaa 0 onnistuessa, 1 jos ohjelman
+// pit lopettaa (ohje tulostettu) ja -1 virheellisill argumenteilla.
+static int parse_options(int argc, char *argv[], Options *opt) {
+    opt->count = 0;
+    opt->decade = NULL;
+    opt->year = 0;
+    opt->seed = 0;
+    opt->has_seed = 0;
+    opt->output = NULL;
+    opt->corpus = NULL;
+    opt->weighted = 0;
+    opt->zipf = 1.0;
+    opt->has_zipf = 0;
+    opt->threads = 0;
+    opt->format = NAMEGEN_FORMAT_TEXT;
+    opt->dictionary = 0;
+    opt->unique = 0;
+    opt->conditional = 0;
+    opt->markov = 0;
+    opt->novel = 0;
+    opt->stats = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 1;
+        } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0) {
+            verbose = 0;
+            continue;
+        } else if (strcmp(arg, "-w") == 0 || strcmp(arg, "--weighted") == 0) {
+            opt->weighted = 1;
+            continue;
+        } else if (strcmp(arg, "-i") == 0 || strcmp(arg, "--ids") == 0) {
+            opt->format = NAMEGEN_FORMAT_IDS;
+            continue;
+        } else if (strcmp(arg, "-u") == 0 || strcmp(arg, "--unique") == 0) {
+            opt->unique = 1;
+            continue;
+        } else if (strcmp(arg, "-m") == 0 || strcmp(arg, "--conditional") == 0) {
+            opt->conditional = 1;
+            continue;
+        } else if (strcmp(arg, "-k") == 0 || strcmp(arg, "--markov") == 0) {
+            opt->markov = 1;
+            continue;
+        } else if (strcmp(arg, "--novel") == 0) {
+            opt->markov = 1;
+            opt->novel = 1;
+            continue;
+        } else if (strcmp(arg, "--dictionary") == 0) {
+            opt->dictionary = 1;
+            continue;
+        } else if (strcmp(arg, "--stats") == 0 || strcmp(arg, "--stats=table") == 0) {
+            opt->stats = 1;
+            continue;
+        } else if (strcmp(arg, "--stats=json") == 0) {
+            opt->stats = 2;
+            continue;
+        }
 
-                // Varaa muistia osoittimelle
-                current_list->names = (char **)realloc(current_list->names, (current_list->count + 1) * sizeof(char *));
+        if (value == NULL) {
+            fprintf(stderr, "ERROR: Unknown option or missing value: %s\n", arg);
+            return -1;
+        }
 
-                // Tallenna nimi
-                current_list->names[current_list->count] = strdup(clean_name);
-                current_list->count++;
+        char *end = NULL;
+        if (strcmp(arg, "-n") == 0 || strcmp(arg, "--count") == 0) {
+            opt->count = strtoll(value, &end, 10);
+            if (*end != '\0' || opt->count <= 0) {
+                fprintf(stderr, "ERROR: Invalid count: %s\n", value);
+                return -1;
             }
-
-            col++;
-            token = strtok(NULL, ",");
+        } else if (strcmp(arg, "-d") == 0 || strcmp(arg, "--decade") == 0) {
+            opt->decade = value;
+        } else if (strcmp(arg, "-y") == 0 || strcmp(arg, "--year") == 0) {
+            long year = strtol(value, &end, 10);
+            if (*end != '\0' || year < 1 || year > 9999) {
+                fprintf(stderr, "ERROR: Invalid year: %s\n", value);
+                return -1;
+            }
+            opt->year = (int)year;
+        } else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--seed") == 0) {
+            opt->seed = strtoull(value, &end, 10);
+            if (*end != '\0') {
+                fprintf(stderr, "ERROR: Invalid seed: %s\n", value);
+                return -1;
+            }
+            opt->has_seed = 1;
+        } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) {
+            opt->output = value;
+        } else if (strcmp(arg, "-c") == 0 || strcmp(arg, "--corpus") == 0) {
+            opt->corpus = value;
+        } else if (strcmp(arg, "-f") == 0 || strcmp(arg, "--format") == 0) {
+            opt->format = parse_format(value);
+            if (opt->format < 0) {
+                fprintf(stderr, "ERROR: Unknown format (text, csv, jsonl, ids, columnar): %s\n", value);
+                return -1;
+            }
+        } else if (strcmp(arg, "-z") == 0 || strcmp(arg, "--zipf") == 0) {
+            opt->zipf = strtod(value, &end);
+            if (end == value || *end != '\0' || opt->zipf < 0.0) {
+                fprintf(stderr, "ERROR: Invalid Zipf exponent: %s\n", value);
+                return -1;
+            }
+            opt->weighted = 1;
+            opt->has_zipf = 1;
+        } else if (strcmp(arg, "-j") == 0 || strcmp(arg, "--threads") == 0) {
+            long threads = strtol(value, &end, 10);
+            if (*end != '\0' || threads <= 0 || threads > 1024) {
+                fprintf(stderr, "ERROR: Invalid thread count: %s\n", value);
+                return -1;
+            }
+            opt->threads = (int)threads;
+        } else {
+            fprintf(stderr, "ERROR: Unknown option: %s\n", arg);
+            return -1;
         }
+        i++; // Arvo ksitelty
     }
 
-    fclose(file);
-}
-
-// Funktio tulostaa kytettviss olevat vuosikymmenet ja niiden koot
-void print_available_decades(const DecadeData *data) {
-    printf("\n--- Available time periods (CSV structure) ---\n");
-    for (int i = 0; i < data->num_decades; i++) {
-        printf("%d: %s (Names on the list: %d)\n",
-               i + 1, data->decades[i], data->lists[i].count);
+    if (opt->decade != NULL && opt->year != 0) {
+        fprintf(stderr, "ERROR: --decade and --year cannot be used together.\n");
+        return -1;
     }
-    printf("------------------------------------------------------\n");
+    if (opt->count > 0 && opt->decade == NULL && opt->year == 0) {
+        fprintf(stderr, "ERROR: --count requires --decade or --year.\n");
+        return -1;
+    }
+    int ids = (opt->format == NAMEGEN_FORMAT_IDS || opt->format == NAMEGEN_FORMAT_RECORDS);
+    if ((ids || opt->dictionary) && opt->corpus == NULL) {
+        fprintf(stderr, "ERROR: --ids, --format columnar and --dictionary require --corpus (the corpus has one dictionary for all lists).\n");
+        return -1;
+    }
+    if (opt->unique && opt->weighted) {
+        fprintf(stderr, "ERROR: --unique draws every combination once, it cannot be combined with --weighted or --zipf.\n");
+        return -1;
+    }
+    if (opt->unique && opt->count == 0) {
+        fprintf(stderr, "ERROR: --unique requires --count.\n");
+        return -1;
+    }
+    if (opt->format != NAMEGEN_FORMAT_TEXT && opt->count == 0) {
+        fprintf(stderr, "ERROR: --format and --ids require --count.\n");
+        return -1;
+    }
+    if (opt->conditional && (opt->year != 0 || opt->unique || ids)) {
+        fprintf(stderr, "ERROR: --conditional cannot be combined with --year, --unique, --ids or --format columnar.\n");
+        return -1;
+    }
+    if (opt->markov && (opt->year != 0 || opt->unique || ids || opt->conditional)) {
+        fprintf(stderr, "ERROR: --markov cannot be combined with --year, --unique, --ids, --format columnar or --conditional.\n");
+        return -1;
+    }
+    if (opt->has_zipf && opt->corpus != NULL) {
+        fprintf(stderr, "WARNING: --zipf is ignored with --corpus, the corpus uses the exponent it was compiled with.\n");
+    }
+    return 0;
 }
 
-// Funktio vapauttaa NameList-rakenteen varaaman muistin
-void free_names(NameList *list) {
-    if (list->names != NULL) {
-        for (int i = 0; i < list->count; i++) {
-            free(list->names[i]);
-        }
-        free(list->names);
+// Erajon tiedot, jotka jaetaan kaikille sikeille (vain luku)
+typedef struct {
+    NameGen *ctx;
+    int decade;
+    int year;            // Nollasta poikkeava: sekoitetut listat vuodelle
+    size_t max_line;     // Pisin mahdollinen rivi, puskuri varataan tmn mukaan
+    int columnar;        // Tietueet knnetn sarakepaloiksi (--format columnar)
+    int unique;          // Yksiksitteiset nimet: pala c on permutaation alue [first, first + count)
+    uint64_t seed;       // Permutaation siemen
+    int *failed;         // Palan virhekoodi (esim. Markov-malli ei lytnyt uutta nime)
+} BatchJob;
+
+// Palan generointi (ChunkFunc): yksi sie, oma virta ja oma puskuri.
+// Puskuriin varataan tila pahimman tapauksen mukaan, joten kaikki nimet mahtuvat.
+static void generate_chunk(void *context, long long first, long long count, Rng *rng, OutBuf *out) {
+    const BatchJob *job = (const BatchJob *)context;
+    uint64_t start = stats_begin();
+    size_t bytes = 0;
+
+    // Sarakemuodossa tietueet kirjoitetaan palan pern ja knnetn sen paikalle
+    size_t batch = job->columnar ? columnar_batch_size((uint32_t)count) : 0;
+    char *dst = outbuf_reserve(out, batch + (size_t)count * job->max_line);
+    if (dst == NULL) {
+        return; // Muisti loppui: virhe j puskuriin, eik palaa kirjoiteta
     }
+    char *p = dst + batch;
+    size_t capacity = out->cap - out->len - batch;
+    long long written;
+    if (job->unique && job->year != 0) {
+        written = namegen_generate_unique_year(job->ctx, job->seed, job->year, (uint64_t)first,
+                                               p, capacity, count, &bytes);
+    } else if (job->unique) {
+        written = namegen_generate_unique(job->ctx, job->seed, job->decade, (uint64_t)first,
+                                          p, capacity, count, &bytes);
+    } else if (job->year != 0) {
+        written = namegen_generate_year(job->ctx, rng, job->year, p, capacity, count, &bytes);
+    } else {
+        written = namegen_generate_batch(job->ctx, rng, job->decade, p, capacity, count, &bytes);
+    }
+    if (written < 0) {
+        __atomic_store_n(job->failed, (int)written, __ATOMIC_RELAXED);
+    }
+    if (job->columnar) {
+        bytes = columnar_batch(dst, (const uint32_t *)(const void *)p, (uint32_t)(bytes / NAMEGEN_RECORD_SIZE));
+    }
+    out->len += bytes;
+    stats_end_batch(start, (uint64_t)count);
 }
 
-// --- 1. TIEDOSTON LATAUSFUNKTIOT ---
+// Funktio palauttaa kuluneen ajan sekunteina
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
 
-// Funktio lataa nimet tavallisesta tiedostosta (yksi nimi per rivi)
-void load_names_simple(const char *filename, NameList *list) {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        fprintf(stderr, "WARNING: Could not open file: %s\n", filename);
-        list->count = 0;
-        list->names = NULL;
-        return;
+// Erajo: generoi opt->count nime ja kirjoittaa ne stdoutiin tai tiedostoon.
+// Nimet generoidaan rinnakkain paloittain; pala c kytt virtaa (seed, c).
+static int run_batch(const Options *opt, uint64_t seed, NameGen *ctx) {
+    int failed = 0;
+    BatchJob job = {ctx, -1, opt->year, 0, opt->format == NAMEGEN_FORMAT_RECORDS, opt->unique, seed, &failed};
+    if (opt->year != 0) {
+        job.max_line = namegen_year_max_line_length(ctx, opt->year);
+        if (!namegen_supports_years(ctx) || job.max_line == 0) {
+            fprintf(stderr, "ERROR: The period titles are not years, cannot use --year.\n");
+            return 1;
+        }
+    } else {
+        job.decade = namegen_find_decade(ctx, opt->decade);
+        if (job.decade < 0 || namegen_decade_size(ctx, job.decade) == 0) {
+            fprintf(stderr, "ERROR: Unknown period or no first names: %s\n", opt->decade);
+            return 1;
+        }
+        job.max_line = namegen_max_line_length(ctx, job.decade);
     }
 
-    list->count = 0;
-    list->names = NULL;
-    char buffer[MAX_LINE_LENGTH];
-
-    // Luetaan rivi kerrallaan
-    while (fgets(buffer, MAX_LINE_LENGTH, file) != NULL) {
-        buffer[strcspn(buffer, "\n\r")] = 0; // Poista rivinvaihto
+    char source[64];
+    if (job.year != 0) {
+        snprintf(source, sizeof(source), "the year %d", job.year);
+    } else {
+        snprintf(source, sizeof(source), "the period '%s'", namegen_decade_label(ctx, job.decade));
+    }
 
-        char *clean_name = trim_leading_spaces(buffer);
-        if (strlen(clean_name) > 0) {
+    // Yksiksitteisi nimi voi olla enintn yhdistelmien verran
+    if (job.unique) {
+        uint64_t space = (job.year != 0) ? namegen_unique_space_year(ctx, job.year)
+                                         : namegen_unique_space(ctx, job.decade);
+        if ((uint64_t)opt->count > space) {
+            fprintf(stderr, "ERROR: --unique: %lld names requested, but %s has only %llu distinct combinations.\n",
+                    opt->count, source, (unsigned long long)space);
+            return 1;
+        }
+    }
 
-            list->names = (char **)realloc(list->names, (list->count + 1) * sizeof(char *));
-            if (list->names == NULL) {
-                perror("Memory allocation failed (simple realloc)");
-                exit(EXIT_FAILURE);
-            }
+    FILE *file = stdout;
+    if (opt->output != NULL) {
+        file = fopen(opt->output, "wb");
+        if (file == NULL) {
+            perror("Error opening output file");
+            return 1;
+        }
+    }
 
-            // KORJAUS: Vain yksi strdup(), kytetn puhdistettua nime
-            list->names[list->count] = strdup(clean_name);
+    OutBuf out;
+    if (outbuf_init(&out, file, OUTBUF_DEFAULT_SIZE) != 0) {
+        if (file != stdout) {
+            fclose(file);
+        }
+        return 1;
+    }
 
-            if (list->names[list->count] == NULL) {
-                perror("Memory allocation failed (simple strdup)");
-                exit(EXIT_FAILURE);
-            }
+    int threads = (opt->threads > 0) ? opt->threads : parallel_default_threads();
+
+    double start = now_seconds();
+    if (opt->format == NAMEGEN_FORMAT_CSV) {
+        outbuf_write(&out, "first,middle,last\r\n", 19);
+    } else if (job.columnar) {
+        // Sanakirja kerran tiedoston alkuun suoraan korpuksen kuvauksesta
+        const uint32_t *names;
+        const char *pool;
+        uint64_t pool_size;
+        namegen_dictionary_data(ctx, &names, &pool, &pool_size);
+        char year[16];
+        snprintf(year, sizeof(year), "%d", job.year);
+        columnar_write_header(&out, (job.year != 0) ? year : namegen_decade_label(ctx, job.decade), seed,
+                              names, namegen_dictionary_size(ctx), pool, pool_size);
+    }
+    int result = parallel_generate(opt->count, seed, threads, generate_chunk, &job, &out);
+    if (job.columnar) {
+        columnar_write_end(&out);
+    }
+    if (outbuf_close(&out) != 0) {
+        result = -1;
+    }
+    double elapsed = now_seconds() - start;
 
-            list->count++;
-        }
+    if (file != stdout && fclose(file) != 0) {
+        result = -1;
+    }
+    if (result != 0) {
+        perror("Error writing names");
+        return 1;
+    }
+    if (failed != 0) {
+        fprintf(stderr, "ERROR: Generation stopped: %s.\n", namegen_strerror(failed));
+        return 1;
     }
 
-    fclose(file);
-    printf("Loaded %d name from the file: %s\n", list->count, filename);
+    if (verbose) {
+        fprintf(stderr, "Generated %lld %snames from %s in %.3f s with %d threads (%.0f names/sec, %.1f MB/s)\n",
+                opt->count, job.unique ? "unique " : "", source, elapsed, threads,
+                elapsed > 0 ? (double)opt->count / elapsed : 0.0,
+                elapsed > 0 ? (double)out.bytes_written / elapsed / 1e6 : 0.0);
+    }
+    return 0;
 }
 
+// --- 3. POHJELMA ---
 
-// Funktio lataa nimet CSV-tiedostosta (ottaa vain ensimmisen sarakkeen huomioon)
-void load_names_from_csv(const char *filename, NameList *list) {
-    FILE *file = fopen(filename, "r");
-    // Siirr osoitinta eteenpin ohittaen alussa olevat vlilynnit
-    if (file == NULL) {
-        fprintf(stderr, "WARNING: Unable to open CSV-file: %s\n", filename);
-        list->count = 0;
-        list->names = NULL;
-        return;
+int main(int argc, char *argv[]) {
+    Options opt;
+    int parsed = parse_options(argc, argv, &opt);
+    if (parsed != 0) {
+        return parsed > 0 ? 0 : 1;
+    }
+    namelist_verbose = verbose;
+    if (opt.stats) {
+        stats_enable(1); // Ennen latausta, jotta tiedostojen vaiheet mitataan
     }
 
-    list->count = 0;
-    list->names = NULL;
-    char buffer[MAX_LINE_LENGTH];
+    // Nimet ja otsikot ovat latauksen jlkeen aina UTF-8:aa (utf8norm.c),
+    // joten lokalisointia ei tarvitse vaihtaa; Windowsin konsoli asetetaan
+    // nyttmn UTF-8:aa
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
 
-    if (list->count == 0) {
-    return ""; // Palauta tyhj merkkijono, jos lista on tyhj.
-}
+    // Asetetaan satunnaislukugeneraattorin siemen (sama siemen = samat nimet)
+    uint64_t seed = opt.has_seed ? opt.seed : (uint64_t)time(NULL);
+    Rng rng;
+    rng_seed(&rng, seed);
 
-    // OHITA ENSIMMINEN OTSIKKORIVI
-    if (fgets(buffer, MAX_LINE_LENGTH, file) == NULL) {
-        fclose(file);
-        return;
+    // 1. LADATAAN KAIKKI KOLME TIEDOSTOA HETI ALUSSA!
+    if (verbose) {
+        fprintf(stderr, "--- Reading files ---\n");
+    }
+    NameGen *ctx = NULL;
+    const char *source = (opt.corpus != NULL) ? opt.corpus : NAMEGEN_DEFAULT_LOCALE;
+    int status = (opt.corpus != NULL) ? namegen_open_corpus(opt.corpus, &ctx)
+                                      : namegen_open_directory(NAMEGEN_DEFAULT_LOCALE, &ctx);
+    if (verbose) {
+        fprintf(stderr, "--------------------------\n");
     }
 
-    // Luetaan rivi kerrallaan
-    while (fgets(buffer, MAX_LINE_LENGTH, file) != NULL) {
-        char temp_buffer[MAX_LINE_LENGTH];
-        strcpy(temp_buffer, buffer); // Kopioidaan rivi, koska strtok muuttaa alkuperist
-
-        // Poista rivinvaihto kopioidusta
-        temp_buffer[strcspn(temp_buffer, "\n\r")] = 0;
-
-        // Kytetn strtok-funktiota erottamaan merkkijono pilkun (',') kohdalta
-        char *name_token = strtok(temp_buffer, ",");
+    // 2. KRIITTINEN TARKISTUS: Poistu, jos pakolliset tiedostot puuttuvat
+    if (status != NAMEGEN_OK) {
+        fprintf(stderr, "\nERROR: Could not load names from %s: %s.\n", source, namegen_strerror(status));
+        return 1;
+    }
 
-       if (name_token != NULL) {
-            // Poista mahdollinen ylimrinen vlilynti nimen alusta
-            char *clean_name = name_token;
-            while (*clean_name == ' ') {
-                clean_name++;
-            }
+    status = namegen_set_weighting(ctx, opt.weighted, opt.zipf);
+    if (status != NAMEGEN_OK) {
+        fprintf(stderr, "ERROR: Could not build weighted tables: %s.\n", namegen_strerror(status));
+        namegen_close(ctx);
+        return 1;
+    }
 
-    if (strlen(clean_name) > 0) { // Varmistus: Tyhjien nimien ohitus
-                list->names = (char **)realloc(list->names, (list->count + 1) * sizeof(char *));
-                if (list->names == NULL) {
-                    perror("Memory allocation failed (csv realloc)");
-                    fclose(file); // Sulje tiedosto ennen poistumista
-                    free_names(list); // Vapauta jo varattu muisti
-                    exit(EXIT_FAILURE);
-                }
-
-                list->names[list->count] = strdup(clean_name); // Tallenna puhdistettu nimi
-                if (list->names[list->count] == NULL) {
-                    perror("Memory allocation failed (csv strdup)");
-                    fclose(file);
-                    free_names(list);
-                    exit(EXIT_FAILURE);
-                }
-
-                list->count++;
-            }
+    // Sanakirja: tunnisteet nimiksi (esim. --ids-tulosteen muuntamiseen)
+    if (opt.dictionary) {
+        for (uint32_t id = 0; id < namegen_dictionary_size(ctx); id++) {
+            size_t length;
+            const char *name = namegen_dictionary_name(ctx, id, &length);
+            printf("%u\t%.*s\n", id, (int)length, name);
         }
+        namegen_close(ctx);
+        return 0;
     }
-
-    fclose(file);
-    printf("Loaded %d names from CSV-file: %s\n", list->count, filename);
-}
-
-// Funktio valitsee ja palauttaa satunnaisen nimen NameList-rakenteesta
-const char* select_random_name(const NameList *list) {
-    if (list->count == 0) {
-        return "";
+    status = namegen_set_format(ctx, opt.format, seed);
+    if (status != NAMEGEN_OK) {
+        fprintf(stderr, "ERROR: --format: %s.\n", namegen_strerror(status));
+        namegen_close(ctx);
+        return 1;
     }
-    // Satunnainen indeksi: 0 ... (list->count - 1)
-    int index = rand() % list->count;
-    return list->names[index];
-}
-
-
-// --- 3. POHJELMA ---
-
-int main() {
-    SetConsoleOutputCP(CP_UTF8);  // merkistvirheen korjaus WIN11, poista tm kun knnt Linuxille.
-    // Asettaa ohjelman lokalisoinnin kyttmn UTF-8-merkist
-    // Tm yritt korjata "189099" -tyyppiset merkkivristymt
-    setlocale(LC_ALL, "fi_FI.UTF-8");
-
-    // Asetetaan satunnaislukugeneraattorin siemen
-    srand(time(NULL));
-
-    // KOLME ERI TIETORAKENNETTA
-    DecadeData first_names = {NULL, NULL, 0};
-    DecadeData middle_names = {NULL, NULL, 0};
-    NameList last_names_simple = {NULL, 0}; // Yksinkertainen lista sukunimille
 
-    const char *first_file = "data/FI-fi/Finnish-men-firts-names.csv";
-    const char *middle_file = "data/FI-fi/Finnish-men-seconds-names.csv";
-    const char *last_file_simple = "data/FI-fi/Finnish-men-last-names.csv";
-
-    // 1. LADATAAN KAIKKI KOLME TIEDOSTOA HETI ALUSSA!
-    printf("--- Reading files ---\n");
-    load_names_multi_column(first_file, &first_names);
-    load_names_multi_column(middle_file, &middle_names);
-    // KORJAUS 1 & 2: Lataa sukunimet oikealla muuttujalla ja oikeassa kohdassa!
-    load_names_simple(last_file_simple, &last_names_simple);
-    printf("--------------------------\n");
+    status = namegen_set_markov(ctx, opt.markov, opt.novel);
+    if (status != NAMEGEN_OK) {
+        fprintf(stderr, "ERROR: --markov: %s.\n", namegen_strerror(status));
+        namegen_close(ctx);
+        return 1;
+    }
 
-    // 2. KRIITTINEN TARKISTUS: Poistu, jos pakolliset tiedostot puuttuvat
-    if (first_names.num_decades == 0 || last_names_simple.count == 0) {
-
-        fprintf(stderr, "\nERROR: Required files are missing or empty.\n");
-        fprintf(stderr, "Number of first name columns: %d, Number of last names: %d.\n",
-                        first_names.num_decades, last_names_simple.count);
-        free_decade_data(&first_names);
-        free_decade_data(&middle_names);
-        free_names(&last_names_simple);
+    status = namegen_set_conditional(ctx, opt.conditional);
+    if (status != NAMEGEN_OK) {
+        fprintf(stderr, "ERROR: --conditional: %s (%s).\n", namegen_strerror(status), NAMEGEN_COMBINATIONS);
+        namegen_close(ctx);
         return 1;
     }
 
     // ANNA VAROITUS, JOS KESKINIMET PUUTTUVAT, MUTTA JATKA
-    if (middle_names.num_decades == 0) {
+    if (!namegen_has_middle_names(ctx)) {
         fprintf(stderr, "\nWARNING: Middle names file not loaded. The generator does not use middle names.\n");
     }
 
+    // ERAJO: ei kysely, nimet suoraan tulosteeseen
+    if (opt.count > 0) {
+        int result = run_batch(&opt, seed, ctx);
+        namegen_close(ctx);
+        if (opt.stats) {
+            stats_print(stderr, opt.stats == 2);
+        }
+        return result;
+    }
+
     // A. KYTTJN ESITTELY JA KYSELY
-    print_available_decades(&first_names); // Kutsutaan vain kerran!
+    print_available_decades(ctx); // Kutsutaan vain kerran!
 
+    int num_decades = namegen_num_decades(ctx);
     int valinta = 0;
     int index = -1; // Kytettv indeksi
 
-    printf("Enter the period number for name generation (1-%d) or 0 to exit: ", first_names.num_decades);
-    if (scanf("%d", &valinta) != 1 || valinta < 0 || valinta > first_names.num_decades) {
+    printf("Enter the period number for name generation (1-%d) or 0 to exit: ", num_decades);
+    if (scanf("%d", &valinta) != 1 || valinta < 0 || valinta > num_decades) {
         printf("Incorrect choice.\n");
         valinta = 0; // Jos virhe, poistu
     }
@@ -361,44 +571,44 @@ int main() {
         index = valinta - 1; // Valittu lista, esim. 1 -> indeksi 0
 
         // TARKISTUS: Varmistetaan, ett valitulla indeksill on nimi etunimilistassa
-        if (index < first_names.num_decades && first_names.lists[index].count > 0) {
-
-            // 1. Nimien valinta
-            const char *first = first_names.lists[index].names[rand() % first_names.lists[index].count];
-            const char *middle = "";
-            const char *last = last_names_simple.names[rand() % last_names_simple.count];
-
-            // 2. KESKINIMEN VALINTA (50% todennkisyys)
-            if (index < middle_names.num_decades &&
-                middle_names.lists[index].count > 0 &&
-                rand() % 100 < 50) {
-                middle = middle_names.lists[index].names[rand() % middle_names.lists[index].count];
+        if (namegen_decade_size(ctx, index) > 0) {
+
+            // 1. Nimen valinta (etunimi, sukunimi ja 50 % todennkisyydell keskinimi)
+            size_t line_cap = namegen_max_line_length(ctx, index);
+            char *line = (char *)malloc(line_cap);
+            size_t line_len = 0;
+            if (line == NULL) {
+                perror("Memory allocation failed (name)");
+                namegen_close(ctx);
+                return 1;
+            }
+            namegen_generate_batch(ctx, &rng, index, line, line_cap, 1, &line_len);
+            if (line_len > 0) {
+                line_len--; // Rivinvaihto pois
             }
 
             // DEBUG-LOHKO: Tulostaa muuttujien arvot vain, jos DEBUG_MODE on 1
 #if DEBUG_MODE
-            fprintf(stderr, "DEBUG: First='%s', Middle='%s', Last='%s'\n", first, middle, last);
+            fprintf(stderr, "DEBUG: Name='%.*s'\n", (int)line_len, line);
 #endif
 
-            // 3. Tulostus
-            printf("\nGenerated name from the period '%s':\n", first_names.decades[index]);
-            if (strlen(middle) > 0) {
-                printf(">>> %s %s %s <<<\n\n", first, middle, last);
-            } else {
-                printf(">>> %s %s <<<\n\n", first, last);
-            }
+            // 2. Tulostus
+            printf("\nGenerated name from the period '%s':\n", namegen_decade_label(ctx, index));
+            printf(">>> %.*s <<<\n\n", (int)line_len, line);
+            free(line);
 
         } else {
-            printf("\nVIRHE: There are not enough first names in the selected time period. (%s). \n", first_names.decades[index]);
+            printf("\nVIRHE: There are not enough first names in the selected time period. (%s). \n", namegen_decade_label(ctx, index));
         }
     } else {
         printf("Exiting the program.\n");
     }
 
     // LOPUSSA: Vapautetaan muisti
-    free_decade_data(&first_names);
-    free_decade_data(&middle_names);
-    free_names(&last_names_simple);
+    namegen_close(ctx);
+    if (opt.stats) {
+        stats_print(stderr, opt.stats == 2);
+    }
 
     return 0;
 }
@@ -0,0 +1,764 @@
+/**
+* @file namelist.c
+* @brief Name list loaders backed by a single string arena.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h> // Käytetään isspace:n kanssa trimmaamiseen
+
+#include "alias.h"
+#include "namedict.h"
+#include "namelist.h"
+#include "stats.h"
+#include "utf8norm.h"
+
+// Paikkataulukon alkukoko (kasvaa aina kaksinkertaiseksi)
+#define INITIAL_SLICES 256
+
+int namelist_verbose = 0;
+
+// --- 1. PAIKKATAULUKKO ---
+
+// Latauksen aikainen apurakenne: nimien paikat kootaan yhteen taulukkoon ja
+// lopuksi pakataan yhteen muistilohkoon. Itse nimet jäävät kuvattuun tiedostoon.
+typedef struct {
+    NameSlice *slices;   // Nimien paikat tiedostossa
+    int *columns;        // Jokaisen nimen sarake (monisarakkeinen lataus)
+    uint32_t *counts;    // Esiintymismäärät, jos tiedostossa on lukumääräsarake
+    size_t count;
+    size_t cap;
+    size_t column_cap;
+    size_t counts_cap;
+    int error;           // NAMELIST_ERR_NOMEM, jos jokin kasvatus epäonnistui
+} SliceArray;
+
+// Funktio kasvattaa taulukkoa geometrisesti, kunnes siihen mahtuu need alkiota.
+// Epäonnistuessa vanha taulukko säilyy ennallaan ja *error asetetaan.
+static void *grow_array(void *ptr, size_t *cap, size_t need, size_t elem_size,
+                        size_t initial, int *error) {
+    if (need <= *cap) {
+        return ptr;
+    }
+
+    size_t new_cap = (*cap > 0) ? *cap : initial;
+    while (new_cap < need) {
+        new_cap *= 2;
+    }
+
+    void *new_ptr = realloc(ptr, new_cap * elem_size);
+    if (new_ptr == NULL) {
+        *error = NAMELIST_ERR_NOMEM;
+        return ptr;
+    }
+    stats_count(STATS_ALLOCS, 1);
+    stats_count(STATS_ALLOC_BYTES, new_cap * elem_size);
+    *cap = new_cap;
+    return new_ptr;
+}
+
+static void slices_init(SliceArray *array) {
+    memset(array, 0, sizeof(*array));
+}
+
+static void slices_free(SliceArray *array) {
+    free(array->slices);
+    free(array->columns);
+    free(array->counts);
+    slices_init(array);
+}
+
+// Funktio lisää nimen paikan taulukkoon ja palauttaa sen indeksin
+// (SIZE_MAX, jos muisti loppui). Sarake tallennetaan vain, jos column >= 0.
+static size_t slices_add(SliceArray *array, size_t offset, uint32_t length, int column) {
+    array->slices = grow_array(array->slices, &array->cap, array->count + 1,
+                               sizeof(NameSlice), INITIAL_SLICES, &array->error);
+    if (column >= 0) {
+        array->columns = grow_array(array->columns, &array->column_cap, array->count + 1,
+                                    sizeof(int), INITIAL_SLICES, &array->error);
+    }
+    if (array->error != 0) {
+        return SIZE_MAX;
+    }
+    if (column >= 0) {
+        array->columns[array->count] = column;
+    }
+
+    array->slices[array->count].offset = (uint32_t)offset;
+    array->slices[array->count].length = length;
+    return array->count++;
+}
+
+// Funktio tallentaa nimen index esiintymismäärän. Nimet, joille määrää ei
+// anneta, saavat painon 1.
+static void slices_set_count(SliceArray *array, size_t index, uint32_t count) {
+    if (index == SIZE_MAX || array->error != 0) {
+        return;
+    }
+    if (array->counts == NULL || array->counts_cap < array->cap) {
+        size_t old_cap = array->counts_cap;
+        array->counts = grow_array(array->counts, &array->counts_cap, array->cap,
+                                   sizeof(uint32_t), INITIAL_SLICES, &array->error);
+        if (array->error != 0) {
+            return;
+        }
+        for (size_t i = old_cap; i < array->counts_cap; i++) {
+            array->counts[i] = 1;
+        }
+    }
+    array->counts[index] = count;
+}
+
+// Funktio pakkaa taulukon NameListiksi: [paikat][esiintymismäärät] yhdessä lohkossa.
+// Taulukko vapautetaan aina. Palauttaa NAMELIST_OK tai NAMELIST_ERR_NOMEM.
+static int slices_to_list(SliceArray *array, NameList *list) {
+    if (array->error != 0 || array->count == 0) {
+        int error = array->error;
+        slices_free(array);
+        return error;
+    }
+
+    size_t slices_size = array->count * sizeof(NameSlice);
+    size_t counts_size = (array->counts != NULL) ? array->count * sizeof(uint32_t) : 0;
+    char *block = (char *)malloc(slices_size + counts_size);
+    if (block == NULL) {
+        slices_free(array);
+        return NAMELIST_ERR_NOMEM;
+    }
+    stats_count(STATS_ALLOCS, 1);
+    stats_count(STATS_ALLOC_BYTES, slices_size + counts_size);
+
+    memcpy(block, array->slices, slices_size);
+    if (counts_size > 0) {
+        memcpy(block + slices_size, array->counts, counts_size);
+        list->counts = (const uint32_t *)(block + slices_size);
+    }
+
+    list->slices = (const NameSlice *)block;
+    list->count = (int)array->count;
+    list->block = block;
+
+    slices_free(array);
+    return NAMELIST_OK;
+}
+
+// Funktio pakkaa taulukon DecadeDataksi. Sarakkeiden nimet koodataan
+// sanakirjaan: jokainen eri nimi on lohkossa kerran, ja sarakkeissa on vain
+// 16- tai 32-bittiset tunnisteet. Lohkon rakenne:
+// [NameList * n][otsikko-osoittimet * n][sanakirja]
+// [esiintymismäärät sarakkeittain, jos on][tunnisteet sarakkeittain][otsikkojen merkkijonot]
+// Taulukko vapautetaan aina. Palauttaa NAMELIST_OK tai NAMELIST_ERR_NOMEM.
+static int slices_to_decades(SliceArray *array, int num_decades, const CsvField *headers,
+                             const char *text, DecadeData *data) {
+    NameDict dict;
+    name_dict_init(&dict, text);
+    uint32_t *entry_ids = (array->error == 0 && array->count > 0) ?
+                          (uint32_t *)malloc(array->count * sizeof(uint32_t)) : NULL;
+    if (array->error != 0 || (array->count > 0 && entry_ids == NULL)) {
+        slices_free(array);
+        free(entry_ids);
+        return NAMELIST_ERR_NOMEM;
+    }
+
+    // 1. Jokainen eri nimi sanakirjaan kerran (ensimmäinen esiintymä jää pooliin)
+    for (size_t i = 0; i < array->count && dict.error == 0; i++) {
+        const NameSlice *slice = &array->slices[i];
+        uint32_t id = name_dict_find(&dict, text + slice->offset, slice->length);
+        entry_ids[i] = (id != NAME_DICT_NONE) ? id : name_dict_add(&dict, slice->offset, slice->length);
+    }
+
+    int id_width = name_dict_id_width(dict.count);
+    size_t lists_size = (size_t)num_decades * sizeof(NameList);
+    size_t decades_size = (size_t)num_decades * sizeof(char *);
+    size_t dict_size = (size_t)dict.count * sizeof(NameSlice);
+    size_t counts_size = (array->counts != NULL) ? array->count * sizeof(uint32_t) : 0;
+    size_t ids_size = array->count * (size_t)id_width;
+    size_t strings_size = 0;
+    for (int col = 0; col < num_decades; col++) {
+        strings_size += headers[col].length + 1;
+    }
+
+    size_t block_size = lists_size + decades_size + dict_size + counts_size + ids_size + strings_size;
+    char *block = (dict.error == 0) ? (char *)malloc(block_size) : NULL;
+    if (block == NULL) {
+        name_dict_free(&dict);
+        free(entry_ids);
+        slices_free(array);
+        return NAMELIST_ERR_NOMEM;
+    }
+    stats_count(STATS_ALLOCS, 2);
+    stats_count(STATS_ALLOC_BYTES, block_size + array->count * sizeof(uint32_t));
+
+    NameList *lists = (NameList *)block;
+    const char **decades = (const char **)(block + lists_size);
+    NameSlice *names = (NameSlice *)(block + lists_size + decades_size);
+    uint32_t *counts = (counts_size > 0) ? (uint32_t *)(block + lists_size + decades_size + dict_size) : NULL;
+    char *ids = block + lists_size + decades_size + dict_size + counts_size;
+    char *strings = ids + ids_size;
+    if (dict_size > 0) {
+        memcpy(names, dict.names, dict_size);
+    }
+
+    // Otsikot kopioidaan NUL-päätteisinä, jotta niitä voi tulostaa suoraan
+    for (int col = 0; col < num_decades; col++) {
+        memset(&lists[col], 0, sizeof(NameList));
+        lists[col].pool = data->source.data;
+        lists[col].slices = names;
+        lists[col].id_width = id_width;
+
+        memcpy(strings, text + headers[col].offset, headers[col].length);
+        strings[headers[col].length] = '\0';
+        decades[col] = strings;
+        strings += headers[col].length + 1;
+    }
+
+    // 2. Lasketaan nimet sarakkeittain ja järjestetään tunnisteet sarakkeiden mukaan
+    size_t *starts = (size_t *)calloc((size_t)num_decades + 1, sizeof(size_t));
+    if (starts == NULL) {
+        free(block);
+        name_dict_free(&dict);
+        free(entry_ids);
+        slices_free(array);
+        return NAMELIST_ERR_NOMEM;
+    }
+    for (size_t i = 0; i < array->count; i++) {
+        lists[array->columns[i]].count++;
+    }
+    for (int col = 0; col < num_decades; col++) {
+        starts[col + 1] = starts[col] + (size_t)lists[col].count;
+        lists[col].ids = ids + starts[col] * (size_t)id_width;
+        if (counts != NULL) {
+            lists[col].counts = counts + starts[col];
+        }
+    }
+    for (size_t i = 0; i < array->count; i++) {
+        size_t target = starts[array->columns[i]]++;
+        name_dict_store_id(ids, id_width, target, entry_ids[i]);
+        if (counts != NULL) {
+            counts[target] = array->counts[i];
+        }
+    }
+
+    data->decades = decades;
+    data->lists = lists;
+    data->num_decades = num_decades;
+    data->num_names = dict.count;
+    data->block = block;
+
+    free(starts);
+    name_dict_free(&dict);
+    free(entry_ids);
+    slices_free(array);
+    return NAMELIST_OK;
+}
+
+// --- 2. TIEDOSTON LATAUSFUNKTIOT ---
+
+// Funktio kuvaa tiedoston muistiin. Palauttaa NAMELIST_OK tai virhekoodin.
+static int open_source(const char *filename, MappedFile *file) {
+    uint64_t start = stats_begin();
+    if (map_file(filename, file) != 0) {
+        return NAMELIST_ERR_IO;
+    }
+    stats_end(STATS_MAP, start);
+    stats_count(STATS_FILES, 1);
+    stats_count(STATS_FILE_BYTES, file->size);
+
+    // NameSlice käyttää 32-bittisiä paikkoja
+    if (file->size > UINT32_MAX) {
+        unmap_file(file);
+        return NAMELIST_ERR_TOO_LARGE;
+    }
+
+    // Merkistö tunnistetaan ja nimet normalisoidaan; puhdas UTF-8 luetaan suoraan kuvauksesta
+    char *normalized = NULL;
+    size_t normalized_size = 0;
+    int encoding = TEXT_ENCODING_UTF8;
+    start = stats_begin();
+    int status = utf8_normalize(file->data, file->size, &normalized, &normalized_size, &encoding);
+    stats_end(STATS_NORMALIZE, start);
+    if (status < 0) {
+        unmap_file(file);
+        return NAMELIST_ERR_NOMEM;
+    }
+    if (status > 0) {
+        if (namelist_verbose) {
+            fprintf(stderr, "Normalized %s (%s)\n", filename,
+                    (encoding == TEXT_ENCODING_LATIN1) ? "Latin-1 -> UTF-8" : "UTF-8");
+        }
+        unmap_file(file);
+        file->data = normalized;
+        file->size = normalized_size;
+        file->mapped = 0;
+        stats_count(STATS_ALLOCS, 1);
+        stats_count(STATS_ALLOC_BYTES, normalized_size + UTF8NORM_PADDING);
+    }
+    return NAMELIST_OK;
+}
+
+// Funktio poistaa kentän alussa olevat välilyönnit (trimmaa)
+static void trim_leading_spaces(const char *text, CsvField *field) {
+    while (field->length > 0 && isspace((unsigned char)text[field->offset])) {
+        field->offset++;
+        field->length--;
+    }
+}
+
+// Funktio tarkistaa, onko otsikko lukumääräsarake ("count", "lkm" tai
+// "1890–99 count"). Lukumääräsarake kuuluu vasemmalla olevalle nimisarakkeelle.
+static int is_count_header(const char *text, const CsvField *field) {
+    static const char *const suffixes[] = {"count", "lkm"};
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        size_t len = strlen(suffixes[i]);
+        if (field->length >= len) {
+            const char *tail = text + field->offset + field->length - len;
+            size_t k = 0;
+            while (k < len && tolower((unsigned char)tail[k]) == suffixes[i][k]) {
+                k++;
+            }
+            if (k == len) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Funktio lukee esiintymismäärän kentästä. Tyhjä tai virheellinen kenttä = 1.
+static uint32_t parse_count(const char *text, const CsvField *field) {
+    uint64_t value = 0;
+    if (field->length == 0) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < field->length; i++) {
+        char c = text[field->offset + i];
+        if (c < '0' || c > '9') {
+            return 1;
+        }
+        value = value * 10 + (uint64_t)(c - '0');
+        if (value > UINT32_MAX) {
+            return UINT32_MAX;
+        }
+    }
+    return (uint32_t)value;
+}
+
+// Funktio lataa nimet tavallisesta tiedostosta (yksi nimi per rivi)
+int load_names_simple(const char *filename, NameList *list) {
+    memset(list, 0, sizeof(*list));
+
+    int result = open_source(filename, &list->source);
+    if (result != NAMELIST_OK) {
+        return result;
+    }
+
+    uint64_t start = stats_begin();
+    const char *text = list->source.data;
+    size_t size = list->source.size;
+    SliceArray array;
+    slices_init(&array);
+
+    // Luetaan rivi kerrallaan suoraan kuvatusta tiedostosta
+    size_t pos = 0;
+    while (pos < size) {
+        const char *newline = (const char *)memchr(text + pos, '\n', size - pos);
+        size_t line_end = (newline != NULL) ? (size_t)(newline - text) : size;
+
+        // Rivi päättyy ensimmäiseen '\r'-merkkiin (CRLF-tiedostot)
+        const char *cr = (const char *)memchr(text + pos, '\r', line_end - pos);
+        CsvField field;
+        field.offset = pos;
+        field.length = (uint32_t)(((cr != NULL) ? (size_t)(cr - text) : line_end) - pos);
+        trim_leading_spaces(text, &field);
+
+        if (field.length > 0) {
+            slices_add(&array, field.offset, field.length, -1);
+        }
+        pos = line_end + 1;
+    }
+    stats_end(STATS_PARSE, start);
+    stats_count(STATS_ROWS, array.count);
+
+    start = stats_begin();
+    result = slices_to_list(&array, list);
+    stats_end(STATS_PACK, start);
+    if (result != NAMELIST_OK) {
+        free_names(list);
+        return result;
+    }
+    list->pool = text;
+    if (namelist_verbose) {
+        fprintf(stderr, "Loaded %d name from the file: %s\n", list->count, filename);
+    }
+    return NAMELIST_OK;
+}
+
+// Funktio lataa nimet CSV-tiedostosta (ottaa vain ensimmäisen sarakkeen huomioon).
+// Jos toisen sarakkeen otsikko on lukumäärä, sen arvot tallennetaan painoiksi.
+int load_names_from_csv(const char *filename, NameList *list) {
+    memset(list, 0, sizeof(*list));
+
+    int result = open_source(filename, &list->source);
+    if (result != NAMELIST_OK) {
+        return result;
+    }
+
+    uint64_t start = stats_begin();
+    const char *text = list->source.data;
+    SliceArray array;
+    slices_init(&array);
+    int has_counts = 0;
+    int row_name = 0;       // Onko nykyisellä rivillä tallennettu nimi
+    size_t row_index = 0;   // Nykyisen rivin nimen indeksi
+
+    CsvScanner scanner;
+    CsvField field;
+    csv_scanner_init(&scanner, text, list->source.size);
+
+    while (csv_next_field(&scanner, &field)) {
+        trim_leading_spaces(text, &field);
+
+        // OHITA ENSIMMÄINEN OTSIKKORIVI (tarkistetaan vain lukumääräsarake)
+        if (field.row == 0) {
+            if (field.column == 1 && is_count_header(text, &field)) {
+                has_counts = 1;
+            }
+            continue;
+        }
+
+        if (field.column == 0) {
+            row_name = 0;
+            if (field.length > 0) { // Varmistus: Tyhjien nimien ohitus
+                row_index = slices_add(&array, field.offset, field.length, -1);
+                row_name = 1;
+            }
+        } else if (field.column == 1 && has_counts && row_name) {
+            slices_set_count(&array, row_index, parse_count(text, &field));
+        }
+    }
+    stats_end(STATS_PARSE, start);
+    stats_count(STATS_ROWS, scanner.row);
+
+    start = stats_begin();
+    result = slices_to_list(&array, list);
+    stats_end(STATS_PACK, start);
+    if (result != NAMELIST_OK) {
+        free_names(list);
+        return result;
+    }
+    list->pool = text;
+    if (namelist_verbose) {
+        fprintf(stderr, "Loaded %d names from CSV-file: %s\n", list->count, filename);
+    }
+    return NAMELIST_OK;
+}
+
+// Ladataan nimet CSV-tiedostosta, jossa on useita sarakkeita (yksi sarake = yksi vuosikymmenlista).
+// Tyhjät kentät säilytetään lukijassa, joten lyhyemmät sarakkeet eivät siirrä muita.
+// Lukumääräsarake ("1890–99 count") antaa vasemmalla olevan vuosikymmenen nimille painot.
+int load_names_multi_column(const char *filename, DecadeData *data) {
+    // Alustus
+    memset(data, 0, sizeof(*data));
+
+    int result = open_source(filename, &data->source);
+    if (result != NAMELIST_OK) {
+        return result;
+    }
+
+    uint64_t start = stats_begin();
+    const char *text = data->source.data;
+    SliceArray array;
+    slices_init(&array);
+    CsvField *headers = NULL;      // Vain vuosikymmenten otsikot
+    size_t header_cap = 0;
+    int num_decades = 0;
+    int *column_decade = NULL;     // Tiedoston sarake -> vuosikymmen (-1 = ei käytössä)
+    int *column_is_count = NULL;   // Onko tiedoston sarake lukumääräsarake
+    size_t *row_index = NULL;      // Nykyisen rivin nimen indeksi vuosikymmenittäin (SIZE_MAX = ei nimeä)
+    size_t column_cap = 0, flag_cap = 0, row_cap = 0;
+    uint32_t num_columns = 0;
+
+    CsvScanner scanner;
+    CsvField field;
+    csv_scanner_init(&scanner, text, data->source.size);
+
+    while (array.error == 0 && csv_next_field(&scanner, &field)) {
+        trim_leading_spaces(text, &field); // Puhdista välilyönnit
+
+        // 1. Otsikkorivi (vuosikymmenet ja mahdolliset lukumääräsarakkeet)
+        if (field.row == 0) {
+            column_decade = grow_array(column_decade, &column_cap, (size_t)num_columns + 1,
+                                       sizeof(int), 16, &array.error);
+            column_is_count = grow_array(column_is_count, &flag_cap, (size_t)num_columns + 1,
+                                         sizeof(int), 16, &array.error);
+            headers = grow_array(headers, &header_cap, (size_t)num_decades + 1,
+                                 sizeof(CsvField), 16, &array.error);
+            if (array.error != 0) {
+                break;
+            }
+            if (num_decades > 0 && is_count_header(text, &field)) {
+                column_decade[num_columns] = num_decades - 1;
+                column_is_count[num_columns] = 1;
+            } else {
+                headers[num_decades] = field;
+                column_decade[num_columns] = num_decades++;
+                column_is_count[num_columns] = 0;
+            }
+            num_columns++;
+            continue;
+        }
+
+        if (field.column >= num_columns) {
+            continue;
+        }
+        int col = column_decade[field.column];
+        if (field.column == 0) {
+            row_index = grow_array(row_index, &row_cap, (size_t)num_decades,
+                                   sizeof(size_t), 16, &array.error);
+            if (array.error != 0) {
+                break;
+            }
+            for (int d = 0; d < num_decades; d++) {
+                row_index[d] = SIZE_MAX;
+            }
+        }
+
+        // 2. Varsinaiset tiedot: jos sarake ei ole tyhjä, tallenna nimi
+        if (column_is_count[field.column]) {
+            if (row_index[col] != SIZE_MAX) {
+                slices_set_count(&array, row_index[col], parse_count(text, &field));
+            }
+        } else if (field.length > 0) {
+            row_index[col] = slices_add(&array, field.offset, field.length, col);
+        }
+    }
+
+    stats_end(STATS_PARSE, start);
+    stats_count(STATS_ROWS, scanner.row);
+
+    start = stats_begin();
+    if (num_decades > 0) {
+        result = slices_to_decades(&array, num_decades, headers, text, data);
+        stats_end(STATS_PACK, start);
+    } else {
+        result = array.error;
+        slices_free(&array);
+    }
+    free(headers);
+    free(column_decade);
+    free(column_is_count);
+    free(row_index);
+
+    if (result != NAMELIST_OK || num_decades == 0) {
+        free_decade_data(data);
+        return result;
+    }
+    if (namelist_verbose) {
+        fprintf(stderr, "Loaded %d headlines of the decade.\n", data->num_decades);
+    }
+    return NAMELIST_OK;
+}
+
+// --- 3. APUFUNKTIOT ---
+
+const char *namelist_strerror(int status) {
+    switch (status) {
+    case NAMELIST_OK:            return "success";
+    case NAMELIST_ERR_IO:        return "file could not be opened";
+    case NAMELIST_ERR_NOMEM:     return "out of memory";
+    case NAMELIST_ERR_FORMAT:    return "file is not a valid name list or corpus";
+    case NAMELIST_ERR_VERSION:   return "corpus version does not match, recompile it with ngcompile";
+    case NAMELIST_ERR_TOO_LARGE: return "file is larger than 4 GiB";
+    default:                     return "unknown error";
+    }
+}
+
+// Funktio rakentaa listalle alias-taulun painoista
+static int build_alias(const NameList *list, AliasEntry *table, double *weights,
+                       double zipf_exponent) {
+    uint64_t start = stats_begin();
+    if (list->counts != NULL) {
+        for (int i = 0; i < list->count; i++) {
+            weights[i] = (double)list->counts[i];
+        }
+    } else {
+        // Sarakkeet ovat suosituimmasta alkaen, joten sija kertoo painon
+        zipf_weights(weights, (uint32_t)list->count, zipf_exponent);
+    }
+    int result = alias_build(table, weights, (uint32_t)list->count);
+    stats_end(STATS_WEIGHTS, start);
+    return result;
+}
+
+// Funktio rakentaa NameListille painotetun otantataulun
+int weight_names(NameList *list, double zipf_exponent) {
+    free(list->alias_block);
+    list->alias = NULL;
+    list->alias_block = NULL;
+    if (list->count == 0) {
+        return NAMELIST_OK;
+    }
+
+    AliasEntry *table = (AliasEntry *)malloc((size_t)list->count * sizeof(AliasEntry));
+    double *weights = (double *)malloc((size_t)list->count * sizeof(double));
+    if (table == NULL || weights == NULL || build_alias(list, table, weights, zipf_exponent) != 0) {
+        free(table);
+        free(weights);
+        return NAMELIST_ERR_NOMEM;
+    }
+    free(weights);
+    stats_count(STATS_ALLOCS, 2);
+    stats_count(STATS_ALLOC_BYTES, (size_t)list->count * (sizeof(AliasEntry) + sizeof(double)));
+
+    list->alias = table;
+    list->alias_block = table;
+    return NAMELIST_OK;
+}
+
+// Funktio rakentaa jokaiselle vuosikymmensarakkeelle painotetun otantataulun.
+// Kaikkien sarakkeiden taulut ovat samassa lohkossa.
+int weight_decade_data(DecadeData *data, double zipf_exponent) {
+    free(data->alias_block);
+    data->alias_block = NULL;
+
+    size_t total = 0;
+    int largest = 0;
+    for (int col = 0; col < data->num_decades; col++) {
+        data->lists[col].alias = NULL;
+        total += (size_t)data->lists[col].count;
+        if (data->lists[col].count > largest) {
+            largest = data->lists[col].count;
+        }
+    }
+    if (total == 0) {
+        return NAMELIST_OK;
+    }
+
+    AliasEntry *block = (AliasEntry *)malloc(total * sizeof(AliasEntry));
+    double *weights = (double *)malloc((size_t)largest * sizeof(double));
+    if (block == NULL || weights == NULL) {
+        free(block);
+        free(weights);
+        return NAMELIST_ERR_NOMEM;
+    }
+    stats_count(STATS_ALLOCS, 2);
+    stats_count(STATS_ALLOC_BYTES, total * sizeof(AliasEntry) + (size_t)largest * sizeof(double));
+
+    size_t start = 0;
+    for (int col = 0; col < data->num_decades; col++) {
+        if (build_alias(&data->lists[col], block + start, weights, zipf_exponent) != 0) {
+            free(block);
+            free(weights);
+            return NAMELIST_ERR_NOMEM;
+        }
+        start += (size_t)data->lists[col].count;
+    }
+    free(weights);
+
+    // Taulut otetaan käyttöön vasta, kun kaikki on rakennettu
+    start = 0;
+    for (int col = 0; col < data->num_decades; col++) {
+        data->lists[col].alias = block + start;
+        start += (size_t)data->lists[col].count;
+    }
+    data->alias_block = block;
+    return NAMELIST_OK;
+}
+
+// Funktio poistaa alias-taulut käytöstä (tasainen otanta)
+void unweight_decade_data(DecadeData *data) {
+    for (int col = 0; col < data->num_decades; col++) {
+        data->lists[col].alias = NULL;
+    }
+    free(data->alias_block);
+    data->alias_block = NULL;
+}
+
+// Funktio vapauttaa NameList-rakenteen varaaman muistin
+void free_names(NameList *list) {
+    free(list->block);
+    free(list->alias_block);
+    unmap_file(&list->source);
+    memset(list, 0, sizeof(*list));
+}
+
+// Funktio vapauttaa DecadeData-rakenteen varaaman muistin
+void free_decade_data(DecadeData *data) {
+    free(data->block);
+    free(data->alias_block);
+    unmap_file(&data->source);
+
+    // Nollaa laskurit ja osoittimet
+    memset(data, 0, sizeof(*data));
+}
+
+// Funktio rakentaa listasta näkymän ilman toistuvia nimiä
+int distinct_names(const NameList *list, NameList *out) {
+    memset(out, 0, sizeof(*out));
+    if (list->count == 0) {
+        return NAMELIST_OK;
+    }
+
+    uint32_t *ids = (uint32_t *)malloc((size_t)list->count * sizeof(uint32_t));
+    if (ids == NULL) {
+        return NAMELIST_ERR_NOMEM;
+    }
+
+    // Sanakirjan kotipooli on listan pooli, joten lisäys on pelkkä paikka
+    NameDict seen;
+    name_dict_init(&seen, list->pool);
+    int count = 0;
+    for (int i = 0; i < list->count && seen.error == 0; i++) {
+        uint32_t length = (uint32_t)name_length(list, i);
+        if (name_dict_find(&seen, name_at(list, i), length) == NAME_DICT_NONE) {
+            name_dict_add(&seen, (uint32_t)(name_at(list, i) - list->pool), length);
+            ids[count++] = name_id(list, i);
+        }
+    }
+    int error = seen.error;
+    name_dict_free(&seen);
+    if (error != 0) {
+        free(ids);
+        return error;
+    }
+
+    out->pool = list->pool;
+    out->slices = list->slices;
+    out->ids = ids;
+    out->id_width = 4;
+    out->count = count;
+    out->block = ids;
+    return NAMELIST_OK;
+}
+
+// Funktio valitsee ja palauttaa satunnaisen nimen NameList-rakenteesta
+const char *select_random_name(const NameList *list, Rng *rng, size_t *length) {
+    if (list->count == 0) {
+        *length = 0;
+        return "";
+    }
+    // Satunnainen indeksi: 0 ... (list->count - 1), painotettu jos taulu on
+    int index = select_random_index(list, rng);
+    *length = name_length(list, index);
+    return name_at(list, index);
+}
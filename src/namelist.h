@@ -0,0 +1,161 @@
+/**
+* @file namelist.h
+* @brief Name lists and decade tables shared by genesim and namegen.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef NAMELIST_H
+#define NAMELIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alias.h"
+#include "csvscan.h"
+#include "rng.h"
+
+// Yhden nimen sijainti merkkijonoareenassa
+typedef struct {
+    uint32_t offset;     // Nimen alku areenassa
+    uint32_t length;     // Nimen pituus tavuina
+} NameSlice;
+
+// Rakenne nimilistan tietojen tallentamiseen.
+// Areena (pool) on muistiin kuvattu lähdetiedosto: nimiä ei kopioida, vaan
+// slices osoittaa suoraan tiedoston kenttiin. Nimet EIVÄT ole NUL-päätteisiä,
+// joten pituus on aina luettava name_length-funktiolla.
+//
+// Vuosikymmensarakkeissa samat nimet toistuvat, joten niiden slices on koko
+// tiedoston (tai korpuksen) sanakirja, jossa jokainen nimi on kerran, ja
+// sarakkeen nimet ovat 16- tai 32-bittisiä tunnisteita sanakirjaan (ids).
+// Ilman ids-taulukkoa nimen i tunniste on i.
+typedef struct {
+    const char *pool;    // Merkkijonoareena
+    const NameSlice *slices; // Sanakirja (ids) tai count kappaletta tiedoston järjestyksessä
+    const void *ids;     // count tunnistetta (uint16_t tai uint32_t), NULL = ei sanakirjaa
+    int id_width;        // Tunnisteen koko tavuina (2 tai 4)
+    int count;           // Nimien lukumäärä
+    void *block;         // Ainoa varattu muistilohko (NULL, jos lista kuuluu DecadeDataan)
+    MappedFile source;   // Kuvattu tiedosto, johon pool osoittaa
+    const uint32_t *counts;   // Esiintymismäärät lukumääräsarakkeesta (NULL = ei saraketta)
+    const AliasEntry *alias;  // Painotettu otantataulu (NULL = tasainen otanta)
+    void *alias_block;        // Listan oma alias-taulu (NULL, jos taulu on DecadeDatan tai korpuksen)
+} NameList;
+
+// Koko säilö CSV-tiedoston vuosikymmentiedoille.
+// Otsikot ja listat ovat samassa muistilohkossa, nimet kuvatussa tiedostossa.
+typedef struct {
+    const char **decades; // Taulukko vuosikymmenten otsikoille ("1870–79"), NUL-päätteisiä
+    NameList *lists;      // NameList jokaiselle sarakkeelle
+    int num_decades;      // Vuosikymmenten lukumäärä (sarakkeiden lkm)
+    uint32_t num_names;   // Sanakirjan koko: eri nimiä kaikissa sarakkeissa
+    void *block;          // Ainoa varattu muistilohko
+    MappedFile source;    // Kuvattu tiedosto, johon listojen pool osoittaa
+    void *alias_block;    // Kaikkien sarakkeiden alias-taulut (weight_decade_data)
+} DecadeData;
+
+// Lataus- ja painotusfunktioiden paluuarvot. Kirjasto (libnamegen.h) välittää
+// ne kutsujalle samoina arvoina; mikään funktio ei lopeta ohjelmaa.
+#define NAMELIST_OK 0
+#define NAMELIST_ERR_IO (-1)         // Tiedostoa ei voitu avata
+#define NAMELIST_ERR_NOMEM (-2)      // Muisti loppui
+#define NAMELIST_ERR_FORMAT (-3)     // Tiedoston rakenne on virheellinen
+#define NAMELIST_ERR_VERSION (-4)    // Korpuksen versio ei täsmää ohjelman kanssa
+#define NAMELIST_ERR_TOO_LARGE (-5)  // Tiedosto on yli 4 GiB
+
+// Palauttaa virhekoodin kuvauksen englanniksi
+const char *namelist_strerror(int status);
+
+// Latausviestit tulostetaan stderriin vain, jos tämä on nollasta poikkeava
+// (oletuksena pois, komentorivityökalut kytkevät sen päälle)
+extern int namelist_verbose;
+
+// Palauttaa nimen i tunnisteen sanakirjassa (slices-taulukon indeksin)
+static inline uint32_t name_id(const NameList *list, int i) {
+    if (list->ids == NULL) {
+        return (uint32_t)i;
+    }
+    return (list->id_width == 2) ? ((const uint16_t *)list->ids)[i] : ((const uint32_t *)list->ids)[i];
+}
+
+// Palauttaa nimen i osoittimen (ei NUL-päätteinen)
+static inline const char *name_at(const NameList *list, int i) {
+    return list->pool + list->slices[name_id(list, i)].offset;
+}
+
+// Palauttaa nimen i pituuden tavuina
+static inline size_t name_length(const NameList *list, int i) {
+    return list->slices[name_id(list, i)].length;
+}
+
+// --- LATAUSFUNKTIOT ---
+// Palauttavat NAMELIST_OK tai virhekoodin. Virheen jälkeen rakenne on tyhjä.
+
+// Lataa nimet tavallisesta tiedostosta (yksi nimi per rivi)
+int load_names_simple(const char *filename, NameList *list);
+
+// Lataa nimet CSV-tiedostosta (ottaa vain ensimmäisen sarakkeen huomioon)
+int load_names_from_csv(const char *filename, NameList *list);
+
+// Lataa CSV-tiedoston, jossa on useita sarakkeita (yksi sarake = yksi vuosikymmenlista)
+int load_names_multi_column(const char *filename, DecadeData *data);
+
+// --- PAINOTETTU OTANTA ---
+
+// Rakentaa listalle alias-taulun. Painot tulevat lukumääräsarakkeesta, jos
+// tiedostossa on sellainen, muuten Zipfin laista: sijan r paino on 1 / (r + 1)^s.
+// Palauttaa NAMELIST_OK tai NAMELIST_ERR_NOMEM (lista jää tasaiseksi).
+int weight_names(NameList *list, double zipf_exponent);
+
+// Rakentaa alias-taulun jokaiselle vuosikymmensarakkeelle (kuten weight_names)
+int weight_decade_data(DecadeData *data, double zipf_exponent);
+
+// Poistaa sarakkeiden alias-taulut käytöstä ja vapauttaa omat taulut
+void unweight_decade_data(DecadeData *data);
+
+// Arpoo nimen indeksin: alias-taululla painotetusti, muuten tasaisesti.
+// Molemmissa tapauksissa yksi satunnaisluku ja vakioaika. Lista ei saa olla tyhjä.
+static inline int select_random_index(const NameList *list, Rng *rng) {
+    if (list->alias != NULL) {
+        return (int)alias_sample(list->alias, (uint32_t)list->count, rng);
+    }
+    return (int)rng_bounded(rng, (uint32_t)list->count);
+}
+
+// --- APUFUNKTIOT ---
+
+// Rakentaa listasta näkymän, jossa jokainen eri nimi on kerran (ensimmäisen
+// esiintymän järjestyksessä). Näkymä jakaa listan poolin ja sanakirjan; sen
+// ainoa varaus on tunnistetaulukko. Painoja ei kopioida. Vapautetaan
+// free_names-funktiolla. Palauttaa NAMELIST_OK tai NAMELIST_ERR_NOMEM.
+int distinct_names(const NameList *list, NameList *out);
+
+// Vapauttaa NameList-rakenteen varaaman muistin ja tiedoston kuvauksen
+void free_names(NameList *list);
+
+// Vapauttaa DecadeData-rakenteen varaaman muistin ja tiedoston kuvauksen
+void free_decade_data(DecadeData *data);
+
+// Valitsee satunnaisen nimen NameList-rakenteesta ja kirjoittaa sen pituuden
+// muuttujaan length. Tyhjälle listalle palautetaan "" ja pituus 0.
+const char *select_random_name(const NameList *list, Rng *rng, size_t *length);
+
+#endif // NAMELIST_H
@@ -0,0 +1,686 @@
+/**
+* @file ngbench.c
+* @brief Benchmarks the loader, sampler and formatter on synthetic name corpora.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "libnamegen.h"
+#include "namelist.h"
+#include "rng.h"
+#include "sampler.h"
+
+#define BENCH_DEFAULT_MIN_ROWS 1000ULL
+#define BENCH_DEFAULT_MAX_ROWS 1000000ULL
+#define BENCH_LIMIT_ROWS 10000000ULL
+#define BENCH_DEFAULT_NAMES 1000000LL
+#define BENCH_DEFAULT_REPEAT 3
+#define BENCH_DEFAULT_THRESHOLD 10.0
+#define BENCH_DECADES 7                // Sarakkeita monisarakkeisessa tiedostossa
+#define BENCH_CHUNK ((size_t)1 << 20)  // Tulospuskuri sampling-, format- ja e2e-vaiheille
+#define BENCH_SEED 20250101ULL
+
+// Tulokset ovat yksi JSON-objekti per rivi, jotta perustaso voidaan lukea
+// takaisin ilman JSON-kirjastoa (ks. read_baseline)
+#define BENCH_RESULT_FORMAT "\"stage\": \"%31[^\"]\", \"layout\": \"%15[^\"]\", \"rows\": %llu, \"ns_per_name\": %lf"
+
+// Yhden vaiheen tulos
+typedef struct {
+    char stage[32];
+    char layout[16];           // "single" (yksi sarake) tai "multi" (vuosikymmenet)
+    unsigned long long rows;   // Tiedoston datarivit
+    double ns_per_name;
+    double mb_per_s;           // < 0 = vaihe ei käsittele tavuja
+    long peak_rss_kb;
+} BenchResult;
+
+typedef struct {
+    BenchResult *items;
+    int count;
+    int cap;
+} ResultList;
+
+// Yhden koon syötteet ja ladatut listat
+typedef struct {
+    char *dir;                 // Väliaikainen paikallishakemisto (namegen_open_directory)
+    char *simple_path;         // Yksi nimi per rivi ilman otsikkoa
+    char *csv_path;            // Yksi sarake otsikolla (= sukunimitiedosto)
+    char *multi_path;          // BENCH_DECADES saraketta (= etu- ja keskinimitiedosto)
+    char *middle_path;         // Linkki monisarakkeiseen tiedostoon
+    unsigned long long rows;
+    long long names;           // Nimiä sampling-, format- ja e2e-vaiheissa
+    NameList simple;
+    NameList csv;
+    DecadeData multi;
+    char *buffer;              // BENCH_CHUNK tavua
+    uint32_t *picks;           // Format-vaiheen valmiiksi arvotut indeksit (3 per nimi)
+} Bench;
+
+static int quiet = 0;
+
+// --- 1. APUFUNKTIOT ---
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Funktio nollaa prosessin muistihuipun (Linux: /proc/self/clear_refs), jotta
+// jokaisen vaiheen huippu mitataan erikseen. Muualla huippu on koko ajon huippu.
+static void reset_peak_rss(void) {
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    if (fp != NULL) {
+        fputs("5", fp);
+        fclose(fp);
+    }
+}
+
+// Funktio palauttaa muistihuipun kilotavuina
+static long peak_rss_kb(void) {
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (fp != NULL) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), fp) != NULL) {
+            if (sscanf(line, "VmHWM: %ld", &kb) == 1) {
+                break;
+            }
+        }
+        fclose(fp);
+        if (kb >= 0) {
+            return kb;
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static long file_size(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+static char *join_path(const char *dir, const char *name) {
+    size_t length = strlen(dir) + strlen(name) + 2;
+    char *path = (char *)malloc(length);
+    if (path == NULL) {
+        perror("Memory allocation failed (path)");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(path, length, "%s/%s", dir, name);
+    return path;
+}
+
+static void add_result(ResultList *results, const BenchResult *result) {
+    if (results->count == results->cap) {
+        results->cap = (results->cap > 0) ? results->cap * 2 : 32;
+        BenchResult *grown = (BenchResult *)realloc(results->items, (size_t)results->cap * sizeof(BenchResult));
+        if (grown == NULL) {
+            perror("Memory allocation failed (results)");
+            exit(EXIT_FAILURE);
+        }
+        results->items = grown;
+    }
+    results->items[results->count++] = *result;
+}
+
+// --- 2. SYNTEETTISET KORPUKSET ---
+
+// Tavut, joista nimet kootaan (mukana UTF-8-merkkejä kuten oikeissa listoissa)
+static const char *const syllables[32] = {
+    "aa", "ai", "ka", "ko", "la", "li", "ma", "mi", "na", "ni", "pe", "pä", "ri", "ro", "sa", "si",
+    "ta", "tö", "va", "vi", "jo", "ju", "he", "hy", "ke", "ky", "lu", "nö", "ol", "sä", "te", "to"
+};
+
+// Funktio kirjoittaa satunnaisen 2-5 tavun nimen (isolla alkukirjaimella) ja palauttaa pituuden
+static size_t synthetic_name(Rng *rng, char *out) {
+    uint64_t x = rng_next(rng);
+    int count = 2 + (int)(x & 3);
+    size_t length = 0;
+    for (int i = 0; i < count; i++) {
+        const char *s = syllables[(x >> (8 + 5 * i)) & 31];
+        size_t n = strlen(s);
+        memcpy(out + length, s, n);
+        length += n;
+    }
+    out[0] = (char)(out[0] - 'a' + 'A');
+    return length;
+}
+
+// Funktio kirjoittaa syötetiedostot: rows datariviä kutakin asettelua
+static int write_corpus(Bench *bench, uint64_t seed) {
+    FILE *simple = fopen(bench->simple_path, "wb");
+    FILE *csv = fopen(bench->csv_path, "wb");
+    FILE *multi = fopen(bench->multi_path, "wb");
+    int ok = simple != NULL && csv != NULL && multi != NULL;
+
+    if (ok) {
+        Rng rng;
+        rng_seed(&rng, seed);
+        char name[32];
+        fputs("name\n", csv);
+        for (int d = 0; d < BENCH_DECADES; d++) {
+            fprintf(multi, "%s%d–%d", (d > 0) ? "," : "", 1870 + 10 * d, 79 + 10 * d);
+        }
+        fputc('\n', multi);
+
+        for (unsigned long long r = 0; r < bench->rows; r++) {
+            size_t length = synthetic_name(&rng, name);
+            name[length] = '\n';
+            fwrite(name, 1, length + 1, simple);
+            length = synthetic_name(&rng, name);
+            name[length] = '\n';
+            fwrite(name, 1, length + 1, csv);
+            for (int d = 0; d < BENCH_DECADES; d++) {
+                length = synthetic_name(&rng, name);
+                name[length] = (d + 1 < BENCH_DECADES) ? ',' : '\n';
+                fwrite(name, 1, length + 1, multi);
+            }
+        }
+    }
+
+    if (simple != NULL && fclose(simple) != 0) {
+        ok = 0;
+    }
+    if (csv != NULL && fclose(csv) != 0) {
+        ok = 0;
+    }
+    if (multi != NULL && fclose(multi) != 0) {
+        ok = 0;
+    }
+    // Keskinimitiedosto on sama kuin etunimitiedosto
+    if (ok && link(bench->multi_path, bench->middle_path) != 0) {
+        ok = 0;
+    }
+    return ok ? 0 : -1;
+}
+
+static void remove_corpus(const Bench *bench) {
+    unlink(bench->simple_path);
+    unlink(bench->csv_path);
+    unlink(bench->multi_path);
+    unlink(bench->middle_path);
+    rmdir(bench->dir);
+}
+
+// --- 3. VAIHEET ---
+// Jokainen vaihe palauttaa yhden ajon keston sekunteina ja käsitellyt tavut
+// muuttujaan *bytes (< 0 = ei sovellu), tai negatiivisen arvon virheessä.
+
+static double stage_load_simple(Bench *bench, double *bytes) {
+    NameList list;
+    double start = now_seconds();
+    int status = load_names_simple(bench->simple_path, &list);
+    double elapsed = now_seconds() - start;
+    free_names(&list);
+    *bytes = (double)file_size(bench->simple_path);
+    return (status == NAMELIST_OK) ? elapsed : -1.0;
+}
+
+static double stage_load_csv(Bench *bench, double *bytes) {
+    NameList list;
+    double start = now_seconds();
+    int status = load_names_from_csv(bench->csv_path, &list);
+    double elapsed = now_seconds() - start;
+    free_names(&list);
+    *bytes = (double)file_size(bench->csv_path);
+    return (status == NAMELIST_OK) ? elapsed : -1.0;
+}
+
+static double stage_load_multi(Bench *bench, double *bytes) {
+    DecadeData data;
+    double start = now_seconds();
+    int status = load_names_multi_column(bench->multi_path, &data);
+    double elapsed = now_seconds() - start;
+    free_decade_data(&data);
+    *bytes = (double)file_size(bench->multi_path);
+    return (status == NAMELIST_OK) ? elapsed : -1.0;
+}
+
+// Pelkkä otanta: etu-, keski- ja sukunimen indeksi sekä kolikko per nimi
+static double stage_sample(Bench *bench, double *bytes) {
+    Rng rng;
+    rng_seed(&rng, BENCH_SEED);
+    const NameList *first = &bench->multi.lists[0];
+    const NameList *middle = &bench->multi.lists[1];
+    uint64_t sum = 0;
+    double start = now_seconds();
+    for (long long i = 0; i < bench->names; i++) {
+        sum += (uint64_t)select_random_index(first, &rng);
+        sum += (uint64_t)select_random_index(middle, &rng);
+        sum += (uint64_t)rng_coin(&rng);
+        sum += (uint64_t)select_random_index(&bench->csv, &rng);
+    }
+    double elapsed = now_seconds() - start;
+    *bytes = -1.0;
+    return (sum != UINT64_MAX) ? elapsed : -1.0; // Summa estää silmukan poistamisen
+}
+
+// Pelkkä muotoilu: valmiiksi arvotut indeksit riveiksi "Etu Keski Suku\n"
+static double stage_format(Bench *bench, double *bytes) {
+    const NameList *first = &bench->multi.lists[0];
+    const NameList *middle = &bench->multi.lists[1];
+    size_t total = 0, used = 0;
+    double start = now_seconds();
+    for (long long i = 0; i < bench->names; i++) {
+        const uint32_t *pick = &bench->picks[3 * i];
+        size_t a = name_length(first, (int)pick[0]);
+        size_t b = name_length(middle, (int)pick[1]);
+        size_t c = name_length(&bench->csv, (int)pick[2]);
+        if (used + a + b + c + 3 > BENCH_CHUNK) {
+            total += used;
+            used = 0;
+        }
+        char *p = bench->buffer + used;
+        memcpy(p, name_at(first, (int)pick[0]), a);
+        p += a;
+        *p++ = ' ';
+        memcpy(p, name_at(middle, (int)pick[1]), b);
+        p += b;
+        *p++ = ' ';
+        memcpy(p, name_at(&bench->csv, (int)pick[2]), c);
+        p += c;
+        *p++ = '\n';
+        used = (size_t)(p - bench->buffer);
+    }
+    double elapsed = now_seconds() - start;
+    *bytes = (double)(total + used);
+    return elapsed;
+}
+
+// Otanta ja muotoilu yhdessä (sampler.c:n lohkoydin)
+static double stage_generate(Bench *bench, double *bytes) {
+    Sampler sampler;
+    sampler_init(&sampler, &bench->multi.lists[0], &bench->multi.lists[1], &bench->csv);
+    Rng rng;
+    rng_seed(&rng, BENCH_SEED);
+    long long done = 0;
+    double total = 0.0;
+    double start = now_seconds();
+    while (done < bench->names) {
+        size_t written = 0;
+        long long n = sampler_generate(&sampler, &rng, bench->buffer, BENCH_CHUNK, bench->names - done, &written);
+        if (n <= 0) {
+            return -1.0;
+        }
+        done += n;
+        total += (double)written;
+    }
+    double elapsed = now_seconds() - start;
+    *bytes = total;
+    return elapsed;
+}
+
+// Koko ketju: paikallishakemiston avaus, generointi ja kirjoitus (/dev/null)
+static double stage_end_to_end(Bench *bench, double *bytes) {
+    FILE *sink = fopen("/dev/null", "wb");
+    if (sink == NULL) {
+        return -1.0;
+    }
+    double total = 0.0;
+    double start = now_seconds();
+    NameGen *ctx = NULL;
+    int status = namegen_open_directory(bench->dir, &ctx);
+    Rng rng;
+    rng_seed(&rng, BENCH_SEED);
+    long long done = 0;
+    while (status == NAMEGEN_OK && done < bench->names) {
+        size_t written = 0;
+        long long n = namegen_generate_batch(ctx, &rng, 0, bench->buffer, BENCH_CHUNK, bench->names - done, &written);
+        if (n <= 0) {
+            status = (n < 0) ? (int)n : NAMEGEN_ERR_ARGUMENT;
+            break;
+        }
+        fwrite(bench->buffer, 1, written, sink);
+        done += n;
+        total += (double)written;
+    }
+    namegen_close(ctx);
+    fclose(sink);
+    double elapsed = now_seconds() - start;
+    *bytes = total;
+    return (status == NAMEGEN_OK) ? elapsed : -1.0;
+}
+
+// Funktio ajaa vaiheen repeat kertaa ja tallentaa nopeimman ajon
+static int run_stage(ResultList *results, Bench *bench, const char *stage, const char *layout, double names,
+                     double (*fn)(Bench *, double *), int repeat) {
+    double best = -1.0, bytes = -1.0;
+    reset_peak_rss();
+    for (int r = 0; r < repeat; r++) {
+        double elapsed = fn(bench, &bytes);
+        if (elapsed < 0.0) {
+            fprintf(stderr, "ERROR: Stage %s failed at %llu rows\n", stage, bench->rows);
+            return -1;
+        }
+        if (best < 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    BenchResult result;
+    memset(&result, 0, sizeof(result));
+    snprintf(result.stage, sizeof(result.stage), "%s", stage);
+    snprintf(result.layout, sizeof(result.layout), "%s", layout);
+    result.rows = bench->rows;
+    result.ns_per_name = best * 1e9 / names;
+    result.mb_per_s = (bytes >= 0.0 && best > 0.0) ? bytes / best / 1e6 : -1.0;
+    result.peak_rss_kb = peak_rss_kb();
+    add_result(results, &result);
+
+    if (!quiet) {
+        fprintf(stderr, "%-12s %-6s %9llu rows %10.2f ns/name", stage, layout, bench->rows, result.ns_per_name);
+        if (result.mb_per_s >= 0.0) {
+            fprintf(stderr, " %9.1f MB/s", result.mb_per_s);
+        }
+        fprintf(stderr, " %8ld KiB peak\n", result.peak_rss_kb);
+    }
+    return 0;
+}
+
+// Funktio ajaa kaikki vaiheet yhdelle koolle
+static int run_size(ResultList *results, const char *base_dir, unsigned long long rows, long long names,
+                    int repeat) {
+    Bench bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.rows = rows;
+    bench.names = names;
+
+    char *template = join_path(base_dir, "ngbench-XXXXXX");
+    bench.dir = mkdtemp(template);
+    if (bench.dir == NULL) {
+        perror("Error creating benchmark directory");
+        free(template);
+        return -1;
+    }
+    bench.simple_path = join_path(bench.dir, "names.txt");
+    bench.csv_path = join_path(bench.dir, NAMEGEN_LAST_NAMES);
+    bench.multi_path = join_path(bench.dir, NAMEGEN_FIRST_NAMES);
+    bench.middle_path = join_path(bench.dir, NAMEGEN_MIDDLE_NAMES);
+    bench.buffer = (char *)malloc(BENCH_CHUNK);
+    bench.picks = (uint32_t *)malloc((size_t)names * 3 * sizeof(uint32_t));
+
+    int result = (bench.buffer != NULL && bench.picks != NULL) ? 0 : -1;
+    if (result != 0) {
+        perror("Memory allocation failed (benchmark buffers)");
+    }
+    if (result == 0 && write_corpus(&bench, BENCH_SEED ^ rows) != 0) {
+        perror("Error writing benchmark corpus");
+        result = -1;
+    }
+
+    // 1. Lataus (jokainen ajo vapauttaa listansa)
+    if (result == 0) {
+        result = run_stage(results, &bench, "load_simple", "single", (double)rows, stage_load_simple, repeat);
+    }
+    if (result == 0) {
+        result = run_stage(results, &bench, "load_csv", "single", (double)rows, stage_load_csv, repeat);
+    }
+    if (result == 0) {
+        result = run_stage(results, &bench, "load_multi", "multi", (double)rows * BENCH_DECADES,
+                           stage_load_multi, repeat);
+    }
+
+    // 2. Otanta ja muotoilu samoilla listoilla: etu- ja keskinimet monisarakkeisesta
+    // tiedostosta, sukunimet yksisarakkeisesta (kuten namegen)
+    if (result == 0) {
+        if (load_names_from_csv(bench.csv_path, &bench.csv) != NAMELIST_OK ||
+            load_names_multi_column(bench.multi_path, &bench.multi) != NAMELIST_OK) {
+            fprintf(stderr, "ERROR: Could not load the benchmark corpus\n");
+            result = -1;
+        }
+    }
+    if (result == 0) {
+        Rng rng;
+        rng_seed(&rng, BENCH_SEED);
+        for (long long i = 0; i < names; i++) {
+            bench.picks[3 * i] = (uint32_t)select_random_index(&bench.multi.lists[0], &rng);
+            bench.picks[3 * i + 1] = (uint32_t)select_random_index(&bench.multi.lists[1], &rng);
+            bench.picks[3 * i + 2] = (uint32_t)select_random_index(&bench.csv, &rng);
+        }
+        result = run_stage(results, &bench, "sample", "multi", (double)names, stage_sample, repeat);
+    }
+    if (result == 0) {
+        result = run_stage(results, &bench, "format", "multi", (double)names, stage_format, repeat);
+    }
+    if (result == 0) {
+        result = run_stage(results, &bench, "generate", "multi", (double)names, stage_generate, repeat);
+    }
+    if (result == 0) {
+        result = run_stage(results, &bench, "end_to_end", "multi", (double)names, stage_end_to_end, repeat);
+    }
+
+    free_names(&bench.csv);
+    free_decade_data(&bench.multi);
+    remove_corpus(&bench);
+    free(bench.simple_path);
+    free(bench.csv_path);
+    free(bench.multi_path);
+    free(bench.middle_path);
+    free(bench.buffer);
+    free(bench.picks);
+    free(template);
+    return result;
+}
+
+// --- 4. TULOKSET JA PERUSTASO ---
+
+static int write_json(FILE *out, const ResultList *results, long long names, int repeat) {
+    fprintf(out, "{\n  \"benchmark\": \"ngbench\",\n  \"kernel\": \"%s\",\n  \"names\": %lld,\n  \"repeat\": %d,\n"
+                 "  \"results\": [\n", sampler_kernel_name(), names, repeat);
+    for (int i = 0; i < results->count; i++) {
+        const BenchResult *r = &results->items[i];
+        fprintf(out, "    {\"stage\": \"%s\", \"layout\": \"%s\", \"rows\": %llu, \"ns_per_name\": %.3f, ",
+                r->stage, r->layout, r->rows, r->ns_per_name);
+        if (r->mb_per_s >= 0.0) {
+            fprintf(out, "\"mb_per_s\": %.1f, ", r->mb_per_s);
+        } else {
+            fputs("\"mb_per_s\": null, ", out);
+        }
+        fprintf(out, "\"peak_rss_kb\": %ld}%s\n", r->peak_rss_kb, (i + 1 < results->count) ? "," : "");
+    }
+    fputs("  ]\n}\n", out);
+    return ferror(out) ? -1 : 0;
+}
+
+// Funktio lukee aiemman ajon JSON-tulosteen (yksi tulos per rivi)
+static int read_baseline(const char *path, ResultList *baseline) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        const char *p = strstr(line, "\"stage\"");
+        BenchResult r;
+        memset(&r, 0, sizeof(r));
+        if (p != NULL && sscanf(p, BENCH_RESULT_FORMAT, r.stage, r.layout, &r.rows, &r.ns_per_name) == 4) {
+            add_result(baseline, &r);
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+// Funktio vertaa tuloksia perustasoon. Vaihe on taantunut, jos sen ns/nimi on
+// yli threshold prosenttia perustasoa suurempi. Palauttaa taantumien määrän.
+static int compare_baseline(const ResultList *results, const ResultList *baseline, double threshold) {
+    int regressions = 0;
+    for (int i = 0; i < results->count; i++) {
+        const BenchResult *r = &results->items[i];
+        for (int k = 0; k < baseline->count; k++) {
+            const BenchResult *b = &baseline->items[k];
+            if (strcmp(r->stage, b->stage) != 0 || strcmp(r->layout, b->layout) != 0 || r->rows != b->rows ||
+                !(b->ns_per_name > 0.0)) {
+                continue;
+            }
+            double change = (r->ns_per_name / b->ns_per_name - 1.0) * 100.0;
+            if (change > threshold) {
+                fprintf(stderr, "REGRESSION: %s %s %llu rows: %.2f ns/name, baseline %.2f (%+.1f %%, limit %.1f %%)\n",
+                        r->stage, r->layout, r->rows, r->ns_per_name, b->ns_per_name, change, threshold);
+                regressions++;
+            } else if (!quiet) {
+                fprintf(stderr, "ok: %s %s %llu rows: %.2f ns/name, baseline %.2f (%+.1f %%)\n",
+                        r->stage, r->layout, r->rows, r->ns_per_name, b->ns_per_name, change);
+            }
+            break;
+        }
+    }
+    return regressions;
+}
+
+// --- 5. PÄÄOHJELMA ---
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--min-rows N] [--max-rows N] [--names N] [--repeat R] [--dir DIR]\n"
+            "          [--output FILE] [--baseline FILE] [--threshold PCT] [--quiet]\n\n"
+            "Generates synthetic name files of N = 10^3 ... 10^6 rows (powers of ten, up to 10^7)\n"
+            "in DIR (default /tmp) and times each stage: load_simple, load_csv, load_multi\n"
+            "(%d decade columns), sample, format, generate and end_to_end. Each stage runs R\n"
+            "times (default %d) and the fastest run counts.\n\n"
+            "Results are written as JSON (ns/name, MB/s, peak RSS) to stdout or FILE.\n"
+            "With --baseline the run fails (exit status 2) if a stage is more than PCT percent\n"
+            "(default %.0f) slower per name than in the baseline file.\n",
+            program, BENCH_DECADES, BENCH_DEFAULT_REPEAT, BENCH_DEFAULT_THRESHOLD);
+}
+
+static int parse_count(const char *text, unsigned long long max, unsigned long long *value) {
+    char *end = NULL;
+    double parsed = strtod(text, &end); // Hyväksyy myös muodon 1e6
+    if (end == text || *end != '\0' || !(parsed >= 1.0) || parsed > (double)max) {
+        return -1;
+    }
+    *value = (unsigned long long)parsed;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long long min_rows = BENCH_DEFAULT_MIN_ROWS, max_rows = BENCH_DEFAULT_MAX_ROWS;
+    unsigned long long names = (unsigned long long)BENCH_DEFAULT_NAMES, repeat = BENCH_DEFAULT_REPEAT;
+    const char *dir = "/tmp";
+    const char *output = NULL;
+    const char *baseline_file = NULL;
+    double threshold = BENCH_DEFAULT_THRESHOLD;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int bad = 0;
+        if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0) {
+            quiet = 1;
+            continue;
+        } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (value == NULL) {
+            bad = 1;
+        } else if (strcmp(arg, "--min-rows") == 0) {
+            bad = parse_count(value, BENCH_LIMIT_ROWS, &min_rows);
+        } else if (strcmp(arg, "--max-rows") == 0) {
+            bad = parse_count(value, BENCH_LIMIT_ROWS, &max_rows);
+        } else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--names") == 0) {
+            bad = parse_count(value, 100000000ULL, &names);
+        } else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--repeat") == 0) {
+            bad = parse_count(value, 1000, &repeat);
+        } else if (strcmp(arg, "--dir") == 0) {
+            dir = value;
+        } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) {
+            output = value;
+        } else if (strcmp(arg, "-b") == 0 || strcmp(arg, "--baseline") == 0) {
+            baseline_file = value;
+        } else if (strcmp(arg, "-t") == 0 || strcmp(arg, "--threshold") == 0) {
+            char *end = NULL;
+            threshold = strtod(value, &end);
+            bad = (end == value || *end != '\0' || threshold < 0.0);
+        } else {
+            bad = 1;
+        }
+        if (bad) {
+            fprintf(stderr, "ERROR: Invalid argument: %s%s%s\n", arg, value ? " " : "", value ? value : "");
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (min_rows > max_rows) {
+        fprintf(stderr, "ERROR: --min-rows is larger than --max-rows\n");
+        return 1;
+    }
+
+    ResultList baseline = {NULL, 0, 0};
+    if (baseline_file != NULL && read_baseline(baseline_file, &baseline) != 0) {
+        perror("Error reading baseline");
+        return 1;
+    }
+
+    if (!quiet) {
+        fprintf(stderr, "Kernel: %s, %llu names per sampling stage, best of %llu runs\n",
+                sampler_kernel_name(), names, repeat);
+    }
+
+    // Koot ovat kymmenen potensseja min_rows ... max_rows
+    ResultList results = {NULL, 0, 0};
+    int result = 0;
+    for (unsigned long long rows = min_rows; rows <= max_rows && result == 0; rows *= 10) {
+        result = run_size(&results, dir, rows, (long long)names, (int)repeat);
+    }
+
+    if (result == 0) {
+        FILE *out = (output != NULL) ? fopen(output, "w") : stdout;
+        if (out == NULL || write_json(out, &results, (long long)names, (int)repeat) != 0) {
+            perror("Error writing results");
+            result = -1;
+        }
+        if (out != NULL && out != stdout) {
+            fclose(out);
+        }
+    }
+
+    int regressions = 0;
+    if (result == 0 && baseline_file != NULL) {
+        regressions = compare_baseline(&results, &baseline, threshold);
+        if (regressions > 0) {
+            fprintf(stderr, "%d stage(s) regressed past %.1f %%\n", regressions, threshold);
+        }
+    }
+
+    free(results.items);
+    free(baseline.items);
+    if (result != 0) {
+        return 1;
+    }
+    return (regressions > 0) ? 2 : 0;
+}
@@ -0,0 +1,248 @@
+/**
+* @file ngcompile.c
+* @brief Compiles a locale directory into a binary name corpus.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+#include "corpus.h"
+#include "namelist.h"
+
+// Yksi lähdetiedosto käännettäväksi
+typedef struct {
+    DecadeData data;     // Ladatut sarakkeet
+    NameList simple;     // .txt-tiedoston nimet (yksi sarake ilman otsikkoa)
+    const char *simple_header;
+} SourceFile;
+
+// Funktio tarkistaa tiedostopäätteen
+static int has_suffix(const char *name, const char *suffix) {
+    size_t name_len = strlen(name);
+    size_t suffix_len = strlen(suffix);
+    return name_len > suffix_len && strcmp(name + name_len - suffix_len, suffix) == 0;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// Funktio listaa hakemiston .csv- ja .txt-tiedostot aakkosjärjestyksessä
+static char **list_sources(const char *dirname, int *count) {
+    *count = 0;
+    DIR *dir = opendir(dirname);
+    if (dir == NULL) {
+        perror("Error opening locale directory");
+        return NULL;
+    }
+
+    char **names = NULL;
+    int cap = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!has_suffix(entry->d_name, ".csv") && !has_suffix(entry->d_name, ".txt")) {
+            continue;
+        }
+        if (*count == cap) {
+            cap = (cap > 0) ? cap * 2 : 16;
+            char **grown = (char **)realloc(names, (size_t)cap * sizeof(char *));
+            if (grown == NULL) {
+                perror("Memory allocation failed (source list)");
+                exit(EXIT_FAILURE);
+            }
+            names = grown;
+        }
+        names[(*count)++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+
+    // Järjestys ei saa riippua tiedostojärjestelmästä
+    qsort(names, (size_t)*count, sizeof(char *), compare_names);
+    return names;
+}
+
+// Funktio tarkistaa olemassa olevan korpuksen kokonaan (namegen tarkistaa
+// avatessaan vain rakenteen). Palauttaa ohjelman paluuarvon.
+static int verify_corpus(const char *filename) {
+    Corpus corpus;
+    int status = corpus_open(filename, &corpus);
+    if (status == NAMELIST_OK) {
+        status = corpus_verify(&corpus);
+        if (status == NAMELIST_OK) {
+            fprintf(stderr, "%s: OK, %u lists, %llu names (%u distinct)\n", filename, corpus.header->num_lists,
+                    (unsigned long long)corpus.header->num_entries, corpus.header->num_names);
+        }
+        corpus_close(&corpus);
+    }
+    if (status != NAMELIST_OK) {
+        fprintf(stderr, "ERROR: %s: %s\n", filename, namelist_strerror(status));
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int arg = 1;
+    namelist_verbose = 1;
+    double zipf_exponent = 1.0;
+    int markov_order = MARKOV_DEFAULT_ORDER;
+    if (argc == 3 && strcmp(argv[1], "--verify") == 0) {
+        return verify_corpus(argv[2]);
+    }
+    while (arg < argc && argv[arg][0] == '-') {
+        if (strcmp(argv[arg], "-q") == 0 || strcmp(argv[arg], "--quiet") == 0) {
+            namelist_verbose = 0;
+            arg++;
+        } else if ((strcmp(argv[arg], "-z") == 0 || strcmp(argv[arg], "--zipf") == 0) && arg + 1 < argc) {
+            char *end = NULL;
+            zipf_exponent = strtod(argv[arg + 1], &end);
+            if (end == argv[arg + 1] || *end != '\0' || zipf_exponent < 0.0) {
+                fprintf(stderr, "ERROR: Invalid Zipf exponent: %s\n", argv[arg + 1]);
+                return 1;
+            }
+            arg += 2;
+        } else if ((strcmp(argv[arg], "-k") == 0 || strcmp(argv[arg], "--order") == 0) && arg + 1 < argc) {
+            char *end = NULL;
+            long order = strtol(argv[arg + 1], &end, 10);
+            if (*end != '\0' || order < 0 || order > MARKOV_MAX_ORDER) {
+                fprintf(stderr, "ERROR: Invalid model order (0-%d): %s\n", MARKOV_MAX_ORDER, argv[arg + 1]);
+                return 1;
+            }
+            markov_order = (int)order;
+            arg += 2;
+        } else {
+            break;
+        }
+    }
+    if (argc - arg != 2) {
+        fprintf(stderr, "Usage: %s [--quiet] [--zipf S] [--order K] LOCALE_DIR OUTPUT_FILE\n"
+                        "       %s --verify CORPUS_FILE\n"
+                        "Example: %s data/FI-fi data/FI-fi.ngc\n"
+                        "Lists without a count column are weighted by rank with exponent S (default 1.0).\n"
+                        "Every list gets a character model of the previous K letters for --markov\n"
+                        "(default %d, 0 = no models).\n",
+                        argv[0], argv[0], argv[0], MARKOV_DEFAULT_ORDER);
+        return 1;
+    }
+
+    const char *dirname = argv[arg];
+    const char *output = argv[arg + 1];
+
+    int num_sources = 0;
+    char **names = list_sources(dirname, &num_sources);
+    if (names == NULL || num_sources == 0) {
+        fprintf(stderr, "ERROR: No .csv or .txt files in %s\n", dirname);
+        free(names);
+        return 1;
+    }
+
+    SourceFile *sources = (SourceFile *)calloc((size_t)num_sources, sizeof(SourceFile));
+    DecadeData *tables = (DecadeData *)calloc((size_t)num_sources, sizeof(DecadeData));
+    if (sources == NULL || tables == NULL) {
+        perror("Memory allocation failed (sources)");
+        return 1;
+    }
+
+    // 1. Ladataan jokainen tiedosto: CSV sarakkeittain, TXT yhtenä listana
+    int result = 0;
+    for (int i = 0; i < num_sources && result == 0; i++) {
+        size_t path_len = strlen(dirname) + strlen(names[i]) + 2;
+        char *path = (char *)malloc(path_len);
+        if (path == NULL) {
+            perror("Memory allocation failed (path)");
+            return 1;
+        }
+        snprintf(path, path_len, "%s/%s", dirname, names[i]);
+
+        SourceFile *source = &sources[i];
+        int status;
+        if (has_suffix(names[i], ".csv")) {
+            status = load_names_multi_column(path, &source->data);
+            if (status == NAMELIST_OK && source->data.num_decades == 0) {
+                status = NAMELIST_ERR_FORMAT;
+            }
+            if (status == NAMELIST_OK) {
+                status = weight_decade_data(&source->data, zipf_exponent);
+            }
+            tables[i] = source->data;
+        } else {
+            // Tavallinen tiedosto on yksi sarake, jolla ei ole otsikkoa
+            status = load_names_simple(path, &source->simple);
+            if (status == NAMELIST_OK) {
+                status = weight_names(&source->simple, zipf_exponent);
+            }
+            source->simple_header = "";
+            tables[i].lists = &source->simple;
+            tables[i].decades = &source->simple_header;
+            tables[i].num_decades = 1;
+        }
+        if (status != NAMELIST_OK) {
+            fprintf(stderr, "ERROR: Could not load %s: %s\n", path, namelist_strerror(status));
+            result = 1;
+        }
+        free(path);
+    }
+
+    // 2. Kirjoitetaan korpus
+    if (result == 0 && corpus_write(output, (const char *const *)names, tables, num_sources, zipf_exponent,
+                                    markov_order) != 0) {
+        result = 1;
+    }
+
+    // 3. Luetaan kirjoitettu korpus kokonaan takaisin: namegen tarkistaa
+    // avatessaan vain rakenteen
+    if (result == 0) {
+        Corpus corpus;
+        int status = corpus_open(output, &corpus);
+        if (status == NAMELIST_OK) {
+            status = corpus_verify(&corpus);
+            if (status == NAMELIST_OK && namelist_verbose) {
+                fprintf(stderr, "Wrote %s: %u tables, %u lists, %llu names (%u distinct, %u-bit IDs), %llu bytes\n",
+                        output, corpus.header->num_tables, corpus.header->num_lists,
+                        (unsigned long long)corpus.header->num_entries, corpus.header->num_names,
+                        corpus.header->id_width * 8, (unsigned long long)corpus.header->file_size);
+                if (corpus.header->markov_order > 0) {
+                    fprintf(stderr, "Name models: order %u, %llu bytes\n", corpus.header->markov_order,
+                            (unsigned long long)corpus.header->models_size);
+                }
+            }
+            corpus_close(&corpus);
+        }
+        if (status != NAMELIST_OK) {
+            fprintf(stderr, "ERROR: %s: %s\n", output, namelist_strerror(status));
+            result = 1;
+        }
+    }
+
+    // 4. Vapautetaan muisti
+    for (int i = 0; i < num_sources; i++) {
+        free_decade_data(&sources[i].data);
+        free_names(&sources[i].simple);
+        free(names[i]);
+    }
+    free(names);
+    free(sources);
+    free(tables);
+    return result;
+}
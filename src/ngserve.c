@@ -0,0 +1,1422 @@
+/**
+* @file ngserve.c
+* @brief Name generation server on a Unix or TCP socket, with a built-in load generator.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#define _GNU_SOURCE // accept4
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "csvscan.h"
+#include "libnamegen.h"
+#include "namelist.h"
+#include "parallel.h"
+#include "rng.h"
+#include "stats.h"
+
+#define SERVE_DEFAULT_SOCKET "/tmp/ngserve.sock"
+#define SERVE_INPUT_SIZE 4096          // Yhteyden lukupuskuri (pisin pyyntörivi)
+#define SERVE_BATCH 32                 // Liukuhihnoitettuja pyyntöjä yhdessä työssä
+#define SERVE_BUFFER_SIZE (1 << 20)    // Työntekijän valmiiksi varattu lähetyspuskuri
+#define SERVE_MAX_COUNT 1000000000LL
+#define SERVE_FRAME_HEADER 9           // Kehyksen pituus: 8 heksanumeroa ja rivinvaihto
+#define SERVE_SEND_TIMEOUT_MS 30000    // Asiakas, joka ei lue näin pitkään, katkaistaan
+#define SERVE_MAX_EVENTS 64
+#define SERVE_RELOAD_DELAY_MS 200      // Hiljaisuus muutosten jälkeen ennen uudelleenlatausta
+
+// Protokolla (yksi pyyntö per rivi, pyyntöjä saa lähettää vastauksia odottamatta):
+//
+//   pyyntö:   n=1000 decade=1890 [seed=42] [format=text|csv|jsonl|ids]\n
+//   vastaus:  OK\n, kehykset "%08x\n" + tavut ja loppukehys "00000000\n"
+//             tai ERR <syy>\n
+//
+// Sama pyyntö antaa samat tavut kuin "namegen -n 1000 -d 1890 -s 42 -f F":
+// pala c (PARALLEL_CHUNK_NAMES nimeä) käyttää virtaa rng_seed_stream(seed, c).
+//
+// Uudelleenlataus (--watch): inotify kertoo muutoksista, taustasäie avaa nimet
+// uudelleen ja silmukka vaihtaa osoittimen current atomisesti. Työntekijä ottaa
+// kontekstin työn alussa ilmoittamalla aikakautensa (epoch), joten generointi ei
+// lukitse eikä näe puolivalmista korpusta. Vanha konteksti vapautetaan, kun
+// yksikään työntekijä ei ole enää vaihtoa edeltävällä aikakaudella.
+
+// --- 1. PALVELIN ---
+
+// epollin tapahtuman kohde: ensimmäinen kenttä kertoo lajin
+enum { HANDLE_LISTEN, HANDLE_CONN, HANDLE_WAKE, HANDLE_SIGNAL, HANDLE_WATCH, HANDLE_TIMER };
+
+typedef struct {
+    int kind;
+    int fd;
+} Handle;
+
+// Yksi asiakasyhteys. Tapahtumasilmukka omistaa yhteyden, paitsi kun busy on
+// asetettu: silloin työntekijä kirjoittaa vastausta eikä yhteyttä suljeta.
+typedef struct Conn {
+    Handle handle;           // HANDLE_CONN
+    char in[SERVE_INPUT_SIZE];
+    size_t in_len;
+    int busy;                // Työ jonossa tai käsittelyssä
+    int eof;                 // Asiakas sulki kirjoituspuolen
+    int failed;              // Lähetys epäonnistui tai rivi oli liian pitkä
+    int reading;             // Onko EPOLLIN päällä
+    struct Conn *next_done;
+} Conn;
+
+typedef struct {
+    long long count;
+    char decade[32];         // Jakso haetaan vasta työn kontekstista
+    int format;
+    uint64_t seed;
+    const char *error;       // Jäsennysvirhe (vastataan ERR-rivillä) tai NULL
+} Request;
+
+// Yhteyden peräkkäiset pyynnöt käsitellään yhtenä työnä: vastaukset kootaan
+// samaan puskuriin ja lähetetään yhdellä kutsulla
+typedef struct Job {
+    Conn *conn;
+    int count;
+    Request requests[SERVE_BATCH];
+    struct Job *next;
+} Job;
+
+// Palvelimen asetukset
+typedef struct {
+    const char *corpus;
+    const char *locale;      // Nimihakemisto, jos korpusta ei annettu
+    const char *socket_path;
+    int tcp_port;            // 0 = ei TCP:tä
+    int workers;             // 0 = laitteiston säiemäärä
+    int weighted;
+    int watch;               // Ladataan uudelleen, kun nimitiedostot muuttuvat
+    int stats;               // 0 = ei, 1 = taulukko, 2 = JSON
+} ServeOptions;
+
+struct Server;
+
+// Työntekijän tila: valmiiksi varattu puskuri, johon vastaukset kootaan
+typedef struct {
+    struct Server *server;
+    pthread_t thread;
+    char *buffer;
+    size_t len;
+    int fd;
+    int error;
+    uint64_t active;         // Aikakausi, jolla konteksti otettiin (0 = ei käytössä)
+} Worker;
+
+// Vaihdettu konteksti, joka odottaa lukijoiden poistumista
+typedef struct Retired {
+    NameGen *ctx;
+    uint64_t epoch;          // Vaihdon jälkeinen aikakausi
+    struct Retired *next;
+} Retired;
+
+typedef struct Server {
+    const ServeOptions *opt;
+    NameGen *current;        // Julkaistu konteksti (atominen osoitin)
+    uint64_t epoch;          // Kasvaa jokaisessa vaihdossa, alkaa 1:stä
+    Retired *retired;        // Silmukan omistama
+    Worker *workers;
+    int num_workers;
+    int epoll_fd;
+    Handle listeners[2];
+    int num_listeners;
+    Handle wake;             // eventfd: työntekijä on valmis
+    Handle signals;          // signalfd: SIGINT ja SIGTERM
+    Handle watch;            // inotify: nimihakemisto (fd -1 ilman --watch)
+    Handle timer;            // timerfd: uudelleenlatauksen viive
+    const char *watch_name;  // Korpustiedoston nimi hakemistossa tai NULL
+    pthread_t builder;
+    int building;            // Taustasäie avaa nimiä
+    int rebuild;             // Muutoksia tuli latauksen aikana
+    int built;               // Taustasäie valmis (lock)
+    NameGen *build_ctx;      // Sen tulos, NULL virheessä
+    int build_status;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    Job *head;               // Työjono
+    Job *tail;
+    Conn *done;              // Valmiit yhteydet silmukalle
+    int stopping;
+    Rng seeds;               // Siemenet pyynnöille, joissa sitä ei ole
+} Server;
+
+static int verbose = 1;
+
+// Palvelun rivimuodot (sarakemuoto on tiedostomuoto, jota ei palvella)
+static const struct {
+    const char *name;
+    int format;
+} formats[] = {
+    {"text", NAMEGEN_FORMAT_TEXT}, {"csv", NAMEGEN_FORMAT_CSV}, {"jsonl", NAMEGEN_FORMAT_JSONL},
+    {"ids", NAMEGEN_FORMAT_IDS},
+};
+
+// Funktio lähettää kaikki tavut. Ei-blokkaavalla pistokkeella odotetaan
+// kirjoitusvuoroa pollilla, jotta hidas asiakas ei pysäytä muita.
+static int send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd wait = {fd, POLLOUT, 0};
+            if (poll(&wait, 1, SERVE_SEND_TIMEOUT_MS) <= 0) {
+                return -1;
+            }
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void worker_flush(Worker *w) {
+    if (w->len > 0 && !w->error && send_all(w->fd, w->buffer, w->len) != 0) {
+        w->error = 1;
+    }
+    stats_count(STATS_OUTPUT_BYTES, w->len);
+    w->len = 0;
+}
+
+static void worker_append(Worker *w, const char *data, size_t n) {
+    if (SERVE_BUFFER_SIZE - w->len < n) {
+        worker_flush(w);
+    }
+    memcpy(w->buffer + w->len, data, n);
+    w->len += n;
+}
+
+// Funktio kirjoittaa kehyksen otsakkeen (pituus kahdeksana heksanumerona)
+static void frame_header(char *out, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    for (int i = 7; i >= 0; i--) {
+        out[i] = hex[length & 15];
+        length >>= 4;
+    }
+    out[8] = '\n';
+}
+
+// Funktio kirjoittaa yhden pyynnön vastauksen työntekijän puskuriin.
+// Nimet generoidaan suoraan kehyksiin, ja täysi puskuri lähetetään.
+static void serve_request(Worker *w, const NameGen *ctx, const Request *req) {
+    const char *error = req->error;
+    int decade = -1;
+    size_t max_line = 0;
+    if (error == NULL) {
+        decade = namegen_find_decade(ctx, req->decade);
+        if (decade < 0 || namegen_decade_size(ctx, decade) == 0) {
+            error = "unknown decade";
+        }
+    }
+    if (error == NULL && !namegen_supports_format(ctx, req->format)) {
+        error = "unsupported format"; // Tunnisteet vaativat korpuksen
+    }
+    if (error == NULL) {
+        max_line = namegen_max_formatted_line(ctx, req->format, decade);
+        if (max_line == 0 || max_line > SERVE_BUFFER_SIZE / 2) {
+            error = "invalid argument";
+        }
+    }
+    if (error != NULL) {
+        char line[128];
+        int n = snprintf(line, sizeof(line), "ERR %s\n", error);
+        worker_append(w, line, (size_t)n);
+        return;
+    }
+
+    uint64_t start = stats_begin();
+    worker_append(w, "OK\n", 3);
+    if (req->format == NAMEGEN_FORMAT_CSV) {
+        char header[SERVE_FRAME_HEADER + 19];
+        frame_header(header, 19);
+        memcpy(header + SERVE_FRAME_HEADER, "first,middle,last\r\n", 19);
+        worker_append(w, header, sizeof(header));
+    }
+
+    long long done = 0;
+    for (uint64_t chunk = 0; done < req->count; chunk++) {
+        Rng rng;
+        rng_seed_stream(&rng, req->seed, chunk);
+        long long left = req->count - done;
+        if (left > PARALLEL_CHUNK_NAMES) {
+            left = PARALLEL_CHUNK_NAMES;
+        }
+        // Pala voi jakautua usealle kehykselle: rng jatkaa samaa sarjaa
+        while (left > 0) {
+            if (SERVE_BUFFER_SIZE - w->len < SERVE_FRAME_HEADER + max_line) {
+                worker_flush(w);
+            }
+            size_t space = SERVE_BUFFER_SIZE - w->len - SERVE_FRAME_HEADER;
+            long long fit = (long long)(space / max_line);
+            size_t bytes = 0;
+            long long written = namegen_generate_formatted(ctx, req->format, req->seed, &rng, decade,
+                                                           w->buffer + w->len + SERVE_FRAME_HEADER, space,
+                                                           (fit < left) ? fit : left, &bytes);
+            if (written <= 0) {
+                w->error = 1; // Vastaus on jo aloitettu, joten yhteys katkaistaan
+                return;
+            }
+            frame_header(w->buffer + w->len, bytes);
+            w->len += SERVE_FRAME_HEADER + bytes;
+            left -= written;
+            done += written;
+        }
+    }
+    worker_append(w, "00000000\n", SERVE_FRAME_HEADER);
+    stats_end_batch(start, (uint64_t)req->count);
+}
+
+// Funktio herättää tapahtumasilmukan
+static void wake_loop(Server *server) {
+    uint64_t one = 1;
+    if (write(server->wake.fd, &one, sizeof(one)) < 0) {
+        // eventfd ei täyty käytännössä; silmukka huomaa muutoksen seuraavalla herätyksellä
+    }
+}
+
+// Funktio ottaa julkaistun kontekstin työn ajaksi. Aikakausi kirjataan ennen
+// osoittimen lukua: jos työntekijä sai vanhan kontekstin, sen aikakausi on
+// vaihtoa edeltävä, ja reclaim odottaa sen vapautumista.
+static const NameGen *acquire_names(Worker *w) {
+    __atomic_store_n(&w->active, __atomic_load_n(&w->server->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&w->server->current, __ATOMIC_SEQ_CST);
+}
+
+static void release_names(Worker *w) {
+    __atomic_store_n(&w->active, 0, __ATOMIC_RELEASE);
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    Server *server = w->server;
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        while (server->head == NULL && !server->stopping) {
+            pthread_cond_wait(&server->work_ready, &server->lock);
+        }
+        Job *job = server->head;
+        if (job == NULL) {
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+        server->head = job->next;
+        if (server->head == NULL) {
+            server->tail = NULL;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        w->fd = job->conn->handle.fd;
+        w->error = 0;
+        const NameGen *ctx = acquire_names(w);
+        for (int i = 0; i < job->count && !w->error; i++) {
+            serve_request(w, ctx, &job->requests[i]);
+        }
+        worker_flush(w);
+        release_names(w);
+
+        // Yhteys takaisin silmukalle
+        Conn *conn = job->conn;
+        pthread_mutex_lock(&server->lock);
+        conn->failed |= w->error;
+        conn->next_done = server->done;
+        server->done = conn;
+        pthread_mutex_unlock(&server->lock);
+        wake_loop(server);
+        free(job);
+    }
+    return NULL;
+}
+
+// Funktio etsii muodon nimen (-1 tuntemattomalle)
+static int find_format(const char *name) {
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcmp(name, formats[i].name) == 0) {
+            return formats[i].format;
+        }
+    }
+    return -1;
+}
+
+// Funktio jäsentää pyyntörivin "n=N decade=X [seed=S] [format=F]"
+static void parse_request(Server *server, char *line, Request *req) {
+    req->count = 0;
+    req->decade[0] = '\0';
+    req->format = NAMEGEN_FORMAT_TEXT;
+    req->seed = 0;
+    req->error = NULL;
+    int has_seed = 0;
+
+    char *save = NULL;
+    for (char *token = strtok_r(line, " \t", &save); token != NULL; token = strtok_r(NULL, " \t", &save)) {
+        char *value = strchr(token, '=');
+        if (value == NULL) {
+            req->error = "expected key=value";
+            return;
+        }
+        *value++ = '\0';
+        char *end = NULL;
+        if (strcmp(token, "n") == 0) {
+            req->count = strtoll(value, &end, 10);
+            if (*end != '\0' || req->count <= 0 || req->count > SERVE_MAX_COUNT) {
+                req->error = "invalid n";
+                return;
+            }
+        } else if (strcmp(token, "decade") == 0) {
+            if (*value == '\0' || strlen(value) >= sizeof(req->decade)) {
+                req->error = "unknown decade";
+                return;
+            }
+            strcpy(req->decade, value);
+        } else if (strcmp(token, "seed") == 0) {
+            req->seed = strtoull(value, &end, 10);
+            if (*end != '\0' || end == value) {
+                req->error = "invalid seed";
+                return;
+            }
+            has_seed = 1;
+        } else if (strcmp(token, "format") == 0) {
+            req->format = find_format(value);
+            if (req->format < 0) {
+                req->error = "unknown format";
+                return;
+            }
+        } else {
+            req->error = "unknown key";
+            return;
+        }
+    }
+    if (req->count == 0 || req->decade[0] == '\0') {
+        req->error = "n and decade are required";
+        return;
+    }
+    if (!has_seed) {
+        req->seed = rng_next(&server->seeds);
+    }
+}
+
+static void set_reading(Server *server, Conn *conn, int reading) {
+    if (conn->reading == reading) {
+        return;
+    }
+    struct epoll_event event = {0};
+    event.events = reading ? EPOLLIN : 0;
+    event.data.ptr = conn;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, conn->handle.fd, &event);
+    conn->reading = reading;
+}
+
+static void close_conn(Server *server, Conn *conn) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, conn->handle.fd, NULL);
+    close(conn->handle.fd);
+    free(conn);
+}
+
+// Funktio siirtää yhteyden valmiit pyyntörivit työksi, jos yhteydellä ei ole
+// työtä kesken, ja sulkee loppuun käsitellyn yhteyden
+static void dispatch(Server *server, Conn *conn) {
+    if (conn->busy) {
+        set_reading(server, conn, !conn->eof && conn->in_len < SERVE_INPUT_SIZE);
+        return;
+    }
+    Job *job = NULL;
+    size_t consumed = 0;
+    while (!conn->failed) {
+        char *newline = memchr(conn->in + consumed, '\n', conn->in_len - consumed);
+        if (newline == NULL) {
+            break;
+        }
+        if (job == NULL) {
+            job = (Job *)malloc(sizeof(Job));
+            if (job == NULL) {
+                conn->failed = 1;
+                break;
+            }
+            job->conn = conn;
+            job->count = 0;
+            job->next = NULL;
+        }
+        char *line = conn->in + consumed;
+        *newline = '\0';
+        if (newline > line && newline[-1] == '\r') {
+            newline[-1] = '\0';
+        }
+        parse_request(server, line, &job->requests[job->count++]);
+        consumed = (size_t)(newline + 1 - conn->in);
+        if (job->count == SERVE_BATCH) {
+            break;
+        }
+    }
+    memmove(conn->in, conn->in + consumed, conn->in_len - consumed);
+    conn->in_len -= consumed;
+    if (conn->in_len == SERVE_INPUT_SIZE && job == NULL) {
+        conn->failed = 1; // Rivi ei mahdu puskuriin
+    }
+
+    if (job != NULL && !conn->failed) {
+        conn->busy = 1;
+        pthread_mutex_lock(&server->lock);
+        if (server->tail != NULL) {
+            server->tail->next = job;
+        } else {
+            server->head = job;
+        }
+        server->tail = job;
+        pthread_cond_signal(&server->work_ready);
+        pthread_mutex_unlock(&server->lock);
+        set_reading(server, conn, !conn->eof && conn->in_len < SERVE_INPUT_SIZE);
+        return;
+    }
+    free(job);
+    if (conn->failed || conn->eof) {
+        close_conn(server, conn);
+    } else {
+        set_reading(server, conn, 1);
+    }
+}
+
+static void read_conn(Server *server, Conn *conn) {
+    while (conn->in_len < SERVE_INPUT_SIZE) {
+        ssize_t n = recv(conn->handle.fd, conn->in + conn->in_len, SERVE_INPUT_SIZE - conn->in_len, 0);
+        if (n > 0) {
+            conn->in_len += (size_t)n;
+        } else if (n == 0) {
+            conn->eof = 1;
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                conn->eof = 1;
+                conn->failed = 1;
+            }
+            break;
+        }
+    }
+    dispatch(server, conn);
+}
+
+static void accept_conns(Server *server, int listen_fd) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN: kaikki odottavat yhteydet otettu
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Unix-pistokkeella ei vaikutusta
+        Conn *conn = (Conn *)calloc(1, sizeof(Conn));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->handle.kind = HANDLE_CONN;
+        conn->handle.fd = fd;
+        conn->reading = 1;
+        struct epoll_event event = {0};
+        event.events = EPOLLIN;
+        event.data.ptr = conn;
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            free(conn);
+        }
+    }
+}
+
+// Funktio käsittelee työntekijöiden valmiiksi merkitsemät yhteydet
+static void finish_conns(Server *server) {
+    uint64_t count;
+    if (read(server->wake.fd, &count, sizeof(count)) < 0) {
+        // Ei herätyksiä (EAGAIN)
+    }
+    pthread_mutex_lock(&server->lock);
+    Conn *conn = server->done;
+    server->done = NULL;
+    pthread_mutex_unlock(&server->lock);
+    while (conn != NULL) {
+        Conn *next = conn->next_done;
+        conn->busy = 0;
+        dispatch(server, conn);
+        conn = next;
+    }
+}
+
+// --- 2. UUDELLEENLATAUS ---
+
+static int add_handle(Server *server, Handle *handle) {
+    struct epoll_event event = {0};
+    event.events = EPOLLIN;
+    event.data.ptr = handle;
+    return epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, handle->fd, &event);
+}
+
+// Funktio avaa nimet asetusten mukaan (alussa ja jokaisessa uudelleenlatauksessa)
+static int open_names(const ServeOptions *opt, NameGen **ctx) {
+    int status = (opt->corpus != NULL) ? namegen_open_corpus(opt->corpus, ctx) : namegen_open_directory(opt->locale, ctx);
+    if (status == NAMEGEN_OK) {
+        status = namegen_set_weighting(*ctx, opt->weighted, 1.0);
+    }
+    if (status != NAMEGEN_OK) {
+        namegen_close(*ctx);
+        *ctx = NULL;
+    }
+    return status;
+}
+
+static void *build_main(void *arg) {
+    Server *server = (Server *)arg;
+    NameGen *ctx = NULL;
+    int status = open_names(server->opt, &ctx);
+    pthread_mutex_lock(&server->lock);
+    server->build_ctx = ctx;
+    server->build_status = status;
+    server->built = 1;
+    pthread_mutex_unlock(&server->lock);
+    wake_loop(server);
+    return NULL;
+}
+
+// Funktio käynnistää taustalatauksen tai merkitsee sen toistettavaksi, jos
+// edellinen on vielä kesken (sen aikana tulleet muutokset jäisivät muuten pois)
+static void start_build(Server *server) {
+    if (server->building) {
+        server->rebuild = 1;
+        return;
+    }
+    server->rebuild = 0;
+    server->built = 0;
+    if (pthread_create(&server->builder, NULL, build_main, server) != 0) {
+        perror("Error starting the reload");
+        return;
+    }
+    server->building = 1;
+}
+
+// Funktio vapauttaa vaihdetut kontekstit, joita yksikään työntekijä ei voi enää lukea
+static void reclaim_names(Server *server) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < server->num_workers; i++) {
+        uint64_t active = __atomic_load_n(&server->workers[i].active, __ATOMIC_SEQ_CST);
+        if (active != 0 && active < oldest) {
+            oldest = active;
+        }
+    }
+    Retired **link = &server->retired;
+    while (*link != NULL) {
+        Retired *retired = *link;
+        if (retired->epoch <= oldest) {
+            *link = retired->next;
+            namegen_close(retired->ctx);
+            free(retired);
+        } else {
+            link = &retired->next;
+        }
+    }
+}
+
+// Funktio julkaisee uuden kontekstin. Vanha jää odottamaan lukijoitaan.
+static void publish_names(Server *server, NameGen *ctx) {
+    Retired *retired = (Retired *)malloc(sizeof(Retired));
+    if (retired == NULL) {
+        fprintf(stderr, "ERROR: Out of memory, keeping the old names\n");
+        namegen_close(ctx);
+        return;
+    }
+    retired->ctx = __atomic_exchange_n(&server->current, ctx, __ATOMIC_SEQ_CST);
+    retired->epoch = __atomic_add_fetch(&server->epoch, 1, __ATOMIC_SEQ_CST);
+    retired->next = server->retired;
+    server->retired = retired;
+    if (verbose) {
+        fprintf(stderr, "Reloaded names: %d periods\n", namegen_num_decades(ctx));
+    }
+    reclaim_names(server);
+}
+
+// Funktio ottaa valmiin taustalatauksen tuloksen käyttöön
+static void finish_build(Server *server) {
+    pthread_mutex_lock(&server->lock);
+    int built = server->built;
+    pthread_mutex_unlock(&server->lock);
+    if (!server->building || !built) {
+        return;
+    }
+    pthread_join(server->builder, NULL);
+    server->building = 0;
+    if (server->build_ctx != NULL) {
+        publish_names(server, server->build_ctx);
+    } else {
+        fprintf(stderr, "ERROR: Could not reload names: %s. Keeping the old names.\n",
+                namegen_strerror(server->build_status));
+    }
+    server->build_ctx = NULL;
+    if (server->rebuild) {
+        start_build(server);
+    }
+}
+
+// Funktio lukee inotify-tapahtumat ja lykkää latausta, kunnes muutokset ovat
+// loppuneet: tiedoston kirjoitus voi näkyä useana tapahtumana
+static void read_changes(Server *server) {
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int relevant = 0;
+    for (;;) {
+        ssize_t n = read(server->watch.fd, events, sizeof(events));
+        if (n <= 0) {
+            break;
+        }
+        for (char *p = events; p < events + n;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            const char *name = (event->len > 0) ? event->name : "";
+            size_t len = strlen(name);
+            if (server->watch_name != NULL) {
+                relevant |= (strcmp(name, server->watch_name) == 0);
+            } else {
+                relevant |= (len > 4 && (strcmp(name + len - 4, ".csv") == 0 || strcmp(name + len - 4, ".txt") == 0));
+            }
+            relevant |= (event->mask & IN_Q_OVERFLOW) != 0;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    if (relevant) {
+        struct itimerspec delay = {{0, 0}, {0, SERVE_RELOAD_DELAY_MS * 1000000L}};
+        timerfd_settime(server->timer.fd, 0, &delay, NULL);
+    }
+}
+
+// Funktio alkaa seurata nimihakemistoa (korpuksen kanssa sen hakemistoa)
+static int open_watch(Server *server, char *dir_buffer, size_t dir_size) {
+    const ServeOptions *opt = server->opt;
+    const char *dir = opt->locale;
+    if (opt->corpus != NULL) {
+        const char *slash = strrchr(opt->corpus, '/');
+        server->watch_name = (slash != NULL) ? slash + 1 : opt->corpus;
+        if (slash == NULL) {
+            dir = ".";
+        } else if ((size_t)(slash - opt->corpus) + 2 > dir_size) {
+            fprintf(stderr, "ERROR: Corpus path is too long: %s\n", opt->corpus);
+            return -1;
+        } else {
+            size_t len = (slash == opt->corpus) ? 1 : (size_t)(slash - opt->corpus);
+            memcpy(dir_buffer, opt->corpus, len);
+            dir_buffer[len] = '\0';
+            dir = dir_buffer;
+        }
+    }
+    server->watch.kind = HANDLE_WATCH;
+    server->watch.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    server->timer.kind = HANDLE_TIMER;
+    server->timer.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (server->watch.fd < 0 || server->timer.fd < 0 ||
+        inotify_add_watch(server->watch.fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) < 0 ||
+        add_handle(server, &server->watch) != 0 || add_handle(server, &server->timer) != 0) {
+        perror("Error watching the names");
+        return -1;
+    }
+    if (verbose) {
+        fprintf(stderr, "Watching %s for changes\n", dir);
+    }
+    return 0;
+}
+
+// Funktio avaa kuuntelevan pistokkeen: Unix-polku tai TCP-portti localhostissa
+static int open_listener(const char *socket_path, int tcp_port) {
+    int fd;
+    if (socket_path != NULL) {
+        struct sockaddr_un addr = {0};
+        addr.sun_family = AF_UNIX;
+        if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+            fprintf(stderr, "ERROR: Socket path is too long: %s\n", socket_path);
+            return -1;
+        }
+        strcpy(addr.sun_path, socket_path);
+        unlink(socket_path); // Edellisen ajon jäljiltä
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            perror("Error binding the Unix socket");
+            return -1;
+        }
+    } else {
+        struct sockaddr_in addr = {0};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)tcp_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (fd >= 0) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+        if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            perror("Error binding the TCP port");
+            return -1;
+        }
+    }
+    if (listen(fd, SOMAXCONN) != 0) {
+        perror("Error listening");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int run_server(const ServeOptions *opt) {
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.opt = opt;
+    server.epoch = 1;
+    server.watch.fd = -1;
+    server.timer.fd = -1;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.work_ready, NULL);
+    rng_seed(&server.seeds, (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32));
+
+    // Nimet ladataan kerran; --watch lataa ne uudelleen muutosten jälkeen.
+    // Seurattavat tiedostot luetaan kopioiksi, koska paikallaan typistetty
+    // kuvattu tiedosto kaataisi vanhaa kontekstia vielä käyttävän työntekijän.
+    namelist_verbose = verbose;
+    map_file_copies = opt->watch;
+    if (opt->stats) {
+        stats_enable(1);
+    }
+    int status = open_names(opt, &server.current);
+    if (status != NAMEGEN_OK) {
+        fprintf(stderr, "ERROR: Could not load names from %s: %s.\n",
+                (opt->corpus != NULL) ? opt->corpus : opt->locale, namegen_strerror(status));
+        return 1;
+    }
+
+    // SIGINT ja SIGTERM luetaan signalfd:stä, jotta silmukka voi lopettaa siististi
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int result = 0;
+    server.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server.wake.kind = HANDLE_WAKE;
+    server.wake.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    server.signals.kind = HANDLE_SIGNAL;
+    server.signals.fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (server.epoll_fd < 0 || server.wake.fd < 0 || server.signals.fd < 0 ||
+        add_handle(&server, &server.wake) != 0 || add_handle(&server, &server.signals) != 0) {
+        perror("Error creating the event loop");
+        result = 1;
+    }
+    if (result == 0 && opt->socket_path != NULL) {
+        Handle *listener = &server.listeners[server.num_listeners++];
+        listener->kind = HANDLE_LISTEN;
+        listener->fd = open_listener(opt->socket_path, 0);
+        result = (listener->fd < 0 || add_handle(&server, listener) != 0);
+    }
+    if (result == 0 && opt->tcp_port > 0) {
+        Handle *listener = &server.listeners[server.num_listeners++];
+        listener->kind = HANDLE_LISTEN;
+        listener->fd = open_listener(NULL, opt->tcp_port);
+        result = (listener->fd < 0 || add_handle(&server, listener) != 0);
+    }
+    char watch_dir[4096];
+    if (result == 0 && opt->watch) {
+        result = (open_watch(&server, watch_dir, sizeof(watch_dir)) != 0);
+    }
+
+    // Työntekijät ja niiden puskurit varataan ennen ensimmäistä pyyntöä
+    int num_workers = (opt->workers > 0) ? opt->workers : parallel_default_threads();
+    Worker *workers = (Worker *)calloc((size_t)num_workers, sizeof(Worker));
+    int started = 0;
+    if (workers == NULL) {
+        result = 1;
+    }
+    server.workers = workers;
+    server.num_workers = num_workers;
+    for (int i = 0; result == 0 && i < num_workers; i++) {
+        workers[i].server = &server;
+        workers[i].buffer = (char *)malloc(SERVE_BUFFER_SIZE);
+        if (workers[i].buffer == NULL || pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            perror("Error starting workers");
+            result = 1;
+            break;
+        }
+        started++;
+    }
+
+    if (result == 0 && verbose) {
+        fprintf(stderr, "Serving %d periods with %d workers on %s%s", namegen_num_decades(server.current), num_workers,
+                (opt->socket_path != NULL) ? opt->socket_path : "", (opt->socket_path != NULL && opt->tcp_port > 0) ? " and " : "");
+        if (opt->tcp_port > 0) {
+            fprintf(stderr, "127.0.0.1:%d", opt->tcp_port);
+        }
+        fprintf(stderr, "\n");
+    }
+
+    // Tapahtumasilmukka: yhteyksien luku ja työn jako, lähetys on työntekijöillä
+    struct epoll_event events[SERVE_MAX_EVENTS];
+    int running = (result == 0);
+    while (running) {
+        int n = epoll_wait(server.epoll_fd, events, SERVE_MAX_EVENTS, -1);
+        if (n < 0 && errno != EINTR) {
+            perror("Error waiting for events");
+            result = 1;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            Handle *handle = (Handle *)events[i].data.ptr;
+            if (handle->kind == HANDLE_LISTEN) {
+                accept_conns(&server, handle->fd);
+            } else if (handle->kind == HANDLE_CONN) {
+                read_conn(&server, (Conn *)handle);
+            } else if (handle->kind == HANDLE_WAKE) {
+                finish_conns(&server);
+                finish_build(&server);
+                reclaim_names(&server);
+            } else if (handle->kind == HANDLE_WATCH) {
+                read_changes(&server);
+            } else if (handle->kind == HANDLE_TIMER) {
+                uint64_t expirations;
+                if (read(server.timer.fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                    start_build(&server);
+                }
+            } else {
+                running = 0;
+            }
+        }
+    }
+    if (verbose) {
+        fprintf(stderr, "Shutting down\n");
+    }
+
+    pthread_mutex_lock(&server.lock);
+    server.stopping = 1;
+    pthread_cond_broadcast(&server.work_ready);
+    pthread_mutex_unlock(&server.lock);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    if (server.building) {
+        pthread_join(server.builder, NULL);
+        namegen_close(server.build_ctx);
+    }
+    for (int i = 0; workers != NULL && i < num_workers; i++) {
+        free(workers[i].buffer);
+    }
+    free(workers);
+
+    // Jonossa ei ole enää töitä; suljetaan yhteydet, jotka työntekijät palauttivat
+    pthread_mutex_lock(&server.lock);
+    Conn *conn = server.done;
+    server.done = NULL;
+    pthread_mutex_unlock(&server.lock);
+    while (conn != NULL) {
+        Conn *next = conn->next_done;
+        close_conn(&server, conn);
+        conn = next;
+    }
+    for (int i = 0; i < server.num_listeners; i++) {
+        if (server.listeners[i].fd >= 0) {
+            close(server.listeners[i].fd);
+        }
+    }
+    if (opt->socket_path != NULL) {
+        unlink(opt->socket_path);
+    }
+    close(server.wake.fd);
+    close(server.signals.fd);
+    if (server.watch.fd >= 0) {
+        close(server.watch.fd);
+    }
+    if (server.timer.fd >= 0) {
+        close(server.timer.fd);
+    }
+    close(server.epoll_fd);
+
+    // Työntekijät ovat pysähtyneet, joten kaikki kontekstit voi vapauttaa
+    while (server.retired != NULL) {
+        Retired *next = server.retired->next;
+        namegen_close(server.retired->ctx);
+        free(server.retired);
+        server.retired = next;
+    }
+    namegen_close(server.current);
+    pthread_cond_destroy(&server.work_ready);
+    pthread_mutex_destroy(&server.lock);
+    if (opt->stats) {
+        stats_print(stderr, opt->stats == 2);
+    }
+    return result;
+}
+
+// --- 3. ASIAKAS ---
+
+// Vastauksen lukija: puskuroitu luku kehysten jäsentämiseen
+typedef struct {
+    int fd;
+    char data[1 << 16];
+    size_t pos;
+    size_t len;
+} Reader;
+
+// Funktio täyttää puskurin. Palauttaa 0 tai -1 (yhteys katkesi).
+static int reader_fill(Reader *r) {
+    if (r->pos > 0) {
+        memmove(r->data, r->data + r->pos, r->len - r->pos);
+        r->len -= r->pos;
+        r->pos = 0;
+    }
+    for (;;) {
+        ssize_t n = recv(r->fd, r->data + r->len, sizeof(r->data) - r->len, 0);
+        if (n > 0) {
+            r->len += (size_t)n;
+            return 0;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return -1;
+    }
+}
+
+// Funktio lukee rivin (ilman rivinvaihtoa) enintään size - 1 merkkiä
+static int reader_line(Reader *r, char *line, size_t size) {
+    for (;;) {
+        char *newline = memchr(r->data + r->pos, '\n', r->len - r->pos);
+        if (newline != NULL) {
+            size_t n = (size_t)(newline - (r->data + r->pos));
+            if (n >= size) {
+                return -1;
+            }
+            memcpy(line, r->data + r->pos, n);
+            line[n] = '\0';
+            r->pos += n + 1;
+            return 0;
+        }
+        if (r->len - r->pos == sizeof(r->data) || reader_fill(r) != 0) {
+            return -1;
+        }
+    }
+}
+
+// Funktio lukee yhden vastauksen. Tavut kirjoitetaan tiedostoon out (NULL =
+// hylätään) ja lasketaan bytes-muuttujaan. Palauttaa 0, 1 (ERR-vastaus, syy
+// tulostetaan) tai -1 (yhteys- tai protokollavirhe).
+static int read_response(Reader *r, FILE *out, uint64_t *bytes) {
+    char line[256];
+    if (reader_line(r, line, sizeof(line)) != 0) {
+        return -1;
+    }
+    if (strncmp(line, "ERR ", 4) == 0) {
+        fprintf(stderr, "ERROR: Server: %s\n", line + 4);
+        return 1;
+    }
+    if (strcmp(line, "OK") != 0) {
+        return -1;
+    }
+    for (;;) {
+        char *end = NULL;
+        if (reader_line(r, line, sizeof(line)) != 0) {
+            return -1;
+        }
+        unsigned long length = strtoul(line, &end, 16);
+        if (end != line + 8 || *end != '\0') {
+            return -1;
+        }
+        if (length == 0) {
+            return 0;
+        }
+        *bytes += length;
+        while (length > 0) {
+            if (r->pos == r->len && reader_fill(r) != 0) {
+                return -1;
+            }
+            size_t n = r->len - r->pos;
+            if (n > length) {
+                n = length;
+            }
+            if (out != NULL && fwrite(r->data + r->pos, 1, n, out) != n) {
+                return -1;
+            }
+            r->pos += n;
+            length -= n;
+        }
+    }
+}
+
+// Funktio yhdistää palvelimeen (Unix-polku tai TCP-portti localhostissa)
+static int connect_server(const char *socket_path, int tcp_port) {
+    int fd;
+    if (tcp_port > 0) {
+        struct sockaddr_in addr = {0};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)tcp_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+    } else {
+        struct sockaddr_un addr = {0};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+    }
+    perror("Error connecting to the server");
+    if (fd >= 0) {
+        close(fd);
+    }
+    return -1;
+}
+
+static int send_line(int fd, const char *request) {
+    char line[SERVE_INPUT_SIZE];
+    int n = snprintf(line, sizeof(line), "%s\n", request);
+    if (n < 0 || (size_t)n >= sizeof(line)) {
+        fprintf(stderr, "ERROR: Request is too long\n");
+        return -1;
+    }
+    return send_all(fd, line, (size_t)n);
+}
+
+// Kuormageneraattorin asetukset
+typedef struct {
+    const char *socket_path;
+    int tcp_port;
+    const char *request;     // Pyyntörivi, joka lähetetään toistuvasti
+    int connections;
+    int requests;            // Pyyntöjä per yhteys
+    int pipeline;            // Vastausta odottamatta lähetetyt pyynnöt per yhteys
+} LoadOptions;
+
+// Yhden kuormayhteyden tila ja tulokset
+typedef struct {
+    const LoadOptions *opt;
+    pthread_t thread;
+    uint64_t *latencies;     // Pyyntöjen kestot (ns) valmistumisjärjestyksessä
+    int completed;
+    uint64_t bytes;
+    int failed;
+    Reader reader;
+} LoadClient;
+
+// Funktio ajaa yhden yhteyden pyynnöt. Kesto mitataan pyynnön lähettämisestä
+// sen loppukehyksen vastaanottoon, joten liukuhihna näkyy jonotusaikana.
+static void *load_main(void *arg) {
+    LoadClient *client = (LoadClient *)arg;
+    const LoadOptions *opt = client->opt;
+    int fd = connect_server(opt->socket_path, opt->tcp_port);
+    if (fd < 0) {
+        client->failed = 1;
+        return NULL;
+    }
+    client->reader.fd = fd;
+    uint64_t *sent = (uint64_t *)malloc((size_t)opt->pipeline * sizeof(uint64_t));
+    if (sent == NULL) {
+        client->failed = 1;
+        close(fd);
+        return NULL;
+    }
+
+    int issued = 0;
+    while (client->completed < opt->requests) {
+        // Jono täyteen: pyynnön i lähetysaika paikassa i % pipeline
+        while (issued < opt->requests && issued - client->completed < opt->pipeline) {
+            sent[issued % opt->pipeline] = stats_now_ns();
+            if (send_line(fd, opt->request) != 0) {
+                client->failed = 1;
+                break;
+            }
+            issued++;
+        }
+        if (client->failed || read_response(&client->reader, NULL, &client->bytes) != 0) {
+            client->failed = 1;
+            break;
+        }
+        int done = client->completed++;
+        client->latencies[done] = stats_now_ns() - sent[done % opt->pipeline];
+    }
+    free(sent);
+    close(fd);
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint64_t *sorted, size_t count, double p) {
+    size_t index = (size_t)(p * (double)(count - 1) + 0.5);
+    return (double)sorted[index] / 1000.0;
+}
+
+// Funktio ajaa kuorman ja tulostaa läpäisyn sekä viiveen prosenttipisteet
+static int run_load(const LoadOptions *opt, int json) {
+    LoadClient *clients = (LoadClient *)calloc((size_t)opt->connections, sizeof(LoadClient));
+    uint64_t *latencies = (uint64_t *)malloc((size_t)opt->connections * (size_t)opt->requests * sizeof(uint64_t));
+    if (clients == NULL || latencies == NULL) {
+        perror("Memory allocation failed (load clients)");
+        free(clients);
+        free(latencies);
+        return 1;
+    }
+
+    uint64_t start = stats_now_ns();
+    int started = 0;
+    for (int i = 0; i < opt->connections; i++) {
+        clients[i].opt = opt;
+        clients[i].latencies = latencies + (size_t)i * (size_t)opt->requests;
+        if (pthread_create(&clients[i].thread, NULL, load_main, &clients[i]) != 0) {
+            perror("Error starting load clients");
+            break;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(clients[i].thread, NULL);
+    }
+    double seconds = (double)(stats_now_ns() - start) / 1e9;
+
+    // Valmiit kestot yhteen taulukkoon
+    size_t count = 0;
+    uint64_t bytes = 0;
+    int failed = (started < opt->connections);
+    for (int i = 0; i < started; i++) {
+        memmove(latencies + count, clients[i].latencies, (size_t)clients[i].completed * sizeof(uint64_t));
+        count += (size_t)clients[i].completed;
+        bytes += clients[i].bytes;
+        failed |= clients[i].failed;
+    }
+    free(clients);
+    if (count == 0) {
+        fprintf(stderr, "ERROR: No requests completed\n");
+        free(latencies);
+        return 1;
+    }
+    qsort(latencies, count, sizeof(uint64_t), compare_u64);
+
+    double p50 = percentile_us(latencies, count, 0.50);
+    double p90 = percentile_us(latencies, count, 0.90);
+    double p99 = percentile_us(latencies, count, 0.99);
+    double max = (double)latencies[count - 1] / 1000.0;
+    if (json) {
+        printf("{\"requests\":%zu,\"seconds\":%.3f,\"requests_per_second\":%.1f,\"mb_per_second\":%.1f,"
+               "\"p50_us\":%.1f,\"p90_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}\n",
+               count, seconds, (double)count / seconds, (double)bytes / seconds / 1e6, p50, p90, p99, max);
+    } else {
+        printf("%zu requests in %.3f s over %d connections (pipeline %d)\n", count, seconds, opt->connections,
+               opt->pipeline);
+        printf("Throughput: %.1f requests/s, %.1f MB/s\n", (double)count / seconds, (double)bytes / seconds / 1e6);
+        printf("Latency: p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n", p50, p90, p99, max);
+    }
+    free(latencies);
+    return failed;
+}
+
+// Funktio lähettää yhden pyynnön ja kirjoittaa vastauksen tavut stdoutiin
+static int run_request(const char *socket_path, int tcp_port, const char *request) {
+    int fd = connect_server(socket_path, tcp_port);
+    if (fd < 0) {
+        return 1;
+    }
+    Reader *reader = (Reader *)malloc(sizeof(Reader));
+    if (reader == NULL) {
+        close(fd);
+        return 1;
+    }
+    reader->fd = fd;
+    reader->pos = 0;
+    reader->len = 0;
+    uint64_t bytes = 0;
+    int status = (send_line(fd, request) == 0) ? read_response(reader, stdout, &bytes) : -1;
+    if (status < 0) {
+        fprintf(stderr, "ERROR: Connection to the server failed\n");
+    }
+    free(reader);
+    close(fd);
+    return (status != 0 || fflush(stdout) != 0);
+}
+
+// --- 4. KOMENTORIVI ---
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--corpus FILE | --locale DIR] [--weighted] [--watch] [--socket PATH]\n"
+            "          [--tcp PORT] [--workers N] [--stats[=json]] [--quiet]\n"
+            "       %s --request \"n=N decade=X [seed=S] [format=F]\" [--socket PATH | --tcp PORT]\n"
+            "       %s --load [--connections C] [--requests R] [--pipeline P] [--count N]\n"
+            "          [--decade X] [--format F] [--json] [--socket PATH | --tcp PORT]\n"
+            "\n"
+            "Loads the names once and answers requests on a Unix socket (default %s)\n"
+            "and optionally on a TCP port on 127.0.0.1. A request is one line, e.g.\n"
+            "\"n=1000 decade=1890 seed=42 format=jsonl\"; format is text (default), csv,\n"
+            "jsonl or ids, and the names are the same as namegen -n N -d X -s S -f F.\n"
+            "\n"
+            "  -c, --corpus FILE    Use a compiled corpus instead of the name files\n"
+            "  -l, --locale DIR     Directory of the name files (default %s)\n"
+            "  -w, --weighted       Draw common names more often\n"
+            "      --watch          Reload the names when the files (or the corpus) change;\n"
+            "                       requests keep using the old names until the new ones\n"
+            "                       are loaded\n"
+            "      --socket PATH    Unix socket path\n"
+            "      --tcp PORT       Also listen on (or with a client mode, connect to) 127.0.0.1:PORT\n"
+            "      --workers N      Worker threads (default: all cores)\n"
+            "      --stats[=json]   Print the request latency histogram and counters at exit\n"
+            "      --request LINE   Send one request and write the names to stdout\n"
+            "      --load           Measure throughput and latency with repeated requests\n"
+            "                       (defaults: 8 connections, 1000 requests each, pipeline 1,\n"
+            "                       count 1000, the first period, text)\n"
+            "  -q, --quiet          Do not print loading messages\n"
+            "  -h, --help           Show this help\n",
+            program, program, program, SERVE_DEFAULT_SOCKET, NAMEGEN_DEFAULT_LOCALE);
+}
+
+// Funktio lukee kokonaisluvun väliltä min ... max (-1 virheellisellä arvolla)
+static long parse_int(const char *value, long min, long max, const char *what) {
+    char *end = NULL;
+    long n = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || n < min || n > max) {
+        fprintf(stderr, "ERROR: Invalid %s: %s\n", what, value);
+        return -1;
+    }
+    return n;
+}
+
+int main(int argc, char *argv[]) {
+    ServeOptions serve = {NULL, NAMEGEN_DEFAULT_LOCALE, SERVE_DEFAULT_SOCKET, 0, 0, 0, 0, 0};
+    LoadOptions load = {SERVE_DEFAULT_SOCKET, 0, NULL, 8, 1000, 1};
+    const char *request = NULL;
+    const char *load_decade = "1";
+    const char *load_format = "text";
+    long load_count = 1000;
+    int load_mode = 0;
+    int json = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        long n = 0;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0) {
+            verbose = 0;
+            continue;
+        } else if (strcmp(arg, "-w") == 0 || strcmp(arg, "--weighted") == 0) {
+            serve.weighted = 1;
+            continue;
+        } else if (strcmp(arg, "--watch") == 0) {
+            serve.watch = 1;
+            continue;
+        } else if (strcmp(arg, "--load") == 0) {
+            load_mode = 1;
+            continue;
+        } else if (strcmp(arg, "--json") == 0) {
+            json = 1;
+            continue;
+        } else if (strcmp(arg, "--stats") == 0 || strcmp(arg, "--stats=table") == 0) {
+            serve.stats = 1;
+            continue;
+        } else if (strcmp(arg, "--stats=json") == 0) {
+            serve.stats = 2;
+            continue;
+        }
+
+        if (value == NULL) {
+            fprintf(stderr, "ERROR: Unknown option or missing value: %s\n", arg);
+            return 1;
+        }
+        if (strcmp(arg, "-c") == 0 || strcmp(arg, "--corpus") == 0) {
+            serve.corpus = value;
+        } else if (strcmp(arg, "-l") == 0 || strcmp(arg, "--locale") == 0) {
+            serve.locale = value;
+        } else if (strcmp(arg, "--socket") == 0) {
+            serve.socket_path = value;
+            load.socket_path = value;
+        } else if (strcmp(arg, "--tcp") == 0) {
+            n = parse_int(value, 1, 65535, "port");
+            serve.tcp_port = load.tcp_port = (int)n;
+        } else if (strcmp(arg, "--workers") == 0) {
+            n = parse_int(value, 1, 1024, "worker count");
+            serve.workers = (int)n;
+        } else if (strcmp(arg, "--request") == 0) {
+            request = value;
+        } else if (strcmp(arg, "--connections") == 0) {
+            n = parse_int(value, 1, 4096, "connection count");
+            load.connections = (int)n;
+        } else if (strcmp(arg, "--requests") == 0) {
+            n = parse_int(value, 1, 100000000, "request count");
+            load.requests = (int)n;
+        } else if (strcmp(arg, "--pipeline") == 0) {
+            n = parse_int(value, 1, SERVE_BATCH * 4, "pipeline depth");
+            load.pipeline = (int)n;
+        } else if (strcmp(arg, "--count") == 0 || strcmp(arg, "-n") == 0) {
+            n = load_count = parse_int(value, 1, (long)SERVE_MAX_COUNT, "count");
+        } else if (strcmp(arg, "--decade") == 0 || strcmp(arg, "-d") == 0) {
+            load_decade = value;
+        } else if (strcmp(arg, "--format") == 0 || strcmp(arg, "-f") == 0) {
+            load_format = value;
+        } else {
+            fprintf(stderr, "ERROR: Unknown option: %s\n", arg);
+            return 1;
+        }
+        if (n < 0) {
+            return 1;
+        }
+        i++; // Arvo käsitelty
+    }
+
+    // Asiakastilat käyttävät TCP:tä vain, jos portti annettiin
+    if (request != NULL) {
+        return run_request(load.socket_path, load.tcp_port, request);
+    }
+    if (load_mode) {
+        char line[256];
+        snprintf(line, sizeof(line), "n=%ld decade=%s format=%s", load_count, load_decade, load_format);
+        load.request = line;
+        return run_load(&load, json);
+    }
+    return run_server(&serve);
+}
@@ -0,0 +1,196 @@
+/**
+* @file outbuf.c
+* @brief Large reusable output buffer for bulk name generation.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "outbuf.h"
+#include "stats.h"
+
+int outbuf_init(OutBuf *out, FILE *file, size_t capacity) {
+    if (capacity == 0) {
+        capacity = OUTBUF_DEFAULT_SIZE;
+    }
+
+    out->data = (char *)malloc(capacity);
+    out->len = 0;
+    out->cap = (out->data != NULL) ? capacity : 0;
+    out->file = file;
+    out->error = 0;
+    out->bytes_written = 0;
+
+    if (out->data == NULL) {
+        perror("Memory allocation failed (output buffer)");
+        return -1;
+    }
+
+    // Oma puskuri korvaa stdion puskurin, joten tuplakopiointia ei tarvita
+    if (file != NULL) {
+        setvbuf(file, NULL, _IONBF, 0);
+    }
+    return 0;
+}
+
+int outbuf_make_room(OutBuf *out, size_t n) {
+    if (out->file != NULL) {
+        outbuf_flush(out);
+        if (out->cap >= n) {
+            return 0;
+        }
+    }
+
+    // Puskuri kasvaa geometrisesti
+    size_t cap = (out->cap > 0) ? out->cap : OUTBUF_DEFAULT_SIZE;
+    while (cap - out->len < n) {
+        if (cap > SIZE_MAX / 2) {
+            out->error = 1;
+            return -1;
+        }
+        cap *= 2;
+    }
+    char *grown = (char *)realloc(out->data, cap);
+    if (grown == NULL) {
+        out->error = 1;
+        return -1;
+    }
+    out->data = grown;
+    out->cap = cap;
+    return 0;
+}
+
+int outbuf_flush(OutBuf *out) {
+    if (out->file == NULL) {
+        return out->error ? -1 : 0; // Muistipuskuri tyhjennetään käsin (len = 0)
+    }
+    if (out->len > 0) {
+        uint64_t start = stats_begin();
+        if (fwrite(out->data, 1, out->len, out->file) != out->len) {
+            out->error = 1;
+        }
+        stats_end(STATS_WRITE, start);
+        stats_count(STATS_OUTPUT_BYTES, out->len);
+        out->bytes_written += out->len;
+        out->len = 0;
+    }
+    return out->error ? -1 : 0;
+}
+
+// Funktio kirjoittaa kappaleet tiedostoon. POSIX-järjestelmissä yksi writev
+// (osittainen kirjoitus jatketaan), muualla fwrite kappale kerrallaan. Stdion
+// puskuri on pois päältä (outbuf_init), joten kuvaajaan voi kirjoittaa suoraan.
+static int write_gather(FILE *file, const OutPiece *pieces, int count) {
+#ifndef _WIN32
+    struct iovec iov[OUTBUF_MAX_PIECES + 1];
+    int num_iov = 0;
+    for (int i = 0; i < count; i++) {
+        if (pieces[i].size > 0) {
+            iov[num_iov].iov_base = (void *)pieces[i].data;
+            iov[num_iov].iov_len = pieces[i].size;
+            num_iov++;
+        }
+    }
+    struct iovec *next = iov;
+    int fd = fileno(file);
+    while (num_iov > 0) {
+        ssize_t n = writev(fd, next, num_iov);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        while (num_iov > 0 && (size_t)n >= next->iov_len) {
+            n -= (ssize_t)next->iov_len;
+            next++;
+            num_iov--;
+        }
+        if (num_iov > 0) {
+            next->iov_base = (char *)next->iov_base + n;
+            next->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+#else
+    for (int i = 0; i < count; i++) {
+        if (fwrite(pieces[i].data, 1, pieces[i].size, file) != pieces[i].size) {
+            return -1;
+        }
+    }
+    return 0;
+#endif
+}
+
+void outbuf_write_pieces(OutBuf *out, const OutPiece *pieces, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += pieces[i].size;
+    }
+    // Muistipuskuriin ja pienet kappaleet kopioiden
+    if (out->file == NULL || total <= out->cap - out->len || count > OUTBUF_MAX_PIECES) {
+        for (int i = 0; i < count; i++) {
+            outbuf_write(out, (const char *)pieces[i].data, pieces[i].size);
+        }
+        return;
+    }
+
+    // Puskurin sisältö ensimmäisenä kappaleena
+    OutPiece gather[OUTBUF_MAX_PIECES + 1];
+    gather[0].data = out->data;
+    gather[0].size = out->len;
+    for (int i = 0; i < count; i++) {
+        gather[i + 1] = pieces[i];
+    }
+    total += out->len;
+    uint64_t start = stats_begin();
+    if (write_gather(out->file, gather, count + 1) != 0) {
+        out->error = 1;
+    }
+    stats_end(STATS_WRITE, start);
+    stats_count(STATS_OUTPUT_BYTES, total);
+    out->bytes_written += total;
+    out->len = 0;
+}
+
+void outbuf_write_direct(OutBuf *out, const char *src, size_t n) {
+    OutPiece piece = {src, n};
+    outbuf_write_pieces(out, &piece, 1);
+}
+
+int outbuf_close(OutBuf *out) {
+    int result = outbuf_flush(out);
+    if (out->file != NULL && fflush(out->file) != 0) {
+        result = -1;
+    }
+
+    free(out->data);
+    out->data = NULL;
+    out->cap = 0;
+    return result;
+}
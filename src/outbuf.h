@@ -0,0 +1,110 @@
+/**
+* @file outbuf.h
+* @brief Large reusable output buffer for bulk name generation.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stdio.h>
+#include <string.h>
+
+// Oletuskoko puskurille (1 MiB riittää pitämään write-kutsut harvoina)
+#define OUTBUF_DEFAULT_SIZE (1 << 20)
+
+// Rakenne puskuroidulle kirjoittajalle: nimet kootaan muistiin ja
+// kirjoitetaan tiedostoon isoina paloina yhden printf-kutsun sijaan.
+// Ilman tiedostoa (file == NULL) puskuri kasvaa ja sisältö jää muistiin,
+// esim. säikeen omaksi paloksi, jonka kirjoittaja tulostaa myöhemmin.
+typedef struct {
+    char *data;      // Puskurin sisältö
+    size_t len;      // Käytössä olevat tavut
+    size_t cap;      // Puskurin koko
+    FILE *file;      // Kohde (stdout, avattu tiedosto tai NULL = muistipuskuri)
+    int error;       // Nollasta poikkeava, jos kirjoitus on epäonnistunut
+    unsigned long long bytes_written; // Kirjoitettujen tavujen määrä yhteensä
+} OutBuf;
+
+// Alustaa puskurin. Palauttaa 0 onnistuessa, -1 jos muistia ei saatu.
+int outbuf_init(OutBuf *out, FILE *file, size_t capacity);
+
+// Tekee tilaa n tavulle: tiedostopuskuri tyhjennetään, muistipuskuria (ja
+// tiedostopuskuria, johon n tavua ei mahdu tyhjänäkään) kasvatetaan.
+// Palauttaa 0 tai -1, jos muisti loppui; silloin error asetetaan.
+int outbuf_make_room(OutBuf *out, size_t n);
+
+// Kirjoittaa puskurin sisällön tiedostoon ja tyhjentää puskurin.
+int outbuf_flush(OutBuf *out);
+
+// Tyhjentää puskurin ja vapauttaa muistin (tiedostoa ei suljeta).
+int outbuf_close(OutBuf *out);
+
+// Yksi kappale koottavaksi kirjoitukseksi
+typedef struct {
+    const void *data;
+    size_t size;
+} OutPiece;
+
+// Enintään näin monta kappaletta yhteen kirjoitukseen (useammat kirjoitetaan yksitellen)
+#define OUTBUF_MAX_PIECES 15
+
+// Kirjoittaa kappaleet peräkkäin. Tiedostoon puskurin sisältö ja kappaleet
+// menevät yhdellä writev-kutsulla ilman kopiointia (esim. korpuksen kuvauksesta
+// tai säikeen palasta); pienet kappaleet kopioidaan puskuriin.
+void outbuf_write_pieces(OutBuf *out, const OutPiece *pieces, int count);
+
+// Kirjoittaa puskuria suuremman kappaleen suoraan tiedostoon puskurin sisällön perään
+void outbuf_write_direct(OutBuf *out, const char *src, size_t n);
+
+// Varmistaa, että puskurissa on tilaa vähintään n tavulle ja palauttaa
+// osoittimen kirjoituskohtaan tai NULL, jos muisti loppui (error asetettu).
+// Kutsujan on kasvatettava out->len itse.
+static inline char *outbuf_reserve(OutBuf *out, size_t n) {
+    if (out->cap - out->len < n && outbuf_make_room(out, n) != 0) {
+        return NULL;
+    }
+    return out->data + out->len;
+}
+
+// Lisää n tavua puskuriin
+static inline void outbuf_write(OutBuf *out, const char *src, size_t n) {
+    if (n > out->cap && out->file != NULL) {
+        outbuf_write_direct(out, src, n);
+        return;
+    }
+    char *dst = outbuf_reserve(out, n);
+    if (dst != NULL) {
+        memcpy(dst, src, n);
+        out->len += n;
+    }
+}
+
+// Lisää yhden merkin puskuriin
+static inline void outbuf_putc(OutBuf *out, char c) {
+    char *dst = outbuf_reserve(out, 1);
+    if (dst != NULL) {
+        *dst = c;
+        out->len++;
+    }
+}
+
+#endif // OUTBUF_H
@@ -0,0 +1,346 @@
+/**
+* @file parallel.c
+* @brief Deterministic multithreaded chunk generation with ordered output.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "parallel.h"
+#include "stats.h"
+
+// Palojen määrä per säie jonossa: säie voi generoida seuraavaa palaa sillä
+// aikaa, kun kirjoittaja tulostaa edellistä
+#define SLOTS_PER_THREAD 2
+
+// Yksi jonon paikka. Paikka i palvelee paloja i, i + num_slots, i + 2 * num_slots, ...
+typedef struct {
+    OutBuf buffer;       // Palan teksti (muistipuskuri)
+    long long chunk;     // Pala, jota paikka odottaa seuraavaksi
+    int ready;           // Onko pala valmis kirjoitettavaksi
+} Slot;
+
+// Säikeiden yhteinen tila
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t slot_ready;   // Kirjoittaja odottaa valmista palaa
+    pthread_cond_t slot_free;    // Säikeet odottavat vapautuvaa paikkaa
+    Slot *slots;
+    int num_slots;
+    long long next_chunk;        // Seuraava jakamaton pala
+    long long num_chunks;
+    long long count;             // Nimiä yhteensä
+    uint64_t seed;
+    int stop;                    // Kirjoitusvirhe: säikeet lopettavat
+    ChunkFunc func;
+    void *context;
+} Pipeline;
+
+int parallel_default_threads(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int threads = (int)info.dwNumberOfProcessors;
+#else
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return threads > 0 ? threads : 1;
+}
+
+// Työsäie: ottaa seuraavan palan, odottaa sen paikan vapautumista ja generoi
+static void *worker_main(void *arg) {
+    Pipeline *pipe = (Pipeline *)arg;
+
+    pthread_mutex_lock(&pipe->lock);
+    while (!pipe->stop && pipe->next_chunk < pipe->num_chunks) {
+        long long chunk = pipe->next_chunk++;
+        Slot *slot = &pipe->slots[chunk % pipe->num_slots];
+        while (!pipe->stop && slot->chunk != chunk) {
+            pthread_cond_wait(&pipe->slot_free, &pipe->lock);
+        }
+        if (pipe->stop) {
+            break;
+        }
+        pthread_mutex_unlock(&pipe->lock);
+
+        // Generointi lukon ulkopuolella: paikka kuuluu nyt tälle säikeelle
+        long long first = chunk * PARALLEL_CHUNK_NAMES;
+        long long names = pipe->count - first;
+        if (names > PARALLEL_CHUNK_NAMES) {
+            names = PARALLEL_CHUNK_NAMES;
+        }
+        Rng rng;
+        rng_seed_stream(&rng, pipe->seed, (uint64_t)chunk);
+        slot->buffer.len = 0;
+        pipe->func(pipe->context, first, names, &rng, &slot->buffer);
+
+        pthread_mutex_lock(&pipe->lock);
+        slot->ready = 1;
+        pthread_cond_signal(&pipe->slot_ready);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+    return NULL;
+}
+
+int parallel_generate(long long count, uint64_t seed, int threads,
+                      ChunkFunc func, void *context, OutBuf *out) {
+    if (count <= 0) {
+        return 0;
+    }
+    if (threads <= 0) {
+        threads = parallel_default_threads();
+    }
+
+    Pipeline pipe;
+    pipe.num_chunks = (count + PARALLEL_CHUNK_NAMES - 1) / PARALLEL_CHUNK_NAMES;
+    if (threads > pipe.num_chunks) {
+        threads = (int)pipe.num_chunks; // Ylimääräisille säikeille ei olisi töitä
+    }
+    pipe.num_slots = threads * SLOTS_PER_THREAD;
+    pipe.next_chunk = 0;
+    pipe.count = count;
+    pipe.seed = seed;
+    pipe.stop = 0;
+    pipe.func = func;
+    pipe.context = context;
+
+    pipe.slots = (Slot *)calloc((size_t)pipe.num_slots, sizeof(Slot));
+    pthread_t *workers = (pthread_t *)malloc((size_t)threads * sizeof(pthread_t));
+    if (pipe.slots == NULL || workers == NULL) {
+        perror("Memory allocation failed (worker threads)");
+        free(pipe.slots);
+        free(workers);
+        return -1;
+    }
+
+    int result = 0;
+    int num_slots = 0;
+    for (; num_slots < pipe.num_slots; num_slots++) {
+        Slot *slot = &pipe.slots[num_slots];
+        if (outbuf_init(&slot->buffer, NULL, OUTBUF_DEFAULT_SIZE) != 0) {
+            result = -1;
+            break;
+        }
+        slot->chunk = num_slots;
+    }
+
+    pthread_mutex_init(&pipe.lock, NULL);
+    pthread_cond_init(&pipe.slot_ready, NULL);
+    pthread_cond_init(&pipe.slot_free, NULL);
+
+    int started = 0;
+    for (; result == 0 && started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, worker_main, &pipe) != 0) {
+            fprintf(stderr, "ERROR: Could not start worker thread %d\n", started + 1);
+            result = -1;
+            break;
+        }
+    }
+
+    // Kirjoittaja: palat tulostetaan järjestyksessä sitä mukaa kun ne valmistuvat
+    if (result == 0) {
+        for (long long chunk = 0; chunk < pipe.num_chunks; chunk++) {
+            Slot *slot = &pipe.slots[chunk % pipe.num_slots];
+
+            uint64_t start = stats_begin();
+            pthread_mutex_lock(&pipe.lock);
+            while (!slot->ready) {
+                pthread_cond_wait(&pipe.slot_ready, &pipe.lock);
+            }
+            pthread_mutex_unlock(&pipe.lock);
+            stats_end(STATS_WAIT, start);
+
+            // Pala, joka ei mahdu puskuriin, kirjoitetaan puskurin sisällön
+            // perään samalla writev-kutsulla kopioimatta. Jos palan muisti
+            // loppui, sitä ei kirjoiteta.
+            if (slot->buffer.error) {
+                result = -1;
+            } else {
+                OutPiece piece = {slot->buffer.data, slot->buffer.len};
+                outbuf_write_pieces(out, &piece, 1);
+            }
+
+            pthread_mutex_lock(&pipe.lock);
+            slot->ready = 0;
+            slot->chunk = chunk + pipe.num_slots;
+            pthread_cond_broadcast(&pipe.slot_free);
+            pthread_mutex_unlock(&pipe.lock);
+
+            if (result != 0 || out->error) {
+                result = -1;
+                break;
+            }
+        }
+    }
+
+    // Virheen sattuessa säikeet pysäytetään ennen odottamista
+    pthread_mutex_lock(&pipe.lock);
+    if (result != 0) {
+        pipe.stop = 1;
+    }
+    pthread_cond_broadcast(&pipe.slot_free);
+    pthread_mutex_unlock(&pipe.lock);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_cond_destroy(&pipe.slot_free);
+    pthread_cond_destroy(&pipe.slot_ready);
+    pthread_mutex_destroy(&pipe.lock);
+    for (int i = 0; i < num_slots; i++) {
+        outbuf_close(&pipe.slots[i].buffer);
+    }
+    free(pipe.slots);
+    free(workers);
+    return result;
+}
+
+// --- SÄIEALLAS ---
+
+struct ParallelPool {
+    pthread_mutex_t lock;
+    pthread_cond_t start;        // Uusi kierros (generation kasvoi)
+    pthread_cond_t finished;     // Viimeinen säie lopetti kierroksen
+    pthread_t *workers;
+    int num_workers;             // Säikeet kutsujan lisäksi
+    unsigned long generation;
+    int running;                 // Kierroksella vielä työskentelevät säikeet
+    int stop;
+    TaskFunc func;
+    void *context;
+    long long num_tasks;
+    long long next_task;         // Seuraava jakamaton tehtävä (atominen)
+};
+
+// Funktio suorittaa tehtäviä, kunnes ne loppuvat
+static void pool_work(ParallelPool *pool) {
+    for (;;) {
+        long long task = __atomic_fetch_add(&pool->next_task, 1, __ATOMIC_RELAXED);
+        if (task >= pool->num_tasks) {
+            return;
+        }
+        pool->func(pool->context, task);
+    }
+}
+
+static void *pool_main(void *arg) {
+    ParallelPool *pool = (ParallelPool *)arg;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_work(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->finished);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ParallelPool *parallel_pool_new(int threads) {
+    if (threads <= 0) {
+        threads = parallel_default_threads();
+    }
+    ParallelPool *pool = (ParallelPool *)calloc(1, sizeof(ParallelPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->workers = (pthread_t *)malloc((size_t)threads * sizeof(pthread_t));
+    if (pool->workers == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&pool->workers[i], NULL, pool_main, pool) != 0) {
+            parallel_pool_free(pool);
+            return NULL;
+        }
+        pool->num_workers++;
+    }
+    return pool;
+}
+
+int parallel_pool_threads(const ParallelPool *pool) {
+    return pool->num_workers + 1;
+}
+
+void parallel_pool_run(ParallelPool *pool, long long num_tasks, TaskFunc func, void *context) {
+    if (num_tasks <= 0) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->context = context;
+    pool->num_tasks = num_tasks;
+    pool->next_task = 0;
+    pool->running = pool->num_workers;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    // Kutsuja tekee tehtäviä muiden mukana
+    pool_work(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->finished, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void parallel_pool_free(ParallelPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->num_workers; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
@@ -0,0 +1,74 @@
+/**
+* @file parallel.h
+* @brief Deterministic multithreaded chunk generation with ordered output.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdint.h>
+
+#include "outbuf.h"
+#include "rng.h"
+
+// Nimiä per pala. Palan koko ei riipu säikeiden määrästä, joten sama siemen
+// tuottaa saman tulosteen millä tahansa säiemäärällä.
+#define PARALLEL_CHUNK_NAMES 65536
+
+// Palan generointifunktio: kirjoittaa count nimeä muistipuskuriin out käyttäen
+// palan omaa satunnaislukuvirtaa. first on palan ensimmäisen nimen järjestysnumero
+// koko ajossa. Kutsutaan samanaikaisesti useasta säikeestä, joten context on vain
+// luettavaa dataa.
+typedef void (*ChunkFunc)(void *context, long long first, long long count, Rng *rng, OutBuf *out);
+
+// Palauttaa laitteiston säikeiden määrän (vähintään 1)
+int parallel_default_threads(void);
+
+// Jakaa count nimeä palojen kesken ja generoi ne threads säikeellä (0 = laitteiston
+// säiemäärä). Pala c saa virran rng_seed_stream(seed, c). Kutsuva säie kirjoittaa
+// valmiit palat järjestyksessä puskuriin out. Palauttaa 0 onnistuessa, -1 virheessä.
+int parallel_generate(long long count, uint64_t seed, int threads,
+                      ChunkFunc func, void *context, OutBuf *out);
+
+// --- SÄIEALLAS ---
+// Toistuviin rinnakkaisiin vaiheisiin (esim. simulaation vuosikierrokset):
+// säikeet luodaan kerran, ja jokainen parallel_pool_run jakaa tehtävät
+// 0 ... num_tasks - 1 säikeille ja kutsujalle. Tehtävä ei saa riippua siitä,
+// mikä säie sen suorittaa, jolloin tulos ei riipu säikeiden määrästä.
+
+typedef void (*TaskFunc)(void *context, long long task);
+
+typedef struct ParallelPool ParallelPool;
+
+// Luo altaan, jossa on threads säiettä kutsuja mukaan lukien (0 = laitteiston
+// säiemäärä). Palauttaa NULL, jos muisti loppui tai säikeitä ei voitu luoda.
+ParallelPool *parallel_pool_new(int threads);
+
+// Säikeiden määrä kutsuja mukaan lukien
+int parallel_pool_threads(const ParallelPool *pool);
+
+// Suorittaa tehtävät ja palaa, kun kaikki ovat valmiita
+void parallel_pool_run(ParallelPool *pool, long long num_tasks, TaskFunc func, void *context);
+
+void parallel_pool_free(ParallelPool *pool);
+
+#endif // PARALLEL_H
@@ -0,0 +1,74 @@
+/**
+* @file permute.c
+* @brief Seeded bijective permutation of [0, N) for sampling without replacement.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "permute.h"
+#include "rng.h"
+
+// splitmix64:n viimeistelyfunktio kierrosfunktioksi
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void permutation_init(Permutation *perm, uint64_t domain, uint64_t seed) {
+    perm->domain = domain;
+
+    // Pienin parillinen bittimäärä, jolla 2^bits >= domain (vähintään 2)
+    int bits = 2;
+    while (bits < 64 && (domain - 1) >> bits != 0) {
+        bits += 2;
+    }
+    perm->half_bits = bits / 2;
+    perm->half_mask = ((uint64_t)1 << perm->half_bits) - 1;
+
+    // Kierrosavaimet omasta virrasta, jotta ne eivät korreloi nimien arvonnan kanssa
+    Rng rng;
+    rng_seed_stream(&rng, seed, UINT64_C(0x756e69717565)); // "unique"
+    for (int i = 0; i < PERMUTE_ROUNDS; i++) {
+        perm->keys[i] = rng_next(&rng);
+    }
+}
+
+// Yksi kierros Feistel-verkon läpi: (L, R) -> (R, L ^ F(R))
+static uint64_t feistel(const Permutation *perm, uint64_t x) {
+    uint64_t left = x >> perm->half_bits;
+    uint64_t right = x & perm->half_mask;
+    for (int i = 0; i < PERMUTE_ROUNDS; i++) {
+        uint64_t next = left ^ (mix64(right ^ perm->keys[i]) & perm->half_mask);
+        left = right;
+        right = next;
+    }
+    return (left << perm->half_bits) | right;
+}
+
+uint64_t permutation_apply(const Permutation *perm, uint64_t index) {
+    // Verkko on bijektio 2k-bittisille luvuille, joten kuvien ketju alueen
+    // ulkopuolella palaa aina alueelle (ja eri lähtöpisteet eri kohtiin)
+    uint64_t x = feistel(perm, index);
+    while (x >= perm->domain) {
+        x = feistel(perm, x);
+    }
+    return x;
+}
@@ -0,0 +1,51 @@
+/**
+* @file permute.h
+* @brief Seeded bijective permutation of [0, N) for sampling without replacement.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef PERMUTE_H
+#define PERMUTE_H
+
+#include <stdint.h>
+
+// Feistel-verkon kierrokset. Kierrosfunktio on sekoitusfunktio, joten neljä
+// kierrosta riittää hyvään hajontaan; kuusi antaa varaa.
+#define PERMUTE_ROUNDS 6
+
+// Siemenellä valittu bijektio joukolle 0 ... domain - 1. Feistel-verkko
+// permutoi 2k-bittisiä lukuja (2^2k >= domain, alle 4 * domain); alueen
+// ulkopuolelle osuva tulos syötetään uudelleen verkkoon ("cycle walking"),
+// kunnes se osuu alueelle. Keskimäärin alle neljä kierrosta, ei muistia.
+typedef struct {
+    uint64_t domain;
+    int half_bits;           // k
+    uint64_t half_mask;      // 2^k - 1
+    uint64_t keys[PERMUTE_ROUNDS];
+} Permutation;
+
+// Alustaa permutaation (domain >= 1). Sama siemen antaa saman järjestyksen.
+void permutation_init(Permutation *perm, uint64_t domain, uint64_t seed);
+
+// Palauttaa indeksin kuvan (index < domain). Eri indeksit antavat aina eri kuvat.
+uint64_t permutation_apply(const Permutation *perm, uint64_t index);
+
+#endif // PERMUTE_H
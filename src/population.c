@@ -0,0 +1,785 @@
+/**
+* @file population.c
+* @brief Structure-of-arrays population store and the yearly simulation of births, marriages and deaths.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libnamegen.h"
+#include "parallel.h"
+#include "population.h"
+#include "stats.h"
+
+// Henkilöitä per tehtävä. Tehtävä c käyttää omaa satunnaislukuvirtaansa, joten
+// tulos ei riipu siitä, mikä säie sen suorittaa.
+#define POP_CHUNK 65536
+
+#define POP_FOUNDER_MAX_AGE 80     // Alkuväestön vanhin ikä
+#define POP_PILOT_FOUNDERS 100000  // population_founders_for-koeajon alkuväestö (kasvun satunnaisvaihtelu noin 1 %)
+#define POP_MAX_MOTHER_AGE 47      // Vanhin synnyttäjä
+#define POP_MAX_BRIDE_AGE 44       // Vanhimmat avioituvat
+#define POP_MAX_GROOM_AGE 49
+#define POP_KINSHIP_MIN_WEIGHT (1.0f / 1024.0f) // Sukulaisuuskertoimen haun syvyys (noin pikkuserkkujen lapset)
+
+// Satunnaislukuvirran numero: vuosi, vaihe ja tehtävä
+enum { PASS_FOUNDERS, PASS_DEATHS, PASS_EVENTS, PASS_NAMES, PASS_MARRIAGES };
+
+// --- 1. NIMET ---
+
+// Funktio lataa yhden nimitiedoston ja painottaa sen sarakkeet sijan mukaan
+static int load_list(DecadeData *data, const char *locale_dir, const char *file) {
+    size_t length = strlen(locale_dir) + strlen(file) + 2;
+    char *path = (char *)malloc(length);
+    if (path == NULL) {
+        return NAMELIST_ERR_NOMEM;
+    }
+    snprintf(path, length, "%s/%s", locale_dir, file);
+    int status = load_names_multi_column(path, data);
+    free(path);
+    if (status == NAMELIST_OK && data->num_decades == 0) {
+        free_decade_data(data);
+        status = NAMELIST_ERR_FORMAT;
+    }
+    if (status == NAMELIST_OK) {
+        status = weight_decade_data(data, 1.0);
+    }
+    return status;
+}
+
+int pop_names_load(PopNames *names, const char *locale_dir) {
+    memset(names, 0, sizeof(PopNames));
+    int status = load_list(&names->first[POP_MALE], locale_dir, NAMEGEN_FIRST_NAMES);
+    if (status == NAMELIST_OK) {
+        status = load_list(&names->middle[POP_MALE], locale_dir, NAMEGEN_MIDDLE_NAMES);
+    }
+    if (status == NAMELIST_OK) {
+        status = load_list(&names->first[POP_FEMALE], locale_dir, POP_WOMEN_FIRST_NAMES);
+    }
+    if (status == NAMELIST_OK) {
+        status = load_list(&names->middle[POP_FEMALE], locale_dir, POP_WOMEN_MIDDLE_NAMES);
+    }
+    if (status == NAMELIST_OK) {
+        status = load_list(&names->last, locale_dir, NAMEGEN_LAST_NAMES);
+    }
+    if (status != NAMELIST_OK) {
+        pop_names_free(names);
+        return status;
+    }
+    // Sarakkeen otsikko alkaa vuodella ("1860–69")
+    names->first_decade_year = atoi(names->first[POP_MALE].decades[0]);
+    if (names->first_decade_year <= 0) {
+        names->first_decade_year = 1860;
+    }
+    return NAMELIST_OK;
+}
+
+void pop_names_free(PopNames *names) {
+    for (int sex = 0; sex < 2; sex++) {
+        free_decade_data(&names->first[sex]);
+        free_decade_data(&names->middle[sex]);
+    }
+    free_decade_data(&names->last);
+}
+
+// Funktio palauttaa sanakirjan nimen tunnisteella
+static const char *dictionary_name(const DecadeData *data, uint32_t id, size_t *length) {
+    if (id == POP_NONE || data->num_decades == 0) {
+        *length = 0;
+        return "";
+    }
+    const NameList *list = &data->lists[0];
+    *length = list->slices[id].length;
+    return list->pool + list->slices[id].offset;
+}
+
+const char *pop_first_name(const PopNames *names, const Population *pop, uint32_t person, size_t *length) {
+    return dictionary_name(&names->first[pop->sex[person]], pop->first_name[person], length);
+}
+
+const char *pop_middle_name(const PopNames *names, const Population *pop, uint32_t person, size_t *length) {
+    return dictionary_name(&names->middle[pop->sex[person]], pop->middle_name[person], length);
+}
+
+const char *pop_last_name(const PopNames *names, const Population *pop, uint32_t person, size_t *length) {
+    return dictionary_name(&names->last, pop->last_name[person], length);
+}
+
+// Funktio arpoo nimen syntymävuoden vuosikymmenen sarakkeesta (sanakirjan tunniste)
+static uint32_t draw_name(const DecadeData *data, int decade, Rng *rng) {
+    if (decade >= data->num_decades) {
+        decade = data->num_decades - 1;
+    }
+    const NameList *list = &data->lists[decade];
+    if (list->count == 0) {
+        return POP_NONE;
+    }
+    return name_id(list, select_random_index(list, rng));
+}
+
+static int decade_of(const PopNames *names, int year) {
+    int decade = (year - names->first_decade_year) / 10;
+    return (decade > 0) ? decade : 0;
+}
+
+// Funktio arpoo etu- ja keskinimen (keskinimi 50 %:n todennäköisyydellä)
+static void draw_names(const Population *pop, const PopNames *names, uint32_t person, int year, Rng *rng) {
+    int sex = pop->sex[person];
+    int decade = decade_of(names, year);
+    pop->first_name[person] = draw_name(&names->first[sex], decade, rng);
+    pop->middle_name[person] = rng_coin(rng) ? draw_name(&names->middle[sex], decade, rng) : POP_NONE;
+}
+
+// --- 2. SARAKKEET ---
+
+void population_init(Population *pop) {
+    memset(pop, 0, sizeof(Population));
+}
+
+// Funktio kasvattaa yhden sarakkeen
+static int grow_column(void **column, uint32_t capacity, size_t width) {
+    void *grown = realloc(*column, (size_t)capacity * width);
+    if (grown == NULL) {
+        return -1;
+    }
+    *column = grown;
+    return 0;
+}
+
+int population_reserve(Population *pop, uint32_t capacity) {
+    if (capacity <= pop->capacity) {
+        return 0;
+    }
+    // Kasvatetaan kerralla 1,5-kertaiseksi, jotta syntymät eivät kopioi joka vuosi
+    uint64_t grown = (uint64_t)pop->capacity + pop->capacity / 2;
+    if (grown > capacity) {
+        capacity = (grown < POP_NONE) ? (uint32_t)grown : POP_NONE - 1;
+    }
+    if (grow_column((void **)&pop->birth_year, capacity, sizeof(uint16_t)) != 0 ||
+        grow_column((void **)&pop->death_year, capacity, sizeof(uint16_t)) != 0 ||
+        grow_column((void **)&pop->sex, capacity, sizeof(uint8_t)) != 0 ||
+        grow_column((void **)&pop->mother, capacity, sizeof(uint32_t)) != 0 ||
+        grow_column((void **)&pop->father, capacity, sizeof(uint32_t)) != 0 ||
+        grow_column((void **)&pop->spouse, capacity, sizeof(uint32_t)) != 0 ||
+        grow_column((void **)&pop->first_name, capacity, sizeof(uint32_t)) != 0 ||
+        grow_column((void **)&pop->middle_name, capacity, sizeof(uint32_t)) != 0 ||
+        grow_column((void **)&pop->last_name, capacity, sizeof(uint32_t)) != 0 ||
+        grow_column((void **)&pop->inbreeding, capacity, sizeof(float)) != 0) {
+        return -1;
+    }
+    pop->capacity = capacity;
+    return 0;
+}
+
+void population_free(Population *pop) {
+    free(pop->birth_year);
+    free(pop->death_year);
+    free(pop->sex);
+    free(pop->mother);
+    free(pop->father);
+    free(pop->spouse);
+    free(pop->first_name);
+    free(pop->middle_name);
+    free(pop->last_name);
+    free(pop->inbreeding);
+    population_init(pop);
+}
+
+// --- 3. VÄESTÖMALLI ---
+// Vuosittaiset todennäköisyydet iän mukaan, karkeasti 1800-luvun lopun Suomen
+// tasolla: imeväiskuolleisuus laskee 17 %:sta noin 9 %:iin, avioliitot solmitaan
+// 20-35-vuotiaina ja naimisissa oleva nainen synnyttää keskimäärin 6 lasta.
+
+static double death_rate(int age, int year) {
+    if (age == 0) {
+        double rate = 0.17 - 0.0012 * (double)(year - 1860);
+        return (rate > 0.06) ? rate : 0.06;
+    }
+    if (age < 5) {
+        return 0.03;
+    }
+    if (age < 15) {
+        return 0.005;
+    }
+    if (age < 50) {
+        return 0.006;
+    }
+    return 0.006 + 0.008 * exp(0.09 * (double)(age - 50));
+}
+
+// Naimisissa olevan naisen synnytys
+static double birth_rate(int age) {
+    static const double by_five_years[] = {0.22, 0.33, 0.31, 0.27, 0.21, 0.11, 0.02}; // 15-19 ... 45-49
+    if (age < 17 || age > POP_MAX_MOTHER_AGE) {
+        return 0.0;
+    }
+    return by_five_years[(age - 15) / 5];
+}
+
+// Naimattoman tai lesken avioituminen
+static double marriage_rate(int sex, int age) {
+    if (sex == POP_FEMALE) {
+        static const double women[] = {0.05, 0.14, 0.14, 0.08, 0.03, 0.03}; // 15-19 ... 40-44
+        return (age < 18 || age > POP_MAX_BRIDE_AGE) ? 0.0 : women[(age - 15) / 5];
+    }
+    static const double men[] = {0.08, 0.16, 0.12, 0.04, 0.04, 0.04}; // 20-24 ... 45-49
+    return (age < 21 || age > POP_MAX_GROOM_AGE) ? 0.0 : men[(age - 20) / 5];
+}
+
+// Alkuväestön naimisissa olevien osuus iän mukaan
+static double married_share(int sex, int age) {
+    if (sex == POP_FEMALE) {
+        return (age < 18) ? 0.0 : (age < 20) ? 0.15 : (age < 25) ? 0.45 : (age < 30) ? 0.7 : 0.8;
+    }
+    return (age < 21) ? 0.0 : (age < 25) ? 0.25 : (age < 30) ? 0.6 : 0.8;
+}
+
+// Todennäköisyys 32-bittisenä kynnyksenä: tapahtuma, jos (rng >> 32) < kynnys
+static uint32_t to_threshold(double p) {
+    if (p <= 0.0) {
+        return 0;
+    }
+    return (p >= 1.0) ? UINT32_MAX : (uint32_t)(p * 4294967296.0);
+}
+
+static inline int happens(Rng *rng, uint32_t threshold) {
+    return (uint32_t)(rng_next(rng) >> 32) < threshold;
+}
+
+// --- 4. SIMULAATIO ---
+
+// Tehtävän tulokset vuosikierroksella
+typedef struct {
+    uint32_t living;          // Elossa kuolemavaiheen jälkeen
+    uint32_t deaths;
+    int finished;             // Tehtävän kaikki henkilöt ovat kuolleet (ohitetaan)
+    uint32_t *mothers;        // Tänä vuonna synnyttävät
+    uint32_t num_mothers;
+    uint32_t mothers_cap;
+    uint32_t first_child;     // Tehtävän ensimmäisen lapsen tunniste
+    uint32_t *candidates[2];  // Avioliittoon halukkaat sukupuolittain
+    uint32_t num_candidates[2];
+    uint32_t candidates_cap[2];
+    int error;
+} ChunkState;
+
+typedef struct {
+    Population *pop;
+    const PopNames *names;
+    uint64_t seed;
+    int year;
+    int founding;             // Alkuväestön avioliitot: ei kuolemia eikä syntymiä
+    uint32_t count;           // Henkilöt vuoden alussa
+    uint32_t founders;
+    uint32_t founder_ages[POP_FOUNDER_MAX_AGE + 2]; // Ensimmäinen tunniste iästä a alkaen vanhimmasta
+    ChunkState *chunks;
+    long long num_chunks;
+    float kinship_limit;      // 0 = vain sisarukset estetään
+    uint64_t rejected;
+    uint32_t death_q[POP_MAX_AGE + 1];
+    uint32_t birth_p[POP_MAX_AGE + 1];
+    uint32_t marry_p[2][POP_MAX_AGE + 1];
+} Sim;
+
+static void chunk_rng(const Sim *sim, int pass, long long chunk, Rng *rng) {
+    rng_seed_stream(rng, sim->seed, ((uint64_t)sim->year << 40) | ((uint64_t)pass << 32) | (uint64_t)chunk);
+}
+
+// Funktio lisää tunnisteen kasvavaan taulukkoon (virhe merkitään tehtävään)
+static void push_id(ChunkState *state, uint32_t **array, uint32_t *count, uint32_t *cap, uint32_t id) {
+    if (*count == *cap) {
+        uint32_t grown = (*cap > 0) ? *cap * 2 : 1024;
+        uint32_t *larger = (uint32_t *)realloc(*array, (size_t)grown * sizeof(uint32_t));
+        if (larger == NULL) {
+            state->error = 1;
+            return;
+        }
+        *array = larger;
+        *cap = grown;
+    }
+    (*array)[(*count)++] = id;
+}
+
+// Vaihe 0: alkuväestö. Tunnisteet ovat syntymäjärjestyksessä, vanhimmat ensin.
+static void founders_task(void *context, long long chunk) {
+    Sim *sim = (Sim *)context;
+    Population *pop = sim->pop;
+    uint32_t begin = (uint32_t)(chunk * POP_CHUNK);
+    uint32_t end = (sim->founders - begin > POP_CHUNK) ? begin + POP_CHUNK : sim->founders;
+    Rng rng;
+    chunk_rng(sim, PASS_FOUNDERS, chunk, &rng);
+
+    int age = POP_FOUNDER_MAX_AGE;
+    while (sim->founder_ages[POP_FOUNDER_MAX_AGE - age + 1] <= begin) {
+        age--;
+    }
+    const DecadeData *last = &sim->names->last;
+    for (uint32_t i = begin; i < end; i++) {
+        while (sim->founder_ages[POP_FOUNDER_MAX_AGE - age + 1] <= i) {
+            age--;
+        }
+        int birth = sim->year - age;
+        pop->birth_year[i] = (uint16_t)birth;
+        pop->death_year[i] = POP_ALIVE;
+        pop->sex[i] = (uint8_t)rng_coin(&rng);
+        pop->mother[i] = POP_NONE;
+        pop->father[i] = POP_NONE;
+        pop->spouse[i] = POP_NONE;
+        pop->inbreeding[i] = 0.0f;
+        draw_names(pop, sim->names, i, birth, &rng);
+        pop->last_name[i] = draw_name(last, 0, &rng);
+    }
+}
+
+// Vaihe 1: kuolemat
+static void deaths_task(void *context, long long chunk) {
+    Sim *sim = (Sim *)context;
+    ChunkState *state = &sim->chunks[chunk];
+    if (state->finished) {
+        return;
+    }
+    Population *pop = sim->pop;
+    uint32_t begin = (uint32_t)(chunk * POP_CHUNK);
+    uint32_t end = (sim->count - begin > POP_CHUNK) ? begin + POP_CHUNK : sim->count;
+    Rng rng;
+    chunk_rng(sim, PASS_DEATHS, chunk, &rng);
+
+    uint32_t living = 0, deaths = 0;
+    uint16_t year = (uint16_t)sim->year;
+    for (uint32_t i = begin; i < end; i++) {
+        if (pop->death_year[i] != POP_ALIVE) {
+            continue;
+        }
+        int age = sim->year - pop->birth_year[i];
+        if (age > POP_MAX_AGE || happens(&rng, sim->death_q[age])) {
+            pop->death_year[i] = year;
+            deaths++;
+        } else {
+            living++;
+        }
+    }
+    state->living = living;
+    state->deaths = deaths;
+    // Täysi tehtävä, jonka kaikki ovat kuolleet, ei enää muutu
+    state->finished = (living == 0 && end - begin == POP_CHUNK);
+}
+
+// Vaihe 2: syntymät ja avioliittoon halukkaat. Puoliso on elossa, jos hänen
+// kuolinvuotensa on POP_ALIVE kuolemavaiheen jälkeen.
+static void events_task(void *context, long long chunk) {
+    Sim *sim = (Sim *)context;
+    ChunkState *state = &sim->chunks[chunk];
+    state->num_mothers = 0;
+    state->num_candidates[POP_MALE] = 0;
+    state->num_candidates[POP_FEMALE] = 0;
+    if (state->finished) {
+        return;
+    }
+    Population *pop = sim->pop;
+    uint32_t begin = (uint32_t)(chunk * POP_CHUNK);
+    uint32_t end = (sim->count - begin > POP_CHUNK) ? begin + POP_CHUNK : sim->count;
+    Rng rng;
+    chunk_rng(sim, PASS_EVENTS, chunk, &rng);
+
+    for (uint32_t i = begin; i < end && !state->error; i++) {
+        if (pop->death_year[i] != POP_ALIVE) {
+            continue;
+        }
+        int age = sim->year - pop->birth_year[i];
+        if (age > POP_MAX_AGE) {
+            continue; // Alkuväestö ennen kuolemavaihetta
+        }
+        int sex = pop->sex[i];
+        uint32_t spouse = pop->spouse[i];
+        if (spouse != POP_NONE && pop->death_year[spouse] == POP_ALIVE) {
+            if (sex == POP_FEMALE && !sim->founding && sim->birth_p[age] > 0 && happens(&rng, sim->birth_p[age])) {
+                push_id(state, &state->mothers, &state->num_mothers, &state->mothers_cap, i);
+            }
+        } else if (sim->marry_p[sex][age] > 0 && happens(&rng, sim->marry_p[sex][age])) {
+            push_id(state, &state->candidates[sex], &state->num_candidates[sex], &state->candidates_cap[sex], i);
+        }
+    }
+}
+
+// Vaihe 3: lapset kirjoitetaan tehtävien järjestyksessä sarakkeiden loppuun
+static void births_task(void *context, long long chunk) {
+    Sim *sim = (Sim *)context;
+    ChunkState *state = &sim->chunks[chunk];
+    if (state->num_mothers == 0) {
+        return;
+    }
+    Population *pop = sim->pop;
+    Rng rng;
+    chunk_rng(sim, PASS_NAMES, chunk, &rng);
+    for (uint32_t k = 0; k < state->num_mothers; k++) {
+        uint32_t child = state->first_child + k;
+        uint32_t mother = state->mothers[k];
+        uint32_t father = pop->spouse[mother];
+        pop->birth_year[child] = (uint16_t)sim->year;
+        pop->death_year[child] = POP_ALIVE;
+        pop->sex[child] = (uint8_t)rng_coin(&rng);
+        pop->mother[child] = mother;
+        pop->father[child] = father;
+        pop->spouse[child] = POP_NONE;
+        pop->inbreeding[child] = 0.0f; // inbreeding_task laskee
+        draw_names(pop, sim->names, child, sim->year, &rng);
+        pop->last_name[child] = pop->last_name[father];
+    }
+}
+
+// Funktio palauttaa weight * φ(a, b). Nuorempi (suurempi tunniste) korvataan
+// vanhemmillaan, kunnes molemmat polut päätyvät samaan henkilöön tai
+// alkuväestöön. Nuorempi ei voi olla vanhemman esivanhempi, joten rekursio
+// on sukulaisuuskertoimen määritelmä. Paino puolittuu joka askeleella; alle
+// POP_KINSHIP_MIN_WEIGHT painoiset polut jätetään pois.
+static float kinship_walk(const Population *pop, uint32_t a, uint32_t b, float weight) {
+    if (a == b) {
+        return 0.5f * weight * (1.0f + pop->inbreeding[a]);
+    }
+    if (a < b) {
+        uint32_t swap = a;
+        a = b;
+        b = swap;
+    }
+    if (pop->mother[a] == POP_NONE || weight < POP_KINSHIP_MIN_WEIGHT) {
+        return 0.0f;
+    }
+    weight *= 0.5f;
+    return kinship_walk(pop, pop->mother[a], b, weight) + kinship_walk(pop, pop->father[a], b, weight);
+}
+
+float population_kinship(const Population *pop, uint32_t a, uint32_t b) {
+    return kinship_walk(pop, a, b, 1.0f);
+}
+
+// Vaihe 3b: tehtävän lasten sukusiitoskertoimet. Vanhemmat ovat syntyneet
+// aiempina vuosina, joten niiden kertoimet ovat valmiina.
+static void inbreeding_task(void *context, long long chunk) {
+    Sim *sim = (Sim *)context;
+    const ChunkState *state = &sim->chunks[chunk];
+    Population *pop = sim->pop;
+    for (uint32_t k = 0; k < state->num_mothers; k++) {
+        uint32_t child = state->first_child + k;
+        pop->inbreeding[child] = population_kinship(pop, pop->mother[child], pop->father[child]);
+    }
+}
+
+// Funktio järjestää tunnisteet syntymävuoden mukaan (laskentalajittelu,
+// vakaa, joten sekoitettu järjestys säilyy saman vuoden sisällä)
+static int sort_by_birth(const Population *pop, uint32_t *ids, uint32_t count, int year) {
+    uint32_t counts[POP_MAX_AGE + 2] = {0};
+    uint32_t *sorted = (uint32_t *)malloc((size_t)count * sizeof(uint32_t));
+    if (sorted == NULL) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        counts[year - pop->birth_year[ids[i]] + 1]++;
+    }
+    for (int age = 1; age <= POP_MAX_AGE + 1; age++) {
+        counts[age] += counts[age - 1];
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        sorted[counts[year - pop->birth_year[ids[i]]]++] = ids[i];
+    }
+    memcpy(ids, sorted, (size_t)count * sizeof(uint32_t));
+    free(sorted);
+    return 0;
+}
+
+// Funktio sekoittaa taulukon (Fisher-Yates)
+static void shuffle(uint32_t *ids, uint32_t count, Rng *rng) {
+    for (uint32_t i = count; i > 1; i--) {
+        uint32_t j = rng_bounded(rng, i);
+        uint32_t t = ids[i - 1];
+        ids[i - 1] = ids[j];
+        ids[j] = t;
+    }
+}
+
+// Funktio kokoaa tehtävien ehdokkaat yhteen taulukkoon tehtävien järjestyksessä
+static uint32_t *gather_candidates(const Sim *sim, int sex, uint32_t *count) {
+    uint32_t total = 0;
+    for (long long c = 0; c < sim->num_chunks; c++) {
+        total += sim->chunks[c].num_candidates[sex];
+    }
+    uint32_t *ids = (uint32_t *)malloc(((size_t)total + 1) * sizeof(uint32_t));
+    if (ids == NULL) {
+        return NULL;
+    }
+    uint32_t n = 0;
+    for (long long c = 0; c < sim->num_chunks; c++) {
+        uint32_t k = sim->chunks[c].num_candidates[sex];
+        if (k > 0) {
+            memcpy(ids + n, sim->chunks[c].candidates[sex], (size_t)k * sizeof(uint32_t));
+            n += k;
+        }
+    }
+    *count = n;
+    return ids;
+}
+
+// Vaihe 4: avioliitot. Ehdokkaat sekoitetaan, järjestetään iän mukaan ja
+// parit muodostetaan samasta kohdasta ikäjärjestystä, joten puolisot ovat
+// suunnilleen samanikäisiä. Pari, jonka sukulaisuuskerroin on rajalla tai
+// yli (rajalla 0: sisarukset), jää tänä vuonna naimattomaksi.
+// Palauttaa solmittujen avioliittojen määrän tai -1 (muisti loppui).
+static long long match_couples(Sim *sim) {
+    Population *pop = sim->pop;
+    uint32_t num_men = 0, num_women = 0;
+    uint32_t *men = gather_candidates(sim, POP_MALE, &num_men);
+    uint32_t *women = gather_candidates(sim, POP_FEMALE, &num_women);
+    if (men == NULL || women == NULL) {
+        free(men);
+        free(women);
+        return -1;
+    }
+    Rng rng;
+    chunk_rng(sim, PASS_MARRIAGES, 0, &rng);
+    shuffle(men, num_men, &rng);
+    shuffle(women, num_women, &rng);
+    if (sort_by_birth(pop, men, num_men, sim->year) != 0 || sort_by_birth(pop, women, num_women, sim->year) != 0) {
+        free(men);
+        free(women);
+        return -1;
+    }
+
+    // Harvemman sukupuolen jokainen ehdokas saa parin toisen sukupuolen
+    // vastaavasta ikäkvantiilista
+    uint32_t pairs = (num_men < num_women) ? num_men : num_women;
+    long long marriages = 0;
+    for (uint32_t i = 0; i < pairs; i++) {
+        uint32_t man = (num_men == pairs) ? men[i] : men[(uint64_t)i * num_men / pairs];
+        uint32_t woman = (num_women == pairs) ? women[i] : women[(uint64_t)i * num_women / pairs];
+        if (sim->kinship_limit > 0.0f) {
+            if (population_kinship(pop, man, woman) >= sim->kinship_limit) {
+                sim->rejected++;
+                continue;
+            }
+        } else if ((pop->mother[man] != POP_NONE && pop->mother[man] == pop->mother[woman]) ||
+                   (pop->father[man] != POP_NONE && pop->father[man] == pop->father[woman])) {
+            sim->rejected++;
+            continue;
+        }
+        pop->spouse[man] = woman;
+        pop->spouse[woman] = man;
+        marriages++;
+    }
+    free(men);
+    free(women);
+    return marriages;
+}
+
+// Funktio täyttää vuoden todennäköisyystaulukot
+static void set_rates(Sim *sim) {
+    for (int age = 0; age <= POP_MAX_AGE; age++) {
+        sim->death_q[age] = to_threshold(death_rate(age, sim->year));
+        sim->birth_p[age] = to_threshold(birth_rate(age));
+        for (int sex = 0; sex < 2; sex++) {
+            double p = sim->founding ? married_share(sex, age) : marriage_rate(sex, age);
+            sim->marry_p[sex][age] = to_threshold(p);
+        }
+    }
+}
+
+// Funktio varaa tehtävien tilat henkilömäärälle count
+static int reserve_chunks(Sim *sim, uint32_t count) {
+    long long needed = ((long long)count + POP_CHUNK - 1) / POP_CHUNK;
+    if (needed <= sim->num_chunks) {
+        return 0;
+    }
+    ChunkState *grown = (ChunkState *)realloc(sim->chunks, (size_t)needed * sizeof(ChunkState));
+    if (grown == NULL) {
+        return -1;
+    }
+    memset(grown + sim->num_chunks, 0, (size_t)(needed - sim->num_chunks) * sizeof(ChunkState));
+    sim->chunks = grown;
+    sim->num_chunks = needed;
+    return 0;
+}
+
+static void free_chunks(Sim *sim) {
+    for (long long c = 0; c < sim->num_chunks; c++) {
+        free(sim->chunks[c].mothers);
+        free(sim->chunks[c].candidates[POP_MALE]);
+        free(sim->chunks[c].candidates[POP_FEMALE]);
+    }
+    free(sim->chunks);
+}
+
+static int chunks_failed(const Sim *sim) {
+    for (long long c = 0; c < sim->num_chunks; c++) {
+        if (sim->chunks[c].error) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Funktio luo alkuväestön: ikä a saa painon e^(-0.03 a), ja tunnisteet
+// jaetaan iän mukaan vanhimmasta nuorimpaan
+static int create_founders(Sim *sim, ParallelPool *pool) {
+    double total = 0.0;
+    for (int age = 0; age <= POP_FOUNDER_MAX_AGE; age++) {
+        total += exp(-0.03 * age);
+    }
+    double cumulative = 0.0;
+    sim->founder_ages[0] = 0;
+    for (int k = 0; k <= POP_FOUNDER_MAX_AGE; k++) {
+        cumulative += exp(-0.03 * (POP_FOUNDER_MAX_AGE - k));
+        sim->founder_ages[k + 1] = (uint32_t)((double)sim->founders * cumulative / total + 0.5);
+    }
+    sim->founder_ages[POP_FOUNDER_MAX_AGE + 1] = sim->founders;
+
+    if (population_reserve(sim->pop, sim->founders) != 0 || reserve_chunks(sim, sim->founders) != 0) {
+        return -1;
+    }
+    parallel_pool_run(pool, sim->num_chunks, founders_task, sim);
+    sim->pop->count = sim->founders;
+    sim->count = sim->founders;
+
+    // Alkuväestön avioliitot: naimisissa olevien osuus iän mukaan
+    sim->founding = 1;
+    set_rates(sim);
+    parallel_pool_run(pool, sim->num_chunks, events_task, sim);
+    sim->founding = 0;
+    return (chunks_failed(sim) || match_couples(sim) < 0) ? -1 : 0;
+}
+
+// Funktio simuloi yhden vuoden
+static int simulate_year(Sim *sim, ParallelPool *pool, PopSummary *summary) {
+    Population *pop = sim->pop;
+    sim->count = pop->count;
+    set_rates(sim);
+
+    uint64_t start = stats_now_ns();
+    parallel_pool_run(pool, sim->num_chunks, deaths_task, sim);
+    uint64_t deaths_done = stats_now_ns();
+    parallel_pool_run(pool, sim->num_chunks, events_task, sim);
+    if (chunks_failed(sim)) {
+        return -1;
+    }
+
+    // Lasten tunnisteet tehtävien järjestyksessä
+    uint64_t births = 0;
+    for (long long c = 0; c < sim->num_chunks; c++) {
+        summary->deaths += sim->chunks[c].deaths;
+        sim->chunks[c].first_child = (uint32_t)(pop->count + births);
+        births += sim->chunks[c].num_mothers;
+    }
+    if (pop->count + births >= POP_NONE || population_reserve(pop, (uint32_t)(pop->count + births)) != 0) {
+        return -1;
+    }
+    parallel_pool_run(pool, sim->num_chunks, births_task, sim);
+    pop->count += (uint32_t)births;
+    summary->births += births;
+    uint64_t births_done = stats_now_ns();
+    parallel_pool_run(pool, sim->num_chunks, inbreeding_task, sim);
+    uint64_t kinship_done = stats_now_ns();
+
+    long long marriages = match_couples(sim);
+    if (marriages < 0) {
+        return -1;
+    }
+    summary->marriages += (uint64_t)marriages;
+
+    // Uudet henkilöt voivat aloittaa uusia tehtäviä
+    if (reserve_chunks(sim, pop->count) != 0) {
+        return -1;
+    }
+    uint64_t end = stats_now_ns();
+    summary->pass_seconds[0] += (double)(deaths_done - start) / 1e9;
+    summary->pass_seconds[1] += (double)(births_done - deaths_done) / 1e9;
+    summary->pass_seconds[2] += (double)(end - kinship_done) / 1e9;
+    summary->pass_seconds[3] += (double)(kinship_done - births_done) / 1e9;
+    return 0;
+}
+
+int population_simulate(Population *pop, const PopNames *names, const PopConfig *config, PopSummary *summary) {
+    memset(summary, 0, sizeof(PopSummary));
+    if (config->founders == 0 || config->end_year < config->start_year) {
+        return -1;
+    }
+    ParallelPool *pool = parallel_pool_new(config->threads);
+    Sim *sim = (Sim *)calloc(1, sizeof(Sim));
+    if (pool == NULL || sim == NULL) {
+        parallel_pool_free(pool);
+        free(sim);
+        return -1;
+    }
+    uint64_t start = stats_now_ns();
+    sim->pop = pop;
+    sim->names = names;
+    sim->seed = config->seed;
+    sim->year = config->start_year;
+    sim->founders = config->founders;
+    sim->kinship_limit = (float)config->kinship_limit;
+    pop->count = 0;
+
+    int result = create_founders(sim, pool);
+    for (int year = config->start_year; result == 0 && year <= config->end_year; year++) {
+        sim->year = year;
+        result = simulate_year(sim, pool, summary);
+    }
+    if (result == 0) {
+        for (long long c = 0; c < sim->num_chunks; c++) {
+            summary->living += sim->chunks[c].living;
+        }
+        // Viimeisen vuoden syntyneet eivät ole vielä kuolemavaiheen laskussa
+        for (long long c = 0; c < sim->num_chunks; c++) {
+            summary->living += sim->chunks[c].num_mothers;
+        }
+        summary->rejected = sim->rejected;
+        double total = 0.0;
+        for (uint32_t i = sim->founders; i < pop->count; i++) {
+            total += pop->inbreeding[i];
+            if (pop->inbreeding[i] > summary->max_inbreeding) {
+                summary->max_inbreeding = pop->inbreeding[i];
+            }
+        }
+        summary->mean_inbreeding = (pop->count > sim->founders) ? total / (double)(pop->count - sim->founders) : 0.0;
+    }
+    summary->seconds = (double)(stats_now_ns() - start) / 1e9;
+    free_chunks(sim);
+    free(sim);
+    parallel_pool_free(pool);
+    return result;
+}
+
+uint32_t population_founders_for(uint64_t target, const PopNames *names, const PopConfig *config) {
+    PopConfig pilot = *config;
+    pilot.founders = (target < POP_PILOT_FOUNDERS) ? (uint32_t)target : POP_PILOT_FOUNDERS;
+    if (pilot.founders == 0) {
+        return 0;
+    }
+    Population pop;
+    PopSummary summary;
+    population_init(&pop);
+    int status = population_simulate(&pop, names, &pilot, &summary);
+    double ratio = (double)pop.count / (double)pilot.founders;
+    population_free(&pop);
+    if (status != 0 || ratio <= 0.0) {
+        return 0;
+    }
+    double founders = (double)target / ratio;
+    return (founders < 1.0) ? 1 : (founders >= (double)POP_NONE / ratio) ? 0 : (uint32_t)founders;
+}
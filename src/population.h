@@ -0,0 +1,139 @@
+/**
+* @file population.h
+* @brief Structure-of-arrays population store and the yearly simulation of births, marriages and deaths.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "namelist.h"
+
+// Henkilöt tallennetaan sarakkeittain (structure of arrays): jokainen kenttä on
+// oma taulukkonsa, ja henkilön tunniste on indeksi niihin. Vuosikierroksen
+// vaiheet lukevat vain tarvitsemansa sarakkeet (esim. kuolemat vain syntymä- ja
+// kuolinvuoden), joten välimuistiin ei tuoda käyttämättömiä kenttiä.
+// Tunnisteet annetaan syntymäjärjestyksessä: vanhemman tunniste on aina
+// pienempi kuin lapsen.
+
+#define POP_NONE UINT32_MAX       // Puuttuva vanhempi, puoliso tai keskinimi
+#define POP_ALIVE 0               // death_year elävällä henkilöllä
+#define POP_MAX_AGE 110           // Tätä vanhemmat kuolevat vuoden aikana
+
+#define POP_MALE 0
+#define POP_FEMALE 1
+
+// Naisten nimilistat (miesten listat ja sukunimet: NAMEGEN_*-tiedostot)
+#define POP_WOMEN_FIRST_NAMES "Finnish-Most-common-first-names-for-women.csv"
+#define POP_WOMEN_MIDDLE_NAMES "Finnish-Most-common-middle-names-for-women.csv"
+
+// Tavuja per henkilö kaikissa sarakkeissa yhteensä
+#define POP_BYTES_PER_PERSON (2 * sizeof(uint16_t) + sizeof(uint8_t) + 6 * sizeof(uint32_t) + sizeof(float))
+
+// Oletusraja puolisoiden sukulaisuuskertoimelle: serkut (1/16) ja läheisemmät
+// eivät avioidu keskenään
+#define POP_KINSHIP_LIMIT (1.0 / 16.0)
+
+typedef struct {
+    uint16_t *birth_year;
+    uint16_t *death_year;     // POP_ALIVE = elossa
+    uint8_t *sex;             // POP_MALE tai POP_FEMALE
+    uint32_t *mother;         // POP_NONE = ei tiedossa (alkuväestö)
+    uint32_t *father;
+    uint32_t *spouse;         // Viimeisin puoliso, POP_NONE = ei koskaan naimisissa
+    uint32_t *first_name;     // Tunniste sukupuolen etunimitiedoston sanakirjaan
+    uint32_t *middle_name;    // Tunniste keskinimitiedoston sanakirjaan tai POP_NONE
+    uint32_t *last_name;      // Syntymäsukunimi, tunniste sukunimitiedoston sanakirjaan
+    float *inbreeding;        // Sukusiitoskerroin F (vanhempien sukulaisuuskerroin), alkuväestöllä 0
+    uint32_t count;
+    uint32_t capacity;
+} Population;
+
+// Nimilistat: sukupuolen (POP_MALE / POP_FEMALE) etu- ja keskinimet
+// vuosikymmenittäin sekä sukunimet. Henkilön nimitunnisteet viittaavat
+// tiedostojen sanakirjoihin (DecadeData.lists[*].slices).
+typedef struct {
+    DecadeData first[2];
+    DecadeData middle[2];
+    DecadeData last;
+    int first_decade_year;    // Ensimmäisen sarakkeen alkuvuosi (esim. 1860)
+} PopNames;
+
+// Simulaation asetukset
+typedef struct {
+    uint64_t seed;
+    int start_year;           // Alkuväestö elää tämän vuoden alussa
+    int end_year;             // Viimeinen simuloitava vuosi
+    uint32_t founders;        // Alkuväestön koko
+    int threads;              // 0 = laitteiston säiemäärä
+    double kinship_limit;     // Avioliitto estetään, jos puolisoiden kerroin on vähintään tämä.
+                              // 0 = vain sisarukset estetään.
+} PopConfig;
+
+// Simulaation tapahtumat
+typedef struct {
+    uint64_t births;
+    uint64_t deaths;
+    uint64_t marriages;
+    uint64_t rejected;        // Sukulaisuuden vuoksi estetyt avioliitot
+    uint32_t living;          // Elossa viimeisen vuoden lopussa
+    double mean_inbreeding;   // Syntyneiden F:n keskiarvo
+    double max_inbreeding;
+    double seconds;           // Kokonaisaika
+    double pass_seconds[4];   // Kuolemat, syntymät (päätös ja kirjoitus), avioliitot, sukusiitoskertoimet
+} PopSummary;
+
+// Lataa nimilistat hakemistosta ja rakentaa niille painotetut otantataulut.
+// Palauttaa NAMELIST_OK tai virhekoodin.
+int pop_names_load(PopNames *names, const char *locale_dir);
+
+void pop_names_free(PopNames *names);
+
+// Palauttaa henkilön nimen osan (ei NUL-päätteinen) ja sen pituuden
+const char *pop_first_name(const PopNames *names, const Population *pop, uint32_t person, size_t *length);
+const char *pop_middle_name(const PopNames *names, const Population *pop, uint32_t person, size_t *length);
+const char *pop_last_name(const PopNames *names, const Population *pop, uint32_t person, size_t *length);
+
+void population_init(Population *pop);
+
+// Varaa sarakkeisiin tilaa vähintään capacity henkilölle. Palauttaa 0 tai -1.
+int population_reserve(Population *pop, uint32_t capacity);
+
+void population_free(Population *pop);
+
+// Luo alkuväestön ja simuloi vuodet start_year ... end_year. Sama siemen antaa
+// saman väestön millä tahansa säiemäärällä. Palauttaa 0 tai -1 (muisti loppui).
+int population_simulate(Population *pop, const PopNames *names, const PopConfig *config, PopSummary *summary);
+
+// Palauttaa henkilöiden a ja b sukulaisuuskertoimen φ sukupuusta laskettuna
+// (serkuilla 1/16). Yli 10 sukupolven polut jätetään pois, joten alle 1/1024
+// osuudet puuttuvat. Esivanhempien inbreeding-sarakkeen on oltava laskettu.
+float population_kinship(const Population *pop, uint32_t a, uint32_t b);
+
+// Arvioi alkuväestön koon, jolla simulaatiossa on noin target henkilöä:
+// simuloi pienen alkuväestön samoilla asetuksilla ja skaalaa tuloksen.
+// Palauttaa 0, jos arviota ei voitu tehdä.
+uint32_t population_founders_for(uint64_t target, const PopNames *names, const PopConfig *config);
+
+#endif // POPULATION_H
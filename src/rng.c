@@ -0,0 +1,88 @@
+/**
+* @file rng.c
+* @brief Seedable xoshiro256** random number generator with unbiased bounded draws.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "rng.h"
+
+// splitmix64: levittää siemenen bitit koko tilaan
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(Rng *rng, uint64_t seed) {
+    uint64_t state = seed;
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&state);
+    }
+}
+
+void rng_seed_stream(Rng *rng, uint64_t seed, uint64_t stream) {
+    // Virran numero sekoitetaan ennen siemenen kanssa yhdistämistä, jotta
+    // (seed, stream) ja (seed + 1, stream - 1) eivät päädy samaan tilaan
+    uint64_t mixed = stream;
+    uint64_t state = seed ^ splitmix64(&mixed);
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&state);
+    }
+}
+
+// Funktio siirtää tilaa eteenpäin hyppypolynomin mukaan
+static void rng_apply_jump(Rng *rng, const uint64_t polynomial[4]) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (polynomial[i] & ((uint64_t)1 << b)) {
+                s0 ^= rng->s[0];
+                s1 ^= rng->s[1];
+                s2 ^= rng->s[2];
+                s3 ^= rng->s[3];
+            }
+            rng_next(rng);
+        }
+    }
+
+    rng->s[0] = s0;
+    rng->s[1] = s1;
+    rng->s[2] = s2;
+    rng->s[3] = s3;
+}
+
+void rng_jump(Rng *rng) {
+    static const uint64_t jump[4] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    rng_apply_jump(rng, jump);
+}
+
+void rng_long_jump(Rng *rng) {
+    static const uint64_t long_jump[4] = {
+        0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+        0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+    };
+    rng_apply_jump(rng, long_jump);
+}
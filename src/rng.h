@@ -0,0 +1,93 @@
+/**
+* @file rng.h
+* @brief Seedable xoshiro256** random number generator with unbiased bounded draws.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Generaattorin tila. Jokaisella säikeellä on oma tilansa, joten piilotettua
+// globaalia tilaa (kuten rand()-funktiolla) ei ole.
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+// Alustaa tilan siemenestä (splitmix64). Sama siemen tuottaa aina saman sarjan.
+void rng_seed(Rng *rng, uint64_t seed);
+
+// Alustaa tilan siemenestä ja virran numerosta. Eri virrat ovat käytännössä
+// riippumattomia, ja minkä tahansa virran voi alustaa suoraan ilman hyppyjä.
+void rng_seed_stream(Rng *rng, uint64_t seed, uint64_t stream);
+
+// Hyppää 2^128 askelta eteenpäin. Peräkkäiset hypyt antavat toisiaan
+// leikkaamattomat virrat (esim. yksi per säie).
+void rng_jump(Rng *rng);
+
+// Hyppää 2^192 askelta eteenpäin (virtojen ryhmiä varten)
+void rng_long_jump(Rng *rng);
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Palauttaa seuraavan 64-bittisen satunnaisluvun (xoshiro256**)
+static inline uint64_t rng_next(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+
+    return result;
+}
+
+// Palauttaa tasajakautuneen luvun väliltä 0 ... bound - 1 (bound > 0).
+// Lemiren kertolaskumenetelmä: ei jakolaskua tavallisella polulla ja
+// hylkäys poistaa vinouman. Jakolasku tehdään vain harvinaisessa
+// hylkäystapauksessa (todennäköisyys bound / 2^32).
+static inline uint32_t rng_bounded(Rng *rng, uint32_t bound) {
+    uint64_t m = (rng_next(rng) >> 32) * (uint64_t)bound;
+    uint32_t low = (uint32_t)m;
+
+    if (low < bound) {
+        uint32_t threshold = (uint32_t)(-bound) % bound;
+        while (low < threshold) {
+            m = (rng_next(rng) >> 32) * (uint64_t)bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+// Palauttaa 0 tai 1 todennäköisyydellä 50 % (ylin bitti on laadukkain)
+static inline int rng_coin(Rng *rng) {
+    return (int)(rng_next(rng) >> 63);
+}
+
+#endif // RNG_H
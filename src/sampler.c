@@ -0,0 +1,661 @@
+/**
+* @file sampler.c
+* @brief Block sampling kernels (scalar, SSE4.1, AVX2) for assembling name lines.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAMPLER_X86 1
+#endif
+
+#include "sampler.h"
+
+// Ytimet vahvuusjärjestyksessä
+enum { KERNEL_SCALAR = 0, KERNEL_SSE41 = 1, KERNEL_AVX2 = 2 };
+
+// Lohkon indeksiydin: laskee SAMPLER_BLOCK indeksiä valmiiksi arvotuista
+// luvuista ja palauttaa hylkäysbitit (tasainen otanta, lohko tehdään uudelleen skalaarina)
+typedef uint32_t (*IndexKernel)(const SamplerList *list, const uint64_t *words, uint32_t *out);
+
+// --- 1. SKALAARINEN MÄÄRITELMÄ ---
+
+void sampler_init(Sampler *sampler, const NameList *first, const NameList *middle,
+                  const NameList *last) {
+    const NameList *lists[3] = {first, last, middle};
+    SamplerList *targets[3] = {&sampler->first, &sampler->last, &sampler->middle};
+
+    sampler->has_middle = (middle != NULL && middle->count > 0);
+    sampler->format = NULL;
+    sampler->cond = NULL;
+    sampler->cond_rows = NULL;
+    for (int i = 0; i < 3; i++) {
+        const NameList *list = (i == 2 && !sampler->has_middle) ? NULL : lists[i];
+        targets[i]->list = list;
+        targets[i]->count = (list != NULL) ? (uint32_t)list->count : 0;
+        targets[i]->threshold = (list != NULL) ? (uint32_t)(-targets[i]->count) % targets[i]->count : 0;
+    }
+}
+
+void sampler_set_conditional(Sampler *sampler, const CondTable *table, int column) {
+    // Keskinimilista on taulun sanakirja, joten arvottu tunniste on suoraan nimi
+    sampler->cond = table;
+    sampler->cond_rows = table->columns[column].rows;
+    sampler->has_middle = 1;
+    sampler->middle.list = &table->names;
+    sampler->middle.count = (uint32_t)table->names.count;
+    sampler->middle.threshold = (sampler->middle.count > 0) ? (uint32_t)(-sampler->middle.count) % sampler->middle.count : 0;
+}
+
+// Funktio muuntaa satunnaisluvun listan indeksiksi: alias-taululla yhdellä
+// haulla, tasaisesti Lemiren menetelmällä (hylkäys arpoo uuden luvun)
+static inline uint32_t draw_index(const SamplerList *s, uint64_t word, Rng *rng) {
+    uint64_t m = (word >> 32) * (uint64_t)s->count;
+    if (s->list->alias != NULL) {
+        AliasEntry entry = s->list->alias[m >> 32];
+        return ((uint32_t)word < entry.prob) ? (uint32_t)(m >> 32) : entry.alias;
+    }
+    while ((uint32_t)m < s->threshold) {
+        m = (rng_next(rng) >> 32) * (uint64_t)s->count;
+    }
+    return (uint32_t)(m >> 32);
+}
+
+// Funktio kirjoittaa yhden rivin, jos se mahtuu. Palauttaa rivin pituuden tai 0.
+static inline size_t write_line(const Sampler *s, const NameSlice *first, const NameSlice *middle,
+                                const NameSlice *last, char *out, size_t space) {
+    size_t len = (size_t)first->length + last->length + 2;
+    if (middle != NULL) {
+        len += (size_t)middle->length + 1;
+    }
+    if (len > space) {
+        return 0;
+    }
+
+    char *p = out;
+    memcpy(p, s->first.list->pool + first->offset, first->length);
+    p += first->length;
+    if (middle != NULL) {
+        *p++ = ' ';
+        memcpy(p, s->middle.list->pool + middle->offset, middle->length);
+        p += middle->length;
+    }
+    *p++ = ' ';
+    memcpy(p, s->last.list->pool + last->offset, last->length);
+    p += last->length;
+    *p = '\n';
+    return len;
+}
+
+// Funktio kirjoittaa luvun kymmenjärjestelmässä ja palauttaa sen pituuden
+static size_t write_decimal(char *out, uint32_t value) {
+    char digits[10];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+// Funktio kirjoittaa rivin tunnisteina "etu [keski] suku\n", jos se mahtuu.
+// Palauttaa rivin pituuden tai 0.
+static size_t write_id_line(uint32_t first, const uint32_t *middle, uint32_t last,
+                            char *out, size_t space) {
+    if (space < SAMPLER_MAX_ID_LINE) {
+        return 0;
+    }
+    char *p = out;
+    p += write_decimal(p, first);
+    if (middle != NULL) {
+        *p++ = ' ';
+        p += write_decimal(p, *middle);
+    }
+    *p++ = ' ';
+    p += write_decimal(p, last);
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+// Funktio kirjoittaa nimen binääritietueena (etu, keski, suku), jos se mahtuu
+static size_t write_record(uint32_t first, const uint32_t *middle, uint32_t last, char *out, size_t space) {
+    if (space < LINE_RECORD_SIZE) {
+        return 0;
+    }
+    uint32_t record[3] = {first, (middle != NULL) ? *middle : LINE_NO_MIDDLE, last};
+    memcpy(out, record, LINE_RECORD_SIZE);
+    return LINE_RECORD_SIZE;
+}
+
+// Funktio kirjoittaa rivin muodon osista ja nimistä (CSV, JSONL), jos pisin
+// mahdollinen rivi mahtuu. Palauttaa rivin pituuden tai 0.
+static size_t write_formatted_line(const Sampler *s, const NameSlice *first, const NameSlice *middle,
+                                   const NameSlice *last, char *out, size_t space) {
+    const LineFormat *f = s->format;
+    size_t bound = f->begin_length + line_format_field_bound(f, first->length) +
+                   line_format_field_bound(f, last->length) + f->end_length;
+    bound += (middle != NULL) ? f->middle_length + line_format_field_bound(f, middle->length) + f->last_length
+                              : f->no_middle_length;
+    if (bound > space) {
+        return 0;
+    }
+
+    char *p = out;
+    memcpy(p, f->begin, f->begin_length);
+    p += f->begin_length;
+    p += line_format_write_field(f, p, s->first.list->pool + first->offset, first->length);
+    if (middle != NULL) {
+        memcpy(p, f->middle, f->middle_length);
+        p += f->middle_length;
+        p += line_format_write_field(f, p, s->middle.list->pool + middle->offset, middle->length);
+        memcpy(p, f->last, f->last_length);
+        p += f->last_length;
+    } else {
+        memcpy(p, f->no_middle, f->no_middle_length);
+        p += f->no_middle_length;
+    }
+    p += line_format_write_field(f, p, s->last.list->pool + last->offset, last->length);
+    memcpy(p, f->end, f->end_length);
+    p += f->end_length;
+    return (size_t)(p - out);
+}
+
+// Funktio kirjoittaa tunnisteiden nimen samplerin muodossa. Palauttaa pituuden tai 0.
+static inline size_t emit_line(const Sampler *s, uint32_t first, const uint32_t *middle, uint32_t last,
+                               char *out, size_t space) {
+    int kind = (s->format != NULL) ? s->format->kind : LINE_FORMAT_TEXT;
+    if (kind == LINE_FORMAT_IDS) {
+        return write_id_line(first, middle, last, out, space);
+    }
+    if (kind == LINE_FORMAT_RECORDS) {
+        return write_record(first, middle, last, out, space);
+    }
+    const NameSlice *middle_slice = (middle != NULL) ? &s->middle.list->slices[*middle] : NULL;
+    if (kind == LINE_FORMAT_TEXT) {
+        return write_line(s, &s->first.list->slices[first], middle_slice, &s->last.list->slices[last], out, space);
+    }
+    return write_formatted_line(s, &s->first.list->slices[first], middle_slice, &s->last.list->slices[last],
+                                out, space);
+}
+
+// Skalaarinen polku: yksi nimi kerrallaan. Tämä on otannan määritelmä.
+static long long generate_scalar(const Sampler *s, Rng *rng, char *out, size_t capacity,
+                                 long long n, size_t *pos) {
+    long long i = 0;
+    for (; i < n; i++) {
+        Rng saved = *rng;
+        uint64_t first_word = rng_next(rng);
+        uint64_t last_word = rng_next(rng);
+        uint64_t coin_word = 0, middle_word = 0;
+        if (s->has_middle) {
+            coin_word = rng_next(rng);
+            middle_word = rng_next(rng);
+        }
+
+        // Indeksit listoihin ja niistä tunnisteet sanakirjaan
+        uint32_t first_index = draw_index(&s->first, first_word, rng);
+        uint32_t first = name_id(s->first.list, (int)first_index);
+        uint32_t last = name_id(s->last.list, (int)draw_index(&s->last, last_word, rng));
+        uint32_t middle = 0;
+        int has_middle = 0;
+        if (s->cond_rows != NULL) {
+            // Etunimen rivi: oma keskinimijakauma ja todennäköisyys
+            middle = cond_sample(s->cond, &s->cond_rows[first_index], coin_word, middle_word);
+            has_middle = (middle != UINT32_MAX);
+        } else if (s->has_middle) {
+            middle = name_id(s->middle.list, (int)draw_index(&s->middle, middle_word, rng));
+            has_middle = (int)(coin_word >> 63);
+        }
+
+        size_t len = emit_line(s, first, has_middle ? &middle : NULL, last, out + *pos, capacity - *pos);
+        if (len == 0) {
+            *rng = saved; // Rivi ei mahdu: seuraava kutsu arpoo sen uudelleen
+            break;
+        }
+        *pos += len;
+    }
+    return i;
+}
+
+// Skalaarinen lohkoydin (käytetään, kun SIMD-ytimiä ei ole). Hylkäysbitit
+// kertovat nimet, joille tasainen otanta tarvitsee lisää lukuja.
+static uint32_t indices_scalar(const SamplerList *list, const uint64_t *words, uint32_t *out) {
+    uint32_t reject = 0;
+    for (int i = 0; i < SAMPLER_BLOCK; i++) {
+        uint64_t m = (words[i] >> 32) * (uint64_t)list->count;
+        uint32_t slot = (uint32_t)(m >> 32);
+        if (list->list->alias != NULL) {
+            AliasEntry entry = list->list->alias[slot];
+            out[i] = ((uint32_t)words[i] < entry.prob) ? slot : entry.alias;
+        } else {
+            out[i] = slot;
+            reject |= (uint32_t)((uint32_t)m < list->threshold) << i;
+        }
+    }
+    return reject;
+}
+
+// --- 2. SIMD-YTIMET ---
+
+#ifdef SAMPLER_X86
+
+// SSE4.1: kaksi 64-bittistä kaistaa. Kerto-siirto _mm_mul_epu32:lla ja valinta
+// _mm_blendv_epi8:lla; alias-taulun haut tehdään skalaarina (ei gather-käskyä).
+__attribute__((target("sse4.1")))
+static uint32_t indices_sse41(const SamplerList *list, const uint64_t *words, uint32_t *out) {
+    const __m128i bound = _mm_set1_epi64x(list->count);
+    const __m128i low_mask = _mm_set1_epi64x(0xffffffffLL);
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    const __m128i threshold = _mm_xor_si128(_mm_set1_epi64x(list->threshold), sign);
+    uint32_t reject = 0;
+
+    for (int i = 0; i < SAMPLER_BLOCK; i += 2) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(words + i));
+        __m128i m = _mm_mul_epu32(_mm_srli_epi64(x, 32), bound);
+        __m128i slot = _mm_srli_epi64(m, 32);
+        __m128i result = slot;
+
+        if (list->list->alias != NULL) {
+            const AliasEntry *alias = list->list->alias;
+            __m128i entry = _mm_set_epi64x(*(const long long *)&alias[_mm_extract_epi32(slot, 2)],
+                                           *(const long long *)&alias[_mm_cvtsi128_si32(slot)]);
+            __m128i prob = _mm_xor_si128(_mm_and_si128(entry, low_mask), sign);
+            __m128i value = _mm_xor_si128(_mm_and_si128(x, low_mask), sign);
+            __m128i take_slot = _mm_shuffle_epi32(_mm_cmpgt_epi32(prob, value), _MM_SHUFFLE(2, 2, 0, 0));
+            result = _mm_blendv_epi8(_mm_srli_epi64(entry, 32), slot, take_slot);
+        } else {
+            // Etumerkitön vertailu low < threshold 32-bittisillä kaistoilla
+            __m128i low = _mm_xor_si128(_mm_and_si128(m, low_mask), sign);
+            int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(threshold, low)));
+            reject |= (uint32_t)((bits & 1) | ((bits >> 1) & 2)) << i;
+        }
+        out[i] = (uint32_t)_mm_cvtsi128_si32(result);
+        out[i + 1] = (uint32_t)_mm_extract_epi32(result, 2);
+    }
+    return reject;
+}
+
+// AVX2: neljä 64-bittistä kaistaa, alias-taulun haut _mm256_i64gather_epi64:llä
+__attribute__((target("avx2")))
+static uint32_t indices_avx2(const SamplerList *list, const uint64_t *words, uint32_t *out) {
+    const __m256i bound = _mm256_set1_epi64x(list->count);
+    const __m256i low_mask = _mm256_set1_epi64x(0xffffffffLL);
+    const __m256i threshold = _mm256_set1_epi64x(list->threshold);
+    const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    uint32_t reject = 0;
+
+    for (int i = 0; i < SAMPLER_BLOCK; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(words + i));
+        __m256i m = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), bound);
+        __m256i slot = _mm256_srli_epi64(m, 32);
+        __m256i result = slot;
+
+        if (list->list->alias != NULL) {
+            // AliasEntry on 8 tavua: prob alapuoliskossa, alias yläpuoliskossa
+            __m256i entry = _mm256_i64gather_epi64((const long long *)list->list->alias, slot, 8);
+            __m256i take_slot = _mm256_cmpgt_epi64(_mm256_and_si256(entry, low_mask),
+                                                   _mm256_and_si256(x, low_mask));
+            result = _mm256_blendv_epi8(_mm256_srli_epi64(entry, 32), slot, take_slot);
+        } else {
+            __m256i low = _mm256_and_si256(m, low_mask);
+            __m256i rejected = _mm256_cmpgt_epi64(threshold, low);
+            reject |= (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(rejected)) << i;
+        }
+        __m256i packed = _mm256_permutevar8x32_epi32(result, pack);
+        _mm_storeu_si128((__m128i *)(out + i), _mm256_castsi256_si128(packed));
+    }
+    return reject;
+}
+
+// Funktio kopioi nimen 16 tavun paloina. Lähteen ylilukeminen sallitaan vain
+// saman muistisivun sisällä, joten se ei voi kaatua; muuten käytetään memcpyä.
+static inline char *copy_wide(char *dst, const char *src, size_t len) {
+    uintptr_t last = (uintptr_t)src + len - 1;
+    uintptr_t wide_last = (uintptr_t)src + ((len + 15) & ~(size_t)15) - 1;
+    if (len == 0) {
+        return dst;
+    }
+    if ((last >> 12) == (wide_last >> 12)) {
+        for (size_t k = 0; k < len; k += 16) {
+            _mm_storeu_si128((__m128i *)(dst + k), _mm_loadu_si128((const __m128i *)(src + k)));
+        }
+    } else {
+        memcpy(dst, src, len);
+    }
+    return dst + len;
+}
+
+#else
+
+static inline char *copy_wide(char *dst, const char *src, size_t len) {
+    memcpy(dst, src, len);
+    return dst + len;
+}
+
+#endif // SAMPLER_X86
+
+// --- 3. VALINTA JA LOHKOPOLKU ---
+
+static int detect_kernel(void) {
+    int best = KERNEL_SCALAR;
+#ifdef SAMPLER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        best = KERNEL_AVX2;
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        best = KERNEL_SSE41;
+    }
+#endif
+    // NAMEGEN_KERNEL=scalar|sse4.1 pakottaa heikomman ytimen (vertailuja varten)
+    const char *forced = getenv("NAMEGEN_KERNEL");
+    if (forced != NULL) {
+        int wanted = (strcmp(forced, "scalar") == 0) ? KERNEL_SCALAR :
+                     (strcmp(forced, "sse4.1") == 0) ? KERNEL_SSE41 : KERNEL_AVX2;
+        if (wanted < best) {
+            best = wanted;
+        }
+    }
+    return best;
+}
+
+// Valittu ydin tallennetaan kerran (+1, jotta 0 tarkoittaa valitsematonta)
+static int selected_kernel;
+
+static int current_kernel(void) {
+    int kernel = __atomic_load_n(&selected_kernel, __ATOMIC_RELAXED);
+    if (kernel == 0) {
+        kernel = detect_kernel() + 1;
+        __atomic_store_n(&selected_kernel, kernel, __ATOMIC_RELAXED);
+    }
+    return kernel - 1;
+}
+
+const char *sampler_kernel_name(void) {
+    static const char *const names[] = {"scalar", "sse4.1", "avx2"};
+    return names[current_kernel()];
+}
+
+static IndexKernel index_kernel(int kernel) {
+#ifdef SAMPLER_X86
+    if (kernel == KERNEL_AVX2) {
+        return indices_avx2;
+    }
+    if (kernel == KERNEL_SSE41) {
+        return indices_sse41;
+    }
+#endif
+    (void)kernel;
+    return indices_scalar;
+}
+
+// Lohkon tulos
+enum { BLOCK_DONE, BLOCK_REJECTED, BLOCK_FULL };
+
+// Funktio muuntaa lohkon indeksit sanakirjan tunnisteiksi. Tunnisteet ovat
+// 2 tai 4 tavua, joten sarakkeen taulukko mahtuu välimuistiin.
+static inline void resolve_ids(const NameList *list, uint32_t *index) {
+    if (list->ids == NULL) {
+        return;
+    }
+    if (list->id_width == 2) {
+        const uint16_t *ids = (const uint16_t *)list->ids;
+        for (int i = 0; i < SAMPLER_BLOCK; i++) {
+            index[i] = ids[index[i]];
+        }
+    } else {
+        const uint32_t *ids = (const uint32_t *)list->ids;
+        for (int i = 0; i < SAMPLER_BLOCK; i++) {
+            index[i] = ids[index[i]];
+        }
+    }
+}
+
+// Funktio kokoaa lohkon tekstiriveiksi, jos lohko mahtuu (leveät kopiot
+// tarvitsevat 16 tavun varan). Palauttaa tavut tai 0.
+static inline size_t assemble_text(const Sampler *s, const uint32_t *first, const uint32_t *middle,
+                                   const uint32_t *last, uint32_t middle_mask, char *out, size_t space) {
+    const NameSlice *first_slices = s->first.list->slices;
+    const NameSlice *last_slices = s->last.list->slices;
+    const NameSlice *middle_slices = s->has_middle ? s->middle.list->slices : NULL;
+    size_t total = 0;
+    for (int i = 0; i < SAMPLER_BLOCK; i++) {
+        total += (size_t)first_slices[first[i]].length + last_slices[last[i]].length + 2;
+        if (middle_mask & (1u << i)) {
+            total += (size_t)middle_slices[middle[i]].length + 1;
+        }
+    }
+    if (space < total + 16) {
+        return 0;
+    }
+
+    char *p = out;
+    const char *first_pool = s->first.list->pool;
+    const char *last_pool = s->last.list->pool;
+    for (int i = 0; i < SAMPLER_BLOCK; i++) {
+        const NameSlice *f = &first_slices[first[i]];
+        const NameSlice *l = &last_slices[last[i]];
+        p = copy_wide(p, first_pool + f->offset, f->length);
+        if (middle_mask & (1u << i)) {
+            const NameSlice *m = &middle_slices[middle[i]];
+            *p++ = ' ';
+            p = copy_wide(p, s->middle.list->pool + m->offset, m->length);
+        }
+        *p++ = ' ';
+        p = copy_wide(p, last_pool + l->offset, l->length);
+        *p++ = '\n';
+    }
+    return total;
+}
+
+// Funktio kirjoittaa lohkon binääritietueina
+static inline size_t assemble_records(const uint32_t *first, const uint32_t *middle, const uint32_t *last,
+                                      uint32_t middle_mask, char *out, size_t space) {
+    uint32_t records[3 * SAMPLER_BLOCK];
+    if (space < sizeof(records)) {
+        return 0;
+    }
+    for (int i = 0; i < SAMPLER_BLOCK; i++) {
+        records[3 * i] = first[i];
+        records[3 * i + 1] = (middle_mask & (1u << i)) ? middle[i] : LINE_NO_MIDDLE;
+        records[3 * i + 2] = last[i];
+    }
+    memcpy(out, records, sizeof(records));
+    return sizeof(records);
+}
+
+// Funktio kokoaa lohkon muodon osista ja nimistä (CSV, JSONL ilman lainattavia
+// nimiä). Osien taulukot ovat 16 tavun monikertoja, joten niitäkin voi kopioida leveästi.
+static inline size_t assemble_formatted(const Sampler *s, const uint32_t *first, const uint32_t *middle,
+                                        const uint32_t *last, uint32_t middle_mask, char *out, size_t space) {
+    const LineFormat *f = s->format;
+    const NameSlice *first_slices = s->first.list->slices;
+    const NameSlice *last_slices = s->last.list->slices;
+    const NameSlice *middle_slices = s->has_middle ? s->middle.list->slices : NULL;
+    size_t fixed = (size_t)f->begin_length + f->end_length;
+    size_t total = 0;
+    for (int i = 0; i < SAMPLER_BLOCK; i++) {
+        total += fixed + first_slices[first[i]].length + last_slices[last[i]].length;
+        total += (middle_mask & (1u << i))
+                 ? (size_t)f->middle_length + middle_slices[middle[i]].length + f->last_length
+                 : f->no_middle_length;
+    }
+    if (space < total + 16) {
+        return 0;
+    }
+
+    char *p = out;
+    for (int i = 0; i < SAMPLER_BLOCK; i++) {
+        const NameSlice *fs = &first_slices[first[i]];
+        const NameSlice *ls = &last_slices[last[i]];
+        p = copy_wide(p, f->begin, f->begin_length);
+        p = copy_wide(p, s->first.list->pool + fs->offset, fs->length);
+        if (middle_mask & (1u << i)) {
+            const NameSlice *ms = &middle_slices[middle[i]];
+            p = copy_wide(p, f->middle, f->middle_length);
+            p = copy_wide(p, s->middle.list->pool + ms->offset, ms->length);
+            p = copy_wide(p, f->last, f->last_length);
+        } else {
+            p = copy_wide(p, f->no_middle, f->no_middle_length);
+        }
+        p = copy_wide(p, s->last.list->pool + ls->offset, ls->length);
+        p = copy_wide(p, f->end, f->end_length);
+    }
+    return total;
+}
+
+// Lohkopolku: arpoo SAMPLER_BLOCK nimen luvut kerralla, laskee indeksit
+// ytimellä ja kokoaa rivit. Jos lohkossa on hylkäys tai se ei mahdu kokonaan
+// (leveät kopiot tarvitsevat 16 tavun varan), rng palautetaan ja lohko tehdään
+// skalaarisella polulla, joten tuloste on aina sama kuin määritelmässä.
+static int generate_block(const Sampler *s, IndexKernel kernel, Rng *rng,
+                          char *out, size_t capacity, size_t *pos) {
+    uint64_t first_words[SAMPLER_BLOCK], last_words[SAMPLER_BLOCK];
+    uint64_t coin_words[SAMPLER_BLOCK], middle_words[SAMPLER_BLOCK];
+    uint32_t first[SAMPLER_BLOCK], last[SAMPLER_BLOCK], middle[SAMPLER_BLOCK];
+    Rng saved = *rng;
+
+    for (int i = 0; i < SAMPLER_BLOCK; i++) {
+        first_words[i] = rng_next(rng);
+        last_words[i] = rng_next(rng);
+        if (s->has_middle) {
+            coin_words[i] = rng_next(rng);
+            middle_words[i] = rng_next(rng);
+        }
+    }
+
+    uint32_t reject = kernel(&s->first, first_words, first) | kernel(&s->last, last_words, last);
+    uint32_t middle_mask = 0;
+    if (s->cond_rows != NULL) {
+        // Etunimen paikka valitsee rivin ennen kuin paikat muunnetaan tunnisteiksi
+        for (int i = 0; i < SAMPLER_BLOCK; i++) {
+            middle[i] = cond_sample(s->cond, &s->cond_rows[first[i]], coin_words[i], middle_words[i]);
+            middle_mask |= (uint32_t)(middle[i] != UINT32_MAX) << i;
+        }
+    } else if (s->has_middle) {
+        reject |= kernel(&s->middle, middle_words, middle);
+        for (int i = 0; i < SAMPLER_BLOCK; i++) {
+            middle_mask |= (uint32_t)(coin_words[i] >> 63) << i; // Kolikko maskiksi
+        }
+    }
+
+    resolve_ids(s->first.list, first);
+    resolve_ids(s->last.list, last);
+    if (s->has_middle) {
+        resolve_ids(s->middle.list, middle);
+    }
+
+    if (reject != 0) {
+        *rng = saved;
+        return BLOCK_REJECTED;
+    }
+
+    size_t written;
+    if (s->format == NULL) {
+        written = assemble_text(s, first, middle, last, middle_mask, out + *pos, capacity - *pos);
+    } else if (s->format->kind == LINE_FORMAT_RECORDS) {
+        written = assemble_records(first, middle, last, middle_mask, out + *pos, capacity - *pos);
+    } else {
+        written = assemble_formatted(s, first, middle, last, middle_mask, out + *pos, capacity - *pos);
+    }
+    if (written == 0) {
+        *rng = saved;
+        return BLOCK_FULL;
+    }
+    *pos += written;
+    return BLOCK_DONE;
+}
+
+long long sampler_generate(const Sampler *sampler, Rng *rng, char *out, size_t capacity,
+                           long long n, size_t *bytes_written) {
+    IndexKernel indices = index_kernel(current_kernel());
+    size_t pos = 0;
+    long long done = 0;
+
+    // Tunnisteet ja lainattavat nimet kirjoitetaan nimi kerrallaan
+    const LineFormat *format = sampler->format;
+    int blocks = (format == NULL || format->kind == LINE_FORMAT_RECORDS ||
+                  (format->kind != LINE_FORMAT_IDS && !format->escape));
+    while (blocks && n - done >= SAMPLER_BLOCK) {
+        int status = generate_block(sampler, indices, rng, out, capacity, &pos);
+        if (status == BLOCK_FULL) {
+            break;
+        }
+        if (status == BLOCK_REJECTED) {
+            // Harvinainen: lohko nimi kerrallaan, hylkäykset arpovat lisää lukuja
+            long long written = generate_scalar(sampler, rng, out, capacity, SAMPLER_BLOCK, &pos);
+            done += written;
+            if (written < SAMPLER_BLOCK) {
+                *bytes_written = pos;
+                return done;
+            }
+            continue;
+        }
+        done += SAMPLER_BLOCK;
+    }
+    // Loput nimi kerrallaan (myös rivit, jotka mahtuvat täyteen puskuriin)
+    done += generate_scalar(sampler, rng, out, capacity, n - done, &pos);
+
+    *bytes_written = pos;
+    return done;
+}
+
+// --- 4. YKSIKÄSITTEISET NIMET ---
+
+uint64_t sampler_space(const Sampler *sampler) {
+    uint64_t middle_radix = (uint64_t)sampler->middle.count + 1; // Viimeinen = ei keskinimeä
+    uint64_t space;
+    if (__builtin_mul_overflow((uint64_t)sampler->first.count, middle_radix, &space) ||
+        __builtin_mul_overflow(space, (uint64_t)sampler->last.count, &space)) {
+        return 0;
+    }
+    return space;
+}
+
+long long sampler_generate_unique(const Sampler *s, const Permutation *perm, uint64_t first_index,
+                                  char *out, size_t capacity, long long n, size_t *bytes_written) {
+    uint64_t middle_radix = (uint64_t)s->middle.count + 1;
+    size_t pos = 0;
+    long long i = 0;
+    for (; i < n; i++) {
+        // Sekasantainen luku: sukunimi vähiten merkitsevänä, etunimi eniten
+        uint64_t index = permutation_apply(perm, first_index + (uint64_t)i);
+        uint32_t last = name_id(s->last.list, (int)(index % s->last.count));
+        index /= s->last.count;
+        uint64_t middle_index = index % middle_radix;
+        uint32_t first = name_id(s->first.list, (int)(index / middle_radix));
+        int has_middle = (middle_index < s->middle.count);
+        uint32_t middle = has_middle ? name_id(s->middle.list, (int)middle_index) : 0;
+
+        size_t len = emit_line(s, first, has_middle ? &middle : NULL, last, out + pos, capacity - pos);
+        if (len == 0) {
+            break;
+        }
+        pos += len;
+    }
+    *bytes_written = pos;
+    return i;
+}
@@ -0,0 +1,108 @@
+/**
+* @file sampler.h
+* @brief Block sampling kernels (scalar, SSE4.1, AVX2) for assembling name lines.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "condtable.h"
+#include "lineformat.h"
+#include "namelist.h"
+#include "permute.h"
+#include "rng.h"
+
+// Nimiä per lohko vektoroidussa polussa
+#define SAMPLER_BLOCK 16
+
+// Pisin tunnisteina tulostettu rivi: kolme 32-bittistä lukua, kaksi välilyöntiä ja rivinvaihto
+#define SAMPLER_MAX_ID_LINE 33
+
+// Yhden listan otantaparametrit
+typedef struct {
+    const NameList *list;
+    uint32_t count;
+    uint32_t threshold;  // Lemiren hylkäysraja (2^32 - count) % count tasaiselle otannalle
+} SamplerList;
+
+// Etu-, suku- ja keskinimilistat yhdelle vuosikymmenelle
+typedef struct {
+    SamplerList first;
+    SamplerList last;
+    SamplerList middle;
+    int has_middle;
+    const LineFormat *format; // Rivimuoto (NULL = "Etu Keski Suku\n", oletus)
+    const CondTable *cond;    // Keskinimi etunimen mukaan (NULL = riippumaton otanta)
+    const CondRow *cond_rows; // Vuosikymmenen rivit, yksi per etunimilistan paikka
+} Sampler;
+
+// Satunnaislukujen käyttö nimeä kohden on kiinteä, jotta lohkon luvut voidaan
+// arpoa etukäteen: etunimi, sukunimi ja keskinimilistan kanssa kolikko ja
+// keskinimi. Keskinimi arvotaan aina, kolikko vain valitsee, tulostetaanko se.
+// Tasaisen otannan harvinaiset hylkäykset arpovat lisää lukuja samassa
+// järjestyksessä (etu-, suku-, keskinimi). Kaikki ytimet tuottavat täsmälleen
+// saman tulosteen.
+//
+// Otanta tehdään tunnisteilla: arvottu indeksi muunnetaan sarakkeen
+// tunnisteeksi sanakirjaan, ja merkkijono haetaan vasta kirjoitettaessa.
+// Rivin muoto tulee format-kentästä: tunnisteet ("17 4 230"), CSV, JSON Lines
+// tai binääritietueet. Nimet kopioidaan suoraan poolista rivin osien väliin.
+
+// Valmistelee listat (first ja last eivät saa olla tyhjiä, middle saa olla NULL)
+void sampler_init(Sampler *sampler, const NameList *first, const NameList *middle,
+                  const NameList *last);
+
+// Ottaa käyttöön ehdollisen keskinimen: etunimen paikka valitsee taulun
+// sarakkeen column rivin, ja kolikko ja keskinimen luku arvotaan sen mukaan.
+// Lukujen käyttö ei muutu. Sarakkeen rivien määrän on oltava etunimilistan koko.
+void sampler_set_conditional(Sampler *sampler, const CondTable *table, int column);
+
+// Kirjoittaa enintään n riviä "Etunimi [Keskinimi] Sukunimi\n" (tai format-muodossa) puskuriin.
+// Jos seuraava rivi ei mahdu, rng palautetaan sen kohdalle. Palauttaa rivien
+// määrän ja tavut muuttujaan *bytes_written.
+long long sampler_generate(const Sampler *sampler, Rng *rng, char *out, size_t capacity,
+                           long long n, size_t *bytes_written);
+
+// --- YKSIKÄSITTEISET NIMET ---
+// Nimi on sekasantainen luku (etunimi, keskinimi tai ei keskinimeä, sukunimi),
+// ja järjestysnumerot 0, 1, 2, ... kuvataan permutaatiolla näihin lukuihin.
+// Ajon nimet ovat siis kaikki eri yhdistelmiä ilman hajautusjoukkoa. Listojen
+// nimet oletetaan erillisiksi (sanakirjan tunnisteet).
+
+// Yhdistelmien määrä: etunimet * (keskinimet + 1) * sukunimet. 0, jos määrä
+// ei mahdu 64 bittiin.
+uint64_t sampler_space(const Sampler *sampler);
+
+// Kirjoittaa järjestysnumeroiden first_index ... first_index + n - 1 nimet
+// (first_index + n <= perm->domain). Ei käytä satunnaislukuja, joten pala voi
+// alkaa mistä tahansa. Palauttaa rivien määrän kuten sampler_generate.
+long long sampler_generate_unique(const Sampler *sampler, const Permutation *perm, uint64_t first_index,
+                                  char *out, size_t capacity, long long n, size_t *bytes_written);
+
+// Käytössä olevan ytimen nimi: "avx2", "sse4.1" tai "scalar". Ydin valitaan
+// suorittimen mukaan; ympäristömuuttuja NAMEGEN_KERNEL voi pakottaa heikomman.
+const char *sampler_kernel_name(void);
+
+#endif // SAMPLER_H
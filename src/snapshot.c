@@ -0,0 +1,279 @@
+/**
+* @file snapshot.c
+* @brief Binary snapshot of a simulated population that is reopened by mapping it into memory.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <string.h>
+
+#include "snapshot.h"
+
+_Static_assert(sizeof(SnapshotHeader) == 296 && sizeof(SnapshotDictionary) == 32, "snapshot layout changed");
+
+// Osiot alkavat 64 tavun (välimuistirivin) rajalta
+#define SNAPSHOT_ALIGN(x) (((x) + 63) & ~(uint64_t)63)
+
+// Sarakkeiden alkioiden koot tiedoston järjestyksessä
+static const uint32_t COLUMN_SIZES[SNAPSHOT_COLUMNS] = {
+    sizeof(uint16_t), sizeof(uint16_t), sizeof(uint8_t), sizeof(uint32_t), sizeof(uint32_t),
+    sizeof(uint32_t), sizeof(uint32_t), sizeof(uint32_t), sizeof(uint32_t), sizeof(float)
+};
+
+// Funktio palauttaa väestön sarakkeiden osoittimet tiedoston järjestyksessä
+static void column_pointers(const Population *pop, void **columns) {
+    columns[0] = pop->birth_year;
+    columns[1] = pop->death_year;
+    columns[2] = pop->sex;
+    columns[3] = pop->mother;
+    columns[4] = pop->father;
+    columns[5] = pop->spouse;
+    columns[6] = pop->first_name;
+    columns[7] = pop->middle_name;
+    columns[8] = pop->last_name;
+    columns[9] = pop->inbreeding;
+}
+
+// Funktio palauttaa nimien sanakirjat tiedoston järjestyksessä
+static void dictionary_pointers(const PopNames *names, const DecadeData **dictionaries) {
+    dictionaries[0] = &names->first[POP_MALE];
+    dictionaries[1] = &names->first[POP_FEMALE];
+    dictionaries[2] = &names->middle[POP_MALE];
+    dictionaries[3] = &names->middle[POP_FEMALE];
+    dictionaries[4] = &names->last;
+}
+
+// --- 1. KIRJOITTAMINEN ---
+
+// Funktio palauttaa sanakirjan poolista käytetyn osan pituuden (nimet
+// osoittavat ladattuun tiedostoon, jossa on niiden lisäksi muuta)
+static uint64_t used_pool(const DecadeData *data) {
+    if (data->num_decades == 0) {
+        return 0;
+    }
+    const NameList *list = &data->lists[0];
+    uint64_t size = 0;
+    for (uint32_t i = 0; i < data->num_names; i++) {
+        uint64_t end = (uint64_t)list->slices[i].offset + list->slices[i].length;
+        size = (end > size) ? end : size;
+    }
+    return size;
+}
+
+void snapshot_write(OutBuf *out, const Population *pop, const PopNames *names, const PopConfig *config) {
+    static const char zeros[64] = {0};
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.seed = config->seed;
+    header.start_year = config->start_year;
+    header.end_year = config->end_year;
+    header.founders = config->founders;
+    header.count = pop->count;
+    header.first_decade_year = names->first_decade_year;
+
+    // 1. Osioiden paikat
+    uint64_t offset = SNAPSHOT_ALIGN(sizeof(SnapshotHeader));
+    for (int c = 0; c < SNAPSHOT_COLUMNS; c++) {
+        header.columns[c] = offset;
+        offset = SNAPSHOT_ALIGN(offset + (uint64_t)pop->count * COLUMN_SIZES[c]);
+    }
+    const DecadeData *dictionaries[SNAPSHOT_DICTIONARIES];
+    dictionary_pointers(names, dictionaries);
+    for (int d = 0; d < SNAPSHOT_DICTIONARIES; d++) {
+        SnapshotDictionary *dictionary = &header.dictionaries[d];
+        dictionary->num_names = (dictionaries[d]->num_decades > 0) ? dictionaries[d]->num_names : 0;
+        dictionary->pool_size = used_pool(dictionaries[d]);
+        dictionary->slices_offset = offset;
+        offset = SNAPSHOT_ALIGN(offset + (uint64_t)dictionary->num_names * sizeof(NameSlice));
+        dictionary->pool_offset = offset;
+        offset = SNAPSHOT_ALIGN(offset + dictionary->pool_size);
+    }
+    header.file_size = offset;
+
+    // 2. Otsake, sarakkeet ja sanakirjat täytteineen. Sarakkeet ovat puskuria
+    // suurempia, joten ne kirjoitetaan suoraan väestön taulukoista.
+    outbuf_write(out, (const char *)&header, sizeof(header));
+    outbuf_write(out, zeros, (size_t)(header.columns[0] - sizeof(header)));
+    void *columns[SNAPSHOT_COLUMNS];
+    column_pointers(pop, columns);
+    for (int c = 0; c < SNAPSHOT_COLUMNS; c++) {
+        uint64_t size = (uint64_t)pop->count * COLUMN_SIZES[c];
+        OutPiece pieces[2] = {
+            {columns[c], (size_t)size},
+            {zeros, (size_t)(SNAPSHOT_ALIGN(size) - size)},
+        };
+        outbuf_write_pieces(out, pieces, 2);
+    }
+    for (int d = 0; d < SNAPSHOT_DICTIONARIES; d++) {
+        const SnapshotDictionary *dictionary = &header.dictionaries[d];
+        if (dictionary->num_names == 0) {
+            continue;
+        }
+        const NameList *list = &dictionaries[d]->lists[0];
+        uint64_t slices_size = (uint64_t)dictionary->num_names * sizeof(NameSlice);
+        OutPiece pieces[4] = {
+            {list->slices, (size_t)slices_size},
+            {zeros, (size_t)(SNAPSHOT_ALIGN(slices_size) - slices_size)},
+            {list->pool, (size_t)dictionary->pool_size},
+            {zeros, (size_t)(SNAPSHOT_ALIGN(dictionary->pool_size) - dictionary->pool_size)},
+        };
+        outbuf_write_pieces(out, pieces, 4);
+    }
+}
+
+// --- 2. LUKEMINEN ---
+
+// Funktio tarkistaa, että osio [offset, offset + count * size) on tiedoston sisällä
+static int section_fits(const SnapshotHeader *header, uint64_t offset, uint64_t count, uint64_t size) {
+    if (offset % 64 != 0 || offset > header->file_size) {
+        return 0;
+    }
+    return count <= (header->file_size - offset) / size;
+}
+
+// Funktio tarkistaa, että sanakirjan nimet ovat poolin sisällä
+static int valid_dictionary(const NameList *list, uint64_t pool_size) {
+    for (int i = 0; i < list->count; i++) {
+        if ((uint64_t)list->slices[i].offset + list->slices[i].length > pool_size) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Funktio tarkistaa, että nimitunniste on sanakirjassa tai puuttuu (POP_NONE)
+static int valid_name(const DecadeData *data, uint32_t id) {
+    return id == POP_NONE || id < data->num_names;
+}
+
+// Funktio tarkistaa henkilöiden viittaukset yhdellä kierroksella: vanhemmat
+// ovat lasta ennen (molemmat tai kumpikaan eivät puutu), puoliso on
+// väestössä ja nimitunnisteet sukupuolen sanakirjoissa
+static int valid_people(const Population *pop, const PopNames *names) {
+    uint32_t count = pop->count;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t mother = pop->mother[i];
+        uint32_t father = pop->father[i];
+        uint8_t sex = pop->sex[i];
+        if ((mother == POP_NONE) != (father == POP_NONE) ||
+            (mother != POP_NONE && (mother >= i || father >= i)) ||
+            (pop->spouse[i] != POP_NONE && pop->spouse[i] >= count) ||
+            (sex != POP_MALE && sex != POP_FEMALE) ||
+            !valid_name(&names->first[sex], pop->first_name[i]) ||
+            !valid_name(&names->middle[sex], pop->middle_name[i]) ||
+            !valid_name(&names->last, pop->last_name[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int snapshot_open(const char *filename, Snapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    if (map_file(filename, &snapshot->file) != 0) {
+        return NAMELIST_ERR_IO;
+    }
+
+    const SnapshotHeader *header = (const SnapshotHeader *)snapshot->file.data;
+    if (snapshot->file.size < sizeof(SnapshotHeader) ||
+        memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        snapshot_close(snapshot);
+        return NAMELIST_ERR_FORMAT;
+    }
+    if (header->version != SNAPSHOT_VERSION || header->byte_order != SNAPSHOT_BYTE_ORDER) {
+        snapshot_close(snapshot);
+        return NAMELIST_ERR_VERSION;
+    }
+
+    // 1. Osiot ovat tiedoston sisällä
+    int valid = (header->file_size == snapshot->file.size);
+    for (int c = 0; c < SNAPSHOT_COLUMNS && valid; c++) {
+        valid = section_fits(header, header->columns[c], header->count, COLUMN_SIZES[c]);
+    }
+    for (int d = 0; d < SNAPSHOT_DICTIONARIES && valid; d++) {
+        const SnapshotDictionary *dictionary = &header->dictionaries[d];
+        valid = section_fits(header, dictionary->slices_offset, dictionary->num_names, sizeof(NameSlice)) &&
+                section_fits(header, dictionary->pool_offset, dictionary->pool_size, 1) &&
+                dictionary->pool_size <= UINT32_MAX;
+    }
+    if (!valid) {
+        snapshot_close(snapshot);
+        return NAMELIST_ERR_FORMAT;
+    }
+
+    // 2. Sarakkeet sellaisinaan väestöksi
+    const char *base = snapshot->file.data;
+    Population *pop = &snapshot->pop;
+    pop->birth_year = (uint16_t *)(base + header->columns[0]);
+    pop->death_year = (uint16_t *)(base + header->columns[1]);
+    pop->sex = (uint8_t *)(base + header->columns[2]);
+    pop->mother = (uint32_t *)(base + header->columns[3]);
+    pop->father = (uint32_t *)(base + header->columns[4]);
+    pop->spouse = (uint32_t *)(base + header->columns[5]);
+    pop->first_name = (uint32_t *)(base + header->columns[6]);
+    pop->middle_name = (uint32_t *)(base + header->columns[7]);
+    pop->last_name = (uint32_t *)(base + header->columns[8]);
+    pop->inbreeding = (float *)(base + header->columns[9]);
+    pop->count = header->count;
+    pop->capacity = header->count;
+
+    // 3. Sanakirjat yhden sarakkeen DecadeDatoiksi, joiden sanakirja on tiedostossa
+    DecadeData *dictionaries[SNAPSHOT_DICTIONARIES] = {
+        &snapshot->names.first[POP_MALE], &snapshot->names.first[POP_FEMALE],
+        &snapshot->names.middle[POP_MALE], &snapshot->names.middle[POP_FEMALE], &snapshot->names.last
+    };
+    for (int d = 0; d < SNAPSHOT_DICTIONARIES; d++) {
+        const SnapshotDictionary *dictionary = &header->dictionaries[d];
+        NameList *list = &snapshot->lists[d];
+        list->pool = base + dictionary->pool_offset;
+        list->slices = (const NameSlice *)(base + dictionary->slices_offset);
+        list->count = (int)dictionary->num_names;
+        snapshot->labels[d] = "";
+        dictionaries[d]->lists = list;
+        dictionaries[d]->decades = &snapshot->labels[d];
+        dictionaries[d]->num_decades = 1;
+        dictionaries[d]->num_names = dictionary->num_names;
+    }
+    snapshot->names.first_decade_year = header->first_decade_year;
+
+    snapshot->config.seed = header->seed;
+    snapshot->config.start_year = header->start_year;
+    snapshot->config.end_year = header->end_year;
+    snapshot->config.founders = header->founders;
+    snapshot->header = header;
+    return NAMELIST_OK;
+}
+
+int snapshot_verify(const Snapshot *snapshot) {
+    for (int d = 0; d < SNAPSHOT_DICTIONARIES; d++) {
+        if (!valid_dictionary(&snapshot->lists[d], snapshot->header->dictionaries[d].pool_size)) {
+            return NAMELIST_ERR_FORMAT;
+        }
+    }
+    return valid_people(&snapshot->pop, &snapshot->names) ? NAMELIST_OK : NAMELIST_ERR_FORMAT;
+}
+
+void snapshot_close(Snapshot *snapshot) {
+    unmap_file(&snapshot->file);
+    memset(snapshot, 0, sizeof(*snapshot));
+}
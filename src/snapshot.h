@@ -0,0 +1,110 @@
+/**
+* @file snapshot.h
+* @brief Binary snapshot of a simulated population that is reopened by mapping it into memory.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+
+#include "csvscan.h"
+#include "namelist.h"
+#include "outbuf.h"
+#include "population.h"
+
+#define SNAPSHOT_MAGIC "GSSNAPSH"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+// Sarakkeet ja sanakirjat tiedostossa tässä järjestyksessä
+#define SNAPSHOT_COLUMNS 10
+#define SNAPSHOT_DICTIONARIES 5   // Miesten ja naisten etunimet ja keskinimet, sukunimet
+
+// --- TIEDOSTOMUOTO ---
+// Luvut ovat kirjoittajan tavujärjestyksessä ja osiot alkavat 64 tavun
+// rajalta, joten kuvatun tiedoston sarakkeet kelpaavat sellaisenaan
+// Population-rakenteen taulukoiksi. Avaaminen ei lue henkilöitä eikä nimiä.
+//
+//   SnapshotHeader
+//   sarakkeet:    birth_year, death_year (uint16), sex (uint8), mother, father,
+//                 spouse, first_name, middle_name, last_name (uint32), inbreeding (float)
+//   sanakirjat:   NameSlice[num_names] ja char pool[pool_size] kukin
+//
+// Nimitunnisteet ovat samat kuin simulaation nimitiedostojen sanakirjoissa,
+// ja tiedostossa on näiden sanakirjojen osat, joihin tunnisteet viittaavat.
+
+typedef struct {
+    uint64_t slices_offset;   // NameSlice[num_names]
+    uint64_t pool_offset;
+    uint64_t pool_size;
+    uint32_t num_names;
+    uint32_t reserved;
+} SnapshotDictionary;
+
+typedef struct {
+    char magic[8];            // SNAPSHOT_MAGIC
+    uint32_t version;         // SNAPSHOT_VERSION
+    uint32_t byte_order;      // SNAPSHOT_BYTE_ORDER kirjoittajan tavujärjestyksessä
+    uint64_t file_size;       // Koko tiedoston pituus
+    uint64_t seed;            // Simulaation asetukset
+    int32_t start_year;
+    int32_t end_year;
+    uint32_t founders;
+    uint32_t count;           // Henkilöitä
+    int32_t first_decade_year;
+    uint32_t reserved;
+    uint64_t columns[SNAPSHOT_COLUMNS];   // Sarakkeiden paikat tiedoston alusta
+    SnapshotDictionary dictionaries[SNAPSHOT_DICTIONARIES];
+} SnapshotHeader;
+
+// Avattu tilannevedos: väestön sarakkeet ja nimien sanakirjat osoittavat
+// suoraan kuvattuun tiedostoon. Väestö on vain luettavissa, eikä sitä saa
+// vapauttaa population_free-funktiolla eikä nimiä pop_names_free-funktiolla.
+typedef struct {
+    MappedFile file;
+    const SnapshotHeader *header;
+    Population pop;
+    PopNames names;
+    PopConfig config;         // seed, start_year, end_year ja founders
+    NameList lists[SNAPSHOT_DICTIONARIES];
+    const char *labels[SNAPSHOT_DICTIONARIES];
+} Snapshot;
+
+// Kirjoittaa väestön ja sen nimien sanakirjat. Sarakkeet kirjoitetaan suoraan
+// väestön taulukoista kokoavilla kirjoituksilla ilman kopiointia. Virhe jää
+// puskurin error-kenttään.
+void snapshot_write(OutBuf *out, const Population *pop, const PopNames *names, const PopConfig *config);
+
+// Kuvaa tilannevedoksen muistiin ja tarkistaa sen rakenteen. Palauttaa
+// NAMELIST_OK tai virhekoodin (NAMELIST_ERR_IO, _FORMAT tai _VERSION).
+int snapshot_open(const char *filename, Snapshot *snapshot);
+
+// Käy avatun tilannevedoksen henkilöt läpi: vanhemmat ennen lasta, puoliso
+// väestössä, nimitunnisteet sanakirjoissa ja nimet pooleissa. Haut ja vienti
+// eivät tarkista näitä, joten epävarma tiedosto tarkistetaan ensin (genesim
+// --verify). Palauttaa NAMELIST_OK tai NAMELIST_ERR_FORMAT.
+int snapshot_verify(const Snapshot *snapshot);
+
+void snapshot_close(Snapshot *snapshot);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,216 @@
+/**
+* @file stats.c
+* @brief Run-time switchable phase timers, counters and a batch latency histogram.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <time.h>
+
+#include "stats.h"
+
+int stats_enabled = 0;
+
+// Vaiheen summa-aika ja kutsujen määrä
+typedef struct {
+    uint64_t ns;
+    uint64_t calls;
+} StatsTimer;
+
+static StatsTimer timers[STATS_NUM_PHASES];
+static uint64_t counters[STATS_NUM_COUNTERS];
+static uint64_t histogram[STATS_HISTOGRAM_BUCKETS];
+
+static const char *const phase_names[STATS_NUM_PHASES] = {
+    "map", "normalize", "parse", "pack", "weights", "generate", "wait", "write"
+};
+
+static const char *const counter_names[STATS_NUM_COUNTERS] = {
+    "files", "file_bytes", "rows", "allocs", "alloc_bytes", "batches", "names", "output_bytes"
+};
+
+// --- 1. KERÄYS ---
+
+void stats_enable(int on) {
+    if (on) {
+        for (int i = 0; i < STATS_NUM_PHASES; i++) {
+            timers[i].ns = 0;
+            timers[i].calls = 0;
+        }
+        for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+            counters[i] = 0;
+        }
+        for (int i = 0; i < STATS_HISTOGRAM_BUCKETS; i++) {
+            histogram[i] = 0;
+        }
+    }
+    __atomic_store_n(&stats_enabled, on ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+uint64_t stats_now_ns(void) {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void stats_add_time(StatsPhase phase, uint64_t ns) {
+    __atomic_fetch_add(&timers[phase].ns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&timers[phase].calls, 1, __ATOMIC_RELAXED);
+}
+
+void stats_add(StatsCounter counter, uint64_t value) {
+    __atomic_fetch_add(&counters[counter], value, __ATOMIC_RELAXED);
+}
+
+// Funktio palauttaa histogrammin lokeron: bittien määrä (0 ns -> 0)
+static int bucket_of(uint64_t ns) {
+    int bucket = 0;
+    while (ns != 0 && bucket < STATS_HISTOGRAM_BUCKETS - 1) {
+        ns >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void stats_add_batch(uint64_t ns) {
+    __atomic_fetch_add(&counters[STATS_BATCHES], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram[bucket_of(ns)], 1, __ATOMIC_RELAXED);
+}
+
+// --- 2. RAPORTTI ---
+
+// Lokeron yläraja nanosekunteina (lokero k: alle 2^k ns)
+static uint64_t bucket_limit(int bucket) {
+    return (uint64_t)1 << bucket;
+}
+
+// Funktio arvioi persentiilin lokeron ylärajana (0, jos paloja ei ole)
+static uint64_t percentile(double fraction) {
+    uint64_t total = counters[STATS_BATCHES];
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(fraction * (double)total);
+    if (target >= total) {
+        target = total - 1;
+    }
+    uint64_t seen = 0;
+    for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        seen += histogram[b];
+        if (seen > target) {
+            return bucket_limit(b);
+        }
+    }
+    return bucket_limit(STATS_HISTOGRAM_BUCKETS - 1);
+}
+
+// Funktio muotoilee keston luettavaksi (ns, µs, ms tai s)
+static void format_duration(char *out, size_t size, uint64_t ns) {
+    if (ns < 1000ULL) {
+        snprintf(out, size, "%llu ns", (unsigned long long)ns);
+    } else if (ns < 1000000ULL) {
+        snprintf(out, size, "%.0f us", (double)ns / 1e3);
+    } else if (ns < 1000000000ULL) {
+        snprintf(out, size, "%.0f ms", (double)ns / 1e6);
+    } else {
+        snprintf(out, size, "%.1f s", (double)ns / 1e9);
+    }
+}
+
+static void print_table(FILE *out) {
+    fprintf(out, "--- Statistics ---\n");
+    fprintf(out, "%-12s %12s %10s\n", "phase", "seconds", "calls");
+    for (int i = 0; i < STATS_NUM_PHASES; i++) {
+        if (timers[i].calls > 0) {
+            fprintf(out, "%-12s %12.6f %10llu\n", phase_names[i], (double)timers[i].ns / 1e9,
+                    (unsigned long long)timers[i].calls);
+        }
+    }
+
+    fprintf(out, "\n%-12s %22s\n", "counter", "value");
+    for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+        fprintf(out, "%-12s %22llu\n", counter_names[i], (unsigned long long)counters[i]);
+    }
+
+    if (counters[STATS_BATCHES] == 0) {
+        return;
+    }
+    char p50[32], p90[32], p99[32];
+    format_duration(p50, sizeof(p50), percentile(0.50));
+    format_duration(p90, sizeof(p90), percentile(0.90));
+    format_duration(p99, sizeof(p99), percentile(0.99));
+    fprintf(out, "\nBatch latency (p50 < %s, p90 < %s, p99 < %s)\n", p50, p90, p99);
+
+    uint64_t largest = 0;
+    for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        if (histogram[b] > largest) {
+            largest = histogram[b];
+        }
+    }
+    for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        if (histogram[b] == 0) {
+            continue;
+        }
+        char limit[32];
+        format_duration(limit, sizeof(limit), bucket_limit(b));
+        int bar = (int)(histogram[b] * 40 / largest);
+        fprintf(out, "  < %-8s %10llu ", limit, (unsigned long long)histogram[b]);
+        for (int i = 0; i < (bar > 0 ? bar : 1); i++) {
+            fputc('#', out);
+        }
+        fputc('\n', out);
+    }
+}
+
+static void print_json(FILE *out) {
+    fprintf(out, "{\"phases\": {");
+    for (int i = 0; i < STATS_NUM_PHASES; i++) {
+        fprintf(out, "%s\"%s\": {\"seconds\": %.9f, \"calls\": %llu}", (i > 0) ? ", " : "", phase_names[i],
+                (double)timers[i].ns / 1e9, (unsigned long long)timers[i].calls);
+    }
+    fprintf(out, "}, \"counters\": {");
+    for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+        fprintf(out, "%s\"%s\": %llu", (i > 0) ? ", " : "", counter_names[i], (unsigned long long)counters[i]);
+    }
+    fprintf(out, "}, \"batch_latency_ns\": {\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"buckets\": [",
+            (unsigned long long)percentile(0.50), (unsigned long long)percentile(0.90),
+            (unsigned long long)percentile(0.99));
+    int first = 1;
+    for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        if (histogram[b] > 0) {
+            fprintf(out, "%s{\"lt\": %llu, \"count\": %llu}", first ? "" : ", ",
+                    (unsigned long long)bucket_limit(b), (unsigned long long)histogram[b]);
+            first = 0;
+        }
+    }
+    fprintf(out, "]}}\n");
+}
+
+void stats_print(FILE *out, int json) {
+    if (json) {
+        print_json(out);
+    } else {
+        print_table(out);
+    }
+}
@@ -0,0 +1,121 @@
+/**
+* @file stats.h
+* @brief Run-time switchable phase timers, counters and a batch latency histogram.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Mittaukset kootaan prosessin yhteisiin laskureihin (atomiset lisäykset), ja ne
+// ovat oletuksena pois päältä. Mittauspisteet ovat tiedosto-, pala- ja
+// kirjoitustasolla, eivät nimikohtaisessa silmukassa, joten pois kytketty
+// mittaus maksaa yhden ennustettavan haarautumisen per pala. Käännöslippu
+// -DNAMEGEN_NO_STATS poistaa mittauspisteet kokonaan.
+
+// Vaiheet (ajat summataan kaikista säikeistä)
+typedef enum {
+    STATS_MAP,         // Tiedoston avaus ja kuvaus muistiin
+    STATS_NORMALIZE,   // Merkistön tunnistus ja normalisointi (utf8norm.c)
+    STATS_PARSE,       // Rivien ja kenttien jäsennys
+    STATS_PACK,        // Sanakirja ja listojen kokoaminen lohkoiksi
+    STATS_WEIGHTS,     // Alias-taulut
+    STATS_GENERATE,    // Nimien generointi paloittain (säikeiden summa)
+    STATS_WAIT,        // Kirjoittaja odottaa seuraavaa palaa
+    STATS_WRITE,       // Tulosteen kirjoitus (fwrite tai koottu writev)
+    STATS_NUM_PHASES
+} StatsPhase;
+
+// Laskurit
+typedef enum {
+    STATS_FILES,         // Avatut tiedostot
+    STATS_FILE_BYTES,    // Tiedostojen koko yhteensä
+    STATS_ROWS,          // Jäsennetyt rivit
+    STATS_ALLOCS,        // Latauksen muistivaraukset
+    STATS_ALLOC_BYTES,   // Latauksen varaamat tavut
+    STATS_BATCHES,       // Generoidut palat
+    STATS_NAMES,         // Generoidut nimet
+    STATS_OUTPUT_BYTES,  // Kirjoitetut tavut
+    STATS_NUM_COUNTERS
+} StatsCounter;
+
+// Palan kesto -histogrammi: lokero k kattaa välin [2^(k-1), 2^k) ns
+#define STATS_HISTOGRAM_BUCKETS 48
+
+// Onko mittaus päällä (stats_enable). Luetaan suoraan mittauspisteissä.
+extern int stats_enabled;
+
+#ifdef NAMEGEN_NO_STATS
+#define STATS_ON 0
+#elif defined(_MSC_VER)
+#define STATS_ON (stats_enabled)
+#else
+#define STATS_ON (__builtin_expect(stats_enabled, 0))
+#endif
+
+// Kytkee mittauksen päälle tai pois. Päälle kytkettäessä laskurit nollataan.
+void stats_enable(int on);
+
+// Monotoninen kello nanosekunteina
+uint64_t stats_now_ns(void);
+
+// Lisäysfunktiot (säieturvallisia); kutsutaan mittauspisteiden kautta
+void stats_add_time(StatsPhase phase, uint64_t ns);
+void stats_add(StatsCounter counter, uint64_t value);
+void stats_add_batch(uint64_t ns);
+
+// Tulostaa raportin taulukkona tai JSON-objektina (json != 0)
+void stats_print(FILE *out, int json);
+
+// --- MITTAUSPISTEET ---
+
+// Vaiheen alku: palauttaa aikaleiman, tai 0, jos mittaus on pois päältä
+static inline uint64_t stats_begin(void) {
+    return STATS_ON ? stats_now_ns() : 0;
+}
+
+// Vaiheen loppu: lisää vaiheeseen stats_begin-kutsusta kuluneen ajan
+static inline void stats_end(StatsPhase phase, uint64_t start) {
+    if (STATS_ON) {
+        stats_add_time(phase, stats_now_ns() - start);
+    }
+}
+
+static inline void stats_count(StatsCounter counter, uint64_t value) {
+    if (STATS_ON) {
+        stats_add(counter, value);
+    }
+}
+
+// Palan loppu: vaiheaika, histogrammi sekä pala- ja nimilaskurit
+static inline void stats_end_batch(uint64_t start, uint64_t names) {
+    if (STATS_ON) {
+        uint64_t ns = stats_now_ns() - start;
+        stats_add_time(STATS_GENERATE, ns);
+        stats_add_batch(ns);
+        stats_add(STATS_NAMES, names);
+    }
+}
+
+#endif // STATS_H
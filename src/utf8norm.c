@@ -0,0 +1,427 @@
+/**
+* @file utf8norm.c
+* @brief Encoding detection, UTF-8 transcoding and normalisation of loaded name files.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UTF8NORM_SSE2 1
+#endif
+
+#include "utf8norm.h"
+
+// --- 1. TAULUT ---
+
+// Yhdistelmämerkki ja ASCII-kirjain -> valmis merkki, järjestetty (mark, base) mukaan
+typedef struct {
+    uint16_t mark;
+    char base;
+    uint16_t composed;
+} Composition;
+
+static const Composition compositions[] = {
+    {0x0300, 'A', 0x00c0}, // À
+    {0x0300, 'E', 0x00c8}, // È
+    {0x0300, 'I', 0x00cc}, // Ì
+    {0x0300, 'O', 0x00d2}, // Ò
+    {0x0300, 'U', 0x00d9}, // Ù
+    {0x0300, 'a', 0x00e0}, // à
+    {0x0300, 'e', 0x00e8}, // è
+    {0x0300, 'i', 0x00ec}, // ì
+    {0x0300, 'o', 0x00f2}, // ò
+    {0x0300, 'u', 0x00f9}, // ù
+    {0x0301, 'A', 0x00c1}, // Á
+    {0x0301, 'C', 0x0106}, // Ć
+    {0x0301, 'E', 0x00c9}, // É
+    {0x0301, 'I', 0x00cd}, // Í
+    {0x0301, 'L', 0x0139}, // Ĺ
+    {0x0301, 'N', 0x0143}, // Ń
+    {0x0301, 'O', 0x00d3}, // Ó
+    {0x0301, 'R', 0x0154}, // Ŕ
+    {0x0301, 'S', 0x015a}, // Ś
+    {0x0301, 'U', 0x00da}, // Ú
+    {0x0301, 'Y', 0x00dd}, // Ý
+    {0x0301, 'Z', 0x0179}, // Ź
+    {0x0301, 'a', 0x00e1}, // á
+    {0x0301, 'c', 0x0107}, // ć
+    {0x0301, 'e', 0x00e9}, // é
+    {0x0301, 'i', 0x00ed}, // í
+    {0x0301, 'l', 0x013a}, // ĺ
+    {0x0301, 'n', 0x0144}, // ń
+    {0x0301, 'o', 0x00f3}, // ó
+    {0x0301, 'r', 0x0155}, // ŕ
+    {0x0301, 's', 0x015b}, // ś
+    {0x0301, 'u', 0x00fa}, // ú
+    {0x0301, 'y', 0x00fd}, // ý
+    {0x0301, 'z', 0x017a}, // ź
+    {0x0302, 'A', 0x00c2}, // Â
+    {0x0302, 'C', 0x0108}, // Ĉ
+    {0x0302, 'E', 0x00ca}, // Ê
+    {0x0302, 'G', 0x011c}, // Ĝ
+    {0x0302, 'H', 0x0124}, // Ĥ
+    {0x0302, 'I', 0x00ce}, // Î
+    {0x0302, 'J', 0x0134}, // Ĵ
+    {0x0302, 'O', 0x00d4}, // Ô
+    {0x0302, 'S', 0x015c}, // Ŝ
+    {0x0302, 'U', 0x00db}, // Û
+    {0x0302, 'W', 0x0174}, // Ŵ
+    {0x0302, 'Y', 0x0176}, // Ŷ
+    {0x0302, 'a', 0x00e2}, // â
+    {0x0302, 'c', 0x0109}, // ĉ
+    {0x0302, 'e', 0x00ea}, // ê
+    {0x0302, 'g', 0x011d}, // ĝ
+    {0x0302, 'h', 0x0125}, // ĥ
+    {0x0302, 'i', 0x00ee}, // î
+    {0x0302, 'j', 0x0135}, // ĵ
+    {0x0302, 'o', 0x00f4}, // ô
+    {0x0302, 's', 0x015d}, // ŝ
+    {0x0302, 'u', 0x00fb}, // û
+    {0x0302, 'w', 0x0175}, // ŵ
+    {0x0302, 'y', 0x0177}, // ŷ
+    {0x0303, 'A', 0x00c3}, // Ã
+    {0x0303, 'I', 0x0128}, // Ĩ
+    {0x0303, 'N', 0x00d1}, // Ñ
+    {0x0303, 'O', 0x00d5}, // Õ
+    {0x0303, 'U', 0x0168}, // Ũ
+    {0x0303, 'a', 0x00e3}, // ã
+    {0x0303, 'i', 0x0129}, // ĩ
+    {0x0303, 'n', 0x00f1}, // ñ
+    {0x0303, 'o', 0x00f5}, // õ
+    {0x0303, 'u', 0x0169}, // ũ
+    {0x0304, 'A', 0x0100}, // Ā
+    {0x0304, 'E', 0x0112}, // Ē
+    {0x0304, 'I', 0x012a}, // Ī
+    {0x0304, 'O', 0x014c}, // Ō
+    {0x0304, 'U', 0x016a}, // Ū
+    {0x0304, 'a', 0x0101}, // ā
+    {0x0304, 'e', 0x0113}, // ē
+    {0x0304, 'i', 0x012b}, // ī
+    {0x0304, 'o', 0x014d}, // ō
+    {0x0304, 'u', 0x016b}, // ū
+    {0x0306, 'A', 0x0102}, // Ă
+    {0x0306, 'E', 0x0114}, // Ĕ
+    {0x0306, 'G', 0x011e}, // Ğ
+    {0x0306, 'I', 0x012c}, // Ĭ
+    {0x0306, 'O', 0x014e}, // Ŏ
+    {0x0306, 'U', 0x016c}, // Ŭ
+    {0x0306, 'a', 0x0103}, // ă
+    {0x0306, 'e', 0x0115}, // ĕ
+    {0x0306, 'g', 0x011f}, // ğ
+    {0x0306, 'i', 0x012d}, // ĭ
+    {0x0306, 'o', 0x014f}, // ŏ
+    {0x0306, 'u', 0x016d}, // ŭ
+    {0x0307, 'C', 0x010a}, // Ċ
+    {0x0307, 'E', 0x0116}, // Ė
+    {0x0307, 'G', 0x0120}, // Ġ
+    {0x0307, 'I', 0x0130}, // İ
+    {0x0307, 'Z', 0x017b}, // Ż
+    {0x0307, 'c', 0x010b}, // ċ
+    {0x0307, 'e', 0x0117}, // ė
+    {0x0307, 'g', 0x0121}, // ġ
+    {0x0307, 'z', 0x017c}, // ż
+    {0x0308, 'A', 0x00c4}, // Ä
+    {0x0308, 'E', 0x00cb}, // Ë
+    {0x0308, 'I', 0x00cf}, // Ï
+    {0x0308, 'O', 0x00d6}, // Ö
+    {0x0308, 'U', 0x00dc}, // Ü
+    {0x0308, 'Y', 0x0178}, // Ÿ
+    {0x0308, 'a', 0x00e4}, // ä
+    {0x0308, 'e', 0x00eb}, // ë
+    {0x0308, 'i', 0x00ef}, // ï
+    {0x0308, 'o', 0x00f6}, // ö
+    {0x0308, 'u', 0x00fc}, // ü
+    {0x0308, 'y', 0x00ff}, // ÿ
+    {0x030a, 'A', 0x00c5}, // Å
+    {0x030a, 'U', 0x016e}, // Ů
+    {0x030a, 'a', 0x00e5}, // å
+    {0x030a, 'u', 0x016f}, // ů
+    {0x030b, 'O', 0x0150}, // Ő
+    {0x030b, 'U', 0x0170}, // Ű
+    {0x030b, 'o', 0x0151}, // ő
+    {0x030b, 'u', 0x0171}, // ű
+    {0x030c, 'C', 0x010c}, // Č
+    {0x030c, 'D', 0x010e}, // Ď
+    {0x030c, 'E', 0x011a}, // Ě
+    {0x030c, 'L', 0x013d}, // Ľ
+    {0x030c, 'N', 0x0147}, // Ň
+    {0x030c, 'R', 0x0158}, // Ř
+    {0x030c, 'S', 0x0160}, // Š
+    {0x030c, 'T', 0x0164}, // Ť
+    {0x030c, 'Z', 0x017d}, // Ž
+    {0x030c, 'c', 0x010d}, // č
+    {0x030c, 'd', 0x010f}, // ď
+    {0x030c, 'e', 0x011b}, // ě
+    {0x030c, 'l', 0x013e}, // ľ
+    {0x030c, 'n', 0x0148}, // ň
+    {0x030c, 'r', 0x0159}, // ř
+    {0x030c, 's', 0x0161}, // š
+    {0x030c, 't', 0x0165}, // ť
+    {0x030c, 'z', 0x017e}, // ž
+    {0x0327, 'C', 0x00c7}, // Ç
+    {0x0327, 'G', 0x0122}, // Ģ
+    {0x0327, 'K', 0x0136}, // Ķ
+    {0x0327, 'L', 0x013b}, // Ļ
+    {0x0327, 'N', 0x0145}, // Ņ
+    {0x0327, 'R', 0x0156}, // Ŗ
+    {0x0327, 'S', 0x015e}, // Ş
+    {0x0327, 'T', 0x0162}, // Ţ
+    {0x0327, 'c', 0x00e7}, // ç
+    {0x0327, 'g', 0x0123}, // ģ
+    {0x0327, 'k', 0x0137}, // ķ
+    {0x0327, 'l', 0x013c}, // ļ
+    {0x0327, 'n', 0x0146}, // ņ
+    {0x0327, 'r', 0x0157}, // ŗ
+    {0x0327, 's', 0x015f}, // ş
+    {0x0327, 't', 0x0163}, // ţ
+    {0x0328, 'A', 0x0104}, // Ą
+    {0x0328, 'E', 0x0118}, // Ę
+    {0x0328, 'I', 0x012e}, // Į
+    {0x0328, 'U', 0x0172}, // Ų
+    {0x0328, 'a', 0x0105}, // ą
+    {0x0328, 'e', 0x0119}, // ę
+    {0x0328, 'i', 0x012f}, // į
+    {0x0328, 'u', 0x0173}, // ų
+};
+
+// Windows-1252:n merkit 0x80-0x9F (0 = määrittelemätön, jätetään pois)
+static const uint16_t cp1252[32] = {
+    0x20ac, 0, 0x201a, 0x0192, 0x201e, 0x2026, 0x2020, 0x2021,
+    0x02c6, 0x2030, 0x0160, 0x2039, 0x0152, 0, 0x017d, 0,
+    0, 0x2018, 0x2019, 0x201c, 0x201d, 0x2022, 0x2013, 0x2014,
+    0x02dc, 0x2122, 0x0161, 0x203a, 0x0153, 0, 0x017e, 0x0178
+};
+
+// --- 2. MERKIT ---
+
+// Funktio palauttaa alun ASCII-tavujen määrän (16 tavua kerrallaan)
+static size_t ascii_run(const unsigned char *p, size_t n) {
+    size_t i = 0;
+#ifdef UTF8NORM_SSE2
+    for (; i + 16 <= n; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(p + i)));
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    while (i < n && p[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+// Funktio purkaa UTF-8-merkin (p[0] >= 0x80). Palauttaa pituuden tai 0, jos
+// jono on virheellinen (katkennut, ylipitkä, korvike tai yli U+10FFFF).
+static size_t utf8_decode(const unsigned char *p, size_t n, uint32_t *cp) {
+    size_t length;
+    uint32_t value, min;
+    if (p[0] >= 0xc2 && p[0] <= 0xdf) {
+        length = 2; value = p[0] & 0x1fu; min = 0x80;
+    } else if (p[0] >= 0xe0 && p[0] <= 0xef) {
+        length = 3; value = p[0] & 0x0fu; min = 0x800;
+    } else if (p[0] >= 0xf0 && p[0] <= 0xf4) {
+        length = 4; value = p[0] & 0x07u; min = 0x10000;
+    } else {
+        return 0;
+    }
+    if (length > n) {
+        return 0;
+    }
+    for (size_t k = 1; k < length; k++) {
+        if ((p[k] & 0xc0) != 0x80) {
+            return 0;
+        }
+        value = (value << 6) | (p[k] & 0x3fu);
+    }
+    if (value < min || value > 0x10ffff || (value >= 0xd800 && value <= 0xdfff)) {
+        return 0;
+    }
+    *cp = value;
+    return length;
+}
+
+// Funktio kirjoittaa merkin UTF-8:na ja palauttaa pituuden
+static size_t utf8_encode(char *out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xc0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3f));
+        return 2;
+    }
+    out[0] = (char)(0xe0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+    out[2] = (char)(0x80 | (cp & 0x3f));
+    return 3; // Latin-1 ja Windows-1252 eivät tarvitse neljää tavua
+}
+
+static int is_invisible(uint32_t cp) {
+    return cp == 0x00ad || cp == 0x034f || (cp >= 0x200b && cp <= 0x200f) || cp == 0x2060 || cp == 0xfeff;
+}
+
+static int is_combining(uint32_t cp) {
+    return cp >= 0x0300 && cp <= 0x036f;
+}
+
+// Funktio etsii valmiin merkin (0 = ei ole) binäärihaulla
+static uint32_t compose(uint32_t mark, char base) {
+    size_t low = 0, high = sizeof(compositions) / sizeof(compositions[0]);
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        const Composition *c = &compositions[mid];
+        if (c->mark == mark && c->base == base) {
+            return c->composed;
+        }
+        if (c->mark < mark || (c->mark == mark && c->base < base)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return 0;
+}
+
+// --- 3. MUUNNOKSET ---
+
+// Funktio kirjoittaa UTF-8-tekstin kohdasta start alkaen normalisoituna.
+// Palauttaa kirjoitetun pituuden tai SIZE_MAX, jos vastaan tulee virheellinen jono.
+static size_t rewrite_utf8(const unsigned char *p, size_t size, size_t start, char *out) {
+    size_t o = start;
+    memcpy(out, p, start);
+    size_t i = start;
+    while (i < size) {
+        size_t run = ascii_run(p + i, size - i);
+        memcpy(out + o, p + i, run);
+        o += run;
+        i += run;
+        if (i == size) {
+            break;
+        }
+
+        uint32_t cp;
+        size_t length = utf8_decode(p + i, size - i, &cp);
+        if (length == 0) {
+            return SIZE_MAX;
+        }
+        i += length;
+        if (is_invisible(cp)) {
+            continue;
+        }
+        if (is_combining(cp) && o > 0 && (unsigned char)out[o - 1] < 0x80) {
+            uint32_t composed = compose(cp, out[o - 1]);
+            if (composed != 0) {
+                o--;
+                o += utf8_encode(out + o, composed);
+                continue;
+            }
+        }
+        memcpy(out + o, p + i - length, length);
+        o += length;
+    }
+    return o;
+}
+
+// Funktio muuntaa Latin-1-tekstin (kohdasta start alkaen, alku on ASCIIa) UTF-8:ksi
+static size_t rewrite_latin1(const unsigned char *p, size_t size, size_t start, char *out) {
+    size_t o = start;
+    memcpy(out, p, start);
+    size_t i = start;
+    while (i < size) {
+        size_t run = ascii_run(p + i, size - i);
+        memcpy(out + o, p + i, run);
+        o += run;
+        i += run;
+        if (i == size) {
+            break;
+        }
+        uint32_t cp = (p[i] < 0xa0) ? cp1252[p[i] - 0x80] : p[i];
+        i++;
+        if (cp != 0 && !is_invisible(cp)) {
+            o += utf8_encode(out + o, cp);
+        }
+    }
+    return o;
+}
+
+// --- 4. TARKISTUS JA NORMALISOINTI ---
+
+int utf8_normalize(const char *data, size_t size, char **out, size_t *out_size, int *encoding) {
+    const unsigned char *p = (const unsigned char *)data;
+    *out = NULL;
+    *out_size = size;
+    *encoding = TEXT_ENCODING_UTF8;
+
+    // 1. Luetaan, kunnes vastaan tulee korjattava kohta
+    size_t first_non_ascii = size;
+    size_t dirty = size;
+    int latin1 = 0;
+    size_t i = 0;
+    while (i < size) {
+        i += ascii_run(p + i, size - i);
+        if (i == size) {
+            break;
+        }
+        if (first_non_ascii == size) {
+            first_non_ascii = i;
+        }
+        uint32_t cp;
+        size_t length = utf8_decode(p + i, size - i, &cp);
+        if (length == 0) {
+            latin1 = 1;
+            break;
+        }
+        if (is_invisible(cp) || is_combining(cp)) {
+            dirty = i;
+            break;
+        }
+        i += length;
+    }
+    if (!latin1 && dirty == size) {
+        return 0; // Puhdas UTF-8: ei kopiota
+    }
+
+    // 2. Kopio: UTF-8 ei kasva, Latin-1 enintään kolminkertaiseksi (Windows-1252:n €)
+    char *buffer = (char *)malloc(size * 3 + UTF8NORM_PADDING);
+    if (buffer == NULL) {
+        return -1;
+    }
+    size_t length = SIZE_MAX;
+    if (!latin1) {
+        length = rewrite_utf8(p, size, dirty, buffer);
+    }
+    if (length == SIZE_MAX) {
+        *encoding = TEXT_ENCODING_LATIN1;
+        length = rewrite_latin1(p, size, first_non_ascii, buffer);
+    }
+
+    memset(buffer + length, 0, UTF8NORM_PADDING);
+    char *shrunk = (char *)realloc(buffer, length + UTF8NORM_PADDING);
+    *out = (shrunk != NULL) ? shrunk : buffer;
+    *out_size = length;
+    return 1;
+}
@@ -0,0 +1,55 @@
+/**
+* @file utf8norm.h
+* @brief Encoding detection, UTF-8 transcoding and normalisation of loaded name files.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef UTF8NORM_H
+#define UTF8NORM_H
+
+#include <stddef.h>
+
+// Tiedoston havaittu merkistö
+#define TEXT_ENCODING_UTF8 0     // UTF-8 (myös pelkkä ASCII)
+#define TEXT_ENCODING_LATIN1 1   // Latin-1 (0x80-0x9F luetaan Windows-1252:na)
+
+#define UTF8NORM_PADDING 16
+
+// Latausvaihe, jonka jälkeen nimet ovat aina kelvollista NFC-muotoista UTF-8:aa
+// ilman näkymättömiä merkkejä, joten tulostus voi kopioida tavut tarkistamatta.
+//
+// Tiedosto käydään läpi kerran: ASCII-jaksot ohitetaan 16 tavua kerrallaan
+// (SSE2), ja vain muut merkit puretaan. Jos tiedosto on jo puhdas, kopiota ei
+// tehdä. Ensimmäisestä korjattavasta kohdasta alkaen kirjoitetaan kopio:
+// - virheellinen UTF-8-jono: koko tiedosto luetaan Latin-1:nä ja muunnetaan
+// - tavutusvihje U+00AD, U+034F, U+200B-U+200F, U+2060 ja U+FEFF (BOM) poistetaan
+// - yhdistelmämerkki (U+0300-U+036F) yhdistetään edeltävään kirjaimeen
+//   valmiiksi merkiksi, jos sellainen on välillä U+00C0-U+017F ("a" + U+0308 -> "ä").
+//   Muita NFC-sääntöjä latinalaisille nimille ei tarvita.
+//
+// Palauttaa 0, jos teksti kelpaa sellaisenaan (*out = NULL), 1, jos *out on
+// normalisoitu kopio (malloc, pituus *out_size), tai -1, jos muisti loppui.
+// Kopion perässä on UTF8NORM_PADDING nollatavua, joten nimiä 16 tavun paloina
+// kopioiva sampler ei lue varatun alueen yli.
+// *encoding saa havaitun merkistön.
+int utf8_normalize(const char *data, size_t size, char **out, size_t *out_size, int *encoding);
+
+#endif // UTF8NORM_H
@@ -0,0 +1,421 @@
+/**
+* @file yearcache.c
+* @brief Year-level blending of decade columns with a bounded LRU cache.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alias.h"
+#include "namedict.h"
+#include "yearcache.h"
+
+// --- 1. SEKOITUS ---
+
+// Funktio laskee listan todennäköisyydet: alias-taulusta tai tasaisesti
+static void list_probabilities(const NameList *list, double *probabilities) {
+    if (list->alias != NULL) {
+        alias_probabilities(list->alias, (uint32_t)list->count, probabilities);
+        return;
+    }
+    for (int i = 0; i < list->count; i++) {
+        probabilities[i] = 1.0 / (double)list->count;
+    }
+}
+
+// Funktio yhdistää kaksi saman sanakirjan listaa painoilla wa ja wb. Nimet
+// tunnistetaan tunnisteista, joten sama nimi on tuloksessa kerran. Tuloksen
+// lohko on [alias-taulu][tunnisteet] ja tunnisteiden leveys sama kuin lähteillä.
+static int blend_lists(const NameList *a, double wa, const NameList *b, double wb, NameList *out) {
+    memset(out, 0, sizeof(*out));
+    size_t total = (size_t)a->count + (size_t)b->count;
+    if (total == 0) {
+        return NAMELIST_OK;
+    }
+
+    size_t hash_size = 16;
+    while (hash_size < total * 2) {
+        hash_size *= 2;
+    }
+
+    double *probabilities = (double *)malloc(total * sizeof(double));
+    double *weights = (double *)calloc(total, sizeof(double));
+    uint32_t *merged = (uint32_t *)malloc(total * sizeof(uint32_t));
+    uint32_t *hash = (uint32_t *)malloc(hash_size * sizeof(uint32_t));
+    if (probabilities == NULL || weights == NULL || merged == NULL || hash == NULL) {
+        free(probabilities);
+        free(weights);
+        free(merged);
+        free(hash);
+        return NAMELIST_ERR_NOMEM;
+    }
+    memset(hash, 0xff, hash_size * sizeof(uint32_t)); // UINT32_MAX = tyhjä
+
+    list_probabilities(a, probabilities);
+    list_probabilities(b, probabilities + a->count);
+
+    const NameList *source = (a->count > 0) ? a : b;
+    uint32_t count = 0;
+    for (size_t i = 0; i < total; i++) {
+        const NameList *list = (i < (size_t)a->count) ? a : b;
+        int index = (i < (size_t)a->count) ? (int)i : (int)(i - (size_t)a->count);
+        double weight = (list == a) ? wa : wb;
+        uint32_t id = name_id(list, index);
+
+        // Haetaan sama tunniste hajautustaulusta (lineaarinen kokeilu)
+        size_t slot = (id * 2654435761u) & (hash_size - 1);
+        while (hash[slot] != UINT32_MAX && merged[hash[slot]] != id) {
+            slot = (slot + 1) & (hash_size - 1);
+        }
+        if (hash[slot] == UINT32_MAX) {
+            hash[slot] = count;
+            merged[count++] = id;
+        }
+        weights[hash[slot]] += weight * probabilities[i];
+    }
+
+    int id_width = (source->ids != NULL) ? source->id_width : 4;
+    char *block = (char *)malloc((size_t)count * (sizeof(AliasEntry) + (size_t)id_width));
+    int result = NAMELIST_ERR_NOMEM;
+    if (block != NULL) {
+        AliasEntry *alias = (AliasEntry *)block;
+        char *ids = block + (size_t)count * sizeof(AliasEntry);
+        for (uint32_t i = 0; i < count; i++) {
+            name_dict_store_id(ids, id_width, i, merged[i]);
+        }
+        if (alias_build(alias, weights, count) == 0) {
+            out->pool = source->pool;
+            out->slices = source->slices;
+            out->ids = ids;
+            out->id_width = id_width;
+            out->count = (int)count;
+            out->alias = alias;
+            out->block = block;
+            result = NAMELIST_OK;
+        } else {
+            free(block);
+        }
+    }
+
+    free(probabilities);
+    free(weights);
+    free(merged);
+    free(hash);
+    return result;
+}
+
+// Funktio etsii vuoden ympäröivät vuosikymmenet: sarakkeet k ja k + 1 sekä
+// jälkimmäisen paino f. Alku- ja loppupään ulkopuoliset vuodet rajataan.
+static void locate_year(const YearCache *cache, int year, int *column, double *fraction) {
+    int n = cache->first_names->num_decades;
+    double y = (double)year;
+    *column = 0;
+    *fraction = 0.0;
+    if (y <= cache->centers[0]) {
+        return;
+    }
+    if (y >= cache->centers[n - 1]) {
+        *column = n - 1;
+        return;
+    }
+    int k = 0;
+    while (k + 1 < n && cache->centers[k + 1] <= y) {
+        k++;
+    }
+    *column = k;
+    *fraction = (y - cache->centers[k]) / (cache->centers[k + 1] - cache->centers[k]);
+}
+
+// Funktio palauttaa vuosikymmenen listan tai tyhjän listan
+static const NameList *column_list(const DecadeData *data, int column) {
+    static const NameList empty;
+    return (column < data->num_decades) ? &data->lists[column] : &empty;
+}
+
+// Funktio rakentaa vuoden taulun
+static int build_table(const YearCache *cache, int year, YearTable **out) {
+    YearTable *table = (YearTable *)calloc(1, sizeof(YearTable));
+    if (table == NULL) {
+        return NAMELIST_ERR_NOMEM;
+    }
+    table->year = year;
+
+    int column;
+    double fraction;
+    locate_year(cache, year, &column, &fraction);
+    int next = (fraction > 0.0) ? column + 1 : column;
+
+    int result = blend_lists(column_list(cache->first_names, column), 1.0 - fraction,
+                             column_list(cache->first_names, next), fraction, &table->first);
+    if (result == NAMELIST_OK) {
+        result = blend_lists(column_list(cache->middle_names, column), 1.0 - fraction,
+                             column_list(cache->middle_names, next), fraction, &table->middle);
+    }
+    if (result != NAMELIST_OK) {
+        free_names(&table->first);
+        free_names(&table->middle);
+        free(table);
+        return result;
+    }
+    *out = table;
+    return NAMELIST_OK;
+}
+
+static void free_table(YearTable *table) {
+    free_names(&table->first);
+    free_names(&table->middle);
+    free(table);
+}
+
+// --- 2. VÄLIMUISTI ---
+
+static size_t year_slot(const YearCache *cache, int year) {
+    return ((uint32_t)year * 2654435761u) & (uint32_t)(cache->hash_size - 1);
+}
+
+static void hash_insert(YearCache *cache, YearTable *table) {
+    size_t slot = year_slot(cache, table->year);
+    while (cache->slots[slot] != NULL) {
+        slot = (slot + 1) & (size_t)(cache->hash_size - 1);
+    }
+    cache->slots[slot] = table;
+}
+
+static YearTable *hash_find(const YearCache *cache, int year) {
+    size_t slot = year_slot(cache, year);
+    while (cache->slots[slot] != NULL) {
+        if (cache->slots[slot]->year == year) {
+            return cache->slots[slot];
+        }
+        slot = (slot + 1) & (size_t)(cache->hash_size - 1);
+    }
+    return NULL;
+}
+
+// Poisto lineaarisesta kokeilusta siirtämällä seuraavia alkioita taaksepäin
+static void hash_remove(YearCache *cache, const YearTable *table) {
+    size_t mask = (size_t)(cache->hash_size - 1);
+    size_t slot = year_slot(cache, table->year);
+    while (cache->slots[slot] != table) {
+        slot = (slot + 1) & mask;
+    }
+    cache->slots[slot] = NULL;
+
+    size_t next = (slot + 1) & mask;
+    while (cache->slots[next] != NULL) {
+        YearTable *moved = cache->slots[next];
+        size_t home = year_slot(cache, moved->year);
+        // Siirretään, jos tyhjä paikka on kotipaikan ja nykyisen paikan välissä
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            cache->slots[slot] = moved;
+            cache->slots[next] = NULL;
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+}
+
+static void lru_unlink(YearCache *cache, YearTable *table) {
+    if (table->prev != NULL) {
+        table->prev->next = table->next;
+    } else {
+        cache->newest = table->next;
+    }
+    if (table->next != NULL) {
+        table->next->prev = table->prev;
+    } else {
+        cache->oldest = table->prev;
+    }
+    table->prev = table->next = NULL;
+}
+
+static void lru_push_front(YearCache *cache, YearTable *table) {
+    table->prev = NULL;
+    table->next = cache->newest;
+    if (cache->newest != NULL) {
+        cache->newest->prev = table;
+    }
+    cache->newest = table;
+    if (cache->oldest == NULL) {
+        cache->oldest = table;
+    }
+}
+
+// Funktio poistaa taulun välimuistista. Käytössä oleva taulu vapautetaan
+// vasta viimeisessä year_cache_release-kutsussa.
+static void evict(YearCache *cache, YearTable *table) {
+    hash_remove(cache, table);
+    lru_unlink(cache, table);
+    cache->size--;
+    table->cached = 0;
+    if (table->refs == 0) {
+        free_table(table);
+    }
+}
+
+static int alloc_slots(YearCache *cache, int capacity) {
+    int hash_size = 16;
+    while (hash_size < capacity * 2) {
+        hash_size *= 2;
+    }
+    YearTable **slots = (YearTable **)calloc((size_t)hash_size, sizeof(YearTable *));
+    if (slots == NULL) {
+        return NAMELIST_ERR_NOMEM;
+    }
+    free(cache->slots);
+    cache->slots = slots;
+    cache->hash_size = hash_size;
+    cache->capacity = capacity;
+    return NAMELIST_OK;
+}
+
+int year_cache_init(YearCache *cache, const DecadeData *first_names,
+                    const DecadeData *middle_names, int capacity) {
+    memset(cache, 0, sizeof(*cache));
+    cache->first_names = first_names;
+    cache->middle_names = middle_names;
+    if (capacity <= 0) {
+        capacity = YEAR_CACHE_DEFAULT;
+    }
+    if (alloc_slots(cache, capacity) != NAMELIST_OK) {
+        return NAMELIST_ERR_NOMEM;
+    }
+
+    // Otsikon alku on vuosikymmenen ensimmäinen vuosi; kaikkien on oltava vuosia
+    int n = first_names->num_decades;
+    cache->centers = (n > 0) ? (double *)malloc((size_t)n * sizeof(double)) : NULL;
+    if (n > 0 && cache->centers == NULL) {
+        free(cache->slots);
+        return NAMELIST_ERR_NOMEM;
+    }
+    for (int i = 0; i < n; i++) {
+        char *end = NULL;
+        long start = strtol(first_names->decades[i], &end, 10);
+        if (end == first_names->decades[i] || (i > 0 && start + 4.5 <= cache->centers[i - 1])) {
+            free(cache->centers);
+            cache->centers = NULL; // Ei vuosia (tai ei kasvavassa järjestyksessä)
+            break;
+        }
+        cache->centers[i] = (double)start + 4.5;
+    }
+
+    pthread_mutex_init(&cache->lock, NULL);
+    return NAMELIST_OK;
+}
+
+void year_cache_clear(YearCache *cache) {
+    if (cache->slots == NULL) {
+        return; // Ei alustettu
+    }
+    pthread_mutex_lock(&cache->lock);
+    while (cache->oldest != NULL) {
+        evict(cache, cache->oldest);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void year_cache_free(YearCache *cache) {
+    if (cache->slots == NULL) {
+        return;
+    }
+    year_cache_clear(cache);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->slots);
+    free(cache->centers);
+    memset(cache, 0, sizeof(*cache));
+}
+
+int year_cache_resize(YearCache *cache, int capacity) {
+    if (capacity <= 0) {
+        return NAMELIST_ERR_FORMAT;
+    }
+    pthread_mutex_lock(&cache->lock);
+    while (cache->size > capacity) {
+        evict(cache, cache->oldest);
+    }
+    // Hajautustaulu rakennetaan uudelleen uuden koon mukaan
+    int result = alloc_slots(cache, capacity);
+    if (result == NAMELIST_OK) {
+        for (YearTable *t = cache->newest; t != NULL; t = t->next) {
+            hash_insert(cache, t);
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return result;
+}
+
+int year_cache_supported(const YearCache *cache) {
+    return cache->centers != NULL;
+}
+
+int year_cache_acquire(YearCache *cache, int year, YearTable **out) {
+    *out = NULL;
+    if (cache->centers == NULL) {
+        return NAMELIST_ERR_FORMAT;
+    }
+
+    // Reunojen ulkopuoliset vuodet saavat saman taulun, joten ne jakavat paikan
+    int n = cache->first_names->num_decades;
+    if (year < cache->centers[0]) {
+        year = (int)floor(cache->centers[0]);
+    } else if (year > cache->centers[n - 1]) {
+        year = (int)ceil(cache->centers[n - 1]);
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    YearTable *table = hash_find(cache, year);
+    if (table != NULL) {
+        cache->hits++;
+        lru_unlink(cache, table);
+        lru_push_front(cache, table);
+    } else {
+        // Rakennetaan lukon alla, jotta samaa vuotta ei rakenneta kahdesti
+        cache->misses++;
+        int result = build_table(cache, year, &table);
+        if (result != NAMELIST_OK) {
+            pthread_mutex_unlock(&cache->lock);
+            return result;
+        }
+        if (cache->size == cache->capacity) {
+            evict(cache, cache->oldest);
+        }
+        table->cached = 1;
+        hash_insert(cache, table);
+        lru_push_front(cache, table);
+        cache->size++;
+    }
+    table->refs++;
+    pthread_mutex_unlock(&cache->lock);
+
+    *out = table;
+    return NAMELIST_OK;
+}
+
+void year_cache_release(YearCache *cache, YearTable *table) {
+    pthread_mutex_lock(&cache->lock);
+    table->refs--;
+    if (table->refs == 0 && !table->cached) {
+        free_table(table);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,87 @@
+/**
+* @file yearcache.h
+* @brief Year-level blending of decade columns with a bounded LRU cache.
+
+genesim - A comprehensive lineage and family relationship simulator.
+Developed with GTK3 and C.
+
+Copyright (C) 2025 Tuomas Lähteenmäki
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 3
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef YEARCACHE_H
+#define YEARCACHE_H
+
+#include <pthread.h>
+
+#include "namelist.h"
+
+// Välimuistin oletuskoko: riittää vuosille 1860-1929 yhdellä kertaa
+#define YEAR_CACHE_DEFAULT 128
+
+// Vuoden sekoitetut listat. Vuosi y sijoittuu kahden vuosikymmenen keskikohtien
+// väliin ja saa niiden jakaumat painoilla (1 - f) ja f. Nimi, joka on molemmissa
+// sarakkeissa, on sekoituksessa kerran yhteenlasketulla todennäköisyydellä.
+// Sekoitus on tunnisteina samaan sanakirjaan kuin vuosikymmenten sarakkeet.
+typedef struct YearTable {
+    int year;
+    int refs;            // Käyttäjien määrä (taulua ei vapauteta kesken käytön)
+    int cached;          // Onko taulu vielä välimuistissa
+    NameList first;      // Sekoitetut etunimet (alias-taulu aina mukana)
+    NameList middle;     // Sekoitetut keskinimet (count = 0, jos ei keskinimiä)
+    struct YearTable *prev, *next; // LRU-lista, uusin ensin
+} YearTable;
+
+// Rajattu LRU-välimuisti vuosittain. Haku on hajautustaulusta O(1); taulu
+// rakennetaan vain ensimmäisellä kerralla. Säieturvallinen.
+typedef struct {
+    pthread_mutex_t lock;
+    const DecadeData *first_names;
+    const DecadeData *middle_names;
+    double *centers;     // Vuosikymmenten keskikohdat (esim. 1894.5), NULL jos otsikot eivät ole vuosia
+    int capacity;
+    int size;
+    YearTable **slots;   // Hajautustaulu (avoin osoitus), koko hash_size
+    int hash_size;
+    YearTable *newest, *oldest;
+    unsigned long long hits, misses;
+} YearCache;
+
+// Alustaa välimuistin. Vuosikymmenet luetaan otsikoiden alusta ("1890–99" -> 1890).
+// Palauttaa NAMELIST_OK tai NAMELIST_ERR_NOMEM.
+int year_cache_init(YearCache *cache, const DecadeData *first_names,
+                    const DecadeData *middle_names, int capacity);
+
+// Vapauttaa välimuistin (tauluja ei saa olla käytössä)
+void year_cache_free(YearCache *cache);
+
+// Tyhjentää välimuistin, esim. kun painotus muuttuu
+void year_cache_clear(YearCache *cache);
+
+// Vaihtaa välimuistin koon (vanhimmat taulut poistetaan)
+int year_cache_resize(YearCache *cache, int capacity);
+
+// Onko otsikoista saatu vuodet
+int year_cache_supported(const YearCache *cache);
+
+// Hakee tai rakentaa vuoden taulun ja varaa sen käyttöön. Palauttaa
+// NAMELIST_OK, NAMELIST_ERR_NOMEM tai NAMELIST_ERR_FORMAT (ei vuosia).
+int year_cache_acquire(YearCache *cache, int year, YearTable **table);
+
+// Vapauttaa varauksen. Välimuistista poistettu taulu vapautetaan viimeisenä.
+void year_cache_release(YearCache *cache, YearTable *table);
+
+#endif // YEARCACHE_H
@@ -0,0 +1,83 @@
+# Testien yhteiset apufunktiot. Ohjelmat käännetään väliaikaiseen hakemistoon
+# ($BUILD) samoilla riveillä kuin README:ssä, ja ne ajetaan src-hakemistossa,
+# jotta data/FI-fi löytyy.
+
+set -u
+
+SRC="$(cd "$(dirname "$0")/../src" && pwd)"
+# Itse luotu väliaikainen hakemisto poistetaan lopuksi, annettu jätetään
+if [ -n "${BUILD:-}" ]; then
+    mkdir -p "$BUILD" || exit 1
+    TEMPORARY_BUILD=""
+else
+    BUILD="$(mktemp -d)" || exit 1
+    TEMPORARY_BUILD="$BUILD"
+fi
+CC="${CC:-gcc}"
+CFLAGS="${CFLAGS:--O2 -Wall}"
+LIBRARY="libnamegen.c sampler.c namelist.c csvscan.c corpus.c alias.c rng.c yearcache.c namedict.c permute.c
+         condtable.c markov.c utf8norm.c stats.c lineformat.c"
+failures=0
+
+# Siivoaa lopuksi. Skripti, joka asettaa oman EXIT-ansan, kutsuu tätä siinä.
+cleanup() {
+    if [ -n "$TEMPORARY_BUILD" ]; then
+        rm -rf "$TEMPORARY_BUILD"
+    fi
+}
+trap cleanup EXIT
+
+# Kääntää ohjelman: build NIMI LÄHTEET...
+build() {
+    local name=$1
+    shift
+    (cd "$SRC" && $CC $CFLAGS -pthread -o "$BUILD/$name" "$@" -lm) || { echo "FAIL build $name"; exit 1; }
+}
+
+build_namegen() {
+    build namegen namegen.c $LIBRARY outbuf.c parallel.c columnar.c
+}
+
+build_genesim() {
+    build genesim main.c $LIBRARY outbuf.c parallel.c population.c kinship.c snapshot.c gedcom.c
+}
+
+build_ngcompile() {
+    build ngcompile ngcompile.c namelist.c csvscan.c corpus.c alias.c rng.c namedict.c markov.c utf8norm.c stats.c
+}
+
+build_ngserve() {
+    build ngserve ngserve.c $LIBRARY outbuf.c parallel.c
+}
+
+# Ajaa ohjelman src-hakemistossa: run NIMI ARGUMENTIT...
+run() {
+    local name=$1
+    shift
+    (cd "$SRC" && "$BUILD/$name" "$@")
+}
+
+# Kirjaa tarkistuksen tuloksen: check KUVAUS KOMENTO...
+check() {
+    local description=$1
+    shift
+    if "$@"; then
+        echo "ok   $description"
+    else
+        echo "FAIL $description"
+        failures=$((failures + 1))
+    fi
+}
+
+# Vertaa kahta tiedostoa tavu tavulta
+same_files() {
+    cmp -s "$1" "$2"
+}
+
+finish() {
+    if [ "$failures" -gt 0 ]; then
+        echo "$failures check(s) failed"
+        exit 1
+    fi
+    echo "All checks passed"
+}
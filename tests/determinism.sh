@@ -0,0 +1,48 @@
+#!/bin/sh
+# Sama siemen antaa saman tulosteen säikeiden määrästä riippumatta: namegenin
+# palat ja genesimin väestö (myös sukulaisuustaulun kanssa) yhdellä ja
+# useammalla säikeellä.
+
+. "$(dirname "$0")/common.sh"
+
+build_namegen
+build_genesim
+build_ngcompile
+run ngcompile --quiet data/FI-fi "$BUILD/FI-fi.ngc" || exit 1
+
+# Ajaa namegenin yhdellä ja kolmella säikeellä ja vertaa tulosteita:
+# same_namegen NIMI ASETUKSET...
+same_namegen() {
+    local name=$1
+    shift
+    run namegen --quiet --count 200000 --seed 42 --threads 1 --output "$BUILD/$name.1" "$@" &&
+        run namegen --quiet --count 200000 --seed 42 --threads 3 --output "$BUILD/$name.3" "$@" &&
+        [ -s "$BUILD/$name.1" ] && same_files "$BUILD/$name.1" "$BUILD/$name.3"
+}
+
+check "namegen text" same_namegen text --decade 1890
+check "namegen weighted csv" same_namegen csv --decade 1920 --weighted --format csv
+check "namegen year blend" same_namegen year --year 1894
+check "namegen unique" same_namegen unique --decade 1890 --unique
+check "namegen conditional" same_namegen conditional --decade 1890 --conditional
+check "namegen markov" same_namegen markov --decade 1890 --markov
+check "namegen markov novel" same_namegen novel --decade 1890 --markov --novel
+check "namegen corpus ids" same_namegen ids --corpus "$BUILD/FI-fi.ngc" --decade 1890 --ids
+check "namegen corpus columnar" same_namegen columnar --corpus "$BUILD/FI-fi.ngc" --decade 1890 --format columnar
+
+# Ajaa genesimin yhdellä ja kolmella säikeellä ja vertaa tilannevedoksia ja
+# GEDCOM-tiedostoja: same_genesim NIMI ASETUKSET...
+same_genesim() {
+    local name=$1
+    shift
+    for threads in 1 3; do
+        run genesim --people 30000 --seed 5 --threads $threads --save "$BUILD/$name.$threads.snap" \
+            --gedcom "$BUILD/$name.$threads.ged" "$@" >/dev/null || return 1
+    done
+    same_files "$BUILD/$name.1.snap" "$BUILD/$name.3.snap" && same_files "$BUILD/$name.1.ged" "$BUILD/$name.3.ged"
+}
+
+check "genesim population" same_genesim population
+check "genesim without the kinship limit" same_genesim siblings --kinship-limit 0
+
+finish
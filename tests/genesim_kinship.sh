@@ -0,0 +1,112 @@
+#!/bin/sh
+# genesimin sukulaisuus: --relatives-listan nimitykset lasketaan uudelleen
+# tilannevedoksen vanhemmista, ja sukulaisuustaulun sukusiitoskertoimet
+# verrataan rekursiiviseen määritelmään. Avioliittoraja pitää: yhdenkään
+# lapsen vanhempien kerroin ei ole rajaa suurempi.
+
+. "$(dirname "$0")/common.sh"
+
+build_genesim
+
+# Lukee tilannevedoksen sarakkeet ja laskee kertoimet: snapshot.py TIEDOSTO TOIMINTO...
+cat > "$BUILD/snapshot.py" <<'PY'
+import re, struct, sys
+sys.setrecursionlimit(100000)
+NONE = 0xFFFFFFFF
+data = open(sys.argv[1], 'rb').read()
+count = struct.unpack_from('<I', data, 44)[0]
+columns = struct.unpack_from('<10Q', data, 56)
+sex = data[columns[2]:columns[2] + count]
+mother = struct.unpack_from('<%dI' % count, data, columns[3])
+father = struct.unpack_from('<%dI' % count, data, columns[4])
+inbreeding = struct.unpack_from('<%df' % count, data, columns[9])
+
+memo = {}
+def phi(a, b):
+    if a < b:
+        a, b = b, a
+    if (a, b) not in memo:
+        if a == b:
+            memo[(a, b)] = 0.5 * (1.0 + (phi(mother[a], father[a]) if mother[a] != NONE else 0.0))
+        elif mother[a] == NONE:
+            memo[(a, b)] = 0.0
+        else:
+            memo[(a, b)] = 0.5 * (phi(mother[a], b) + phi(father[a], b))
+    return memo[(a, b)]
+
+def ancestors(person):
+    found, level = {person: 0}, [person]
+    for up in range(1, 9):
+        level = [p for q in level for p in (mother[q], father[q]) if p != NONE]
+        for p in level:
+            found.setdefault(p, up)
+    return found
+
+# Nimitys kuten kinship_describe: a suhteessa b:hen
+def describe(a, b):
+    up_a, up_b = ancestors(a), ancestors(b)
+    common = [(up_a[p] + up_b[p], p) for p in up_a if p in up_b]
+    if not common:
+        return 'not related'
+    best = min(common)[0]
+    nearest = [p for total, p in common if total == best]
+    x, y = up_a[nearest[0]], up_b[nearest[0]]
+    half = 'half-' if len(nearest) == 1 else ''
+    s = sex[a]
+    greats = lambda n: 'great-' * max(n, 0)
+    if x == 0:
+        return greats(y - 2) + ('grand' if y > 1 else '') + ('father', 'mother')[s]
+    if y == 0:
+        return greats(x - 2) + ('grand' if x > 1 else '') + ('son', 'daughter')[s]
+    if x == 1 and y == 1:
+        return half + ('brother', 'sister')[s]
+    if x == 1:
+        return half + greats(y - 2) + ('uncle', 'aunt')[s]
+    if y == 1:
+        return half + greats(x - 2) + ('nephew', 'niece')[s]
+    ordinals = ['first', 'second', 'third', 'fourth', 'fifth', 'sixth', 'seventh']
+    removals = ['', ' once removed', ' twice removed', ' three times removed']
+    return half + ordinals[min(x, y) - 2] + ' cousin' + removals[abs(x - y)]
+
+action = sys.argv[2]
+if action == 'relatives':
+    person, checked, wrong = int(sys.argv[3]), 0, 0
+    for line in open(sys.argv[4], encoding='utf-8'):
+        match = re.match(r'  ([a-z -]+): (\d+) ', line)
+        if match:
+            checked += 1
+            expected = describe(int(match.group(2)), person)
+            if expected != match.group(1):
+                print('%s is %s, expected %s' % (match.group(2), match.group(1), expected))
+                wrong += 1
+    sys.exit(0 if checked > 0 and wrong == 0 else 1)
+elif action == 'inbreeding':
+    worst = max(abs(phi(mother[i], father[i]) - inbreeding[i]) for i in range(count) if mother[i] != NONE)
+    sys.exit(0 if worst < 0.001 else 1)
+elif action == 'limit':
+    limit = float(sys.argv[3])
+    sys.exit(0 if all(phi(mother[i], father[i]) < limit for i in range(count) if mother[i] != NONE) else 1)
+elif action == 'inbred':
+    sys.exit(0 if any(f > 0 for f in inbreeding) else 1)
+PY
+
+snapshot() {
+    python3 "$BUILD/snapshot.py" "$@"
+}
+
+run genesim --people 20000 --seed 3 --save "$BUILD/pop.snap" >/dev/null || exit 1
+for person in 12000 15000 17000 19000; do
+    run genesim --load "$BUILD/pop.snap" --relatives $person > "$BUILD/relatives.$person" || exit 1
+    check "relatives of $person" snapshot "$BUILD/pop.snap" relatives $person "$BUILD/relatives.$person"
+done
+
+# Ilman rajaa (1) myös sisarukset voivat avioitua, joten kertoimia on
+run genesim --people 100000 --seed 2 --kinship-limit 1 --save "$BUILD/inbred.snap" >/dev/null || exit 1
+check "some children are inbred without a limit" snapshot "$BUILD/inbred.snap" inbred
+check "inbreeding matches the recursive definition" snapshot "$BUILD/inbred.snap" inbreeding
+
+run genesim --people 100000 --seed 2 --kinship-limit 0.0625 --save "$BUILD/limited.snap" >/dev/null || exit 1
+check "no parents are first cousins or closer" snapshot "$BUILD/limited.snap" limit 0.0625
+check "inbreeding matches with the limit" snapshot "$BUILD/limited.snap" inbreeding
+
+finish
@@ -0,0 +1,91 @@
+#!/bin/sh
+# genesimin tilannevedos: tallennettu ja uudelleen avattu väestö tuottaa saman
+# GEDCOM-tiedoston, ja vioittunut tiedosto hylätään kaatumatta.
+
+. "$(dirname "$0")/common.sh"
+
+build_genesim
+
+run genesim --people 20000 --seed 11 --save "$BUILD/pop.snap" --gedcom "$BUILD/simulated.ged" >/dev/null || exit 1
+run genesim --load "$BUILD/pop.snap" --gedcom "$BUILD/loaded.ged" >/dev/null
+check "snapshot opens" [ $? -eq 0 ]
+check "round trip gives identical GEDCOM" same_files "$BUILD/simulated.ged" "$BUILD/loaded.ged"
+check "GEDCOM ends with TRLR" [ "$(tail -c 8 "$BUILD/loaded.ged" | tr -d '\r\n')" = "0 TRLR" ]
+
+# GEDCOM-rakenne: tunnisteet ovat yksikäsitteisiä, jokaisella linkillä on
+# vastalinkki, rivit ovat enintään 255 merkkiä ja perheen lasten vanhemmat
+# ovat samat kuin tilannevedoksessa
+gedcom_valid() {
+    python3 - "$BUILD/loaded.ged" "$BUILD/pop.snap" <<'PY'
+import struct, sys
+records, current = {}, None
+for line in open(sys.argv[1], encoding='utf-8'):
+    if len(line) > 255:
+        sys.exit('line too long')
+    parts = line.rstrip('\n').split(' ', 2)
+    if parts[0] == '0' and parts[1].startswith('@'):
+        if parts[1] in records:
+            sys.exit('duplicate ' + parts[1])
+        current = records[parts[1]] = []
+    elif parts[0] == '0':
+        current = None
+    elif current is not None and len(parts) == 3:
+        current.append((parts[1], parts[2]))
+BACK = {'FAMC': ('CHIL',), 'FAMS': ('HUSB', 'WIFE'), 'HUSB': ('FAMS',), 'WIFE': ('FAMS',), 'CHIL': ('FAMC',)}
+for xref, lines in records.items():
+    for tag, value in lines:
+        if tag in BACK and (value not in records or
+                            not any(t in BACK[tag] and v == xref for t, v in records[value])):
+            sys.exit('%s %s %s has no link back' % (xref, tag, value))
+
+data = open(sys.argv[2], 'rb').read()
+count = struct.unpack_from('<I', data, 44)[0]
+columns = struct.unpack_from('<10Q', data, 56)
+mother = struct.unpack_from('<%dI' % count, data, columns[3])
+father = struct.unpack_from('<%dI' % count, data, columns[4])
+person = lambda xref: int(xref[2:-1])
+people = 0
+for xref, lines in records.items():
+    people += xref.startswith('@I')
+    links = dict(lines)
+    for tag, value in lines:
+        if tag == 'CHIL' and (mother[person(value)] != person(links['WIFE']) or
+                              father[person(value)] != person(links['HUSB'])):
+            sys.exit('%s: wrong parents for %s' % (xref, value))
+sys.exit(0 if people == count else 'people missing')
+PY
+}
+check "GEDCOM links and parents are consistent" gedcom_valid
+
+# Vioittaa sarakkeen viimeisen henkilön kohdalta: corrupt SARAKE ARVO TIEDOSTO.
+# Arvo voi viitata henkilöiden määrään (count).
+corrupt() {
+    python3 - "$BUILD/pop.snap" "$1" "$2" "$3" <<'PY'
+import struct, sys
+path, column, value, output = sys.argv[1], int(sys.argv[2]), sys.argv[3], sys.argv[4]
+data = bytearray(open(path, 'rb').read())
+count = struct.unpack_from('<I', data, 44)[0]
+offset = struct.unpack_from('<10Q', data, 56)[column]
+struct.pack_into('<I', data, offset + 4 * (count - 1), eval(value, {'count': count}))
+open(output, 'wb').write(data)
+PY
+}
+
+# Vioittunut tiedosto: --verify hylkää sen virheilmoitukseen, ei signaaliin
+rejected() {
+    run genesim --load "$1" --verify --gedcom "$BUILD/broken.ged" >/dev/null 2>&1
+    [ $? -eq 1 ]
+}
+
+check "intact snapshot passes --verify" run genesim --load "$BUILD/pop.snap" --verify
+
+corrupt 3 "count - 1" "$BUILD/mother.snap"
+check "mother born after the child is rejected" rejected "$BUILD/mother.snap"
+corrupt 5 "count + 3" "$BUILD/spouse.snap"
+check "spouse outside the population is rejected" rejected "$BUILD/spouse.snap"
+corrupt 8 "0xfffffff0" "$BUILD/name.snap"
+check "name ID outside the dictionary is rejected" rejected "$BUILD/name.snap"
+head -c 100000 "$BUILD/pop.snap" > "$BUILD/truncated.snap"
+check "truncated snapshot is rejected" rejected "$BUILD/truncated.snap"
+
+finish
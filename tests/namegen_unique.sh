@@ -0,0 +1,47 @@
+#!/bin/sh
+# namegen --unique: Feistel-permutaatio käy jokaisen yhdistelmän läpi
+# täsmälleen kerran, eikä yhdistelmiä voi pyytää enempää kuin niitä on.
+
+. "$(dirname "$0")/common.sh"
+
+build_namegen
+
+# Yhdistelmien määrä virheilmoituksesta: space ASETUKSET...
+space() {
+    run namegen --quiet --count 999999999999 --unique "$@" 2>&1 | sed -n 's/.* has only \([0-9]*\) distinct.*/\1/p'
+}
+
+# Generoi kaikki yhdistelmät ja tarkistaa, ettei yksikään toistu:
+# all_distinct NIMI ASETUKSET...
+all_distinct() {
+    local name=$1
+    shift
+    local total
+    total=$(space "$@")
+    [ -n "$total" ] || return 1
+    run namegen --quiet --count "$total" --seed 9 --unique --output "$BUILD/$name" "$@" || return 1
+    [ "$(wc -l < "$BUILD/$name")" -eq "$total" ] && [ "$(sort -u "$BUILD/$name" | wc -l)" -eq "$total" ]
+}
+
+# Yksi yli yhdistelmien määrän: virhe eikä tulostetta
+one_too_many() {
+    local total
+    total=$(space "$@")
+    [ -n "$total" ] || return 1
+    ! run namegen --quiet --count $((total + 1)) --seed 9 --unique --output "$BUILD/too_many" "$@" 2>/dev/null
+}
+
+# Eri siemen antaa eri järjestyksen samoista nimistä
+other_order() {
+    run namegen --quiet --count 1000 --seed 10 --unique --decade 1890 --output "$BUILD/seed10" &&
+        head -n 1000 "$BUILD/period" > "$BUILD/seed9" &&
+        ! same_files "$BUILD/seed9" "$BUILD/seed10"
+}
+
+check "every combination of a period once" all_distinct period --decade 1890
+check "every combination of a blended year once" all_distinct year --year 1894
+check "more names than combinations fails (period)" one_too_many --decade 1890
+check "more names than combinations fails (year)" one_too_many --year 1894
+check "another seed gives another order" other_order
+
+finish
@@ -0,0 +1,117 @@
+#!/bin/sh
+# ngserven pyyntöprotokolla: ERR-vastaukset, yhteys pysyy auki virheen
+# jälkeen ja putkitetut pyynnöt vastataan järjestyksessä.
+
+. "$(dirname "$0")/common.sh"
+
+build_ngserve
+build_ngcompile
+run ngcompile --quiet data/FI-fi "$BUILD/FI-fi.ngc" || exit 1
+
+SERVER_PID=""
+stop_server() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null
+        wait "$SERVER_PID" 2>/dev/null
+        SERVER_PID=""
+    fi
+}
+trap 'stop_server; cleanup' EXIT
+
+# Käynnistää palvelimen ja odottaa, että pistoke on olemassa: start_server ASETUKSET...
+start_server() {
+    SOCKET="$BUILD/ngserve.sock"
+    rm -f "$SOCKET"
+    (cd "$SRC" && exec "$BUILD/ngserve" --quiet --workers 2 --socket "$SOCKET" "$@") &
+    SERVER_PID=$!
+    for i in $(seq 50); do
+        [ -S "$SOCKET" ] && return 0
+        sleep 0.1
+    done
+    echo "FAIL server did not start"
+    exit 1
+}
+
+# Lähettää pyynnöt yhdellä kirjoituksella (putkitettuina) ja tulostaa koko
+# vastauksen, kun palvelin on vastannut kaikkiin: exchange PYYNNÖT VASTAUKSIA
+exchange() {
+    python3 - "$SOCKET" "$1" "$2" <<'PY'
+import socket, sys
+path, payload, expected = sys.argv[1], sys.argv[2].replace('\\n', '\n'), int(sys.argv[3])
+s = socket.socket(socket.AF_UNIX)
+s.settimeout(5)
+s.connect(path)
+s.sendall(payload.encode())
+data = b''
+# Vastaus on valmis, kun ERR-rivejä ja loppukehyksiä on yhtä monta kuin pyyntöjä
+while data.count(b'ERR ') + data.count(b'00000000\n') < expected:
+    chunk = s.recv(65536)
+    if not chunk:
+        break
+    data += chunk
+sys.stdout.write(data.decode('utf-8', 'replace'))
+PY
+}
+
+# Tarkistaa, että vastaus alkaa annetulla tekstillä: starts_with VASTAUS ALKU
+starts_with() {
+    case "$1" in
+        "$2"*) return 0 ;;
+        *) return 1 ;;
+    esac
+}
+
+ends_with() {
+    case "$1" in
+        *"$2") return 0 ;;
+        *) return 1 ;;
+    esac
+}
+
+# 1. Nimitiedostot ilman korpusta
+start_server
+
+reply=$(exchange 'n=5 decade=1890 seed=1 format=ids\nn=2 decade=1890 seed=1\n' 2)
+check "format=ids without a corpus is refused" starts_with "$reply" "ERR unsupported format
+OK
+"
+check "request after the refused one is answered" ends_with "$reply" "00000000"
+
+reply=$(exchange 'n=1 decade=1750\n' 1)
+check "unknown decade" starts_with "$reply" "ERR unknown decade"
+
+reply=$(exchange 'n=1\n' 1)
+check "missing decade" starts_with "$reply" "ERR n and decade are required"
+
+reply=$(exchange 'n=x decade=1890\n' 1)
+check "invalid n" starts_with "$reply" "ERR invalid n"
+
+reply=$(exchange 'n=1 decade=1890 format=xml\n' 1)
+check "unknown format" starts_with "$reply" "ERR unknown format"
+
+reply=$(exchange 'n=1 decade=1890 colour=red\n' 1)
+check "unknown key" starts_with "$reply" "ERR unknown key"
+
+reply=$(exchange 'hello\n' 1)
+check "line without key=value" starts_with "$reply" "ERR expected key=value"
+
+reply=$(exchange 'n=1 decade=1750\nn=1 decade=1890 format=xml\nn=3 decade=1890 seed=7\n' 3)
+check "pipelined errors keep their order" starts_with "$reply" "ERR unknown decade
+ERR unknown format
+OK
+"
+
+# Sama siemen antaa samat nimet pyynnöstä toiseen
+first=$(exchange 'n=100 decade=1890 seed=42 format=jsonl\n' 1)
+second=$(exchange 'n=100 decade=1890 seed=42 format=jsonl\n' 1)
+check "same seed gives the same names" [ "$first" = "$second" ]
+stop_server
+
+# 2. Korpus: tunnisteet ovat sallittuja
+start_server --corpus "$BUILD/FI-fi.ngc"
+reply=$(exchange 'n=5 decade=1890 seed=1 format=ids\n' 1)
+check "format=ids with a corpus" starts_with "$reply" "OK
+"
+stop_server
+
+finish
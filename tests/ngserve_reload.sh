@@ -0,0 +1,90 @@
+#!/bin/sh
+# ngserve --watch: nimet ladataan uudelleen kesken pyyntöjen. Jokaiseen
+# pyyntöön vastataan, palvelin ei kaadu vanhojen nimien vapautukseen, ja
+# muutetut nimet tulevat käyttöön.
+
+. "$(dirname "$0")/common.sh"
+
+build_ngserve
+LOCALE="$BUILD/locale"
+mkdir -p "$LOCALE" && cp "$SRC"/data/FI-fi/* "$LOCALE"/ || exit 1
+
+SOCKET="$BUILD/ngserve.sock"
+SERVER_PID=""
+stop_server() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null
+        wait "$SERVER_PID" 2>/dev/null
+        SERVER_PID=""
+    fi
+}
+trap 'stop_server; cleanup' EXIT
+
+rm -f "$SOCKET"
+(cd "$SRC" && exec "$BUILD/ngserve" --watch --workers 2 --locale "$LOCALE" --socket "$SOCKET" 2> "$BUILD/server.log") &
+SERVER_PID=$!
+for i in $(seq 50); do
+    [ -S "$SOCKET" ] && break
+    sleep 0.1
+done
+
+# Lähettää pyyntöjä kahdella yhteydellä, kunnes tiedosto STOP on olemassa, ja
+# tulostaa vastausten määrän ja virheet: requests STOP
+requests() {
+    python3 - "$SOCKET" "$1" <<'PY'
+import os, socket, sys
+path, stop = sys.argv[1], sys.argv[2]
+connections = [socket.socket(socket.AF_UNIX) for _ in range(2)]
+for s in connections:
+    s.settimeout(5)
+    s.connect(path)
+answered, errors = 0, 0
+while not os.path.exists(stop):
+    for s in connections:
+        s.sendall(b'n=500 decade=1890 seed=1\nn=3 decade=1750\n')
+        data = b''
+        while data.count(b'00000000\n') + data.count(b'ERR ') < 2:
+            chunk = s.recv(65536)
+            if not chunk:
+                sys.exit('connection closed')
+            data += chunk
+        ok = data.startswith(b'OK\n') and b'ERR unknown decade\n' in data
+        answered += 1
+        errors += not ok
+print(answered, errors)
+PY
+}
+
+# Tiedostoja kirjoitetaan uudelleen 150 ms välein, joten osa latauksista
+# peruuntuu ja osa vaihtaa nimet kesken pyyntöjen
+requests "$BUILD/stop" > "$BUILD/answers" &
+CLIENT_PID=$!
+for i in $(seq 12); do
+    cp "$SRC/data/FI-fi/surnames.txt" "$LOCALE/surnames.txt"
+    sleep 0.15
+    [ $((i % 3)) -eq 0 ] && sleep 0.3
+done
+touch "$BUILD/stop"
+wait $CLIENT_PID
+read answered errors < "$BUILD/answers"
+all_answered() {
+    [ "${answered:-0}" -gt 0 ] && [ "${errors:-1}" -eq 0 ]
+}
+check "requests are answered during reloads" all_answered
+check "names were reloaded several times" [ "$(grep -c "Reloaded names" "$BUILD/server.log")" -ge 2 ]
+check "server is still running" kill -0 "$SERVER_PID"
+
+# Muutettu nimi tulee käyttöön latauksen jälkeen
+for file in "$LOCALE"/*; do
+    sed 's/^Virtanen/Testinen/' "$file" > "$file.new" && mv "$file.new" "$file"
+done
+changed() {
+    for i in $(seq 30); do
+        "$BUILD/ngserve" --socket "$SOCKET" --request "n=2000 decade=1890 seed=3" | grep -q Testinen && return 0
+        sleep 0.1
+    done
+    return 1
+}
+check "changed names are used after the reload" changed
+
+finish